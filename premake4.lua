@@ -12,6 +12,19 @@ solution "carli"
     }
   }
 
+  newoption {
+    trigger     = "intrusive-ptr",
+    value       = "false",
+    description = "Hold Rete symbols, WMEs, tokens and nodes through non-atomic intrusive reference counts instead of std::shared_ptr",
+    allowed = {
+      { "false", "std::shared_ptr" },
+      { "true",  "Rete::Intrusive_Ptr" },
+    }
+  }
+  if _OPTIONS["intrusive-ptr"] == "true" then
+    defines { "RETE_INTRUSIVE_PTR" }
+  end
+
   arch = "not-sparc64"
   if os.get() == "windows" then
     defines { "_WINDOWS", "WIN32", "_CRT_SECURE_NO_DEPRECATE" }
@@ -65,20 +78,20 @@ solution "carli"
   end
 
   configuration "Debug"
---     defines { "NDEBUG", "debuggable_cast=dynamic_cast", "debuggable_pointer_cast=std::dynamic_pointer_cast" }
-    defines { "_DEBUG", "DEBUG", "debuggable_cast=dynamic_cast", "debuggable_pointer_cast=std::dynamic_pointer_cast" }
+--     defines { "NDEBUG", "debuggable_cast=dynamic_cast", "debuggable_pointer_cast=Rete::dynamic_pointer_cast" }
+    defines { "_DEBUG", "DEBUG", "debuggable_cast=dynamic_cast", "debuggable_pointer_cast=Rete::dynamic_pointer_cast" }
     defines { "DEBUG_OUTPUT" }
 --     defines { "DISABLE_POOL_ALLOCATOR" }
     flags { "Symbols" }
     TARGETSUFFIX = "_d"
     targetsuffix(TARGETSUFFIX)
   configuration "Profiling"
-    defines { "NDEBUG", "debuggable_cast=static_cast", "debuggable_pointer_cast=std::static_pointer_cast" }
+    defines { "NDEBUG", "debuggable_cast=static_cast", "debuggable_pointer_cast=Rete::static_pointer_cast" }
     flags { "Symbols", "Optimize" }
     TARGETSUFFIX = "_p"
     targetsuffix(TARGETSUFFIX)
   configuration "Release"
-    defines { "NDEBUG", "debuggable_cast=static_cast", "debuggable_pointer_cast=std::static_pointer_cast" }
+    defines { "NDEBUG", "debuggable_cast=static_cast", "debuggable_pointer_cast=Rete::static_pointer_cast" }
     if arch == "sparc64" then
       buildoptions { "-Os" }
     else
@@ -110,16 +123,6 @@ solution "carli"
     if arch == "sparc64" then
       linkoptions { "-Wl,-rpath,/usr/local/lib64",
                     "-Wl,-rpath-link,/usr/local/lib64" }
-    else
-      configuration { "linux" }
-        linkoptions { "-Wl,-rpath,/home/bazald/Software/gperftools/lib",
-                      "-Wl,-rpath-link,/home/bazald/Software/gperftools/lib" }
-      configuration { "linux", "Debug" }
-        links { "tcmalloc" }
-      configuration { "linux", "Profiling" }
-        links { "tcmalloc_and_profiler" }
-      configuration { "linux", "Release" }
-        links { "tcmalloc" }
     end
     if _OPTIONS["clang"] == "true" then
       configuration "linux"
@@ -157,6 +160,7 @@ solution "carli"
   include "src/sliding_puzzle"
   include "src/sliding_puzzle_env"
 --  include "src/stats"
+  include "src/sweep"
   include "src/taxicab"
   include "src/taxicab_env"
 --  include "src/tetris"
@@ -20,6 +20,7 @@ namespace Advent {
 
   using std::dynamic_pointer_cast;
   using std::endl;
+  using std::istream;
   using std::ostream;
 
   typedef int64_t block_id;
@@ -62,6 +63,10 @@ namespace Advent {
   
   class ADVENT_LINKAGE Action : public Carli::Action {
   public:
+    static const Rete::Variable_Slot name_slot;
+    static const Rete::Variable_Slot direction_slot;
+    static const Rete::Variable_Slot item_slot;
+
     virtual int64_t compare(const Move &rhs) const = 0;
     virtual int64_t compare(const Attack &rhs) const = 0;
     virtual int64_t compare(const Take &rhs) const = 0;
@@ -83,7 +88,7 @@ namespace Advent {
     }
 
     Move(const Rete::Variable_Indices &variables, const Rete::WME_Token &token)
-     : direction(Direction(debuggable_cast<const Rete::Symbol_Constant_Int &>(*token[variables.find("direction")->second]).value))
+     : direction(Direction(token.get<Rete::Symbol_Constant_Int>(variables, direction_slot).value))
     {
       assert(direction == DIR_NONE || direction == DIR_NORTH || direction == DIR_SOUTH || direction == DIR_EAST || direction == DIR_WEST);
     }
@@ -139,7 +144,7 @@ namespace Advent {
     }
 
     Take(const Rete::Variable_Indices &variables, const Rete::WME_Token &token)
-     : item(Item(debuggable_cast<const Rete::Symbol_Constant_Int &>(*token[variables.find("item")->second]).value))
+     : item(Item(token.get<Rete::Symbol_Constant_Int>(variables, item_slot).value))
     {
       assert(item > 0 && item < 7);
     }
@@ -176,7 +181,7 @@ namespace Advent {
     }
 
     Drop(const Rete::Variable_Indices &variables, const Rete::WME_Token &token)
-     : item(Item(debuggable_cast<const Rete::Symbol_Constant_Int &>(*token[variables.find("item")->second]).value))
+     : item(Item(token.get<Rete::Symbol_Constant_Int>(variables, item_slot).value))
     {
       assert(item > 0 && item < 7);
     }
@@ -213,7 +218,7 @@ namespace Advent {
     }
 
     Equip(const Rete::Variable_Indices &variables, const Rete::WME_Token &token)
-     : weapon(Weapon(debuggable_cast<const Rete::Symbol_Constant_Int &>(*token[variables.find("item")->second]).value))
+     : weapon(Weapon(token.get<Rete::Symbol_Constant_Int>(variables, item_slot).value))
     {
       assert(can_Equip(Item(weapon)));
     }
@@ -250,7 +255,7 @@ namespace Advent {
     }
 
     Cast(const Rete::Variable_Indices &variables, const Rete::WME_Token &token)
-     : spell(Spell(debuggable_cast<const Rete::Symbol_Constant_Int &>(*token[variables.find("item")->second]).value))
+     : spell(Spell(token.get<Rete::Symbol_Constant_Int>(variables, item_slot).value))
     {
       assert(can_Cast(Item(spell)));
     }
@@ -275,7 +280,7 @@ namespace Advent {
   };
 
   inline std::shared_ptr<Carli::Action> make_Action(const Rete::Variable_Indices &variables, const Rete::WME_Token &token) {
-    const int64_t action = debuggable_cast<const Rete::Symbol_Constant_Int &>(*token[variables.find("name")->second]).value;
+    const int64_t action = token.get<Rete::Symbol_Constant_Int>(variables, Action::name_slot).value;
     
     switch(action) {
       case 1:
@@ -466,6 +471,9 @@ namespace Advent {
 
     void print_impl(ostream &os) const;
 
+    void save_impl(ostream &os) const;
+    void load_impl(istream &is);
+
     Zeni::Random m_random;
     std::array<std::array<std::shared_ptr<Room>, 5>, 5> m_rooms;
     Character m_player;
@@ -490,6 +498,9 @@ namespace Advent {
 
     void update();
 
+    void save_impl(ostream &os) const;
+    void load_impl(istream &is);
+
     Zeni::Random m_random;
 
     /*
@@ -503,32 +514,32 @@ namespace Advent {
      *            block ^matches-top stack
      */
 
-    const Rete::Symbol_Identifier_Ptr_C m_player_id = Rete::Symbol_Identifier_Ptr_C(new Rete::Symbol_Identifier("PLAYER"));
-    const Rete::Symbol_Identifier_Ptr_C m_enemy_id = Rete::Symbol_Identifier_Ptr_C(new Rete::Symbol_Identifier("ENEMY"));
-    const Rete::Symbol_Identifier_Ptr_C m_room_id = Rete::Symbol_Identifier_Ptr_C(new Rete::Symbol_Identifier("ROOM"));
-    const Rete::Symbol_Identifier_Ptr_C m_attack_id = Rete::Symbol_Identifier_Ptr_C(new Rete::Symbol_Identifier("ATTACK"));
-    const Rete::Symbol_Constant_String_Ptr_C m_action_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("action"));
-    const Rete::Symbol_Constant_String_Ptr_C m_name_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("name"));
-    const Rete::Symbol_Constant_String_Ptr_C m_direction_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("direction"));
-    const Rete::Symbol_Constant_String_Ptr_C m_item_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("item"));
-    const Rete::Symbol_Constant_String_Ptr_C m_player_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("player"));
-    const Rete::Symbol_Constant_String_Ptr_C m_enemy_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("enemy"));
-    const Rete::Symbol_Constant_String_Ptr_C m_type_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("type"));
-    const Rete::Symbol_Constant_String_Ptr_C m_x_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("x"));
-    const Rete::Symbol_Constant_String_Ptr_C m_y_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("y"));
-    const Rete::Symbol_Constant_String_Ptr_C m_dead_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("dead"));
-    const Rete::Symbol_Constant_String_Ptr_C m_health_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("health"));
-    const Rete::Symbol_Constant_String_Ptr_C m_in_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("in"));
-    const Rete::Symbol_Constant_String_Ptr_C m_has_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("has"));
-    const Rete::Symbol_Constant_String_Ptr_C m_equipped_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("equipped"));
-    const Rete::Symbol_Constant_String_Ptr_C m_true_value = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("true"));
-    const Rete::Symbol_Constant_String_Ptr_C m_false_value = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("false"));
-    const Rete::Symbol_Constant_Int_Ptr_C m_move_value = Rete::Symbol_Constant_Int_Ptr_C(new Rete::Symbol_Constant_Int(1));
-    const Rete::Symbol_Constant_Int_Ptr_C m_attack_value = Rete::Symbol_Constant_Int_Ptr_C(new Rete::Symbol_Constant_Int(2));
-    const Rete::Symbol_Constant_Int_Ptr_C m_take_value = Rete::Symbol_Constant_Int_Ptr_C(new Rete::Symbol_Constant_Int(3));
-    const Rete::Symbol_Constant_Int_Ptr_C m_drop_value = Rete::Symbol_Constant_Int_Ptr_C(new Rete::Symbol_Constant_Int(4));
-    const Rete::Symbol_Constant_Int_Ptr_C m_equip_value = Rete::Symbol_Constant_Int_Ptr_C(new Rete::Symbol_Constant_Int(5));
-    const Rete::Symbol_Constant_Int_Ptr_C m_cast_value = Rete::Symbol_Constant_Int_Ptr_C(new Rete::Symbol_Constant_Int(6));
+    const Rete::Symbol_Identifier_Ptr_C m_player_id = Rete::Symbol_Identifier::intern("PLAYER");
+    const Rete::Symbol_Identifier_Ptr_C m_enemy_id = Rete::Symbol_Identifier::intern("ENEMY");
+    const Rete::Symbol_Identifier_Ptr_C m_room_id = Rete::Symbol_Identifier::intern("ROOM");
+    const Rete::Symbol_Identifier_Ptr_C m_attack_id = Rete::Symbol_Identifier::intern("ATTACK");
+    const Rete::Symbol_Constant_String_Ptr_C m_action_attr = Rete::Symbol_Constant_String::intern("action");
+    const Rete::Symbol_Constant_String_Ptr_C m_name_attr = Rete::Symbol_Constant_String::intern("name");
+    const Rete::Symbol_Constant_String_Ptr_C m_direction_attr = Rete::Symbol_Constant_String::intern("direction");
+    const Rete::Symbol_Constant_String_Ptr_C m_item_attr = Rete::Symbol_Constant_String::intern("item");
+    const Rete::Symbol_Constant_String_Ptr_C m_player_attr = Rete::Symbol_Constant_String::intern("player");
+    const Rete::Symbol_Constant_String_Ptr_C m_enemy_attr = Rete::Symbol_Constant_String::intern("enemy");
+    const Rete::Symbol_Constant_String_Ptr_C m_type_attr = Rete::Symbol_Constant_String::intern("type");
+    const Rete::Symbol_Constant_String_Ptr_C m_x_attr = Rete::Symbol_Constant_String::intern("x");
+    const Rete::Symbol_Constant_String_Ptr_C m_y_attr = Rete::Symbol_Constant_String::intern("y");
+    const Rete::Symbol_Constant_String_Ptr_C m_dead_attr = Rete::Symbol_Constant_String::intern("dead");
+    const Rete::Symbol_Constant_String_Ptr_C m_health_attr = Rete::Symbol_Constant_String::intern("health");
+    const Rete::Symbol_Constant_String_Ptr_C m_in_attr = Rete::Symbol_Constant_String::intern("in");
+    const Rete::Symbol_Constant_String_Ptr_C m_has_attr = Rete::Symbol_Constant_String::intern("has");
+    const Rete::Symbol_Constant_String_Ptr_C m_equipped_attr = Rete::Symbol_Constant_String::intern("equipped");
+    const Rete::Symbol_Constant_String_Ptr_C m_true_value = Rete::Symbol_Constant_String::intern("true");
+    const Rete::Symbol_Constant_String_Ptr_C m_false_value = Rete::Symbol_Constant_String::intern("false");
+    const Rete::Symbol_Constant_Int_Ptr_C m_move_value = Rete::Symbol_Constant_Int::intern(1);
+    const Rete::Symbol_Constant_Int_Ptr_C m_attack_value = Rete::Symbol_Constant_Int::intern(2);
+    const Rete::Symbol_Constant_Int_Ptr_C m_take_value = Rete::Symbol_Constant_Int::intern(3);
+    const Rete::Symbol_Constant_Int_Ptr_C m_drop_value = Rete::Symbol_Constant_Int::intern(4);
+    const Rete::Symbol_Constant_Int_Ptr_C m_equip_value = Rete::Symbol_Constant_Int::intern(5);
+    const Rete::Symbol_Constant_Int_Ptr_C m_cast_value = Rete::Symbol_Constant_Int::intern(6);
 
     std::map<Direction, Rete::Symbol_Identifier_Ptr_C> m_move_ids;
     std::map<Item, Rete::Symbol_Identifier_Ptr_C> m_take_ids;
@@ -543,7 +554,7 @@ namespace Advent {
     std::map<int64_t, Rete::Symbol_Constant_Int_Ptr_C> m_health_values;
     std::map<Creature, Rete::Symbol_Constant_Int_Ptr_C> m_creature_values;
 
-    std::list<Rete::WME_Ptr_C> m_wmes_prev;
+    std::vector<Rete::WME_Ptr_C> m_wmes; ///< The next state, collected by generate_features
 
 //    double m_feature_generation_time = 0.0;
   };
@@ -4,6 +4,10 @@
 
 namespace Advent {
 
+  const Rete::Variable_Slot Action::name_slot("name");
+  const Rete::Variable_Slot Action::direction_slot("direction");
+  const Rete::Variable_Slot Action::item_slot("item");
+
   Environment::Environment() {
     init_impl();
   }
@@ -162,6 +166,14 @@ namespace Advent {
     }
   }
 
+  void Environment::save_impl(ostream &os) const {
+    m_random.save(os);
+  }
+
+  void Environment::load_impl(istream &is) {
+    m_random.load(is);
+  }
+
   Agent::Agent(const std::shared_ptr<Carli::Environment> &env_)
    : Carli::Agent(env_, [this](const Rete::Variable_Indices &variables, const Rete::WME_Token &token)->Carli::Action_Ptr_C {return make_Action(variables, token);})
   {
@@ -170,44 +182,44 @@ namespace Advent {
 
     for(int64_t i : std::array<int64_t, 5>({{1, 2, 3, 5, 6}})) {
       oss << "TAKE-" << i;
-      m_take_ids[Item(i)] = Rete::Symbol_Identifier_Ptr_C(new Rete::Symbol_Identifier(oss.str()));
+      m_take_ids[Item(i)] = Rete::Symbol_Identifier::intern(oss.str());
       oss.str("");
       oss << "DROP-" << i;
-      m_drop_ids[Item(i)] = Rete::Symbol_Identifier_Ptr_C(new Rete::Symbol_Identifier(oss.str()));
+      m_drop_ids[Item(i)] = Rete::Symbol_Identifier::intern(oss.str());
       oss.str("");
     }
 
     for(int64_t i = 0; i != 4; ++i) {
       oss << "EQUIP-" << i;
-      m_equip_ids[Weapon(i)] = Rete::Symbol_Identifier_Ptr_C(new Rete::Symbol_Identifier(oss.str()));
+      m_equip_ids[Weapon(i)] = Rete::Symbol_Identifier::intern(oss.str());
       oss.str("");\
     }
 
     for(int64_t i = 4; i != 7; ++i) {
       oss << "CAST-" << i;
-      m_cast_ids[Spell(i)] = Rete::Symbol_Identifier_Ptr_C(new Rete::Symbol_Identifier(oss.str()));
+      m_cast_ids[Spell(i)] = Rete::Symbol_Identifier::intern(oss.str());
       oss.str("");\
     }
 
-    m_move_ids[DIR_NONE] = Rete::Symbol_Identifier_Ptr_C(new Rete::Symbol_Identifier("WAIT"));
-    m_move_ids[DIR_NORTH] = Rete::Symbol_Identifier_Ptr_C(new Rete::Symbol_Identifier("MOVE-NORTH"));
-    m_move_ids[DIR_SOUTH] = Rete::Symbol_Identifier_Ptr_C(new Rete::Symbol_Identifier("MOVE-SOUTH"));
-    m_move_ids[DIR_EAST] = Rete::Symbol_Identifier_Ptr_C(new Rete::Symbol_Identifier("MOVE-EAST"));
-    m_move_ids[DIR_WEST] = Rete::Symbol_Identifier_Ptr_C(new Rete::Symbol_Identifier("MOVE-WEST"));
+    m_move_ids[DIR_NONE] = Rete::Symbol_Identifier::intern("WAIT");
+    m_move_ids[DIR_NORTH] = Rete::Symbol_Identifier::intern("MOVE-NORTH");
+    m_move_ids[DIR_SOUTH] = Rete::Symbol_Identifier::intern("MOVE-SOUTH");
+    m_move_ids[DIR_EAST] = Rete::Symbol_Identifier::intern("MOVE-EAST");
+    m_move_ids[DIR_WEST] = Rete::Symbol_Identifier::intern("MOVE-WEST");
     for(int64_t i = 0; i != 5; ++i)
-      m_direction_values[Direction(i)] = Rete::Symbol_Constant_Int_Ptr_C(new Rete::Symbol_Constant_Int(i));
+      m_direction_values[Direction(i)] = Rete::Symbol_Constant_Int::intern(i);
 
     for(int64_t i = 0; i != 7; ++i)
-      m_item_values[Item(i)] = Rete::Symbol_Constant_Int_Ptr_C(new Rete::Symbol_Constant_Int(i));
+      m_item_values[Item(i)] = Rete::Symbol_Constant_Int::intern(i);
 
     for(int64_t i = 0; i != env->get_Rooms_size(); ++i)
-      m_position_values[i] = Rete::Symbol_Constant_Int_Ptr_C(new Rete::Symbol_Constant_Int(i));
+      m_position_values[i] = Rete::Symbol_Constant_Int::intern(i);
 
     for(int64_t i = 0; i != 11; ++i)
-      m_health_values[i] = Rete::Symbol_Constant_Int_Ptr_C(new Rete::Symbol_Constant_Int(i));
+      m_health_values[i] = Rete::Symbol_Constant_Int::intern(i);
 
     for(int64_t i = 0; i != 4; ++i)
-      m_creature_values[Creature(i)] = Rete::Symbol_Constant_Int_Ptr_C(new Rete::Symbol_Constant_Int(i));
+      m_creature_values[Creature(i)] = Rete::Symbol_Constant_Int::intern(i);
 
     generate_rete();
     generate_features();
@@ -220,7 +232,7 @@ namespace Advent {
   }
 
   void Agent::generate_rete() {
-    std::string rules_in = dynamic_cast<const Option_String &>(Options::get_global()["rules"]).get_value();
+    std::string rules_in = dynamic_cast<const Option_String &>(get_context().get_options()["rules"]).get_value();
     if(rules_in == "default")
       rules_in = "rules/advent.carli";
     if(rete_parse_file(*this, rules_in))
@@ -238,81 +250,79 @@ namespace Advent {
     const auto &room = env->get_Room(player_pos.first, player_pos.second);
     const auto &enemy = room->enemy;
 
-    std::list<Rete::WME_Ptr_C> wmes_current;
-
-    wmes_current.push_back(std::make_shared<Rete::WME>(m_s_id, m_player_attr, m_player_id));
-    wmes_current.push_back(std::make_shared<Rete::WME>(m_player_id, m_x_attr, m_position_values[player_pos.first]));
-    wmes_current.push_back(std::make_shared<Rete::WME>(m_player_id, m_y_attr, m_position_values[player_pos.second]));
-    wmes_current.push_back(std::make_shared<Rete::WME>(m_player_id, m_dead_attr, player.is_dead ? m_true_value : m_false_value));
-    wmes_current.push_back(std::make_shared<Rete::WME>(m_player_id, m_health_attr, m_health_values[player.health]));
-    wmes_current.push_back(std::make_shared<Rete::WME>(m_player_id, m_equipped_attr, m_item_values[Item(player.weapon)]));
+    m_wmes.push_back(Rete::WME::create(m_s_id, m_player_attr, m_player_id));
+    m_wmes.push_back(Rete::WME::create(m_player_id, m_x_attr, m_position_values[player_pos.first]));
+    m_wmes.push_back(Rete::WME::create(m_player_id, m_y_attr, m_position_values[player_pos.second]));
+    m_wmes.push_back(Rete::WME::create(m_player_id, m_dead_attr, player.is_dead ? m_true_value : m_false_value));
+    m_wmes.push_back(Rete::WME::create(m_player_id, m_health_attr, m_health_values[player.health]));
+    m_wmes.push_back(Rete::WME::create(m_player_id, m_equipped_attr, m_item_values[Item(player.weapon)]));
 
-    wmes_current.push_back(std::make_shared<Rete::WME>(m_player_id, m_in_attr, m_room_id));
+    m_wmes.push_back(Rete::WME::create(m_player_id, m_in_attr, m_room_id));
 
     if(enemy) {
-      wmes_current.push_back(std::make_shared<Rete::WME>(m_room_id, m_enemy_attr, m_enemy_id));
-      wmes_current.push_back(std::make_shared<Rete::WME>(m_enemy_id, m_type_attr, m_creature_values[enemy ? Creature(enemy->creature) : Creature::CREATURE_SOLID]));
-      wmes_current.push_back(std::make_shared<Rete::WME>(m_enemy_id, m_dead_attr, (!enemy || enemy->is_dead) ? m_true_value : m_false_value));
-      wmes_current.push_back(std::make_shared<Rete::WME>(m_enemy_id, m_health_attr, m_health_values[enemy ? enemy->health : 0]));
+      m_wmes.push_back(Rete::WME::create(m_room_id, m_enemy_attr, m_enemy_id));
+      m_wmes.push_back(Rete::WME::create(m_enemy_id, m_type_attr, m_creature_values[enemy ? Creature(enemy->creature) : Creature::CREATURE_SOLID]));
+      m_wmes.push_back(Rete::WME::create(m_enemy_id, m_dead_attr, (!enemy || enemy->is_dead) ? m_true_value : m_false_value));
+      m_wmes.push_back(Rete::WME::create(m_enemy_id, m_health_attr, m_health_values[enemy ? enemy->health : 0]));
     }
 
     for(int i = 1; i != 7; ++i) {
       if(room->items.has(Item(i)))
-        wmes_current.push_back(std::make_shared<Rete::WME>(m_room_id, m_has_attr, m_item_values[Item(i)]));
+        m_wmes.push_back(Rete::WME::create(m_room_id, m_has_attr, m_item_values[Item(i)]));
       if(player.items.has(Item(i)))
-        wmes_current.push_back(std::make_shared<Rete::WME>(m_player_id, m_has_attr, m_item_values[Item(i)]));
+        m_wmes.push_back(Rete::WME::create(m_player_id, m_has_attr, m_item_values[Item(i)]));
     }
 
     /// 1. Move
 
-    wmes_current.push_back(std::make_shared<Rete::WME>(m_s_id, m_action_attr, m_move_ids[Direction::DIR_NONE]));
-    wmes_current.push_back(std::make_shared<Rete::WME>(m_move_ids[Direction::DIR_NONE], m_name_attr, m_move_value));
-    wmes_current.push_back(std::make_shared<Rete::WME>(m_move_ids[Direction::DIR_NONE], m_direction_attr, m_direction_values[Direction::DIR_NONE]));
-    wmes_current.push_back(std::make_shared<Rete::WME>(m_move_ids[Direction::DIR_NONE], m_item_attr, m_item_values[Item::ITEM_NONE]));
+    m_wmes.push_back(Rete::WME::create(m_s_id, m_action_attr, m_move_ids[Direction::DIR_NONE]));
+    m_wmes.push_back(Rete::WME::create(m_move_ids[Direction::DIR_NONE], m_name_attr, m_move_value));
+    m_wmes.push_back(Rete::WME::create(m_move_ids[Direction::DIR_NONE], m_direction_attr, m_direction_values[Direction::DIR_NONE]));
+    m_wmes.push_back(Rete::WME::create(m_move_ids[Direction::DIR_NONE], m_item_attr, m_item_values[Item::ITEM_NONE]));
     if(!enemy || enemy->is_dead || (enemy->health == 1 && enemy->creature == CREATURE_TROLL)) {
       if(env->get_Room(player_pos.first, player_pos.second + 1)) {
-        wmes_current.push_back(std::make_shared<Rete::WME>(m_s_id, m_action_attr, m_move_ids[Direction::DIR_NORTH]));
-        wmes_current.push_back(std::make_shared<Rete::WME>(m_move_ids[Direction::DIR_NORTH], m_name_attr, m_move_value));
-        wmes_current.push_back(std::make_shared<Rete::WME>(m_move_ids[Direction::DIR_NORTH], m_direction_attr, m_direction_values[Direction::DIR_NORTH]));
-        wmes_current.push_back(std::make_shared<Rete::WME>(m_move_ids[Direction::DIR_NORTH], m_item_attr, m_item_values[Item::ITEM_NONE]));
+        m_wmes.push_back(Rete::WME::create(m_s_id, m_action_attr, m_move_ids[Direction::DIR_NORTH]));
+        m_wmes.push_back(Rete::WME::create(m_move_ids[Direction::DIR_NORTH], m_name_attr, m_move_value));
+        m_wmes.push_back(Rete::WME::create(m_move_ids[Direction::DIR_NORTH], m_direction_attr, m_direction_values[Direction::DIR_NORTH]));
+        m_wmes.push_back(Rete::WME::create(m_move_ids[Direction::DIR_NORTH], m_item_attr, m_item_values[Item::ITEM_NONE]));
       }
       if(env->get_Room(player_pos.first, player_pos.second - 1)) {
-        wmes_current.push_back(std::make_shared<Rete::WME>(m_s_id, m_action_attr, m_move_ids[Direction::DIR_SOUTH]));
-        wmes_current.push_back(std::make_shared<Rete::WME>(m_move_ids[Direction::DIR_SOUTH], m_name_attr, m_move_value));
-        wmes_current.push_back(std::make_shared<Rete::WME>(m_move_ids[Direction::DIR_SOUTH], m_direction_attr, m_direction_values[Direction::DIR_SOUTH]));
-        wmes_current.push_back(std::make_shared<Rete::WME>(m_move_ids[Direction::DIR_SOUTH], m_item_attr, m_item_values[Item::ITEM_NONE]));
+        m_wmes.push_back(Rete::WME::create(m_s_id, m_action_attr, m_move_ids[Direction::DIR_SOUTH]));
+        m_wmes.push_back(Rete::WME::create(m_move_ids[Direction::DIR_SOUTH], m_name_attr, m_move_value));
+        m_wmes.push_back(Rete::WME::create(m_move_ids[Direction::DIR_SOUTH], m_direction_attr, m_direction_values[Direction::DIR_SOUTH]));
+        m_wmes.push_back(Rete::WME::create(m_move_ids[Direction::DIR_SOUTH], m_item_attr, m_item_values[Item::ITEM_NONE]));
       }
       if(env->get_Room(player_pos.first + 1, player_pos.second)) {
-        wmes_current.push_back(std::make_shared<Rete::WME>(m_s_id, m_action_attr, m_move_ids[Direction::DIR_EAST]));
-        wmes_current.push_back(std::make_shared<Rete::WME>(m_move_ids[Direction::DIR_EAST], m_name_attr, m_move_value));
-        wmes_current.push_back(std::make_shared<Rete::WME>(m_move_ids[Direction::DIR_EAST], m_direction_attr, m_direction_values[Direction::DIR_EAST]));
-        wmes_current.push_back(std::make_shared<Rete::WME>(m_move_ids[Direction::DIR_EAST], m_item_attr, m_item_values[Item::ITEM_NONE]));
+        m_wmes.push_back(Rete::WME::create(m_s_id, m_action_attr, m_move_ids[Direction::DIR_EAST]));
+        m_wmes.push_back(Rete::WME::create(m_move_ids[Direction::DIR_EAST], m_name_attr, m_move_value));
+        m_wmes.push_back(Rete::WME::create(m_move_ids[Direction::DIR_EAST], m_direction_attr, m_direction_values[Direction::DIR_EAST]));
+        m_wmes.push_back(Rete::WME::create(m_move_ids[Direction::DIR_EAST], m_item_attr, m_item_values[Item::ITEM_NONE]));
       }
       if(env->get_Room(player_pos.first - 1, player_pos.second)) {
-        wmes_current.push_back(std::make_shared<Rete::WME>(m_s_id, m_action_attr, m_move_ids[Direction::DIR_WEST]));
-        wmes_current.push_back(std::make_shared<Rete::WME>(m_move_ids[Direction::DIR_WEST], m_name_attr, m_move_value));
-        wmes_current.push_back(std::make_shared<Rete::WME>(m_move_ids[Direction::DIR_WEST], m_direction_attr, m_direction_values[Direction::DIR_WEST]));
-        wmes_current.push_back(std::make_shared<Rete::WME>(m_move_ids[Direction::DIR_WEST], m_item_attr, m_item_values[Item::ITEM_NONE]));
+        m_wmes.push_back(Rete::WME::create(m_s_id, m_action_attr, m_move_ids[Direction::DIR_WEST]));
+        m_wmes.push_back(Rete::WME::create(m_move_ids[Direction::DIR_WEST], m_name_attr, m_move_value));
+        m_wmes.push_back(Rete::WME::create(m_move_ids[Direction::DIR_WEST], m_direction_attr, m_direction_values[Direction::DIR_WEST]));
+        m_wmes.push_back(Rete::WME::create(m_move_ids[Direction::DIR_WEST], m_item_attr, m_item_values[Item::ITEM_NONE]));
       }
     }
 
     /// 2. Attack
 
     if(enemy) {
-      wmes_current.push_back(std::make_shared<Rete::WME>(m_s_id, m_action_attr, m_attack_id));
-      wmes_current.push_back(std::make_shared<Rete::WME>(m_attack_id, m_name_attr, m_attack_value));
-      wmes_current.push_back(std::make_shared<Rete::WME>(m_attack_id, m_direction_attr, m_direction_values[Direction::DIR_NONE]));
-      wmes_current.push_back(std::make_shared<Rete::WME>(m_attack_id, m_item_attr, m_item_values[Item::ITEM_NONE]));
+      m_wmes.push_back(Rete::WME::create(m_s_id, m_action_attr, m_attack_id));
+      m_wmes.push_back(Rete::WME::create(m_attack_id, m_name_attr, m_attack_value));
+      m_wmes.push_back(Rete::WME::create(m_attack_id, m_direction_attr, m_direction_values[Direction::DIR_NONE]));
+      m_wmes.push_back(Rete::WME::create(m_attack_id, m_item_attr, m_item_values[Item::ITEM_NONE]));
     }
 
     /// 3. Take
 
     for(int i = 1; i != 7; ++i) {
       if(room->items.has(Item(i))) {
-        wmes_current.push_back(std::make_shared<Rete::WME>(m_s_id, m_action_attr, m_take_ids[Item(i)]));
-        wmes_current.push_back(std::make_shared<Rete::WME>(m_take_ids[Item(i)], m_name_attr, m_take_value));
-        wmes_current.push_back(std::make_shared<Rete::WME>(m_take_ids[Item(i)], m_direction_attr, m_direction_values[Direction::DIR_NONE]));
-        wmes_current.push_back(std::make_shared<Rete::WME>(m_take_ids[Item(i)], m_item_attr, m_item_values[Item(i)]));
+        m_wmes.push_back(Rete::WME::create(m_s_id, m_action_attr, m_take_ids[Item(i)]));
+        m_wmes.push_back(Rete::WME::create(m_take_ids[Item(i)], m_name_attr, m_take_value));
+        m_wmes.push_back(Rete::WME::create(m_take_ids[Item(i)], m_direction_attr, m_direction_values[Direction::DIR_NONE]));
+        m_wmes.push_back(Rete::WME::create(m_take_ids[Item(i)], m_item_attr, m_item_values[Item(i)]));
       }
     }
 
@@ -320,81 +330,57 @@ namespace Advent {
 
 //     for(int i = 1; i != 7; ++i) {
 //       if(player.items.has(Item(i))) {
-//         wmes_current.push_back(std::make_shared<Rete::WME>(m_s_id, m_action_attr, m_drop_ids[Item(i)]));
-//         wmes_current.push_back(std::make_shared<Rete::WME>(m_drop_ids[Item(i)], m_name_attr, m_drop_value));
-//         wmes_current.push_back(std::make_shared<Rete::WME>(m_drop_ids[Item(i)], m_direction_attr, m_direction_values[Direction::DIR_NONE]));
-//         wmes_current.push_back(std::make_shared<Rete::WME>(m_drop_ids[Item(i)], m_item_attr, m_item_values[Item(i)]));
+//         m_wmes.push_back(Rete::WME::create(m_s_id, m_action_attr, m_drop_ids[Item(i)]));
+//         m_wmes.push_back(Rete::WME::create(m_drop_ids[Item(i)], m_name_attr, m_drop_value));
+//         m_wmes.push_back(Rete::WME::create(m_drop_ids[Item(i)], m_direction_attr, m_direction_values[Direction::DIR_NONE]));
+//         m_wmes.push_back(Rete::WME::create(m_drop_ids[Item(i)], m_item_attr, m_item_values[Item(i)]));
 //       }
 //     }
 
     /// 5. Equip
 
 //     if(player.weapon != Weapon::WEAPON_FISTS) {
-//       wmes_current.push_back(std::make_shared<Rete::WME>(m_s_id, m_action_attr, m_equip_ids[Weapon::WEAPON_FISTS]));
-//       wmes_current.push_back(std::make_shared<Rete::WME>(m_equip_ids[Weapon::WEAPON_FISTS], m_name_attr, m_equip_value));
-//       wmes_current.push_back(std::make_shared<Rete::WME>(m_equip_ids[Weapon::WEAPON_FISTS], m_direction_attr, m_direction_values[Direction::DIR_NONE]));
-//       wmes_current.push_back(std::make_shared<Rete::WME>(m_equip_ids[Weapon::WEAPON_FISTS], m_item_attr, m_item_values[Item(Weapon::WEAPON_FISTS)]));
+//       m_wmes.push_back(Rete::WME::create(m_s_id, m_action_attr, m_equip_ids[Weapon::WEAPON_FISTS]));
+//       m_wmes.push_back(Rete::WME::create(m_equip_ids[Weapon::WEAPON_FISTS], m_name_attr, m_equip_value));
+//       m_wmes.push_back(Rete::WME::create(m_equip_ids[Weapon::WEAPON_FISTS], m_direction_attr, m_direction_values[Direction::DIR_NONE]));
+//       m_wmes.push_back(Rete::WME::create(m_equip_ids[Weapon::WEAPON_FISTS], m_item_attr, m_item_values[Item(Weapon::WEAPON_FISTS)]));
 //     }
     for(int i = 1; i != 4; ++i) {
       if(player.items.has(Item(i)) && player.weapon != Weapon(i)) {
-        wmes_current.push_back(std::make_shared<Rete::WME>(m_s_id, m_action_attr, m_equip_ids[Weapon(i)]));
-        wmes_current.push_back(std::make_shared<Rete::WME>(m_equip_ids[Weapon(i)], m_name_attr, m_equip_value));
-        wmes_current.push_back(std::make_shared<Rete::WME>(m_equip_ids[Weapon(i)], m_direction_attr, m_direction_values[Direction::DIR_NONE]));
-        wmes_current.push_back(std::make_shared<Rete::WME>(m_equip_ids[Weapon(i)], m_item_attr, m_item_values[Item(i)]));
+        m_wmes.push_back(Rete::WME::create(m_s_id, m_action_attr, m_equip_ids[Weapon(i)]));
+        m_wmes.push_back(Rete::WME::create(m_equip_ids[Weapon(i)], m_name_attr, m_equip_value));
+        m_wmes.push_back(Rete::WME::create(m_equip_ids[Weapon(i)], m_direction_attr, m_direction_values[Direction::DIR_NONE]));
+        m_wmes.push_back(Rete::WME::create(m_equip_ids[Weapon(i)], m_item_attr, m_item_values[Item(i)]));
       }
     }
 
     /// 6. Cast
 
-    wmes_current.push_back(std::make_shared<Rete::WME>(m_s_id, m_action_attr, m_cast_ids[Spell::SPELL_HEAL]));
-    wmes_current.push_back(std::make_shared<Rete::WME>(m_cast_ids[Spell::SPELL_HEAL], m_name_attr, m_cast_value));
-    wmes_current.push_back(std::make_shared<Rete::WME>(m_cast_ids[Spell::SPELL_HEAL], m_direction_attr, m_direction_values[Direction::DIR_NONE]));
-    wmes_current.push_back(std::make_shared<Rete::WME>(m_cast_ids[Spell::SPELL_HEAL], m_item_attr, m_item_values[Item(Spell::SPELL_HEAL)]));
+    m_wmes.push_back(Rete::WME::create(m_s_id, m_action_attr, m_cast_ids[Spell::SPELL_HEAL]));
+    m_wmes.push_back(Rete::WME::create(m_cast_ids[Spell::SPELL_HEAL], m_name_attr, m_cast_value));
+    m_wmes.push_back(Rete::WME::create(m_cast_ids[Spell::SPELL_HEAL], m_direction_attr, m_direction_values[Direction::DIR_NONE]));
+    m_wmes.push_back(Rete::WME::create(m_cast_ids[Spell::SPELL_HEAL], m_item_attr, m_item_values[Item(Spell::SPELL_HEAL)]));
     for(int i = 5; i != 7; ++i) {
       if(player.items.has(Item(i)) && enemy && !enemy->is_dead) {
-        wmes_current.push_back(std::make_shared<Rete::WME>(m_s_id, m_action_attr, m_cast_ids[Spell(i)]));
-        wmes_current.push_back(std::make_shared<Rete::WME>(m_cast_ids[Spell(i)], m_name_attr, m_cast_value));
-        wmes_current.push_back(std::make_shared<Rete::WME>(m_cast_ids[Spell(i)], m_direction_attr, m_direction_values[Direction::DIR_NONE]));
-        wmes_current.push_back(std::make_shared<Rete::WME>(m_cast_ids[Spell(i)], m_item_attr, m_item_values[Item(i)]));
+        m_wmes.push_back(Rete::WME::create(m_s_id, m_action_attr, m_cast_ids[Spell(i)]));
+        m_wmes.push_back(Rete::WME::create(m_cast_ids[Spell(i)], m_name_attr, m_cast_value));
+        m_wmes.push_back(Rete::WME::create(m_cast_ids[Spell(i)], m_direction_attr, m_direction_values[Direction::DIR_NONE]));
+        m_wmes.push_back(Rete::WME::create(m_cast_ids[Spell(i)], m_item_attr, m_item_values[Item(i)]));
       }
     }
 
-//     wmes_current.push_back(std::make_shared<Rete::WME>(m_s_id, m_item_attr, m_item_ids[Item::ITEM_NONE]));
-//     wmes_current.push_back(std::make_shared<Rete::WME>(m_s_id, m_weapon_attr, m_weapon_ids[m_player.weapon]));
-//     wmes_current.push_back(std::make_shared<Rete::WME>(m_s_id, m_spell_attr, m_spell_ids[Spell::SPELL_NONE]));
+//     m_wmes.push_back(Rete::WME::create(m_s_id, m_item_attr, m_item_ids[Item::ITEM_NONE]));
+//     m_wmes.push_back(Rete::WME::create(m_s_id, m_weapon_attr, m_weapon_ids[m_player.weapon]));
+//     m_wmes.push_back(Rete::WME::create(m_s_id, m_spell_attr, m_spell_ids[Spell::SPELL_NONE]));
 
 //    const auto end_time = std::chrono::high_resolution_clock::now();
 //    m_feature_generation_time += std::chrono::duration_cast<dseconds>(end_time - start_time).count();
 
-    Rete::Agenda::Locker locker(agenda);
-    CPU_Accumulator cpu_accumulator(*this);
-
-    if(get_Option_Ranged<bool>(Options::get_global(), "rete-flush-wmes")) {
-      for(auto wt = m_wmes_prev.begin(), wend = m_wmes_prev.end(); wt != wend; ++wt)
-        remove_wme(*wt);
-      m_wmes_prev.clear();
-    }
-    else {
-      for(auto wt = m_wmes_prev.begin(), wend = m_wmes_prev.end(); wt != wend; ) {
-        const auto found = std::find_if(wmes_current.begin(), wmes_current.end(), [wt](const Rete::WME_Ptr_C &wme_)->bool{return *wme_ == **wt;});
-        if(found == wmes_current.end()) {
-          remove_wme(*wt);
-          m_wmes_prev.erase(wt++);
-        }
-        else {
-          wmes_current.erase(found);
-          ++wt;
-        }
-      }
-    }
+    if(get_Option_Ranged<bool>(get_context().get_options(), "rete-flush-wmes"))
+      clear_wmes();
 
-    for(auto &wme : wmes_current) {
-      const auto found = std::find_if(m_wmes_prev.begin(), m_wmes_prev.end(), [wme](const Rete::WME_Ptr_C &wme_)->bool{return *wme_ == *wme;});
-      if(found == m_wmes_prev.end()) {
-        m_wmes_prev.push_back(wme);
-        insert_wme(wme);
-      }
-    }
+    set_wmes(m_wmes);
+    m_wmes.clear();
   }
 
   void Agent::update() {
@@ -406,4 +392,12 @@ namespace Advent {
       m_metastate = Carli::Metastate::FAILURE;
   }
 
+  void Agent::save_impl(ostream &os) const {
+    m_random.save(os);
+  }
+
+  void Agent::load_impl(istream &is) {
+    m_random.load(is);
+  }
+
 }
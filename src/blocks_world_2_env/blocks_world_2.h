@@ -20,6 +20,7 @@ namespace Blocks_World_2 {
 
   using std::dynamic_pointer_cast;
   using std::endl;
+  using std::istream;
   using std::ostream;
 
   typedef int64_t block_id;
@@ -44,9 +45,12 @@ namespace Blocks_World_2 {
     {
     }
 
+    static const Rete::Variable_Slot block_name_slot;
+    static const Rete::Variable_Slot dest_name_slot;
+
     Move(const Rete::Variable_Indices &variables, const Rete::WME_Token &token)
-     : block(debuggable_cast<const Rete::Symbol_Constant_Int &>(*token[variables.find("block-name")->second]).value),
-     dest(debuggable_cast<const Rete::Symbol_Constant_Int &>(*token[variables.find("dest-name")->second]).value)
+     : block(token.get<Rete::Symbol_Constant_Int>(variables, block_name_slot).value),
+     dest(token.get<Rete::Symbol_Constant_Int>(variables, dest_name_slot).value)
     {
     }
 
@@ -123,14 +127,17 @@ namespace Blocks_World_2 {
 
     void print_impl(ostream &os) const;
 
-    Goal m_goal = dynamic_cast<const Option_Itemized &>(Options::get_global()["bw2-goal"]).get_value() == "exact" ? Goal::EXACT
-                : dynamic_cast<const Option_Itemized &>(Options::get_global()["bw2-goal"]).get_value() == "color" ? Goal::COLOR
-                : dynamic_cast<const Option_Itemized &>(Options::get_global()["bw2-goal"]).get_value() == "stack" ? Goal::STACK
-                : dynamic_cast<const Option_Itemized &>(Options::get_global()["bw2-goal"]).get_value() == "unstack" ? Goal::UNSTACK
+    void save_impl(ostream &os) const;
+    void load_impl(istream &is);
+
+    Goal m_goal = dynamic_cast<const Option_Itemized &>(get_context().get_options()["bw2-goal"]).get_value() == "exact" ? Goal::EXACT
+                : dynamic_cast<const Option_Itemized &>(get_context().get_options()["bw2-goal"]).get_value() == "color" ? Goal::COLOR
+                : dynamic_cast<const Option_Itemized &>(get_context().get_options()["bw2-goal"]).get_value() == "stack" ? Goal::STACK
+                : dynamic_cast<const Option_Itemized &>(get_context().get_options()["bw2-goal"]).get_value() == "unstack" ? Goal::UNSTACK
                 : Goal::ON_A_B;
-    const Reward m_reward = dynamic_cast<const Option_Itemized &>(Options::get_global()["bw2-reward"]).get_value() == "guiding" ? Reward::GUIDING : Reward::BLIND;
-    const int64_t m_num_blocks_min = get_Option_Ranged<int64_t>(Options::get_global(), "num-blocks-min");
-    const int64_t m_num_blocks_max = get_Option_Ranged<int64_t>(Options::get_global(), "num-blocks-max");
+    const Reward m_reward = dynamic_cast<const Option_Itemized &>(get_context().get_options()["bw2-reward"]).get_value() == "guiding" ? Reward::GUIDING : Reward::BLIND;
+    const int64_t m_num_blocks_min = get_Option_Ranged<int64_t>(get_context().get_options(), "num-blocks-min");
+    const int64_t m_num_blocks_max = get_Option_Ranged<int64_t>(get_context().get_options(), "num-blocks-max");
 
     std::function<bool (const Environment::Block &lhs, const Environment::Block &rhs)> m_match_test;
 
@@ -139,8 +146,9 @@ namespace Blocks_World_2 {
     Stacks m_target;
     Block m_table = Block(0, 0);
 
-    const bool m_evaluate_optimality = dynamic_cast<const Option_Ranged<bool> &>(Options::get_global()["evaluate-optimality"]).get_value() && supports_optimal() && dynamic_cast<const Option_Itemized &>(Options::get_global()["output"]).get_value() != "null";
+    const bool m_evaluate_optimality = dynamic_cast<const Option_Ranged<bool> &>(get_context().get_options()["evaluate-optimality"]).get_value() && supports_optimal() && dynamic_cast<const Option_Itemized &>(get_context().get_options()["output"]).get_value() != "null";
     int64_t m_num_steps_to_goal = 0;
+    bool m_skip_first_optimality = true;
   };
 
   class BLOCKS_WORLD_2_LINKAGE Agent : public Carli::Agent {
@@ -158,6 +166,9 @@ namespace Blocks_World_2 {
 
     void update();
 
+    void save_impl(ostream &os) const;
+    void load_impl(istream &is);
+
     Zeni::Random m_random;
 
     /*
@@ -171,76 +182,50 @@ namespace Blocks_World_2 {
      *            block ^matches-top stack
      */
 
-    const Rete::Symbol_Constant_String_Ptr_C m_above_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("above"));
-    const Rete::Symbol_Constant_String_Ptr_C m_action_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("action"));
-    const Rete::Symbol_Constant_String_Ptr_C m_action_in_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("action-in"));
-    const Rete::Symbol_Constant_String_Ptr_C m_action_out_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("action-out"));
-    const Rete::Symbol_Constant_String_Ptr_C m_block_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("block"));
-    const Rete::Symbol_Constant_String_Ptr_C m_dest_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("dest"));
-    const Rete::Symbol_Constant_String_Ptr_C m_color_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("color"));
-    const Rete::Symbol_Constant_String_Ptr_C m_brightness_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("brightness")); ///< Distractor
-    const Rete::Symbol_Constant_String_Ptr_C m_glowing_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("glowing")); ///< Distractor
-    const Rete::Symbol_Constant_String_Ptr_C m_height_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("height")); ///< Distractor
-    const Rete::Symbol_Constant_String_Ptr_C m_clear_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("clear")); ///< Legacy
-    const Rete::Symbol_Constant_String_Ptr_C m_on_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("on")); ///< Legacy
-    const Rete::Symbol_Constant_String_Ptr_C m_in_place_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("in-place")); ///< Legacy
-    const Rete::Symbol_Constant_String_Ptr_C m_name_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("name"));
-    const Rete::Symbol_Constant_String_Ptr_C m_blocks_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("blocks"));
-    const Rete::Symbol_Constant_String_Ptr_C m_stacks_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("stacks"));
-    const Rete::Symbol_Constant_String_Ptr_C m_discrepancy_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("discrepancy"));
-    const Rete::Symbol_Constant_String_Ptr_C m_higher_than_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("higher-than"));
-    const Rete::Symbol_Constant_String_Ptr_C m_target_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("goal"));
-    const Rete::Symbol_Constant_String_Ptr_C m_goal_on_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("goal-on"));
-    const Rete::Symbol_Constant_String_Ptr_C m_stack_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("stack"));
-    const Rete::Symbol_Constant_String_Ptr_C m_matches_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("matches"));
-    const Rete::Symbol_Constant_String_Ptr_C m_early_matches_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("early-matches")); ///< Defective
-    const Rete::Symbol_Constant_String_Ptr_C m_late_matches_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("late-matches")); ///< Defective
-    const Rete::Symbol_Constant_String_Ptr_C m_tallest_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("tallest"));
-    const Rete::Symbol_Constant_String_Ptr_C m_top_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("top"));
-    const Rete::Symbol_Constant_String_Ptr_C m_matches_top_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("matches-top"));
-    const Rete::Symbol_Constant_String_Ptr_C m_early_matches_top_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("early-matches-top")); ///< Defective
-    const Rete::Symbol_Constant_String_Ptr_C m_late_matches_top_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("late-matches-top")); ///< Defective
-    const Rete::Symbol_Constant_String_Ptr_C m_true_value = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("true"));
-    const Rete::Symbol_Constant_String_Ptr_C m_false_value = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("false"));
-    const Rete::Symbol_Identifier_Ptr_C m_blocks_id = Rete::Symbol_Identifier_Ptr_C(new Rete::Symbol_Identifier("BLOCKS"));
-    const Rete::Symbol_Identifier_Ptr_C m_stacks_id = Rete::Symbol_Identifier_Ptr_C(new Rete::Symbol_Identifier("STACKS"));
-    const Rete::Symbol_Identifier_Ptr_C m_target_id = Rete::Symbol_Identifier_Ptr_C(new Rete::Symbol_Identifier("GOAL"));
-    const Rete::Symbol_Identifier_Ptr_C m_table_id = Rete::Symbol_Identifier_Ptr_C(new Rete::Symbol_Identifier("TABLE"));
-    const Rete::Symbol_Identifier_Ptr_C m_table_stack_id = m_table_id; //Rete::Symbol_Identifier_Ptr_C(new Rete::Symbol_Identifier("|"));
-    const Rete::Symbol_Constant_Int_Ptr_C m_table_name = Rete::Symbol_Constant_Int_Ptr_C(new Rete::Symbol_Constant_Int(0));
+    const Rete::Symbol_Constant_String_Ptr_C m_above_attr = Rete::Symbol_Constant_String::intern("above");
+    const Rete::Symbol_Constant_String_Ptr_C m_action_attr = Rete::Symbol_Constant_String::intern("action");
+    const Rete::Symbol_Constant_String_Ptr_C m_action_in_attr = Rete::Symbol_Constant_String::intern("action-in");
+    const Rete::Symbol_Constant_String_Ptr_C m_action_out_attr = Rete::Symbol_Constant_String::intern("action-out");
+    const Rete::Symbol_Constant_String_Ptr_C m_block_attr = Rete::Symbol_Constant_String::intern("block");
+    const Rete::Symbol_Constant_String_Ptr_C m_dest_attr = Rete::Symbol_Constant_String::intern("dest");
+    const Rete::Symbol_Constant_String_Ptr_C m_color_attr = Rete::Symbol_Constant_String::intern("color");
+    const Rete::Symbol_Constant_String_Ptr_C m_brightness_attr = Rete::Symbol_Constant_String::intern("brightness"); ///< Distractor
+    const Rete::Symbol_Constant_String_Ptr_C m_glowing_attr = Rete::Symbol_Constant_String::intern("glowing"); ///< Distractor
+    const Rete::Symbol_Constant_String_Ptr_C m_height_attr = Rete::Symbol_Constant_String::intern("height"); ///< Distractor
+    const Rete::Symbol_Constant_String_Ptr_C m_clear_attr = Rete::Symbol_Constant_String::intern("clear"); ///< Legacy
+    const Rete::Symbol_Constant_String_Ptr_C m_on_attr = Rete::Symbol_Constant_String::intern("on"); ///< Legacy
+    const Rete::Symbol_Constant_String_Ptr_C m_in_place_attr = Rete::Symbol_Constant_String::intern("in-place"); ///< Legacy
+    const Rete::Symbol_Constant_String_Ptr_C m_name_attr = Rete::Symbol_Constant_String::intern("name");
+    const Rete::Symbol_Constant_String_Ptr_C m_blocks_attr = Rete::Symbol_Constant_String::intern("blocks");
+    const Rete::Symbol_Constant_String_Ptr_C m_stacks_attr = Rete::Symbol_Constant_String::intern("stacks");
+    const Rete::Symbol_Constant_String_Ptr_C m_discrepancy_attr = Rete::Symbol_Constant_String::intern("discrepancy");
+    const Rete::Symbol_Constant_String_Ptr_C m_higher_than_attr = Rete::Symbol_Constant_String::intern("higher-than");
+    const Rete::Symbol_Constant_String_Ptr_C m_target_attr = Rete::Symbol_Constant_String::intern("goal");
+    const Rete::Symbol_Constant_String_Ptr_C m_goal_on_attr = Rete::Symbol_Constant_String::intern("goal-on");
+    const Rete::Symbol_Constant_String_Ptr_C m_stack_attr = Rete::Symbol_Constant_String::intern("stack");
+    const Rete::Symbol_Constant_String_Ptr_C m_matches_attr = Rete::Symbol_Constant_String::intern("matches");
+    const Rete::Symbol_Constant_String_Ptr_C m_early_matches_attr = Rete::Symbol_Constant_String::intern("early-matches"); ///< Defective
+    const Rete::Symbol_Constant_String_Ptr_C m_late_matches_attr = Rete::Symbol_Constant_String::intern("late-matches"); ///< Defective
+    const Rete::Symbol_Constant_String_Ptr_C m_tallest_attr = Rete::Symbol_Constant_String::intern("tallest");
+    const Rete::Symbol_Constant_String_Ptr_C m_top_attr = Rete::Symbol_Constant_String::intern("top");
+    const Rete::Symbol_Constant_String_Ptr_C m_matches_top_attr = Rete::Symbol_Constant_String::intern("matches-top");
+    const Rete::Symbol_Constant_String_Ptr_C m_early_matches_top_attr = Rete::Symbol_Constant_String::intern("early-matches-top"); ///< Defective
+    const Rete::Symbol_Constant_String_Ptr_C m_late_matches_top_attr = Rete::Symbol_Constant_String::intern("late-matches-top"); ///< Defective
+    const Rete::Symbol_Constant_String_Ptr_C m_true_value = Rete::Symbol_Constant_String::intern("true");
+    const Rete::Symbol_Constant_String_Ptr_C m_false_value = Rete::Symbol_Constant_String::intern("false");
+    const Rete::Symbol_Identifier_Ptr_C m_blocks_id = Rete::Symbol_Identifier::intern("BLOCKS");
+    const Rete::Symbol_Identifier_Ptr_C m_stacks_id = Rete::Symbol_Identifier::intern("STACKS");
+    const Rete::Symbol_Identifier_Ptr_C m_target_id = Rete::Symbol_Identifier::intern("GOAL");
+    const Rete::Symbol_Identifier_Ptr_C m_table_id = Rete::Symbol_Identifier::intern("TABLE");
+    const Rete::Symbol_Identifier_Ptr_C m_table_stack_id = m_table_id; //Rete::Symbol_Identifier::intern("|");
+    const Rete::Symbol_Constant_Int_Ptr_C m_table_name = Rete::Symbol_Constant_Int::intern(0);
 
     std::map<block_id, Rete::Symbol_Identifier_Ptr_C> m_block_ids;
     std::map<block_id, Rete::Symbol_Constant_Int_Ptr_C> m_block_names;
     std::map<block_id, Rete::Symbol_Identifier_Ptr_C> m_stack_ids;
     std::map<block_id, Rete::Symbol_Identifier_Ptr_C> m_target_stack_ids;
 
-    std::unordered_map<Rete::WME_Ptr_C, bool, Rete::hash_deref<Rete::WME>, Rete::compare_deref_eq> m_wmes;
-
-    void clear_old_wmes() {
-      auto wt = m_wmes.begin(), wend = m_wmes.end();
-      while(wt != wend) {
-        if(wt->second)
-          wt++->second = false;
-        else {
-          {
-            CPU_Accumulator cpu_accumulator(*this);
-            remove_wme(wt->first);
-          }
-          wt = m_wmes.erase(wt);
-        }
-      }
-    }
-
-    void insert_new_wme(const Rete::WME_Ptr_C &wme) {
-      const auto found = m_wmes.find(wme);
-      if(found == m_wmes.end()) {
-        m_wmes[wme] = true;
-        CPU_Accumulator cpu_accumulator(*this);
-        insert_wme(wme);
-      }
-      else
-        found->second = true;
-    }
+    std::vector<Rete::WME_Ptr_C> m_wmes; ///< The next state, collected by generate_features
 
 //    double m_feature_generation_time = 0.0;
   };
@@ -14,6 +14,9 @@ namespace Blocks_World_2 {
   using Carli::Node_Unsplit;
   using Carli::Q_Value;
 
+  const Rete::Variable_Slot Move::block_name_slot("block-name");
+  const Rete::Variable_Slot Move::dest_name_slot("dest-name");
+
   static const int32_t g_num_colors = 3;
 
   static bool xor_string(const std::string &str) {
@@ -700,9 +703,8 @@ namespace Blocks_World_2 {
       }
     }
     else if(m_goal == Goal::EXACT /*|| m_goal == Goal::COLOR*/) {
-      static bool skip_first = true;
-      if(skip_first)
-        skip_first = false;
+      if(m_skip_first_optimality)
+        m_skip_first_optimality = false;
       else
         m_num_steps_to_goal = calculate_num_steps_to_goal();
     }
@@ -907,6 +909,31 @@ namespace Blocks_World_2 {
     }
   }
 
+  void Environment::save_impl(ostream &os) const {
+    m_random.save(os);
+    Zeni::serialize(os, m_goal);
+    Zeni::serialize(os, m_num_steps_to_goal);
+    Zeni::serialize(os, m_skip_first_optimality);
+  }
+
+  void Environment::load_impl(istream &is) {
+    m_random.load(is);
+    Zeni::deserialize(is, m_goal);
+    Zeni::deserialize(is, m_num_steps_to_goal);
+    Zeni::deserialize(is, m_skip_first_optimality);
+
+    if(m_goal == Goal::COLOR) {
+      m_match_test = [](const Environment::Block &lhs, const Environment::Block &rhs)->bool{
+        return lhs.color == rhs.color;
+      };
+    }
+    else {
+      m_match_test = [](const Environment::Block &lhs, const Environment::Block &rhs)->bool{
+        return lhs.id == rhs.id;
+      };
+    }
+  }
+
   Agent::Agent(const std::shared_ptr<Carli::Environment> &env_)
    : Carli::Agent(env_, [this](const Rete::Variable_Indices &variables, const Rete::WME_Token &token)->Carli::Action_Ptr_C {return std::make_shared<Move>(variables, token);})
   {
@@ -914,10 +941,10 @@ namespace Blocks_World_2 {
     std::ostringstream oss;
     for(int64_t block_id = 0; block_id != env->get_num_blocks_max() + 1; ++block_id) {
       oss << block_id;
-      m_block_ids[block_id] = Rete::Symbol_Identifier_Ptr_C(new Rete::Symbol_Identifier(oss.str()));
-      m_block_names[block_id] = Rete::Symbol_Constant_Int_Ptr_C(new Rete::Symbol_Constant_Int(block_id));
-      m_stack_ids[block_id] = Rete::Symbol_Identifier_Ptr_C(new Rete::Symbol_Identifier(std::string("|") + oss.str()));
-      m_target_stack_ids[block_id] = Rete::Symbol_Identifier_Ptr_C(new Rete::Symbol_Identifier(std::string(":") + oss.str()));
+      m_block_ids[block_id] = Rete::Symbol_Identifier::intern(oss.str());
+      m_block_names[block_id] = Rete::Symbol_Constant_Int::intern(block_id);
+      m_stack_ids[block_id] = Rete::Symbol_Identifier::intern(std::string("|") + oss.str());
+      m_target_stack_ids[block_id] = Rete::Symbol_Identifier::intern(std::string(":") + oss.str());
       oss.str("");
     }
 
@@ -932,7 +959,7 @@ namespace Blocks_World_2 {
   }
 
   void Agent::generate_rete() {
-    std::string rules_in = dynamic_cast<const Option_String &>(Options::get_global()["rules"]).get_value();
+    std::string rules_in = dynamic_cast<const Option_String &>(get_context().get_options()["rules"]).get_value();
     if(rules_in == "default")
       rules_in = "rules/blocks-world-2.carli";
     if(rete_parse_file(*this, rules_in))
@@ -949,23 +976,19 @@ namespace Blocks_World_2 {
     const auto &target = env->get_target();
     const auto &table = env->get_table();
 
-    if(get_Option_Ranged<bool>(Options::get_global(), "rete-flush-wmes")) {
-      Rete::Agenda::Locker locker(agenda);
-      clear_old_wmes();
-    }
-
-    Rete::Agenda::Locker locker(agenda);
+    if(get_Option_Ranged<bool>(get_context().get_options(), "rete-flush-wmes"))
+      clear_wmes();
 
     if(env->get_goal() == Environment::Goal::ON_A_B)
-      insert_new_wme(std::make_shared<Rete::WME>(m_block_ids[1], m_goal_on_attr, m_block_ids[2]));
+      m_wmes.push_back(Rete::WME::create(m_block_ids[1], m_goal_on_attr, m_block_ids[2]));
     else if(env->get_goal() == Environment::Goal::EXACT) {
       for(const auto &stack : target) {
         Rete::Symbol_Identifier_Ptr_C prev_id = m_table_id;
-        insert_new_wme(std::make_shared<Rete::WME>(m_block_ids[stack.begin()->id], m_goal_on_attr, m_table_id));
+        m_wmes.push_back(Rete::WME::create(m_block_ids[stack.begin()->id], m_goal_on_attr, m_table_id));
         for(const auto &block : stack) {
           const Rete::Symbol_Identifier_Ptr_C block_id = m_block_ids[block.id];
           assert(block.id);
-          insert_new_wme(std::make_shared<Rete::WME>(block_id, m_goal_on_attr, prev_id));
+          m_wmes.push_back(Rete::WME::create(block_id, m_goal_on_attr, prev_id));
           prev_id = block_id;
         }
       }
@@ -979,14 +1002,14 @@ namespace Blocks_World_2 {
       int64_t height = 0;
       for(const auto &block : stack) {
         const auto block_id = m_block_ids[block.id];
-        insert_new_wme(std::make_shared<Rete::WME>(block_id, m_height_attr, std::make_shared<Rete::Symbol_Constant_Int>(++height)));
+        m_wmes.push_back(Rete::WME::create(block_id, m_height_attr, Rete::Symbol_Constant_Int::intern(++height)));
 
-        insert_new_wme(std::make_shared<Rete::WME>(block_id, m_color_attr, std::make_shared<Rete::Symbol_Constant_Int>(block.color)));
+        m_wmes.push_back(Rete::WME::create(block_id, m_color_attr, Rete::Symbol_Constant_Int::intern(block.color)));
 
         const double brightness = m_random.frand_lte();
-        insert_new_wme(std::make_shared<Rete::WME>(block_id, m_brightness_attr, std::make_shared<Rete::Symbol_Constant_Float>(brightness)));
+        m_wmes.push_back(Rete::WME::create(block_id, m_brightness_attr, Rete::Symbol_Constant_Float::intern(brightness)));
         if(brightness >= 0.5)
-          insert_new_wme(std::make_shared<Rete::WME>(block_id, m_glowing_attr, m_true_value));
+          m_wmes.push_back(Rete::WME::create(block_id, m_glowing_attr, m_true_value));
       }
       max_height = std::max(max_height, int64_t(stack.size()));
 
@@ -994,73 +1017,73 @@ namespace Blocks_World_2 {
         if(stack == dest_stack)
           continue;
         oss << "move-" << stack.rbegin()->id << "-|" << dest_stack.begin()->id;
-        const Rete::Symbol_Identifier_Ptr_C action_id = std::make_shared<Rete::Symbol_Identifier>(oss.str());
+        const Rete::Symbol_Identifier_Ptr_C action_id = Rete::Symbol_Identifier::intern(oss.str());
         const Rete::Symbol_Identifier_Ptr_C dest_id = m_stack_ids[dest_stack.begin()->id];
         oss.str("");
-        insert_new_wme(std::make_shared<Rete::WME>(m_s_id, m_action_attr, action_id));
-        insert_new_wme(std::make_shared<Rete::WME>(dest_id, m_action_in_attr, action_id));
-        insert_new_wme(std::make_shared<Rete::WME>(stack_id, m_action_out_attr, action_id));
-        insert_new_wme(std::make_shared<Rete::WME>(action_id, m_block_attr, m_block_ids[stack.rbegin()->id]));
-        insert_new_wme(std::make_shared<Rete::WME>(action_id, m_dest_attr, m_block_ids[dest_stack.rbegin()->id]));
+        m_wmes.push_back(Rete::WME::create(m_s_id, m_action_attr, action_id));
+        m_wmes.push_back(Rete::WME::create(dest_id, m_action_in_attr, action_id));
+        m_wmes.push_back(Rete::WME::create(stack_id, m_action_out_attr, action_id));
+        m_wmes.push_back(Rete::WME::create(action_id, m_block_attr, m_block_ids[stack.rbegin()->id]));
+        m_wmes.push_back(Rete::WME::create(action_id, m_dest_attr, m_block_ids[dest_stack.rbegin()->id]));
       }
 
       if(stack.size() > 1) {
         oss << "move-" << stack.rbegin()->id << "-TABLE";
-        const Rete::Symbol_Identifier_Ptr_C action_id = std::make_shared<Rete::Symbol_Identifier>(oss.str());
+        const Rete::Symbol_Identifier_Ptr_C action_id = Rete::Symbol_Identifier::intern(oss.str());
         oss.str("");
-        insert_new_wme(std::make_shared<Rete::WME>(m_s_id, m_action_attr, action_id));
-        insert_new_wme(std::make_shared<Rete::WME>(m_table_id, m_action_in_attr, action_id));
-        insert_new_wme(std::make_shared<Rete::WME>(stack_id, m_action_out_attr, action_id));
-        insert_new_wme(std::make_shared<Rete::WME>(action_id, m_block_attr, m_block_ids[stack.rbegin()->id]));
-        insert_new_wme(std::make_shared<Rete::WME>(action_id, m_dest_attr, m_table_id));
+        m_wmes.push_back(Rete::WME::create(m_s_id, m_action_attr, action_id));
+        m_wmes.push_back(Rete::WME::create(m_table_id, m_action_in_attr, action_id));
+        m_wmes.push_back(Rete::WME::create(stack_id, m_action_out_attr, action_id));
+        m_wmes.push_back(Rete::WME::create(action_id, m_block_attr, m_block_ids[stack.rbegin()->id]));
+        m_wmes.push_back(Rete::WME::create(action_id, m_dest_attr, m_table_id));
       }
     }
-    insert_new_wme(std::make_shared<Rete::WME>(m_table_id, m_height_attr, std::make_shared<Rete::Symbol_Constant_Int>(0)));
-    insert_new_wme(std::make_shared<Rete::WME>(m_table_id, m_color_attr, std::make_shared<Rete::Symbol_Constant_Int>(table.color)));
+    m_wmes.push_back(Rete::WME::create(m_table_id, m_height_attr, Rete::Symbol_Constant_Int::intern(0)));
+    m_wmes.push_back(Rete::WME::create(m_table_id, m_color_attr, Rete::Symbol_Constant_Int::intern(table.color)));
     const double brightness = m_random.frand_lte();
-    insert_new_wme(std::make_shared<Rete::WME>(m_table_id, m_brightness_attr, std::make_shared<Rete::Symbol_Constant_Float>(brightness)));
+    m_wmes.push_back(Rete::WME::create(m_table_id, m_brightness_attr, Rete::Symbol_Constant_Float::intern(brightness)));
     if(brightness >= 0.5)
-      insert_new_wme(std::make_shared<Rete::WME>(m_table_id, m_glowing_attr, m_true_value));
-
-    insert_new_wme(std::make_shared<Rete::WME>(m_s_id, m_blocks_attr, m_blocks_id));
-    insert_new_wme(std::make_shared<Rete::WME>(m_s_id, m_stacks_attr, m_stacks_id));
-    insert_new_wme(std::make_shared<Rete::WME>(m_s_id, m_target_attr, m_target_id));
-    insert_new_wme(std::make_shared<Rete::WME>(m_blocks_id, m_block_attr, m_table_id));
-    insert_new_wme(std::make_shared<Rete::WME>(m_table_id, m_name_attr, m_table_name));
-    insert_new_wme(std::make_shared<Rete::WME>(m_stacks_id, m_stack_attr, m_table_stack_id));
-    insert_new_wme(std::make_shared<Rete::WME>(m_target_id, m_stack_attr, m_table_stack_id));
-    insert_new_wme(std::make_shared<Rete::WME>(m_table_stack_id, m_top_attr, m_table_id));
-    insert_new_wme(std::make_shared<Rete::WME>(m_table_stack_id, m_matches_attr, m_table_stack_id));
+      m_wmes.push_back(Rete::WME::create(m_table_id, m_glowing_attr, m_true_value));
+
+    m_wmes.push_back(Rete::WME::create(m_s_id, m_blocks_attr, m_blocks_id));
+    m_wmes.push_back(Rete::WME::create(m_s_id, m_stacks_attr, m_stacks_id));
+    m_wmes.push_back(Rete::WME::create(m_s_id, m_target_attr, m_target_id));
+    m_wmes.push_back(Rete::WME::create(m_blocks_id, m_block_attr, m_table_id));
+    m_wmes.push_back(Rete::WME::create(m_table_id, m_name_attr, m_table_name));
+    m_wmes.push_back(Rete::WME::create(m_stacks_id, m_stack_attr, m_table_stack_id));
+    m_wmes.push_back(Rete::WME::create(m_target_id, m_stack_attr, m_table_stack_id));
+    m_wmes.push_back(Rete::WME::create(m_table_stack_id, m_top_attr, m_table_id));
+    m_wmes.push_back(Rete::WME::create(m_table_stack_id, m_matches_attr, m_table_stack_id));
 //    if(get_total_step_count() < 5000) {
-//      insert_new_wme(std::make_shared<Rete::WME>(m_table_stack_id, m_early_matches_attr, m_table_stack_id));
+//      m_wmes.push_back(Rete::WME::create(m_table_stack_id, m_early_matches_attr, m_table_stack_id));
 //      if(xor_string(m_table_stack_id->value))
-//        insert_new_wme(std::make_shared<Rete::WME>(m_table_stack_id, m_late_matches_attr, m_table_stack_id));
+//        m_wmes.push_back(Rete::WME::create(m_table_stack_id, m_late_matches_attr, m_table_stack_id));
 //    }
 //    else {
 //      if(xor_string(m_table_stack_id->value))
-//        insert_new_wme(std::make_shared<Rete::WME>(m_table_stack_id, m_early_matches_attr, m_table_stack_id));
-//      insert_new_wme(std::make_shared<Rete::WME>(m_table_stack_id, m_late_matches_attr, m_table_stack_id));
+//        m_wmes.push_back(Rete::WME::create(m_table_stack_id, m_early_matches_attr, m_table_stack_id));
+//      m_wmes.push_back(Rete::WME::create(m_table_stack_id, m_late_matches_attr, m_table_stack_id));
 //    }
 
     for(const auto &stack : blocks) {
       Rete::Symbol_Identifier_Ptr_C stack_id = m_stack_ids[stack.begin()->id];
 
-      insert_new_wme(std::make_shared<Rete::WME>(m_stacks_id, m_stack_attr, stack_id));
+      m_wmes.push_back(Rete::WME::create(m_stacks_id, m_stack_attr, stack_id));
       for(const auto &block : stack) {
         const Rete::Symbol_Identifier_Ptr_C block_id = m_block_ids[block.id];
-        insert_new_wme(std::make_shared<Rete::WME>(m_blocks_id, m_block_attr, block_id));
-        insert_new_wme(std::make_shared<Rete::WME>(stack_id, m_block_attr, block_id));
-        insert_new_wme(std::make_shared<Rete::WME>(block_id, m_name_attr, m_block_names[block.id]));
-        insert_new_wme(std::make_shared<Rete::WME>(block_id, m_above_attr, m_table_id));
-        insert_new_wme(std::make_shared<Rete::WME>(block_id, m_higher_than_attr, m_table_id));
+        m_wmes.push_back(Rete::WME::create(m_blocks_id, m_block_attr, block_id));
+        m_wmes.push_back(Rete::WME::create(stack_id, m_block_attr, block_id));
+        m_wmes.push_back(Rete::WME::create(block_id, m_name_attr, m_block_names[block.id]));
+        m_wmes.push_back(Rete::WME::create(block_id, m_above_attr, m_table_id));
+        m_wmes.push_back(Rete::WME::create(block_id, m_higher_than_attr, m_table_id));
       }
 
-      insert_new_wme(std::make_shared<Rete::WME>(m_block_ids[stack.rbegin()->id], m_clear_attr, m_true_value));
+      m_wmes.push_back(Rete::WME::create(m_block_ids[stack.rbegin()->id], m_clear_attr, m_true_value));
 
-      insert_new_wme(std::make_shared<Rete::WME>(stack_id, m_top_attr, m_block_ids[stack.rbegin()->id]));
-      ///insert_new_wme(std::make_shared<Rete::WME>(stack_id, m_matches_attr, m_table_stack_id));
+      m_wmes.push_back(Rete::WME::create(stack_id, m_top_attr, m_block_ids[stack.rbegin()->id]));
+      ///m_wmes.push_back(Rete::WME::create(stack_id, m_matches_attr, m_table_stack_id));
       if(int64_t(stack.size()) == max_height)
-        insert_new_wme(std::make_shared<Rete::WME>(stack_id, m_tallest_attr, m_true_value));
+        m_wmes.push_back(Rete::WME::create(stack_id, m_tallest_attr, m_true_value));
     }
 
     for(const auto &stack : blocks) {
@@ -1068,15 +1091,15 @@ namespace Blocks_World_2 {
       for(const auto &block1 : stack) {
         const Rete::Symbol_Identifier_Ptr_C block1_id = m_block_ids[block1.id];
         if(block1_height == 1)
-          insert_new_wme(std::make_shared<Rete::WME>(block1_id, m_on_attr, m_table_id));
+          m_wmes.push_back(Rete::WME::create(block1_id, m_on_attr, m_table_id));
         int64_t block2_height = 1;
         for(const auto &block2 : stack) {
           if(block2_height >= block1_height)
             break;
           const Rete::Symbol_Identifier_Ptr_C block2_id = m_block_ids[block2.id];
           if(block1_height == block2_height + 1)
-            insert_new_wme(std::make_shared<Rete::WME>(block1_id, m_on_attr, block2_id));
-          insert_new_wme(std::make_shared<Rete::WME>(block1_id, m_above_attr, block2_id));
+            m_wmes.push_back(Rete::WME::create(block1_id, m_on_attr, block2_id));
+          m_wmes.push_back(Rete::WME::create(block1_id, m_above_attr, block2_id));
           ++block2_height;
         }
         ++block1_height;
@@ -1093,7 +1116,7 @@ namespace Blocks_World_2 {
             if(block2_height >= block1_height)
               break;
             const Rete::Symbol_Identifier_Ptr_C block2_id = m_block_ids[block2.id];
-            insert_new_wme(std::make_shared<Rete::WME>(block1_id, m_higher_than_attr, block2_id));
+            m_wmes.push_back(Rete::WME::create(block1_id, m_higher_than_attr, block2_id));
             ++block2_height;
           }
         }
@@ -1134,16 +1157,16 @@ namespace Blocks_World_2 {
         const auto bmend = target_stack.size() < best_match->size() ? best_match->begin() + target_stack.size() : best_match->end();
         const auto match = std::mismatch(best_match->begin(), bmend, target_stack.begin(), env->get_match_test());
 
-        insert_new_wme(std::make_shared<Rete::WME>(stack_id, m_matches_attr, target_id));
+        m_wmes.push_back(Rete::WME::create(stack_id, m_matches_attr, target_id));
 //        if(get_total_step_count() < 5000) {
-//          insert_new_wme(std::make_shared<Rete::WME>(stack_id, m_early_matches_attr, target_id));
+//          m_wmes.push_back(Rete::WME::create(stack_id, m_early_matches_attr, target_id));
 //          if(xor_string(stack_id->value) ^ xor_string(target_id->value))
-//            insert_new_wme(std::make_shared<Rete::WME>(stack_id, m_late_matches_attr, target_id));
+//            m_wmes.push_back(Rete::WME::create(stack_id, m_late_matches_attr, target_id));
 //        }
 //        else {
 //          if(xor_string(stack_id->value) ^ xor_string(target_id->value))
-//            insert_new_wme(std::make_shared<Rete::WME>(stack_id, m_early_matches_attr, target_id));
-//          insert_new_wme(std::make_shared<Rete::WME>(stack_id, m_late_matches_attr, target_id));
+//            m_wmes.push_back(Rete::WME::create(stack_id, m_early_matches_attr, target_id));
+//          m_wmes.push_back(Rete::WME::create(stack_id, m_late_matches_attr, target_id));
 //        }
 
         if(match.second != target_stack.end()) {
@@ -1151,16 +1174,16 @@ namespace Blocks_World_2 {
             for(const auto &block : stack) {
               if(env->get_match_test()(block, *match.second)) {
                 const Rete::Symbol_Identifier_Ptr_C block_id = m_block_ids[block.id];
-                insert_new_wme(std::make_shared<Rete::WME>(block_id, m_matches_top_attr, stack_id));
+                m_wmes.push_back(Rete::WME::create(block_id, m_matches_top_attr, stack_id));
                 if(get_total_step_count() < 5000) {
-                  insert_new_wme(std::make_shared<Rete::WME>(block_id, m_early_matches_top_attr, stack_id));
+                  m_wmes.push_back(Rete::WME::create(block_id, m_early_matches_top_attr, stack_id));
                   if(xor_string(block_id->value) ^ xor_string(stack_id->value))
-                    insert_new_wme(std::make_shared<Rete::WME>(block_id, m_late_matches_top_attr, stack_id));
+                    m_wmes.push_back(Rete::WME::create(block_id, m_late_matches_top_attr, stack_id));
                 }
                 else {
                   if(xor_string(block_id->value) ^ xor_string(stack_id->value))
-                    insert_new_wme(std::make_shared<Rete::WME>(block_id, m_early_matches_top_attr, stack_id));
-                  insert_new_wme(std::make_shared<Rete::WME>(block_id, m_late_matches_top_attr, stack_id));
+                    m_wmes.push_back(Rete::WME::create(block_id, m_early_matches_top_attr, stack_id));
+                  m_wmes.push_back(Rete::WME::create(block_id, m_late_matches_top_attr, stack_id));
                 }
               }
             }
@@ -1180,54 +1203,55 @@ namespace Blocks_World_2 {
         if(match.first != target_stack.begin()) {
           discrepancy -= match.first - target_stack.begin();
           for(auto bt = target_stack.begin(); bt != match.first; ++bt)
-            insert_new_wme(std::make_shared<Rete::WME>(m_block_ids[bt->id], m_in_place_attr, m_true_value));
+            m_wmes.push_back(Rete::WME::create(m_block_ids[bt->id], m_in_place_attr, m_true_value));
           break;
         }
       }
       assert(!target_stack.empty());
       const Rete::Symbol_Identifier_Ptr_C target_base_id = m_block_ids[target_stack.begin()->id];
-      insert_new_wme(std::make_shared<Rete::WME>(target_base_id, m_matches_top_attr, m_table_stack_id));
+      m_wmes.push_back(Rete::WME::create(target_base_id, m_matches_top_attr, m_table_stack_id));
 //      if(get_total_step_count() < 5000) {
-//        insert_new_wme(std::make_shared<Rete::WME>(target_base_id, m_early_matches_top_attr, m_table_stack_id));
+//        m_wmes.push_back(Rete::WME::create(target_base_id, m_early_matches_top_attr, m_table_stack_id));
 //        if(xor_string(target_base_id->value) ^ xor_string(m_table_stack_id->value))
-//          insert_new_wme(std::make_shared<Rete::WME>(target_base_id, m_late_matches_top_attr, m_table_stack_id));
+//          m_wmes.push_back(Rete::WME::create(target_base_id, m_late_matches_top_attr, m_table_stack_id));
 //      }
 //      else {
 //        if(xor_string(target_base_id->value) ^ xor_string(m_table_stack_id->value))
-//          insert_new_wme(std::make_shared<Rete::WME>(target_base_id, m_early_matches_top_attr, m_table_stack_id));
-//        insert_new_wme(std::make_shared<Rete::WME>(target_base_id, m_late_matches_top_attr, m_table_stack_id));
+//          m_wmes.push_back(Rete::WME::create(target_base_id, m_early_matches_top_attr, m_table_stack_id));
+//        m_wmes.push_back(Rete::WME::create(target_base_id, m_late_matches_top_attr, m_table_stack_id));
 //      }
     }
-//    insert_new_wme(std::make_shared<Rete::WME>(m_s_id, m_discrepancy_attr, Rete::Symbol_Constant_Int_Ptr_C(new Rete::Symbol_Constant_Int(discrepancy))));
+//    m_wmes.push_back(Rete::WME::create(m_s_id, m_discrepancy_attr, Rete::Symbol_Constant_Int::intern(discrepancy)));
 
     for(const auto &target_stack : target) {
       Rete::Symbol_Identifier_Ptr_C target_stack_id = m_target_stack_ids[target_stack.begin()->id];
 
-      insert_new_wme(std::make_shared<Rete::WME>(m_target_id, m_stack_attr, target_stack_id));
+      m_wmes.push_back(Rete::WME::create(m_target_id, m_stack_attr, target_stack_id));
       for(const auto &block : target_stack) {
         const Rete::Symbol_Identifier_Ptr_C block_id = m_block_ids[block.id];
-        insert_new_wme(std::make_shared<Rete::WME>(target_stack_id, m_block_attr, block_id));
+        m_wmes.push_back(Rete::WME::create(target_stack_id, m_block_attr, block_id));
       }
       if(std::find(blocks.begin(), blocks.end(), target_stack) == blocks.end())
-        insert_new_wme(std::make_shared<Rete::WME>(target_stack_id, m_top_attr, m_block_ids[target_stack.rbegin()->id]));
+        m_wmes.push_back(Rete::WME::create(target_stack_id, m_top_attr, m_block_ids[target_stack.rbegin()->id]));
       const Rete::Symbol_Identifier_Ptr_C target_base_id = m_block_ids[target_stack.begin()->id];
-      insert_new_wme(std::make_shared<Rete::WME>(target_base_id, m_matches_top_attr, m_table_stack_id));
+      m_wmes.push_back(Rete::WME::create(target_base_id, m_matches_top_attr, m_table_stack_id));
 //      if(get_total_step_count() < 5000) {
-//        insert_new_wme(std::make_shared<Rete::WME>(target_base_id, m_early_matches_top_attr, m_table_stack_id));
+//        m_wmes.push_back(Rete::WME::create(target_base_id, m_early_matches_top_attr, m_table_stack_id));
 //        if(xor_string(target_base_id->value) ^ xor_string(m_table_stack_id->value))
-//          insert_new_wme(std::make_shared<Rete::WME>(target_base_id, m_late_matches_top_attr, m_table_stack_id));
+//          m_wmes.push_back(Rete::WME::create(target_base_id, m_late_matches_top_attr, m_table_stack_id));
 //      }
 //      else {
 //        if(xor_string(target_base_id->value) ^ xor_string(m_table_stack_id->value))
-//          insert_new_wme(std::make_shared<Rete::WME>(target_base_id, m_early_matches_top_attr, m_table_stack_id));
-//        insert_new_wme(std::make_shared<Rete::WME>(target_base_id, m_late_matches_top_attr, m_table_stack_id));
+//          m_wmes.push_back(Rete::WME::create(target_base_id, m_early_matches_top_attr, m_table_stack_id));
+//        m_wmes.push_back(Rete::WME::create(target_base_id, m_late_matches_top_attr, m_table_stack_id));
 //      }
     }
 
 //    const auto end_time = std::chrono::high_resolution_clock::now();
 //    m_feature_generation_time += std::chrono::duration_cast<dseconds>(end_time - start_time).count();
 
-    clear_old_wmes();
+    set_wmes(m_wmes);
+    m_wmes.clear();
   }
 
   void Agent::update() {
@@ -1237,4 +1261,12 @@ namespace Blocks_World_2 {
       m_metastate = Metastate::SUCCESS;
   }
 
+  void Agent::save_impl(ostream &os) const {
+    m_random.save(os);
+  }
+
+  void Agent::load_impl(istream &is) {
+    m_random.load(is);
+  }
+
 }
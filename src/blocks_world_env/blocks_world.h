@@ -20,6 +20,7 @@ namespace Blocks_World {
 
   using std::dynamic_pointer_cast;
   using std::endl;
+  using std::istream;
   using std::ostream;
 
   typedef int64_t block_id;
@@ -44,9 +45,12 @@ namespace Blocks_World {
     {
     }
 
+    static const Rete::Variable_Slot block_name_slot;
+    static const Rete::Variable_Slot dest_name_slot;
+
     Move(const Rete::Variable_Indices &variables, const Rete::WME_Token &token)
-     : block(debuggable_cast<const Rete::Symbol_Constant_Int &>(*token[variables.find("block-name")->second]).value),
-     dest(debuggable_cast<const Rete::Symbol_Constant_Int &>(*token[variables.find("dest-name")->second]).value)
+     : block(token.get<Rete::Symbol_Constant_Int>(variables, block_name_slot).value),
+     dest(token.get<Rete::Symbol_Constant_Int>(variables, dest_name_slot).value)
     {
     }
 
@@ -89,6 +93,9 @@ namespace Blocks_World {
 
     void print_impl(ostream &os) const;
 
+    void save_impl(ostream &) const {} ///< init_impl() regenerates every field
+    void load_impl(istream &) {}
+
     Stacks m_blocks;
     Stacks m_goal;
   };
@@ -105,19 +112,22 @@ namespace Blocks_World {
 
     void update();
 
+    void save_impl(ostream &os) const;
+    void load_impl(istream &is);
+
     Zeni::Random m_random;
 
-    const Rete::Symbol_Constant_String_Ptr_C m_action_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("action"));
-    const Rete::Symbol_Constant_String_Ptr_C m_dest_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("dest"));
-    const Rete::Symbol_Constant_String_Ptr_C m_block_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("block"));
-//    const Rete::Symbol_Constant_String_Ptr_C m_brightness_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("brightness"));
-    const Rete::Symbol_Constant_String_Ptr_C m_clear_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("clear"));
-//    const Rete::Symbol_Constant_String_Ptr_C m_glowing_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("glowing"));
-//    const Rete::Symbol_Constant_String_Ptr_C m_height_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("height"));
-    const Rete::Symbol_Constant_String_Ptr_C m_in_place_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("in-place"));
-    const Rete::Symbol_Constant_String_Ptr_C m_name_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("name"));
-//    const Rete::Symbol_Constant_String_Ptr_C m_on_top_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("on-top"));
-    const Rete::Symbol_Constant_String_Ptr_C m_true_value = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("true"));
+    const Rete::Symbol_Constant_String_Ptr_C m_action_attr = Rete::Symbol_Constant_String::intern("action");
+    const Rete::Symbol_Constant_String_Ptr_C m_dest_attr = Rete::Symbol_Constant_String::intern("dest");
+    const Rete::Symbol_Constant_String_Ptr_C m_block_attr = Rete::Symbol_Constant_String::intern("block");
+//    const Rete::Symbol_Constant_String_Ptr_C m_brightness_attr = Rete::Symbol_Constant_String::intern("brightness");
+    const Rete::Symbol_Constant_String_Ptr_C m_clear_attr = Rete::Symbol_Constant_String::intern("clear");
+//    const Rete::Symbol_Constant_String_Ptr_C m_glowing_attr = Rete::Symbol_Constant_String::intern("glowing");
+//    const Rete::Symbol_Constant_String_Ptr_C m_height_attr = Rete::Symbol_Constant_String::intern("height");
+    const Rete::Symbol_Constant_String_Ptr_C m_in_place_attr = Rete::Symbol_Constant_String::intern("in-place");
+    const Rete::Symbol_Constant_String_Ptr_C m_name_attr = Rete::Symbol_Constant_String::intern("name");
+//    const Rete::Symbol_Constant_String_Ptr_C m_on_top_attr = Rete::Symbol_Constant_String::intern("on-top");
+    const Rete::Symbol_Constant_String_Ptr_C m_true_value = Rete::Symbol_Constant_String::intern("true");
 
     /// http://msdn.microsoft.com/en-us/library/dn793970.aspx
 //    const std::array<Rete::Symbol_Identifier_Ptr_C, 7> m_block_ids;
@@ -125,7 +135,7 @@ namespace Blocks_World {
     const std::array<Rete::Symbol_Identifier_Ptr_C, 4> m_block_ids;
     const std::array<Rete::Symbol_Constant_Int_Ptr_C, 4> m_block_names;
 
-    std::list<Rete::WME_Ptr_C> m_wmes_prev;
+    std::vector<Rete::WME_Ptr_C> m_wmes; ///< The next state, collected by generate_features
   };
 
 }
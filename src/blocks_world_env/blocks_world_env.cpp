@@ -10,6 +10,9 @@ namespace Blocks_World {
   using Carli::Node_Unsplit;
   using Carli::Q_Value;
 
+  const Rete::Variable_Slot Move::block_name_slot("block-name");
+  const Rete::Variable_Slot Move::dest_name_slot("dest-name");
+
   Environment::Environment() {
     init_impl();
 
@@ -91,21 +94,21 @@ namespace Blocks_World {
 
   Agent::Agent(const std::shared_ptr<Carli::Environment> &env)
    : Carli::Agent(env, [this](const Rete::Variable_Indices &variables, const Rete::WME_Token &token)->Carli::Action_Ptr_C {return std::make_shared<Move>(variables, token);}),
-   m_block_ids({{Rete::Symbol_Identifier_Ptr_C(new Rete::Symbol_Identifier("TABLE")),
-                 Rete::Symbol_Identifier_Ptr_C(new Rete::Symbol_Identifier("A")),
-                 Rete::Symbol_Identifier_Ptr_C(new Rete::Symbol_Identifier("B")),
-                 Rete::Symbol_Identifier_Ptr_C(new Rete::Symbol_Identifier("C"))//,
-//                 Rete::Symbol_Identifier_Ptr_C(new Rete::Symbol_Identifier("D")),
-//                 Rete::Symbol_Identifier_Ptr_C(new Rete::Symbol_Identifier("E")),
-////                 Rete::Symbol_Identifier_Ptr_C(new Rete::Symbol_Identifier("F"))
+   m_block_ids({{Rete::Symbol_Identifier::intern("TABLE"),
+                 Rete::Symbol_Identifier::intern("A"),
+                 Rete::Symbol_Identifier::intern("B"),
+                 Rete::Symbol_Identifier::intern("C")//,
+//                 Rete::Symbol_Identifier::intern("D"),
+//                 Rete::Symbol_Identifier::intern("E"),
+////                 Rete::Symbol_Identifier::intern("F")
                }}),
-   m_block_names({{Rete::Symbol_Constant_Int_Ptr_C(new Rete::Symbol_Constant_Int(0)),
-                   Rete::Symbol_Constant_Int_Ptr_C(new Rete::Symbol_Constant_Int(1)),
-                   Rete::Symbol_Constant_Int_Ptr_C(new Rete::Symbol_Constant_Int(2)),
-                   Rete::Symbol_Constant_Int_Ptr_C(new Rete::Symbol_Constant_Int(3))//,
-//                   Rete::Symbol_Constant_Int_Ptr_C(new Rete::Symbol_Constant_Int(4)),
-//                   Rete::Symbol_Constant_Int_Ptr_C(new Rete::Symbol_Constant_Int(5)),
-//                   Rete::Symbol_Constant_Int_Ptr_C(new Rete::Symbol_Constant_Int(6))
+   m_block_names({{Rete::Symbol_Constant_Int::intern(0),
+                   Rete::Symbol_Constant_Int::intern(1),
+                   Rete::Symbol_Constant_Int::intern(2),
+                   Rete::Symbol_Constant_Int::intern(3)//,
+//                   Rete::Symbol_Constant_Int::intern(4),
+//                   Rete::Symbol_Constant_Int::intern(5),
+//                   Rete::Symbol_Constant_Int::intern(6)
                  }})
   {
     generate_rete();
@@ -117,7 +120,7 @@ namespace Blocks_World {
   }
 
   void Agent::generate_rete() {
-    std::string rules_in = dynamic_cast<const Option_String &>(Options::get_global()["rules"]).get_value();
+    std::string rules_in = dynamic_cast<const Option_String &>(get_context().get_options()["rules"]).get_value();
     if(rules_in == "default")
       rules_in = "rules/blocks-world.carli";
     if(rete_parse_file(*this, rules_in))
@@ -129,7 +132,6 @@ namespace Blocks_World {
 
     const auto &blocks = env->get_blocks();
     const auto &goal = env->get_goal();
-    std::list<Rete::WME_Ptr_C> wmes_current;
 
     std::ostringstream oss;
 //    for(size_t block = 1; block != m_block_ids.size(); ++block) {
@@ -137,11 +139,11 @@ namespace Blocks_World {
 //        if(block == dest)
 //          continue;
 //        oss << "move-" << block << '-' << dest;
-//        Rete::Symbol_Identifier_Ptr_C action_id = std::make_shared<Rete::Symbol_Identifier>(oss.str());
+//        Rete::Symbol_Identifier_Ptr_C action_id = Rete::Symbol_Identifier::intern(oss.str());
 //        oss.str("");
-//        wmes_current.push_back(std::make_shared<Rete::WME>(m_s_id, m_action_attr, action_id));
-//        wmes_current.push_back(std::make_shared<Rete::WME>(action_id, m_block_attr, m_block_ids[block]));
-//        wmes_current.push_back(std::make_shared<Rete::WME>(action_id, m_dest_attr, m_block_ids[dest]));
+//        m_wmes.push_back(Rete::WME::create(m_s_id, m_action_attr, action_id));
+//        m_wmes.push_back(Rete::WME::create(action_id, m_block_attr, m_block_ids[block]));
+//        m_wmes.push_back(Rete::WME::create(action_id, m_dest_attr, m_block_ids[dest]));
 //      }
 //    }
     for(auto stack : blocks) {
@@ -151,84 +153,60 @@ namespace Blocks_World {
         if(block == dest)
           continue;
         oss << "move-" << block << '-' << dest;
-        Rete::Symbol_Identifier_Ptr_C action_id = std::make_shared<Rete::Symbol_Identifier>(oss.str());
+        Rete::Symbol_Identifier_Ptr_C action_id = Rete::Symbol_Identifier::intern(oss.str());
         oss.str("");
-        wmes_current.push_back(std::make_shared<Rete::WME>(m_s_id, m_action_attr, action_id));
-        wmes_current.push_back(std::make_shared<Rete::WME>(action_id, m_block_attr, m_block_ids[block]));
-        wmes_current.push_back(std::make_shared<Rete::WME>(action_id, m_dest_attr, m_block_ids[dest]));
+        m_wmes.push_back(Rete::WME::create(m_s_id, m_action_attr, action_id));
+        m_wmes.push_back(Rete::WME::create(action_id, m_block_attr, m_block_ids[block]));
+        m_wmes.push_back(Rete::WME::create(action_id, m_dest_attr, m_block_ids[dest]));
       }
     }
     for(auto stack : blocks) {
       auto block = stack.front();
       oss << "move-" << block << '-' << 0;
-      Rete::Symbol_Identifier_Ptr_C action_id = std::make_shared<Rete::Symbol_Identifier>(oss.str());
+      Rete::Symbol_Identifier_Ptr_C action_id = Rete::Symbol_Identifier::intern(oss.str());
       oss.str("");
-      wmes_current.push_back(std::make_shared<Rete::WME>(m_s_id, m_action_attr, action_id));
-      wmes_current.push_back(std::make_shared<Rete::WME>(action_id, m_block_attr, m_block_ids[block]));
-      wmes_current.push_back(std::make_shared<Rete::WME>(action_id, m_dest_attr, m_block_ids[0]));
+      m_wmes.push_back(Rete::WME::create(m_s_id, m_action_attr, action_id));
+      m_wmes.push_back(Rete::WME::create(action_id, m_block_attr, m_block_ids[block]));
+      m_wmes.push_back(Rete::WME::create(action_id, m_dest_attr, m_block_ids[0]));
     }
 
     for(auto bt = blocks.begin(), bend = blocks.end(); bt != bend; ++bt) {
 //      int64_t height = 0;
       for(auto st = bt->begin(), send = bt->end(); st != send; ++st) {
-        wmes_current.push_back(std::make_shared<Rete::WME>(m_s_id, m_block_attr, m_block_ids[size_t(*st)]));
-        wmes_current.push_back(std::make_shared<Rete::WME>(m_block_ids[size_t(*st)], m_name_attr, m_block_names[size_t(*st)]));
-//        wmes_current.push_back(std::make_shared<Rete::WME>(m_block_ids[size_t(*st)], m_height_attr, std::make_shared<Rete::Symbol_Constant_Int>(++height)));
+        m_wmes.push_back(Rete::WME::create(m_s_id, m_block_attr, m_block_ids[size_t(*st)]));
+        m_wmes.push_back(Rete::WME::create(m_block_ids[size_t(*st)], m_name_attr, m_block_names[size_t(*st)]));
+//        m_wmes.push_back(Rete::WME::create(m_block_ids[size_t(*st)], m_height_attr, Rete::Symbol_Constant_Int::intern(++height)));
 
 //        const double brightness = m_random.frand_lte();
-//        wmes_current.push_back(std::make_shared<Rete::WME>(m_block_ids[size_t(*st)], m_brightness_attr, std::make_shared<Rete::Symbol_Constant_Float>(brightness)));
+//        m_wmes.push_back(Rete::WME::create(m_block_ids[size_t(*st)], m_brightness_attr, Rete::Symbol_Constant_Float::intern(brightness)));
 //        if(brightness > 0.5)
-//          wmes_current.push_back(std::make_shared<Rete::WME>(m_block_ids[size_t(*st)], m_glowing_attr, m_true_value));
+//          m_wmes.push_back(Rete::WME::create(m_block_ids[size_t(*st)], m_glowing_attr, m_true_value));
       }
 
-//      wmes_current.push_back(std::make_shared<Rete::WME>(m_block_ids[size_t(*bt->begin())], m_clear_attr, m_true_value));
+//      m_wmes.push_back(Rete::WME::create(m_block_ids[size_t(*bt->begin())], m_clear_attr, m_true_value));
 
 //      for(auto st = bt->begin(), stn = ++bt->begin(), send = bt->end(); stn != send; st = stn, ++stn)
-//        wmes_current.push_back(std::make_shared<Rete::WME>(get_block_id(*st), m_on_top_attr, get_block_id(*stn)));
+//        m_wmes.push_back(Rete::WME::create(get_block_id(*st), m_on_top_attr, get_block_id(*stn)));
 
       auto base = bt->rbegin();
       const auto stack = std::find_if(goal.begin(), goal.end(), [&base](const Environment::Stack &stack)->bool{return std::find(stack.begin(), stack.end(), *base) != stack.end();});
       if(stack != goal.end()) {
         for(auto base_goal = stack->rbegin(); base != bt->rend() && base_goal != stack->rend() && *base == *base_goal; ++base, ++base_goal)
-          wmes_current.push_back(std::make_shared<Rete::WME>(m_block_ids[size_t(*base)], m_in_place_attr, m_true_value));
+          m_wmes.push_back(Rete::WME::create(m_block_ids[size_t(*base)], m_in_place_attr, m_true_value));
       }
     }
 
-    wmes_current.push_back(std::make_shared<Rete::WME>(m_s_id, m_block_attr, m_block_ids[0]));
-    wmes_current.push_back(std::make_shared<Rete::WME>(m_block_ids[0], m_name_attr, m_block_names[0]));
-//    wmes_current.push_back(std::make_shared<Rete::WME>(m_block_ids[0], m_clear_attr, m_true_value));
-    wmes_current.push_back(std::make_shared<Rete::WME>(m_block_ids[0], m_in_place_attr, m_true_value));
-//    wmes_current.push_back(std::make_shared<Rete::WME>(m_block_ids[0], m_height_attr, std::make_shared<Rete::Symbol_Constant_Int>(0)));
-
-    Rete::Agenda::Locker locker(agenda);
-    CPU_Accumulator cpu_accumulator(*this);
+    m_wmes.push_back(Rete::WME::create(m_s_id, m_block_attr, m_block_ids[0]));
+    m_wmes.push_back(Rete::WME::create(m_block_ids[0], m_name_attr, m_block_names[0]));
+//    m_wmes.push_back(Rete::WME::create(m_block_ids[0], m_clear_attr, m_true_value));
+    m_wmes.push_back(Rete::WME::create(m_block_ids[0], m_in_place_attr, m_true_value));
+//    m_wmes.push_back(Rete::WME::create(m_block_ids[0], m_height_attr, Rete::Symbol_Constant_Int::intern(0)));
 
-    if(get_Option_Ranged<bool>(Options::get_global(), "rete-flush-wmes")) {
-      for(auto wt = m_wmes_prev.begin(), wend = m_wmes_prev.end(); wt != wend; ++wt)
-        remove_wme(*wt);
-      m_wmes_prev.clear();
-    }
-    else {
-      for(auto wt = m_wmes_prev.begin(), wend = m_wmes_prev.end(); wt != wend; ) {
-        const auto found = std::find_if(wmes_current.begin(), wmes_current.end(), [wt](const Rete::WME_Ptr_C &wme_)->bool{return *wme_ == **wt;});
-        if(found == wmes_current.end()) {
-          remove_wme(*wt);
-          m_wmes_prev.erase(wt++);
-        }
-        else {
-          wmes_current.erase(found);
-          ++wt;
-        }
-      }
-    }
+    if(get_Option_Ranged<bool>(get_context().get_options(), "rete-flush-wmes"))
+      clear_wmes();
 
-    for(auto &wme : wmes_current) {
-      const auto found = std::find_if(m_wmes_prev.begin(), m_wmes_prev.end(), [wme](const Rete::WME_Ptr_C &wme_)->bool{return *wme_ == *wme;});
-      if(found == m_wmes_prev.end()) {
-        m_wmes_prev.push_back(wme);
-        insert_wme(wme);
-      }
-    }
+    set_wmes(m_wmes);
+    m_wmes.clear();
   }
 
   void Agent::update() {
@@ -245,4 +223,12 @@ namespace Blocks_World {
     m_metastate = Metastate::SUCCESS;
   }
 
+  void Agent::save_impl(ostream &os) const {
+    m_random.save(os);
+  }
+
+  void Agent::load_impl(istream &is) {
+    m_random.load(is);
+  }
+
 }
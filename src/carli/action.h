@@ -12,6 +12,7 @@
 namespace Carli {
 
   class Action;
+  class Candidates;
   
   typedef std::shared_ptr<const Action> Action_Ptr_C;
 
@@ -48,6 +49,14 @@ namespace Carli {
     virtual int64_t compare(const Action &rhs) const = 0;
 
     virtual void print_impl(std::ostream &os) const = 0;
+
+  private:
+    /// Actions are interned per agent and each agent has one Candidates, so no two tables ever index the same action
+    friend class Candidates;
+    mutable int64_t m_candidate = -1; ///< Index into the agent's Candidates while this action is one of them
+#ifndef NDEBUG
+    mutable const Candidates * m_candidates = nullptr; ///< The table m_candidate indexes, so that any other asserts
+#endif
   };
 }
 
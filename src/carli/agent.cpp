@@ -1,5 +1,9 @@
 #include "agent.h"
 
+#include "parser/rete_parser.h"
+
+#include <stdexcept>
+
 //#include "../infinite_mario/infinite_mario.h"
 
 namespace Carli {
@@ -8,13 +12,13 @@ namespace Carli {
 //  inline void dump_rules(const Agent &) {}
 //#else
   static void dump_rules(const Agent &agent) {
-    const std::string rules_out_file = dynamic_cast<const Option_String &>(Options::get_global()["rules-out"]).get_value();
+    const std::string rules_out_file = dynamic_cast<const Option_String &>(agent.get_context().get_options()["rules-out"]).get_value();
     if(!rules_out_file.empty()) {
-      static int64_t count = 0;
+      static thread_local int64_t count = 0;
       std::ostringstream oss;
 //      oss << rules_out_file << ".dump";
       oss << rules_out_file << '.' << ++count;
-      std::cerr << "Rule Dump #" << count << std::endl;
+      agent.get_context().get_err() << "Rule Dump #" << count << std::endl;
 //      if(count > 560) {
         std::ofstream rules_out(oss.str().c_str());
         rules_out << "set-rule-name-index " << agent.get_rule_name_index() << std::endl
@@ -91,7 +95,7 @@ namespace Carli {
       double aggregate_value = 0.0;
     };
 
-    std::unordered_set<Rete::Rete_Action_Ptr> excise;
+    std::vector<Rete::Rete_Action_Ptr> excise; ///< In the order found, so that excision order does not depend on addresses
     std::map<tracked_ptr<Feature>,
       std::map<tracked_ptr<Feature>, Data, Rete::compare_deref_lt>,
       Rete::compare_deref_memfun_lt<Feature, Feature, &Feature::compare_axis>> features;
@@ -110,7 +114,7 @@ namespace Carli {
       : root(split),
       root_feature(debuggable_cast<Carli::Node &>(*split).q_value_fringe->feature)
     {
-      excise.insert(split->rete_action.lock());
+      excise.push_back(split->rete_action.lock());
       auto descendants = split->descendants();
       for(auto node : descendants)
         (*this)(*node->rete_action.lock());
@@ -123,7 +127,9 @@ namespace Carli {
       }
 
       if(dynamic_cast<Node *>(rete_node.data.get())->q_value_fringe->depth > root->q_value_fringe->depth) {
-        excise.insert(debuggable_pointer_cast<Rete::Rete_Action>(rete_node.shared()));
+        auto action = debuggable_pointer_cast<Rete::Rete_Action>(rete_node.shared());
+        if(std::find(excise.begin(), excise.end(), action) == excise.end())
+          excise.push_back(std::move(action));
 
         auto &node = debuggable_cast<Carli::Node &>(*rete_node.data);
         auto &feature = node.q_value_fringe->feature;
@@ -139,7 +145,7 @@ namespace Carli {
         const auto found_axis = features.find(feature);
         if(found_axis != features.end()) {
 #ifdef DEBUG_OUTPUT
-          std::cerr << *found_axis->first << " =axis= " << *feature << std::endl;
+          get_context().get_err() << *found_axis->first << " =axis= " << *feature << std::endl;
 #endif
 
 //          const int64_t depth_diff = feature->get_depth() - found_axis->second.begin()->first->get_depth();
@@ -210,7 +216,7 @@ namespace Carli {
 
     if(m_concrete_update_count && general.q_value_weight->update_count > m_concrete_update_count) {
 #ifdef DEBUG_OUTPUT
-      std::cerr << "Cementing " << general.rete_action.lock()->get_name() << std::endl;
+      get_context().get_err() << "Cementing " << general.rete_action.lock()->get_name() << std::endl;
 #endif
 
       general.blacklist_full = true;
@@ -282,7 +288,7 @@ namespace Carli {
   //#endif
 
     if(m_output_dot) {
-      std::cerr << "Rete size before expansion: " << rete_size() << std::endl;
+      get_context().get_err() << "Rete size before expansion: " << rete_size() << std::endl;
 
       std::ostringstream fname;
       g_output_dot_exp_count = (g_output_dot_exp_count + 1) % 4;
@@ -515,7 +521,7 @@ namespace Carli {
 #endif
 
     if(m_output_dot) {
-      std::cerr << "Rete size after expansion: " << rete_size() << std::endl;
+      get_context().get_err() << "Rete size after expansion: " << rete_size() << std::endl;
 
       std::ostringstream fname;
       fname << "post-expansion-" << g_output_dot_exp_count << ".dot";
@@ -545,25 +551,25 @@ namespace Carli {
     unsplit.fringe_values.erase(specialization);
 
 #ifdef DEBUG_OUTPUT
-    std::cerr << "Refining:";
+    get_context().get_err() << "Refining:";
     for(auto &leaf : leaves) {
-      std::cerr << ' ';
+      get_context().get_err() << ' ';
       if(leaf->rete_action.lock()->is_active())
-        std::cerr << '*';
-      std::cerr << *leaf->q_value_fringe->feature;
+        get_context().get_err() << '*';
+      get_context().get_err() << *leaf->q_value_fringe->feature;
     }
-    std::cerr << std::endl << "Carrying over detected:";
+    get_context().get_err() << std::endl << "Carrying over detected:";
     for(auto &fringe_axis : unsplit.fringe_values) {
-      std::cerr << std::endl << "  ";
+      get_context().get_err() << std::endl << "  ";
       for(auto &fringe_w : fringe_axis.second) {
         auto fringe = fringe_w.lock();
-        std::cerr << ' ';
+        get_context().get_err() << ' ';
         if(fringe->rete_action.lock()->is_active())
-          std::cerr << '*';
-        std::cerr << *fringe->q_value_fringe->feature;
+          get_context().get_err() << '*';
+        get_context().get_err() << *fringe->q_value_fringe->feature;
       }
     }
-    std::cerr << std::endl;
+    get_context().get_err() << std::endl;
 #endif
 
     /** Step 1.5: Detect whether a new & distinct variable needs to be created for Higher Order Grammar rules, along with new fringe nodes **/
@@ -593,7 +599,7 @@ namespace Carli {
             }
             if(!is_hog_variable) {
 #ifdef DEBUG_OUTPUT
-              std::cerr << "Non-HOG variable skipped: " << vt->first << std::endl;
+              get_context().get_err() << "Non-HOG variable skipped: " << vt->first << std::endl;
 #endif
               continue;
             }
@@ -805,6 +811,7 @@ namespace Carli {
           fringe->q_value_fringe->catde_post_split = 0.0;
         }
       }
+      invalidate_value_sums();
     }
 
     if(auto grandparent_action = unsplit.parent_action.lock()) {
@@ -828,7 +835,7 @@ namespace Carli {
         auto data = dynamic_cast<Node *>(rule->data.get());
         if(data) {
           if(data->q_value_fringe->depth != 1 && data->parent_action.expired()) {
-            std::cerr << "Bad rule found pre-collapse: " << rule->get_name() << std::endl;
+            get_context().get_err() << "Bad rule found pre-collapse: " << rule->get_name() << std::endl;
             abort();
           }
         }
@@ -938,7 +945,7 @@ namespace Carli {
       return false;
 
     if(m_output_dot) {
-      std::cerr << "Rete size before collapse: " << rete_size() << std::endl;
+      get_context().get_err() << "Rete size before collapse: " << rete_size() << std::endl;
 
       std::ostringstream fname;
       g_output_dot_col_count = (g_output_dot_col_count + 1) % 4;
@@ -948,17 +955,17 @@ namespace Carli {
     }
 
 #ifdef DEBUG_OUTPUT
-    std::cerr << "Features: ";
+    get_context().get_err() << "Features: ";
     for(const auto &feature_axis : fringe_collector.features)
       for(const auto &feature_node : feature_axis.second)
-        std::cerr << ' ' << *feature_node.first << ';' << feature_node.second.count << ';' << feature_node.second.aggregate_value;
-    std::cerr << std::endl;
+        get_context().get_err() << ' ' << *feature_node.first << ';' << feature_node.second.count << ';' << feature_node.second.aggregate_value;
+    get_context().get_err() << std::endl;
 #endif
 
     /// Make new unsplit node
     const auto unsplit = split->create_unsplit(split->parent_action.lock());
 #ifdef DEBUG_OUTPUT
-    std::cerr << "Collapsing " << split << " to " << unsplit << std::endl;
+    get_context().get_err() << "Collapsing " << split << " to " << unsplit << std::endl;
 #endif
 
 //    const size_t unsplit_variables_size = unsplit->variables->size();
@@ -1013,12 +1020,13 @@ namespace Carli {
 //    std::cerr << "Excising " << fringe_collector.excise.size() << " actions." << std::endl;
 //#endif
 
-    for(auto fct = fringe_collector.excise.begin(), fend = fringe_collector.excise.end(); fct != fend; ) {
-      auto fringe = fct->get();
-      fct = fringe_collector.excise.erase(fct);
-//      std::cerr << "Excising " << fringe->get_name() << std::endl;
-      excise_rule(fringe->get_name(), false);
+    for(auto &fct : fringe_collector.excise) {
+      const std::string name = fct->get_name();
+      fct.reset();
+//      std::cerr << "Excising " << name << std::endl;
+      excise_rule(name, false);
     }
+    fringe_collector.excise.clear();
 
     if(auto grandparent_action = split->parent_action.lock()) {
       auto &grandparent_node = debuggable_cast<Node_Split &>(*grandparent_action->data);
@@ -1028,7 +1036,7 @@ namespace Carli {
     }
 
     if(m_output_dot) {
-      std::cerr << "Rete size after collapse: " << rete_size() << std::endl;
+      get_context().get_err() << "Rete size after collapse: " << rete_size() << std::endl;
 
       std::ostringstream fname;
       fname << "post-collapse-" << g_output_dot_col_count << ".dot";
@@ -1049,7 +1057,7 @@ namespace Carli {
       auto data = dynamic_cast<Node *>(rule->data.get());
       if(data) {
         if(data->q_value_fringe->depth != 1 && data->parent_action.expired()) {
-          std::cerr << "Bad rule found post-collapse: " << rule->get_name() << std::endl;
+          get_context().get_err() << "Bad rule found post-collapse: " << rule->get_name() << std::endl;
           abort();
         }
       }
@@ -1159,17 +1167,18 @@ namespace Carli {
   }
 
   Agent::Agent(const std::shared_ptr<Environment> &environment, const std::function<Carli::Action_Ptr_C (const Rete::Variable_Indices &variables, const Rete::WME_Token &token)> &get_action_)
-    : get_action(get_action_),
+    : Rete_Agent(environment->get_context()),
     m_target_policy([this]()->Action_Ptr_C{return this->choose_greedy(nullptr, std::numeric_limits<int64_t>::max());}),
     m_exploration_policy(
-		                 dynamic_cast<const Option_Itemized &>(Options::get_global()["exploration"]).get_value() == "boltzmann" ?
+		                 dynamic_cast<const Option_Itemized &>(get_context().get_options()["exploration"]).get_value() == "boltzmann" ?
 		                 std::function<Action_Ptr_C ()>([this]()->Action_Ptr_C{return this->choose_boltzmann(nullptr, std::numeric_limits<int64_t>::max());}) :
 #ifdef ENABLE_T_TEST
-		                 dynamic_cast<const Option_Itemized &>(Options::get_global()["exploration"]).get_value() == "t-test" ?
+		                 dynamic_cast<const Option_Itemized &>(get_context().get_options()["exploration"]).get_value() == "t-test" ?
 		                 std::function<Action_Ptr_C ()>([this]()->Action_Ptr_C{return this->choose_t_test(nullptr, std::numeric_limits<int64_t>::max());}) :
 #endif
 		                 std::function<Action_Ptr_C ()>([this]()->Action_Ptr_C{return this->choose_epsilon_greedy(nullptr, std::numeric_limits<int64_t>::max());})),
     m_environment(environment),
+    m_make_action(get_action_),
     m_credit_assignment(
       m_credit_assignment_code == "all" ?
         [this](const Q_Value_List &value_list){return this->assign_credit_all(value_list);} :
@@ -1291,7 +1300,14 @@ namespace Carli {
   }
 
   void Agent::destroy() {
-    const std::string rules_out_file = dynamic_cast<const Option_String &>(Options::get_global()["rules-out"]).get_value();
+    if(!dynamic_cast<const Option_String &>(get_context().get_options()["rules-out"]).get_value().empty() ||
+       !dynamic_cast<const Option_String &>(get_context().get_options()["rules-out-binary"]).get_value().empty() ||
+       !dynamic_cast<const Option_String &>(get_context().get_options()["dependencies-out"]).get_value().empty())
+    {
+      materialize_deferred();
+    }
+
+    const std::string rules_out_file = dynamic_cast<const Option_String &>(get_context().get_options()["rules-out"]).get_value();
     if(!rules_out_file.empty()) {
       std::ofstream rules_out(rules_out_file.c_str());
       rules_out << "# CPU time = " << rete_cpu_time() << " seconds" << std::endl << std::endl;
@@ -1300,7 +1316,13 @@ namespace Carli {
       rete_print_rules(rules_out);
     }
 
-    const std::string dependencies_out_file = dynamic_cast<const Option_String &>(Options::get_global()["dependencies-out"]).get_value();
+    const std::string rules_out_binary_file = dynamic_cast<const Option_String &>(get_context().get_options()["rules-out-binary"]).get_value();
+    if(!rules_out_binary_file.empty()) {
+      std::ofstream rules_out(rules_out_binary_file.c_str(), std::ios::binary);
+      Rete::rete_save_binary(*this, rules_out);
+    }
+
+    const std::string dependencies_out_file = dynamic_cast<const Option_String &>(get_context().get_options()["dependencies-out"]).get_value();
     if(!dependencies_out_file.empty()) {
       auto dependency_collector = visit_preorder(Feature_Dependency_Collector(), true);
       std::ofstream dependencies_out(dependencies_out_file);
@@ -1322,7 +1344,89 @@ namespace Carli {
     m_total_reward = 0.0;
   }
 
+  bool Agent::is_mid_episode() const {
+    return m_metastate == Metastate::NON_TERMINAL && m_step_count && m_step_count != m_step_cutoff;
+  }
+
+  void Agent::save(std::ostream &os) const {
+    if(is_mid_episode())
+      throw std::runtime_error("Agent cannot be saved mid-episode, without its eligibility trace, next action, and environment.");
+
+    get_context().get_random().save(os);
+    random.save(os);
+
+    Zeni::serialize(os, get_rule_name_index());
+    Zeni::serialize(os, m_creation_index);
+    Zeni::serialize(os, m_metastate);
+    Zeni::serialize(os, m_episode_number);
+    Zeni::serialize(os, m_step_count);
+    Zeni::serialize(os, m_total_step_count);
+    Zeni::serialize(os, m_total_reward);
+    Zeni::serialize(os, m_epsilon);
+    Zeni::serialize(os, m_inverse_temperature);
+
+    m_mean_catde.save(os);
+    m_mean_catde_queue.save(os);
+#ifdef TRACK_MEAN_ABSOLUTE_BELLMAN_ERROR
+    m_mean_matde.save(os);
+#endif
+#ifdef WHITESON_ADAPTIVE_TILE
+    Zeni::serialize(os, m_steps_since_minbe);
+#endif
+#ifndef NO_COLLAPSE_DETECTION_HACK
+    Zeni::serialize(os, m_positive_rewards_in_a_row);
+    Zeni::serialize(os, m_experienced_n_positive_rewards_in_a_row);
+#endif
+    Zeni::serialize(os, std::vector<std::pair<int64_t, int64_t>>(m_unrefinements.begin(), m_unrefinements.end()));
+
+    m_environment->save(os);
+    save_impl(os);
+  }
+
+  void Agent::load(std::istream &is) {
+    get_context().get_random().load(is);
+    random.load(is);
+
+    int64_t rule_name_index;
+    Zeni::deserialize(is, rule_name_index);
+    set_rule_name_index(rule_name_index);
+    Zeni::deserialize(is, m_creation_index);
+    Zeni::deserialize(is, m_metastate);
+    Zeni::deserialize(is, m_episode_number);
+    Zeni::deserialize(is, m_step_count);
+    Zeni::deserialize(is, m_total_step_count);
+    Zeni::deserialize(is, m_total_reward);
+    Zeni::deserialize(is, m_epsilon);
+    Zeni::deserialize(is, m_inverse_temperature);
+    if(is_mid_episode())
+      throw std::runtime_error("Agent saved mid-episode cannot be resumed.");
+
+    m_mean_catde.load(is);
+    m_mean_catde_queue.load(is);
+#ifdef TRACK_MEAN_ABSOLUTE_BELLMAN_ERROR
+    m_mean_matde.load(is);
+#endif
+#ifdef WHITESON_ADAPTIVE_TILE
+    Zeni::deserialize(is, m_steps_since_minbe);
+#endif
+#ifndef NO_COLLAPSE_DETECTION_HACK
+    Zeni::deserialize(is, m_positive_rewards_in_a_row);
+    Zeni::deserialize(is, m_experienced_n_positive_rewards_in_a_row);
+#endif
+    std::vector<std::pair<int64_t, int64_t>> unrefinements;
+    Zeni::deserialize(is, unrefinements);
+    m_unrefinements = std::map<int64_t, int64_t>(unrefinements.begin(), unrefinements.end());
+
+    /// init() clears the trace before the next episode uses it
+    clear_eligibility_trace();
+
+    m_environment->load(is);
+    load_impl(is);
+  }
+
   void Agent::init() {
+    const Zeni::Runtime_Context::Scope scope(get_context());
+
     m_epsilon = 1.0 / ((1.0 / m_epsilon_initial) + m_inverse_epsilon_episodic_increment * m_episode_number);
     m_inverse_temperature = std::log(m_inverse_temperature_initial + m_inverse_temperature_episodic_increment * m_episode_number);
 
@@ -1344,20 +1448,25 @@ namespace Carli {
   }
 
   Agent::reward_type Agent::act() {
+    const Zeni::Runtime_Context::Scope scope(get_context());
+
     /// Calculate \rho
     double rho = 1.0;
     if(!m_on_policy)
-      rho = probability_greedy(m_next, nullptr, std::numeric_limits<int64_t>::max()) / probability_epsilon_greedy(m_next, m_epsilon, nullptr, std::numeric_limits<int64_t>::max());
+      rho = probability_greedy(m_next, nullptr, std::numeric_limits<int64_t>::max()) /
+            (m_exploration_code == "boltzmann" ? probability_boltzmann(m_next, nullptr, std::numeric_limits<int64_t>::max())
+                                               : probability_epsilon_greedy(m_next, m_epsilon, nullptr, std::numeric_limits<int64_t>::max()));
 
     m_current = m_next;
-    m_current_q_value = m_next_q_values[m_next];
-//    m_current_q_value.sort([](const tracked_ptr<Q_Value> &lhs, const tracked_ptr<Q_Value> &rhs)->bool{return lhs->depth < rhs->depth;});
 
     if(!m_current) {
-      std::cerr << "No action selected. Terminating." << std::endl;
+      get_context().get_err() << "No action selected. Terminating." << std::endl;
       abort();
     }
 
+    m_current_q_value = m_next_q_values[*m_current];
+//    m_current_q_value.sort([](const tracked_ptr<Q_Value> &lhs, const tracked_ptr<Q_Value> &rhs)->bool{return lhs->depth < rhs->depth;});
+
     const std::pair<reward_type, reward_type> reward = m_environment->transition(*m_current);
 
 #ifndef NO_COLLAPSE_DETECTION_HACK
@@ -1380,14 +1489,14 @@ namespace Carli {
   //        std::cerr << "   " << *next_q.first << " is an option." << std::endl;
 //       std::cerr << "   " << *m_next << " is next." << std::endl;
 #endif
-      auto &value_best = m_next_q_values[m_next];
+      auto &value_best = m_next_q_values[*m_next];
       td_update(m_current_q_value, reward.first, value_best, rho, 1.0);
 
       if(!m_on_policy) {
         const auto next = m_exploration_policy();
 
         if(!m_secondary_learning_rate && *m_next != *next &&
-           std::get<0>(sum_value(nullptr, m_next_q_values[next], nullptr, std::numeric_limits<int64_t>::max())) < std::get<0>(sum_value(nullptr, m_next_q_values[m_next], nullptr, std::numeric_limits<int64_t>::max())))
+           std::get<0>(candidate_value(*m_next_q_values.find(*next), nullptr, nullptr, std::numeric_limits<int64_t>::max()).value) < std::get<0>(candidate_value(*m_next_q_values.find(*m_next), nullptr, nullptr, std::numeric_limits<int64_t>::max()).value))
         {
           clear_eligibility_trace();
         }
@@ -1400,7 +1509,7 @@ namespace Carli {
       }
 
 #ifdef DEBUG_OUTPUT
-      std::cerr << "   " << *m_next << " is next." << std::endl;
+      get_context().get_err() << "   " << *m_next << " is next." << std::endl;
 #endif
     }
     else {
@@ -1415,17 +1524,21 @@ namespace Carli {
   }
 
   Rete::Rete_Action_Ptr Agent::make_standard_action(const Rete::Rete_Node_Ptr &parent, const std::string &name, const bool &user_command, const Rete::Variable_Indices_Ptr_C &variables) {
-    return make_action_retraction(name, user_command,
+    auto new_action = make_action_retraction(name, user_command,
       [this](const Rete::Rete_Action &action, const Rete::WME_Token &token) {
         debuggable_cast<Node *>(action.data.get())->action(token);
       }, [this](const Rete::Rete_Action &action, const Rete::WME_Token &token) {
         debuggable_cast<Node *>(action.data.get())->retraction(token);
       }, parent, variables);
+    new_action->set_modification([this](const Rete::Rete_Action &action, const Rete::WME_Token &old_token, const Rete::WME_Token &new_token) {
+      debuggable_cast<Node *>(action.data.get())->modification(old_token, new_token);
+    });
+    return new_action;
   }
 
   Rete::Rete_Action_Ptr Agent::make_standard_fringe(const Rete::Rete_Node_Ptr &parent, const std::string &name, const bool &user_command, const Node_Unsplit_Ptr &root_action_data, const tracked_ptr<Feature> &feature, const Rete::Variable_Indices_Ptr_C &variables) {
     auto new_leaf = make_standard_action(parent, name, user_command, variables);
-    auto new_leaf_data = std::make_shared<Node_Fringe>(*this, root_action_data->rete_action.lock(), new_leaf, 2, feature);
+    auto new_leaf_data = std::allocate_shared<Node_Fringe>(Zeni::Pool_Allocator<Node_Fringe>(), *this, root_action_data->rete_action.lock(), new_leaf, 2, feature);
     new_leaf->data = new_leaf_data;
     root_action_data->fringe_values[new_leaf_data->q_value_fringe->feature.get()].push_back(new_leaf_data);
     return new_leaf;
@@ -1444,12 +1557,69 @@ namespace Carli {
     }
   }
 
+  Action_Ptr_C Agent::get_action(const Rete::Variable_Indices_Ptr_C &variables, const Rete::WME_Token &token) {
+    size_t hash = std::hash<const Rete::Variable_Indices *>()(variables.get());
+    for(const auto &variable : *variables) {
+      if(is_bound(variable.second, token))
+        hash = Rete::hash_combine(hash, std::hash<const Rete::Symbol *>()(token[variable.second].get()));
+    }
+
+    for(auto range = m_action_keys.equal_range(hash); range.first != range.second; ++range.first) {
+      const Action_Key &key = range.first->second;
+      if(key.variables != variables)
+        continue;
+      auto st = key.symbols.cbegin();
+      bool match = true;
+      for(const auto &variable : *variables) {
+        if(is_bound(variable.second, token) && (st++)->get() != token[variable.second].get()) {
+          match = false;
+          break;
+        }
+      }
+      if(match)
+        return key.action;
+    }
+
+    Action_Key key;
+    key.variables = variables;
+    for(const auto &variable : *variables) {
+      if(is_bound(variable.second, token))
+        key.symbols.push_back(token[variable.second]);
+    }
+    key.action = *m_actions.insert(m_make_action(*variables, token)).first;
+
+    if(m_action_keys.size() >= m_action_prune_size)
+      prune_actions();
+
+    return m_action_keys.emplace(hash, std::move(key))->second.action;
+  }
+
+  void Agent::prune_actions() {
+    /// Keys whose variables or symbols are held by nothing else can never match again
+    for(auto kt = m_action_keys.begin(), kend = m_action_keys.end(); kt != kend; ) {
+      bool expired = kt->second.variables.use_count() == 1;
+      for(const auto &symbol : kt->second.symbols)
+        expired |= symbol.use_count() == 1;
+      if(expired)
+        kt = m_action_keys.erase(kt);
+      else
+        ++kt;
+    }
+
+    for(auto at = m_actions.begin(), aend = m_actions.end(); at != aend; ) {
+      if(at->use_count() == 1)
+        at = m_actions.erase(at);
+      else
+        ++at;
+    }
+
+    m_action_prune_size = std::max(size_t(64), 2 * m_action_keys.size());
+  }
+
   void Agent::insert_q_value_next(const Action_Ptr_C &action, const tracked_ptr<Q_Value> &q_value) {
   //#ifdef DEBUG_OUTPUT
   //  std::cerr << "Inserting next value " << q_value << " for action " << *action << std::endl;
   //#endif
-    auto &q_values = m_next_q_values[action];
-
 //#ifdef DEBUG_OUTPUT
 //    std::cerr << "insert_q_value_next(" << *action << ',' << q_value.get() << ") into {";
 //    for(auto &q : q_values) {
@@ -1473,7 +1643,7 @@ namespace Carli {
 //      increment_badness();
 //    }
 //#endif
-    ++q_values[q_value];
+    m_next_q_values.insert(action, q_value);
   }
 
   void Agent::purge_q_value_next(const Action_Ptr_C &action, const tracked_ptr<Q_Value> &q_value) {
@@ -1481,26 +1651,7 @@ namespace Carli {
   //  std::cerr << "Purging next value " << q_value << " for action " << *action << std::endl;
   //#endif
     assert(q_value);
-    auto &q_values = m_next_q_values[action];
-//    auto found = std::find(q_values.begin(), q_values.end(), q_value);
-    auto found = q_values.find(q_value);
-//    assert(found != q_values.end());
-    if(found != q_values.end()) {
-      if(!--found->second)
-        q_values.erase(found);
-//#ifndef NDEBUG
-//      if(std::find(q_values.begin(), q_values.end(), q_value) != q_values.end()) {
-//        std::cerr << "BADNESS DECREMENT FOR " << *action << ": ";
-//        if(q_value->feature)
-//          std::cerr << *q_value->feature;
-//        std::cerr << std::endl;
-//        decrement_badness();
-//      }
-//#endif
-    }
-
-    if(q_values.empty())
-      m_next_q_values.erase(action);
+    m_next_q_values.purge(action, q_value);
 
 //#ifdef DEBUG_OUTPUT
 //    std::cerr << "purge_q_value_next(" << *action << ',' << q_value.get() << ") ";
@@ -1520,7 +1671,7 @@ namespace Carli {
   }
 
   void Agent::purge_q_value_eligible(const tracked_ptr<Q_Value> &q_value) {
-    q_value->eligible.erase_from(m_eligible);
+    m_eligible.erase(*q_value);
   }
 
   void Agent::print(std::ostream &os) const {
@@ -1529,8 +1680,8 @@ namespace Carli {
   //    print_feature_lists(os);
 
     os << "  Candidates:\n  ";
-    for(const auto &action_value : m_next_q_values)
-      os << ' ' << *action_value.first;
+    for(const auto &candidate : m_next_q_values.ordered())
+      os << ' ' << *candidate->action;
     os << std::endl;
 
   //#if defined(DEBUG_OUTPUT) && defined(DEBUG_OUTPUT_VALUE_FUNCTION)
@@ -1565,6 +1716,9 @@ namespace Carli {
   //  }
 
   void Agent::visit_increment_depth() {
+    materialize_deferred();
+    invalidate_value_sums();
+
     std::function<void (Rete::Rete_Node &)> visitor = [](Rete::Rete_Node &rete_node) {
       if(rete_node.data) {
         auto &node = debuggable_cast<Carli::Node &>(*rete_node.data);
@@ -1578,6 +1732,9 @@ namespace Carli {
   }
 
   void Agent::visit_reset_update_count() {
+    materialize_deferred();
+    invalidate_value_sums();
+
     std::function<void (Rete::Rete_Node &)> visitor = [](Rete::Rete_Node &rete_node) {
       if(rete_node.data) {
         auto &node = debuggable_cast<Carli::Node &>(*rete_node.data);
@@ -1590,65 +1747,31 @@ namespace Carli {
     visit_preorder(visitor, true);
   }
 
-  Action_Ptr_C Agent::choose_boltzmann(const Node_Fringe * const &fringe, const int64_t &fringe_depth) {
-    std::vector<double> values;
-    values.reserve(m_next_q_values.size());
+  void Agent::materialize_deferred() {
+    Rete::Agenda::Locker locker(agenda);
 
-    double value_sum = 0.0;
+    for(bool deferred = true; deferred; ) {
+      deferred = false;
 
-    const tracked_ptr<Q_Value> parent_q = fringe ? dynamic_cast<Node *>(fringe->parent_action.lock()->data.get())->q_value_weight : nullptr;
-    for(const auto &action_q : m_next_q_values) {
-      double value;
-      if(parent_q && action_q.second.find(parent_q) == action_q.second.end())
-        value = std::get<0>(sum_value(action_q.first.get(), action_q.second, nullptr, fringe_depth));
-      else
-        value = std::get<0>(sum_value(action_q.first.get(), action_q.second, fringe ? fringe->q_value_fringe->feature.get() : nullptr, fringe_depth));
-
-      values.push_back(value);
-    }
-
-    // For IEEE-compatible type double, overflow is guaranteed if 709.8 < arg, and underflow is guaranteed if arg < -708.4
-
-    double min_value = *values.begin(), max_value = min_value;
-    for(auto &value : values) {
-      value *= m_inverse_temperature;
-
-      if(value < min_value)
-        min_value = value;
-      else if(value > max_value)
-        max_value = value;
-    }
-
-    if(max_value - min_value > 1218.2) {
-      for(auto &value : values)
-        value = (value - min_value) / (max_value - min_value) * 1218.2 -608.4;
-    }
-    else if(min_value < -608.4) {
-      for(auto &value : values)
-        value += -608.4 - min_value;
-    }
-    else if(max_value > 609.8) {
-      for(auto &value : values)
-        value += 609.8 - max_value;
-    }
-
-    for(auto &value : values) {
-      value = std::exp(value);
-      value_sum += value;
+      for(const auto &action : get_rules_by_rank()) {
+        const auto split = dynamic_cast<Node_Split *>(action->data.get());
+        if(split && split->deferred_children) {
+          split->materialize_children();
+          deferred = true;
+        }
+      }
     }
+  }
 
-    double value = value_sum * random.frand_lt();
-
-    auto vt = values.begin();
-    for(const auto &action_q : m_next_q_values) {
-      if(value < *vt)
-        return action_q.first;
+  Action_Ptr_C Agent::choose_boltzmann(const Node_Fringe * const &fringe, const int64_t &fringe_depth) {
+    compute_boltzmann(fringe, fringe_depth);
 
-      value -= *vt++;
+    if(!m_boltzmann.size()) {
+      get_context().get_err() << "Boltzmann action selection failed! (No candidates)" << std::endl;
+      abort();
     }
 
-    std::cerr << "Boltzmann action selection failed! (No action selected, remainder = " << value << ")" << std::endl;
-    abort();
+    return m_next_q_values.ordered()[m_boltzmann.sample(random.frand_lt())]->action;
   }
 
   Action_Ptr_C Agent::choose_epsilon_greedy(const Node_Fringe * const &fringe, const int64_t &fringe_depth) {
@@ -1661,26 +1784,22 @@ namespace Carli {
 #ifdef ENABLE_T_TEST
 
   Action_Ptr_C Agent::choose_t_test(const Node_Fringe * const &fringe, const int64_t &fringe_depth) {
-    const Q_Value * const parent_q = fringe ? dynamic_cast<Node *>(fringe->parent_action.lock()->data.get())->q_value_weight.get() : nullptr;
+    const tracked_ptr<Q_Value> parent_q = fringe ? dynamic_cast<Node *>(fringe->parent_action.lock()->data.get())->q_value_weight : nullptr;
+    const Feature * const axis = fringe ? fringe->q_value_fringe->feature.get() : nullptr;
     const auto greedy = choose_greedy(fringe, fringe_depth);
-    const auto greedy_weights = m_next_q_values[greedy];
-    const auto greedy_value = parent_q && std::find(greedy_weights.begin(), greedy_weights.end(), parent_q) == greedy_weights.end()
-                            ? sum_value(greedy.get(), greedy_weights, nullptr, fringe_depth)
-                            : sum_value(greedy.get(), greedy_weights, fringe ? fringe->q_value_fringe->feature.get() : nullptr, fringe_depth);
+    const auto greedy_value = candidate_value(*m_next_q_values.find(*greedy), parent_q, axis, fringe_depth).value;
 
     Action_Ptr_C gtewp;
     int32_t gtewp_count = 0;
-    for(const auto &action_q : m_next_q_values) {
-      const auto value = parent_q && std::find(action_q.second.begin(), action_q.second.end(), parent_q) == action_q.second.end()
-                       ? sum_value(action_q.first.get(), action_q.second, nullptr, fringe_depth)
-                       : sum_value(action_q.first.get(), action_q.second, fringe ? fringe->q_value_fringe->feature.get() : nullptr, fringe_depth);
+    for(const auto &candidate : m_next_q_values.ordered()) {
+      const auto value = candidate_value(*candidate, parent_q, axis, fringe_depth).value;
 
       if(probability_gte(std::get<2>(value), std::get<0>(value), std::get<1>(value),
                          std::get<2>(greedy_value), std::get<0>(greedy_value), std::get<1>(greedy_value)))
       {
         ++gtewp_count;
         if(gtewp_count == 1 || random.rand_lt(gtewp_count) == 0)
-          gtewp = action_q.first;
+          gtewp = candidate->action;
       }
     }
 
@@ -1699,29 +1818,25 @@ namespace Carli {
 
   std::list<Action_Ptr_C, Zeni::Pool_Allocator<Action_Ptr_C>> Agent::choose_greedies(const Node_Fringe * const &fringe, const int64_t &fringe_depth) {
 #ifdef DEBUG_OUTPUT
-    std::cerr << "  choose_greedy(";
+    get_context().get_err() << "  choose_greedy(";
     if(fringe)
-      fringe->q_value_fringe->feature->print_axis(std::cerr);
-    std::cerr << ')' << std::endl;
+      fringe->q_value_fringe->feature->print_axis(get_context().get_err());
+    get_context().get_err() << ')' << std::endl;
 #endif
 
     std::list<Action_Ptr_C, Zeni::Pool_Allocator<Action_Ptr_C>> greedies;
     double value = double();
     const tracked_ptr<Q_Value> parent_q = fringe ? dynamic_cast<Node *>(fringe->parent_action.lock()->data.get())->q_value_weight : nullptr;
-    for(const auto &action_q : m_next_q_values) {
-      double value_;
-//      if(parent_q && std::find(action_q.second.begin(), action_q.second.end(), parent_q) == action_q.second.end())
-      if(parent_q && action_q.second.find(parent_q) == action_q.second.end())
-        value_ = std::get<0>(sum_value(action_q.first.get(), action_q.second, nullptr, fringe_depth));
-      else
-        value_ = std::get<0>(sum_value(action_q.first.get(), action_q.second, fringe ? fringe->q_value_fringe->feature.get() : nullptr, fringe_depth));
+    const Feature * const axis = fringe ? fringe->q_value_fringe->feature.get() : nullptr;
+    for(const auto &candidate : m_next_q_values.ordered()) {
+      const double value_ = std::get<0>(candidate_value(*candidate, parent_q, axis, fringe_depth).value);
 
       if(greedies.empty() || value_ > value) {
-        greedies = {{action_q.first}};
+        greedies = {{candidate->action}};
         value = value_;
       }
       else if(value_ == value)
-        greedies.push_back(action_q.first);
+        greedies.push_back(candidate->action);
     }
 
     return greedies;
@@ -1729,37 +1844,50 @@ namespace Carli {
 
   Action_Ptr_C Agent::choose_randomly() {
 #ifdef DEBUG_OUTPUT
-    std::cerr << "  choose_randomly" << std::endl;
+    get_context().get_err() << "  choose_randomly" << std::endl;
 #endif
 
     int32_t counter = int32_t(m_next_q_values.size());
     counter = random.rand_lt(counter) + 1;
     Action_Ptr_C action;
-    for(const auto &action_q : m_next_q_values) {
+    for(const auto &candidate : m_next_q_values.ordered()) {
       if(!--counter)
-        action = action_q.first;
+        action = candidate->action;
     }
 
     return action;
   }
 
+  double Agent::probability_boltzmann(const Action_Ptr_C &action, const Node_Fringe * const &fringe, const int64_t &fringe_depth) {
+    const Candidates::Candidate * const candidate_action = m_next_q_values.find(*action);
+    if(!candidate_action)
+      return 0.0;
+
+    compute_boltzmann(fringe, fringe_depth);
+
+    const auto &ordered = m_next_q_values.ordered();
+    return m_boltzmann.probability(size_t(std::find(ordered.begin(), ordered.end(), candidate_action) - ordered.begin()));
+  }
+
   double Agent::probability_epsilon_greedy(const Action_Ptr_C &action, const double &epsilon, const Node_Fringe * const &fringe, const int64_t &fringe_depth) {
     return (1 - epsilon) * probability_greedy(action, fringe, fringe_depth) + epsilon * probability_random();
   }
 
   double Agent::probability_greedy(const Action_Ptr_C &action, const Node_Fringe * const &fringe, const int64_t &fringe_depth) {
     const tracked_ptr<Q_Value> parent_q = fringe ? dynamic_cast<Node *>(fringe->parent_action.lock()->data.get())->q_value_weight : nullptr;
-    const auto &next_q_values_action = m_next_q_values[action];
-    if(parent_q && next_q_values_action.find(parent_q) == next_q_values_action.end())
+    const Feature * const axis = fringe ? fringe->q_value_fringe->feature.get() : nullptr;
+    const Candidates::Candidate * const candidate_action = m_next_q_values.find(*action);
+    if(parent_q && !(candidate_action && candidate_value(*candidate_action, parent_q, axis, fringe_depth).includes_parent))
       return 0.0;
 
     double count = double();
-    const double value = std::get<0>(sum_value(action.get(), next_q_values_action, fringe ? fringe->q_value_fringe->feature.get() : nullptr, fringe_depth));
+    const double value = candidate_action ? std::get<0>(candidate_value(*candidate_action, parent_q, axis, fringe_depth).value) : double();
 
-    for(const auto &action_q : m_next_q_values) {
-      if(parent_q && action_q.second.find(parent_q) == action_q.second.end())
+    for(const auto &candidate : m_next_q_values) {
+      const auto &sum = candidate_value(candidate, parent_q, axis, fringe_depth);
+      if(!sum.includes_parent)
         continue;
-      const double value_ = std::get<0>(sum_value(action_q.first.get(), action_q.second, fringe ? fringe->q_value_fringe->feature.get() : nullptr, fringe_depth));
+      const double value_ = std::get<0>(sum.value);
 
       if(value_ > value)
         return 0.0;
@@ -1778,6 +1906,8 @@ namespace Carli {
     if(!m_learning_rate)
       return;
 
+    const uint64_t update = ++m_td_update_count;
+
 //    dump_rules(*this);
     assert(!m_badness);
 
@@ -1786,50 +1916,45 @@ namespace Carli {
 
     double q_old = 0.0;
 #ifdef DEBUG_OUTPUT
-    std::cerr << " current :";
+    get_context().get_err() << " current :";
 #endif
     for(const auto &q : current) {
       ++q.first->update_count;
+      q.first->updated = update;
 
       if(q.first->type != Q_Value::Type::FRINGE) {
         q_old += q.first->primary /* * q.weight */;
 #ifdef DEBUG_OUTPUT
-        std::cerr << ' ' << q.first->primary;
+        get_context().get_err() << ' ' << q.first->primary;
 #endif
       }
     }
 #ifdef DEBUG_OUTPUT
-    std::cerr << std::endl;
-    std::cerr << " fringe  :";
+    get_context().get_err() << std::endl;
+    get_context().get_err() << " fringe  :";
     for(const auto &q : current) {
       if(q.first->type == Q_Value::Type::FRINGE)
-        std::cerr << ' ' << q.first->primary;
+        get_context().get_err() << ' ' << q.first->primary;
     }
-    std::cerr << std::endl;
-    std::cerr << " next    :";
+    get_context().get_err() << std::endl;
+    get_context().get_err() << " next    :";
     for(const auto &q : next) {
       if(q.first->type != Q_Value::Type::FRINGE)
-        std::cerr << ' ' << q.first->primary;
+        get_context().get_err() << ' ' << q.first->primary;
     }
-    std::cerr << std::endl;
+    get_context().get_err() << std::endl;
 #endif
 
     m_credit_assignment(current);
 
     double dot_w_phi = 0.0;
-    if(m_secondary_learning_rate) {
-      for(Q_Value::List::list_pointer_type q_ptr = m_eligible; q_ptr; q_ptr = q_ptr->next())
-        (*q_ptr)->eligibility *= rho;
-    }
+    if(m_secondary_learning_rate)
+      m_eligible.scale(rho);
     for(const auto &q : current) {
       if(!q.first->credit)
         continue;
 
-      if(q.first->eligibility < 0.0)
-        q.first->eligible.insert_before(m_eligible);
-
-      q.first->eligibility = (q.first->eligibility == -1.0 ? 0.0 : q.first->eligibility) + (m_secondary_learning_rate ? I * q.first->credit : q.first->credit);
-      q.first->eligibility_init = true;
+      m_eligible.accumulate(*q.first, m_secondary_learning_rate ? I * q.first->credit : q.first->credit);
 
       if(q.first->type != Q_Value::Type::FRINGE)
         dot_w_phi += q.first->secondary;
@@ -1853,14 +1978,18 @@ namespace Carli {
     const bool weight_assignment_all = true;
 #endif
     double dot_w_e = 0.0;
-    for(Q_Value::List::list_pointer_type q_ptr = m_eligible; q_ptr; q_ptr = q_ptr->next()) {
-      Q_Value &q = **q_ptr;
+    for(size_t e = m_eligible.size(); e--; ) {
+      if(!m_eligible.q_value(e))
+        continue;
+      Q_Value &q = *m_eligible.q_value(e);
+      const double eligibility = m_eligible.eligibility(e);
+      q.updated = update;
 
       const double ldelta = weight_assignment_all && q.type != Q_Value::Type::FRINGE ? delta : target_value - q.primary;
-      const double edelta = q.eligibility * ldelta;
+      const double edelta = eligibility * ldelta;
 
       if(q.type != Q_Value::Type::FRINGE)
-        dot_w_e += q.secondary * q.eligibility;
+        dot_w_e += q.secondary * eligibility;
 
       q.primary += m_learning_rate * edelta;
       if(m_secondary_learning_rate && q.credit)
@@ -1871,7 +2000,7 @@ namespace Carli {
         if(q.type_internal) {
           const double abs_delta = fabs(target_value - q.primary);
 #ifdef DEBUG_OUTPUT
-          std::cerr << "Absolute Delta = " << abs_delta << std::endl;
+          get_context().get_err() << "Absolute Delta = " << abs_delta << std::endl;
 #endif
           q.catde += abs_delta;
           q.catde_post_split += abs_delta;
@@ -1879,7 +2008,7 @@ namespace Carli {
         else {
           const double abs_edelta = std::abs(edelta);
 
-          if(q.eligibility_init) {
+          if(m_eligible.initialized(e)) {
             if(q.last_episode_fired != this->m_episode_number) {
               ++q.pseudoepisode_count;
               q.last_episode_fired = this->m_episode_number;
@@ -1927,6 +2056,7 @@ namespace Carli {
         if(q.first->credit) {
           q.first->primary -= m_learning_rate * m_discount_rate * (1 - m_eligibility_trace_decay_rate) * dot_w_e;
           q.first->update_totals();
+          q.first->updated = update;
         }
       }
 
@@ -1938,20 +2068,9 @@ namespace Carli {
       }
     }
 
-    for(Q_Value::List::list_pointer_type q_ptr = m_eligible; q_ptr; ) {
-      Q_Value &q = **q_ptr;
-      const auto q_next = q_ptr->next();
+    m_eligible.decay(m_discount_rate * m_eligibility_trace_decay_rate, m_eligibility_trace_decay_threshold);
 
-      assert(q.eligibility >= 0.0);
-      q.eligibility_init = false;
-      q.eligibility *= m_discount_rate * m_eligibility_trace_decay_rate;
-      if(q.eligibility < m_eligibility_trace_decay_threshold) {
-        q.eligible.erase_from(m_eligible);
-        q.eligibility = -1.0;
-      }
-
-      q_ptr = q_next;
-    }
+    m_next_q_values.invalidate_if([update](const Q_Value &q)->bool {return q.updated == update;});
 
 #ifdef DEBUG_OUTPUT
     double q_new = double();
@@ -1960,21 +2079,21 @@ namespace Carli {
         q_new += q.first->primary /* * q.weight */;
     }
 
-    std::cerr.unsetf(std::ios_base::floatfield);
-    std::cerr << " td_update: " << q_old << " <" << m_learning_rate << "= " << reward << " + " << m_discount_rate << " * " << target_next << std::endl;
-    std::cerr << "            " << delta << " = " << target_value << " - " << q_old << std::endl;
-    std::cerr << "            " << q_new << std::endl;
-    std::cerr.setf(std::ios_base::fixed, std::ios_base::floatfield);
+    get_context().get_err().unsetf(std::ios_base::floatfield);
+    get_context().get_err() << " td_update: " << q_old << " <" << m_learning_rate << "= " << reward << " + " << m_discount_rate << " * " << target_next << std::endl;
+    get_context().get_err() << "            " << delta << " = " << target_value << " - " << q_old << std::endl;
+    get_context().get_err() << "            " << q_new << std::endl;
+    get_context().get_err().setf(std::ios_base::fixed, std::ios_base::floatfield);
 
     for(const auto &q : current) {
       if(q.first->type == Q_Value::Type::UNSPLIT) {
-        std::cerr << " updates:  " << q.first->update_count << std::endl;
+        get_context().get_err() << " updates:  " << q.first->update_count << std::endl;
         if(m_mean_catde_queue_size)
-          std::cerr << " catde q:   " << q.first->catde << " of " << this->m_mean_catde_queue.mean() << ':' << this->m_mean_catde_queue.mean().get_stddev() << std::endl;
+          get_context().get_err() << " catde q:   " << q.first->catde << " of " << this->m_mean_catde_queue.mean() << ':' << this->m_mean_catde_queue.mean().get_stddev() << std::endl;
         else
-          std::cerr << " catde:     " << q.first->catde << " of " << this->m_mean_catde << ':' << this->m_mean_catde.get_stddev() << std::endl;
+          get_context().get_err() << " catde:     " << q.first->catde << " of " << this->m_mean_catde << ':' << this->m_mean_catde.get_stddev() << std::endl;
 #ifdef TRACK_MEAN_ABSOLUTE_BELLMAN_ERROR
-        std::cerr << " matde:     " << q.first->matde << " of " << this->m_mean_matde << ':' << this->m_mean_matde.get_stddev() << std::endl;
+        get_context().get_err() << " matde:     " << q.first->matde << " of " << this->m_mean_matde << ':' << this->m_mean_matde.get_stddev() << std::endl;
 #endif
       }
     }
@@ -1982,14 +2101,7 @@ namespace Carli {
   }
 
   void Agent::clear_eligibility_trace() {
-    for(auto q = m_eligible->begin(), next = q; q != m_eligible->end(); q = next) {
-      ++next;
-      q->eligible.erase_hard();
-      q->eligibility_init = false;
-      q->eligibility = -1.0;
-    }
-
-    m_eligible.zero();
+    m_eligible.clear();
   }
 
   //#ifdef ENABLE_WEIGHT
@@ -2233,12 +2345,12 @@ namespace Carli {
         }
 
         if(!hog) {
-          std::cerr << "WARNING: No feature in the fringe matches the current token for " << general.rete_action.lock()->get_name() << "!" << std::endl;
+          get_context().get_err() << "WARNING: No feature in the fringe matches the current token for " << general.rete_action.lock()->get_name() << "!" << std::endl;
 
           for(auto fringe_axis = general.fringe_values.begin(), fend = general.fringe_values.end(); fringe_axis != fend; ++fringe_axis) {
             for(auto &fringe : fringe_axis->second) {
               if(fringe.lock()->q_value_fringe->feature->arity == -1) {
-                fringe.lock()->rete_action.lock()->print_rule(std::cerr);
+                fringe.lock()->rete_action.lock()->print_rule(get_context().get_err());
               }
             }
           }
@@ -2336,14 +2448,14 @@ namespace Carli {
         continue;
 
 #ifdef DEBUG_OUTPUT
-      std::cerr << "Greedy mismatch for axis: ";
-      fringe_axis->first->print_axis(std::cerr);
-      std::cerr << " by ";
+      get_context().get_err() << "Greedy mismatch for axis: ";
+      fringe_axis->first->print_axis(get_context().get_err());
+      get_context().get_err() << " by ";
       if(chosen_axis != general.fringe_values.end())
-        chosen_axis->first->print_axis(std::cerr);
+        chosen_axis->first->print_axis(get_context().get_err());
       else
-        std::cerr << "nullptr";
-      std::cerr << std::endl;
+        get_context().get_err() << "nullptr";
+      get_context().get_err() << std::endl;
 #endif
 
       chosen_axis = fringe_axis;
@@ -2362,12 +2474,12 @@ namespace Carli {
         }
 
         if(!hog) {
-          std::cerr << "WARNING: No feature in the fringe matches the current token for " << general.rete_action.lock()->get_name() << "!" << std::endl;
+          get_context().get_err() << "WARNING: No feature in the fringe matches the current token for " << general.rete_action.lock()->get_name() << "!" << std::endl;
 
           for(auto fringe_axis = general.fringe_values.begin(), fend = general.fringe_values.end(); fringe_axis != fend; ++fringe_axis) {
             for(auto &fringe : fringe_axis->second) {
               if(fringe.lock()->q_value_fringe->feature->arity == -1) {
-                fringe.lock()->rete_action.lock()->print_rule(std::cerr);
+                fringe.lock()->rete_action.lock()->print_rule(get_context().get_err());
               }
             }
           }
@@ -2411,7 +2523,7 @@ namespace Carli {
         auto fringe = fringe_w.lock();
 
         if(!fringe) {
-          std::cerr << general.rete_action.lock()->get_name() << " has expired weak pointer in fringe!" << std::endl;
+          get_context().get_err() << general.rete_action.lock()->get_name() << " has expired weak pointer in fringe!" << std::endl;
           dump_rules(*this);
           abort();
           return general.fringe_values.end();
@@ -2484,12 +2596,12 @@ namespace Carli {
         }
 
         if(!hog) {
-          std::cerr << "WARNING: No feature in the fringe matches the current token for " << general.rete_action.lock()->get_name() << "!" << std::endl;
+          get_context().get_err() << "WARNING: No feature in the fringe matches the current token for " << general.rete_action.lock()->get_name() << "!" << std::endl;
 
           for(auto fringe_axis = general.fringe_values.begin(), fend = general.fringe_values.end(); fringe_axis != fend; ++fringe_axis) {
             for(auto &fringe : fringe_axis->second) {
               if(fringe.lock()->q_value_fringe->feature->arity == -1) {
-                fringe.lock()->rete_action.lock()->print_rule(std::cerr);
+                fringe.lock()->rete_action.lock()->print_rule(get_context().get_err());
               }
             }
           }
@@ -2543,7 +2655,7 @@ namespace Carli {
     const double improvement = general.q_value_fringe->catde_post_split * boost_general - sum_error * boost_children;
 
 #ifdef DEBUG_OUTPUT
-    std::cerr << "CATDE Improvement = " << general.q_value_fringe->catde_post_split << " - " << sum_error << " = " << improvement << std::endl;
+    get_context().get_err() << "CATDE Improvement = " << general.q_value_fringe->catde_post_split << " - " << sum_error << " = " << improvement << std::endl;
 #endif
 
     /// Counterintuitive: actually unsplit if error is reduced in the children?
@@ -2630,7 +2742,7 @@ namespace Carli {
     const double improvement = max_score - chosen_score;
 
 #ifdef DEBUG_OUTPUT
-    std::cerr << "Policy Improvement = " << max_score << " - " << chosen_score << " = " << improvement << ')' << std::endl;
+    get_context().get_err() << "Policy Improvement = " << max_score << " - " << chosen_score << " = " << improvement << ')' << std::endl;
 #endif
 
     return improvement > 0.0;
@@ -2690,7 +2802,7 @@ namespace Carli {
     const double improvement = fringe_spread - (child_range.second - child_range.first) * boost_general;
 
 #ifdef DEBUG_OUTPUT
-    std::cerr << "Value Improvement = " << fringe_spread
+    get_context().get_err() << "Value Improvement = " << fringe_spread
               << " - (" << child_range.second << " - " << child_range.first << " = " << improvement << ')' << std::endl;
 #endif
 
@@ -2716,8 +2828,8 @@ namespace Carli {
                                                        const int64_t &fringe_depth) const {
 #ifdef DEBUG_OUTPUT
     if(action) {
-      std::cerr.unsetf(std::ios_base::floatfield);
-      std::cerr << "   sum_value(" << *action << ") = " << value_list.size() << " {";
+      get_context().get_err().unsetf(std::ios_base::floatfield);
+      get_context().get_err() << "   sum_value(" << *action << ") = " << value_list.size() << " {";
     }
 #endif
 
@@ -2734,11 +2846,11 @@ namespace Carli {
       const bool any_contribution = fringe_contribution || normal_contribution;
 #ifdef DEBUG_OUTPUT
       if(action && (!axis || any_contribution)) {
-        std::cerr << ' ' << q.first->primary << ';' << q.first->primary_variance << ':' << q.first->depth;
+        get_context().get_err() << ' ' << q.first->primary << ';' << q.first->primary_variance << ':' << q.first->depth;
         if(q.first->type == Q_Value::Type::FRINGE)
-          std::cerr << (q.first->type_internal ? 'i' : 'f');
+          get_context().get_err() << (q.first->type_internal ? 'i' : 'f');
         if(q.first->feature)
-          std::cerr << ':' << *q.first->feature;
+          get_context().get_err() << ':' << *q.first->feature;
       }
 #endif
       if(any_contribution) {
@@ -2763,7 +2875,7 @@ namespace Carli {
 //#endif
 #ifdef DEBUG_OUTPUT
     if(action)
-      std::cerr << " } = ";
+      get_context().get_err() << " } = ";
 
     if(!(touched || value_list.empty())) {
       dump_rules(*this);
@@ -2773,14 +2885,37 @@ namespace Carli {
     }
 
     if(action) {
-      std::cerr << sum << " + " << stddev << " = " << sum + stddev << std::endl;
-      std::cerr.setf(std::ios_base::fixed, std::ios_base::floatfield);
+      get_context().get_err() << sum << " + " << stddev << " = " << sum + stddev << std::endl;
+      get_context().get_err().setf(std::ios_base::fixed, std::ios_base::floatfield);
     }
 #endif
 
     return std::make_tuple(sum, stddev, min_update_count);
   }
 
+  const Candidates::Sum & Agent::candidate_value(const Candidates::Candidate &candidate, const tracked_ptr<Q_Value> &parent_q, const Feature * const &axis, const int64_t &fringe_depth) const {
+    if(const Candidates::Sum * const cached = m_next_q_values.find_sum(candidate, parent_q.get(), axis, fringe_depth))
+      return *cached;
+
+    Candidates::Sum sum;
+    sum.parent = parent_q.get();
+    sum.axis = axis;
+    sum.fringe_depth = fringe_depth;
+    sum.includes_parent = !parent_q || candidate.q_values.find(parent_q) != candidate.q_values.end();
+    sum.value = sum_value(candidate.action.get(), candidate.q_values, sum.includes_parent ? axis : nullptr, fringe_depth);
+    return m_next_q_values.insert_sum(candidate, sum);
+  }
+
+  void Agent::compute_boltzmann(const Node_Fringe * const &fringe, const int64_t &fringe_depth) {
+    const tracked_ptr<Q_Value> parent_q = fringe ? dynamic_cast<Node *>(fringe->parent_action.lock()->data.get())->q_value_weight : nullptr;
+    const Feature * const axis = fringe ? fringe->q_value_fringe->feature.get() : nullptr;
+
+    m_boltzmann.clear(m_inverse_temperature);
+    for(const auto &candidate : m_next_q_values.ordered())
+      m_boltzmann.push_back(std::get<0>(candidate_value(*candidate, parent_q, axis, fringe_depth).value));
+    m_boltzmann.compute();
+  }
+
   //void Agent::print_value_function_grid_set(std::ostream &os, const std::set<typename Node_Ranged::Line, std::less<typename Node_Ranged::Line>, Zeni::Pool_Allocator<typename Node_Ranged::Line>> &line_segments) const {
   //  for(const auto &line_segment : line_segments)
   //    os << line_segment.first.first << ',' << line_segment.first.second << '/' << line_segment.second.first << ',' << line_segment.second.second << std::endl;
@@ -2913,7 +3048,7 @@ namespace Carli {
   //  }
 
   void Agent::generate_all_features() {
-    m_nodes_active.swap(m_nodes_activating);
+    std::swap(m_nodes_active, m_nodes_activating);
 
     generate_features();
 
@@ -2921,32 +3056,25 @@ namespace Carli {
       Node_Tracker::get().validate(*this, nullptr);
 #endif
 
-    while(!m_nodes_activating.empty()) {
+    while(m_nodes_activating) {
 //#ifndef NDEBUG
 //      Node_Tracker::get().validate(*this);
 //#endif
 
-      const auto nat = m_nodes_activating.begin();
-      const auto node = *nat;
-      m_nodes_activating.erase(nat);
-      m_nodes_active.insert(node);
+      const Node_Ptr node = m_nodes_activating->get()->shared_from_this();
+      node->activation.erase_from(m_nodes_activating);
+      node->activation.insert_before(m_nodes_active);
 
       Rete::Agenda::Locker lock(agenda);
 //      std::cerr << "Testing action " << node->rete_action.lock()->get_name() << std::endl;
 //      assert(node->rete_action.lock()->is_active());
-      node.first->decision();
+      node->decision();
     }
 
 #ifndef NDEBUG
     Node_Tracker::get().validate(*this, nullptr);
 #endif
 
-    for(auto it = m_next_q_values.begin(), iend = m_next_q_values.end(); it != iend; ) {
-      if(it->second.empty())
-        m_next_q_values.erase(it++);
-      else
-        ++it;
-    }
   }
 
 }
@@ -6,6 +6,9 @@
 
 #include "rete/rete_agent.h"
 
+#include "boltzmann.h"
+#include "candidates.h"
+#include "eligibility_trace.h"
 #include "environment.h"
 #include "feature.h"
 #include "node.h"
@@ -18,6 +21,7 @@
 #include <set>
 #include <stack>
 #include <string>
+#include <unordered_map>
 
 #include <iostream>
 #include <fstream>
@@ -34,7 +38,7 @@ namespace Carli {
     typedef Feature feature_type;
     typedef Action action_type;
     typedef double reward_type;
-    typedef std::unordered_map<tracked_ptr<Q_Value>, int64_t> Q_Value_List;
+    typedef Carli::Q_Value_List Q_Value_List;
 
     bool respecialize(Rete::Rete_Action &rete_action);
     bool specialize(Rete::Rete_Action &rete_action);
@@ -87,8 +91,20 @@ namespace Carli {
 
     void set_total_step_count(const int64_t &total_step_count_) {m_total_step_count = total_step_count_;}
 
+    /// Nodes, and the Q-values they first hold, are listed in the order of their creation wherever order could change the course of a run
+    int64_t next_creation_index() {return m_creation_index++;}
+    int64_t get_creation_index() const {return m_creation_index;}
+    void set_creation_index(const int64_t &creation_index_) {m_creation_index = creation_index_;}
+
     void reset_statistics();
 
+    /// Counters, exploration schedules, statistics, random state, and the environment, between episodes
+    /// Rules, their values, and working memory are left to a checkpointer, which must restore them before load
+    /// Both throw std::runtime_error mid-episode, as the eligibility trace and the environment's state within an episode are not recorded
+    void save(std::ostream &os) const;
+    void load(std::istream &is);
+    bool is_mid_episode() const; ///< Acted since init() without reaching a terminal state or the step cutoff
+
     void init();
 
     reward_type act();
@@ -103,6 +119,9 @@ namespace Carli {
 
     void purge_q_value_eligible(const tracked_ptr<Q_Value> &q_value);
 
+    /// Must be called whenever Q-values contributing to candidate actions change in ways that affect their sums
+    void invalidate_value_sums() {m_next_q_values.invalidate();}
+
     void print(std::ostream &os) const;
 
     //void print_value_function_grid(std::ostream &os) const;
@@ -110,13 +129,17 @@ namespace Carli {
     void visit_increment_depth();
     void visit_reset_update_count();
 
-    const std::function<Carli::Action_Ptr_C (const Rete::Variable_Indices &variables, const Rete::WME_Token &token)> get_action;
+    void materialize_deferred(); ///< Build every rule a lazily loaded rules file still defers
+
+    /// Get the canonical action bound by the token, only asking the environment to make one for unfamiliar bindings
+    Action_Ptr_C get_action(const Rete::Variable_Indices_Ptr_C &variables, const Rete::WME_Token &token);
+
     int64_t q_value_count = 0;
 
-    std::unordered_map<Node_Ptr, int64_t> m_nodes_active;
-    std::unordered_map<Node_Ptr, int64_t> m_nodes_activating;
+    Node::List::list_pointer_type m_nodes_active = nullptr;
+    Node::List::list_pointer_type m_nodes_activating = nullptr; ///< Nodes awaiting a decision
 
-    const bool terse_out = get_Option_Ranged<bool>(Options::get_global(), "terse-out");
+    const bool terse_out = get_Option_Ranged<bool>(get_context().get_options(), "terse-out");
 
   protected:
     Action_Ptr_C choose_boltzmann(const Node_Fringe * const &fringe, const int64_t &fringe_depth);
@@ -128,6 +151,7 @@ namespace Carli {
     std::list<Action_Ptr_C, Zeni::Pool_Allocator<Action_Ptr_C>> choose_greedies(const Node_Fringe * const &fringe, const int64_t &fringe_depth);
     Action_Ptr_C choose_randomly();
 
+    double probability_boltzmann(const Action_Ptr_C &action, const Node_Fringe * const &fringe, const int64_t &fringe_depth);
     double probability_epsilon_greedy(const Action_Ptr_C &action, const double &epsilon, const Node_Fringe * const &fringe, const int64_t &fringe_depth);
     double probability_greedy(const Action_Ptr_C &action, const Node_Fringe * const &fringe, const int64_t &fringe_depth);
     double probability_random();
@@ -163,6 +187,10 @@ namespace Carli {
 
     /// Get the sample mean and standard deviation
     std::tuple<double, double, int64_t> sum_value(const action_type * const &action, const Q_Value_List &value_list, const Feature * const &axis, const int64_t &fringe_depth) const;
+    /// Get the value of a candidate with respect to a fringe node's parent and axis, summing it only if not already cached
+    const Candidates::Sum & candidate_value(const Candidates::Candidate &candidate, const tracked_ptr<Q_Value> &parent_q, const Feature * const &axis, const int64_t &fringe_depth) const;
+    /// Compute Boltzmann weights for the candidates, in order
+    void compute_boltzmann(const Node_Fringe * const &fringe, const int64_t &fringe_depth);
 
     void generate_all_features();
 
@@ -186,22 +214,26 @@ namespace Carli {
     Action_Ptr_C m_current;
     Q_Value_List m_current_q_value;
     Action_Ptr_C m_next;
-    std::map<Action_Ptr_C, Q_Value_List, Rete::compare_deref_lt, Zeni::Pool_Allocator<std::pair<const Action_Ptr_C, Q_Value_List>>> m_next_q_values;
+    Candidates m_next_q_values;
+    uint64_t m_td_update_count = 0; ///< Stamps the Q-values each td_update changes, so only their candidates' sums are discarded
+    Boltzmann m_boltzmann; ///< Scratch space for Boltzmann action selection
     std::function<Action_Ptr_C ()> m_target_policy; ///< Sarsa/Q-Learning selector
     std::function<Action_Ptr_C ()> m_exploration_policy; ///< Exploration policy
     std::function<Fringe_Values::iterator (Node_Unsplit &)> m_split_criterion; ///< true if too general, false if sufficiently general
     std::function<bool (Node_Split &)> m_unsplit_criterion; ///< true if too general, false if sufficiently general
     //std::map<Action_Ptr_C, std::set<typename Node_Ranged::Line, std::less<typename Node_Ranged::Line>, Zeni::Pool_Allocator<typename Node_Ranged::Line>>, std::less<Action_Ptr_C>, Zeni::Pool_Allocator<std::pair<Action_Ptr_C, std::set<typename Node_Ranged::Line, std::less<typename Node_Ranged::Line>, Zeni::Pool_Allocator<typename Node_Ranged::Line>>>>> m_lines;
 
-    Rete::Symbol_Identifier_Ptr_C m_s_id = Rete::Symbol_Identifier_Ptr_C(new Rete::Symbol_Identifier("S1"));
+    Rete::Symbol_Identifier_Ptr_C m_s_id = Rete::Symbol_Identifier::intern("S1");
 
   private:
     virtual void generate_features() = 0;
     virtual void update() = 0;
+    virtual void save_impl(std::ostream &) const {}
+    virtual void load_impl(std::istream &) {} ///< Working memory is already restored
 
     Mean m_mean_catde;
     Value_Queue m_mean_catde_queue;
-    const int64_t m_mean_catde_queue_size = get_Option_Ranged<int64_t>(Options::get_global(), "mean-catde-queue-size");
+    const int64_t m_mean_catde_queue_size = get_Option_Ranged<int64_t>(get_context().get_options(), "mean-catde-queue-size");
 
   #ifdef TRACK_MEAN_ABSOLUTE_BELLMAN_ERROR
     Mean m_mean_matde;
@@ -213,68 +245,88 @@ namespace Carli {
 
     std::shared_ptr<Environment> m_environment;
 
+    struct Action_Key {
+      Rete::Variable_Indices_Ptr_C variables;
+      std::vector<Rete::Symbol_Ptr_C> symbols; ///< Bound symbols, held so that their addresses cannot be reused
+      Action_Ptr_C action;
+    };
+
+    static bool is_bound(const Rete::WME_Token_Index &index, const Rete::WME_Token &token) {
+      return !index.existential && index.token_row < token.size();
+    }
+
+    void prune_actions();
+
+    const std::function<Action_Ptr_C (const Rete::Variable_Indices &variables, const Rete::WME_Token &token)> m_make_action;
+    std::unordered_multimap<size_t, Action_Key> m_action_keys; ///< Keyed by the variables and the addresses of the symbols they bind
+    std::set<Action_Ptr_C, Rete::compare_deref_lt> m_actions; ///< Canonical actions
+    size_t m_action_prune_size = 64;
+
     Zeni::Random random;
 
     int64_t m_episode_number = 1;
     int64_t m_step_count = 0;
     int64_t m_total_step_count = 0;
+    int64_t m_creation_index = 0;
     reward_type m_total_reward = 0.0;
-    const int64_t m_step_cutoff = dynamic_cast<const Option_Ranged<int64_t> &>(Options::get_global()["step-cutoff"]).get_value();
+    const int64_t m_step_cutoff = dynamic_cast<const Option_Ranged<int64_t> &>(get_context().get_options()["step-cutoff"]).get_value();
+
+    const int64_t m_value_function_cap = get_Option_Ranged<int64_t>(get_context().get_options(), "value-function-cap"); ///< at this threshold, no more entries will be added to the value functions through refinement
 
-    const int64_t m_value_function_cap = get_Option_Ranged<int64_t>(Options::get_global(), "value-function-cap"); ///< at this threshold, no more entries will be added to the value functions through refinement
+    const double m_learning_rate = get_Option_Ranged<double>(get_context().get_options(), "learning-rate"); ///< alpha
+    const double m_secondary_learning_rate = get_Option_Ranged<double>(get_context().get_options(), "secondary-learning-rate"); ///< eta
+    const double m_discount_rate = get_Option_Ranged<double>(get_context().get_options(), "discount-rate"); ///< gamma
+    const double m_eligibility_trace_decay_rate = get_Option_Ranged<double>(get_context().get_options(), "eligibility-trace-decay-rate"); ///< lambda
+    const double m_eligibility_trace_decay_threshold = get_Option_Ranged<double>(get_context().get_options(), "eligibility-trace-decay-threshold");
 
-    const double m_learning_rate = get_Option_Ranged<double>(Options::get_global(), "learning-rate"); ///< alpha
-    const double m_secondary_learning_rate = get_Option_Ranged<double>(Options::get_global(), "secondary-learning-rate"); ///< eta
-    const double m_discount_rate = get_Option_Ranged<double>(Options::get_global(), "discount-rate"); ///< gamma
-    const double m_eligibility_trace_decay_rate = get_Option_Ranged<double>(Options::get_global(), "eligibility-trace-decay-rate"); ///< lambda
-    const double m_eligibility_trace_decay_threshold = get_Option_Ranged<double>(Options::get_global(), "eligibility-trace-decay-threshold");
+    const std::string m_exploration_code = dynamic_cast<const Option_Itemized &>(get_context().get_options()["exploration"]).get_value();
 
-    const std::string m_credit_assignment_code = dynamic_cast<const Option_Itemized &>(Options::get_global()["credit-assignment"]).get_value();
+    const std::string m_credit_assignment_code = dynamic_cast<const Option_Itemized &>(get_context().get_options()["credit-assignment"]).get_value();
     const std::function<void (const Q_Value_List &)> m_credit_assignment; ///< How to assign credit to multiple Q-values
-    const double m_credit_assignment_epsilon = get_Option_Ranged<double>(Options::get_global(), "credit-assignment-epsilon");
-    const double m_credit_assignment_log_base = get_Option_Ranged<double>(Options::get_global(), "credit-assignment-log-base");
+    const double m_credit_assignment_epsilon = get_Option_Ranged<double>(get_context().get_options(), "credit-assignment-epsilon");
+    const double m_credit_assignment_log_base = get_Option_Ranged<double>(get_context().get_options(), "credit-assignment-log-base");
     const double m_credit_assignment_log_base_value = std::log(m_credit_assignment_log_base);
-    const double m_credit_assignment_root = get_Option_Ranged<double>(Options::get_global(), "credit-assignment-root");
+    const double m_credit_assignment_root = get_Option_Ranged<double>(get_context().get_options(), "credit-assignment-root");
     const double m_credit_assignment_root_value = 1.0 / m_credit_assignment_root;
-    const bool m_credit_assignment_normalize = get_Option_Ranged<bool>(Options::get_global(), "credit-assignment-normalize");
+    const bool m_credit_assignment_normalize = get_Option_Ranged<bool>(get_context().get_options(), "credit-assignment-normalize");
 
   //#ifdef ENABLE_WEIGHT
-  //  const std::string m_weight_assignment_code = dynamic_cast<const Option_Itemized &>(Options::get_global()["weight-assignment"]).get_value();
+  //  const std::string m_weight_assignment_code = dynamic_cast<const Option_Itemized &>(get_context().get_options()["weight-assignment"]).get_value();
   //  const std::function<void (Q_Value::List * const &)> m_weight_assignment; ///< How to assign weight to multiple Q-values at summation time
   //#endif
 
-    const bool m_on_policy = dynamic_cast<const Option_Itemized &>(Options::get_global()["policy"]).get_value() == "on-policy"; ///< for Sarsa/Q-learning selection
-    const double m_inverse_epsilon_episodic_increment = get_Option_Ranged<double>(Options::get_global(), "inverse-epsilon-episodic-increment"); ///< for epsilon-greedy decision-making
-    const double m_epsilon_initial = get_Option_Ranged<double>(Options::get_global(), "epsilon-greedy"); ///< for epsilon-greedy decision-making
-    double m_epsilon = get_Option_Ranged<double>(Options::get_global(), "epsilon-greedy"); ///< for epsilon-greedy decision-making
+    const bool m_on_policy = dynamic_cast<const Option_Itemized &>(get_context().get_options()["policy"]).get_value() == "on-policy"; ///< for Sarsa/Q-learning selection
+    const double m_inverse_epsilon_episodic_increment = get_Option_Ranged<double>(get_context().get_options(), "inverse-epsilon-episodic-increment"); ///< for epsilon-greedy decision-making
+    const double m_epsilon_initial = get_Option_Ranged<double>(get_context().get_options(), "epsilon-greedy"); ///< for epsilon-greedy decision-making
+    double m_epsilon = get_Option_Ranged<double>(get_context().get_options(), "epsilon-greedy"); ///< for epsilon-greedy decision-making
 #ifdef ENABLE_T_TEST
-    const double m_t_test = get_Option_Ranged<double>(Options::get_global(), "t-test"); ///< for t-test decision-making
+    const double m_t_test = get_Option_Ranged<double>(get_context().get_options(), "t-test"); ///< for t-test decision-making
 #endif
-    const double m_inverse_temperature_episodic_increment = get_Option_Ranged<double>(Options::get_global(), "inverse-temperature-episodic-increment"); ///< for Boltzmann decision-making
-    const double m_inverse_temperature_initial = get_Option_Ranged<double>(Options::get_global(), "inverse-temperature"); ///< for Boltzmann decision-making
-    double m_inverse_temperature = get_Option_Ranged<double>(Options::get_global(), "inverse-temperature"); ///< for Boltzmann decision-making
-
-    const int64_t m_pseudoepisode_threshold = get_Option_Ranged<int64_t>(Options::get_global(), "pseudoepisode-threshold"); ///< For deciding how many steps indicates a pseudoepisode
-    const double m_split_catde = get_Option_Ranged<double>(Options::get_global(), "split-catde");
-    const double m_split_catde_qmult = get_Option_Ranged<double>(Options::get_global(), "split-catde-qmult");
-    const int64_t m_split_max = get_Option_Ranged<int64_t>(Options::get_global(), "split-max");
-    const int64_t m_split_min = get_Option_Ranged<int64_t>(Options::get_global(), "split-min");
-    const int64_t m_split_pseudoepisodes = get_Option_Ranged<int64_t>(Options::get_global(), "split-pseudoepisodes");
-    const std::string m_split_test = dynamic_cast<const Option_Itemized &>(Options::get_global()["split-test"]).get_value();
-    const std::string m_unsplit_test = dynamic_cast<const Option_Itemized &>(Options::get_global()["unsplit-test"]).get_value();
-    const int64_t m_split_update_count = get_Option_Ranged<int64_t>(Options::get_global(), "split-update-count");
-    const int64_t m_unsplit_update_count = get_Option_Ranged<int64_t>(Options::get_global(), "unsplit-update-count");
-    const int64_t m_concrete_update_count = get_Option_Ranged<int64_t>(Options::get_global(), "concrete-update-count");
-    const std::string m_resplit_bias = dynamic_cast<const Option_Itemized &>(Options::get_global()["resplit-bias"]).get_value();
-    const double m_resplit_boost_scale = get_Option_Ranged<double>(Options::get_global(), "resplit-boost-scale");
-    const double m_split_probability = get_Option_Ranged<double>(Options::get_global(), "split-probability");
-    const double m_unsplit_probability = get_Option_Ranged<double>(Options::get_global(), "unsplit-probability");
-
-    const int64_t m_contribute_update_count = get_Option_Ranged<int64_t>(Options::get_global(), "contribute-update-count");
-    const bool m_dynamic_midpoint = get_Option_Ranged<bool>(Options::get_global(), "dynamic-midpoint");
-    const double m_fringe_learning_scale = get_Option_Ranged<double>(Options::get_global(), "fringe-learning-scale");
-
-    Q_Value::List::list_pointer_type m_eligible;
+    const double m_inverse_temperature_episodic_increment = get_Option_Ranged<double>(get_context().get_options(), "inverse-temperature-episodic-increment"); ///< for Boltzmann decision-making
+    const double m_inverse_temperature_initial = get_Option_Ranged<double>(get_context().get_options(), "inverse-temperature"); ///< for Boltzmann decision-making
+    double m_inverse_temperature = get_Option_Ranged<double>(get_context().get_options(), "inverse-temperature"); ///< for Boltzmann decision-making
+
+    const int64_t m_pseudoepisode_threshold = get_Option_Ranged<int64_t>(get_context().get_options(), "pseudoepisode-threshold"); ///< For deciding how many steps indicates a pseudoepisode
+    const double m_split_catde = get_Option_Ranged<double>(get_context().get_options(), "split-catde");
+    const double m_split_catde_qmult = get_Option_Ranged<double>(get_context().get_options(), "split-catde-qmult");
+    const int64_t m_split_max = get_Option_Ranged<int64_t>(get_context().get_options(), "split-max");
+    const int64_t m_split_min = get_Option_Ranged<int64_t>(get_context().get_options(), "split-min");
+    const int64_t m_split_pseudoepisodes = get_Option_Ranged<int64_t>(get_context().get_options(), "split-pseudoepisodes");
+    const std::string m_split_test = dynamic_cast<const Option_Itemized &>(get_context().get_options()["split-test"]).get_value();
+    const std::string m_unsplit_test = dynamic_cast<const Option_Itemized &>(get_context().get_options()["unsplit-test"]).get_value();
+    const int64_t m_split_update_count = get_Option_Ranged<int64_t>(get_context().get_options(), "split-update-count");
+    const int64_t m_unsplit_update_count = get_Option_Ranged<int64_t>(get_context().get_options(), "unsplit-update-count");
+    const int64_t m_concrete_update_count = get_Option_Ranged<int64_t>(get_context().get_options(), "concrete-update-count");
+    const std::string m_resplit_bias = dynamic_cast<const Option_Itemized &>(get_context().get_options()["resplit-bias"]).get_value();
+    const double m_resplit_boost_scale = get_Option_Ranged<double>(get_context().get_options(), "resplit-boost-scale");
+    const double m_split_probability = get_Option_Ranged<double>(get_context().get_options(), "split-probability");
+    const double m_unsplit_probability = get_Option_Ranged<double>(get_context().get_options(), "unsplit-probability");
+
+    const int64_t m_contribute_update_count = get_Option_Ranged<int64_t>(get_context().get_options(), "contribute-update-count");
+    const bool m_dynamic_midpoint = get_Option_Ranged<bool>(get_context().get_options(), "dynamic-midpoint");
+    const double m_fringe_learning_scale = get_Option_Ranged<double>(get_context().get_options(), "fringe-learning-scale");
+
+    Eligibility_Trace m_eligible;
 
   #ifndef NDEBUG
     void increment_badness() {++m_badness; assert(m_badness);}
@@ -282,12 +334,12 @@ namespace Carli {
     size_t m_badness = 0u;
   #endif
 
-    const std::string m_value_function_map_mode = dynamic_cast<const Option_Itemized &>(Options::get_global()["value-function-map-mode"]).get_value();
-    const std::string m_value_function_map_filename = dynamic_cast<const Option_String &>(Options::get_global()["value-function-map-filename"]).get_value();
+    const std::string m_value_function_map_mode = dynamic_cast<const Option_Itemized &>(get_context().get_options()["value-function-map-mode"]).get_value();
+    const std::string m_value_function_map_filename = dynamic_cast<const Option_String &>(get_context().get_options()["value-function-map-filename"]).get_value();
     std::unordered_set<std::string> m_value_function_map;
     mutable std::ofstream m_value_function_out;
 
-    const bool m_output_dot = get_Option_Ranged<bool>(Options::get_global(), "output-dot");
+    const bool m_output_dot = get_Option_Ranged<bool>(get_context().get_options(), "output-dot");
     size_t g_output_dot_exp_count = 0u;
     size_t g_output_dot_col_count = 0u;
 
@@ -0,0 +1,130 @@
+#include "boltzmann.h"
+
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CARLI_BOLTZMANN_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace Carli {
+
+  namespace {
+
+    /// exp(x) for x <= 0, following Cephes: Cody-Waite reduction by ln(2) and a Pade approximant, flushing to 0 below ln(2^-1022)
+    /// The scalar and SSE2 versions perform identical operations, so results do not depend on batch alignment or on the libm
+
+    const double exp_lower_bound = -708.39641853226408;
+    const double exp_log2e = 1.4426950408889634074;
+    const double exp_round = 6755399441055744.0; ///< 1.5 * 2^52, so adding and subtracting it rounds to the nearest integer
+    const double exp_c1 = 6.93145751953125E-1;
+    const double exp_c2 = 1.42860682030941723212E-6;
+    const double exp_p0 = 1.26177193074810590878E-4;
+    const double exp_p1 = 3.02994407707441961300E-2;
+    const double exp_p2 = 9.99999999999999999910E-1;
+    const double exp_q0 = 3.00198505138664455042E-6;
+    const double exp_q1 = 2.52448340349684104192E-3;
+    const double exp_q2 = 2.27265548208155028766E-1;
+    const double exp_q3 = 2.00000000000000000009E0;
+
+    double exp_nonpositive(const double &x) {
+      if(!(x >= exp_lower_bound))
+        return 0.0;
+
+      const double n = (x * exp_log2e + exp_round) - exp_round;
+      const double r = (x - n * exp_c1) - n * exp_c2;
+      const double rr = r * r;
+      const double px = r * ((exp_p0 * rr + exp_p1) * rr + exp_p2);
+      const double qx = ((exp_q0 * rr + exp_q1) * rr + exp_q2) * rr + exp_q3;
+      const double e = 1.0 + 2.0 * (px / (qx - px));
+
+      const uint64_t bits = uint64_t(int64_t(n) + 1023) << 52;
+      double scale;
+      std::memcpy(&scale, &bits, sizeof(scale));
+      return e * scale;
+    }
+
+#ifdef CARLI_BOLTZMANN_SSE2
+    __m128d exp_nonpositive(const __m128d &x) {
+      const __m128d in_range = _mm_cmpge_pd(x, _mm_set1_pd(exp_lower_bound));
+      const __m128d x_ = _mm_max_pd(x, _mm_set1_pd(exp_lower_bound));
+
+      const __m128d round = _mm_set1_pd(exp_round);
+      const __m128d n = _mm_sub_pd(_mm_add_pd(_mm_mul_pd(x_, _mm_set1_pd(exp_log2e)), round), round);
+      const __m128d r = _mm_sub_pd(_mm_sub_pd(x_, _mm_mul_pd(n, _mm_set1_pd(exp_c1))), _mm_mul_pd(n, _mm_set1_pd(exp_c2)));
+      const __m128d rr = _mm_mul_pd(r, r);
+      const __m128d px = _mm_mul_pd(r, _mm_add_pd(_mm_mul_pd(_mm_add_pd(_mm_mul_pd(_mm_set1_pd(exp_p0), rr), _mm_set1_pd(exp_p1)), rr), _mm_set1_pd(exp_p2)));
+      const __m128d qx = _mm_add_pd(_mm_mul_pd(_mm_add_pd(_mm_mul_pd(_mm_add_pd(_mm_mul_pd(_mm_set1_pd(exp_q0), rr), _mm_set1_pd(exp_q1)), rr), _mm_set1_pd(exp_q2)), rr), _mm_set1_pd(exp_q3));
+      const __m128d e = _mm_add_pd(_mm_set1_pd(1.0), _mm_mul_pd(_mm_set1_pd(2.0), _mm_div_pd(px, _mm_sub_pd(qx, px))));
+
+      const __m128i biased = _mm_add_epi32(_mm_cvtpd_epi32(n), _mm_set1_epi32(1023));
+      const __m128d scale = _mm_castsi128_pd(_mm_slli_epi64(_mm_unpacklo_epi32(biased, _mm_setzero_si128()), 52));
+      return _mm_and_pd(_mm_mul_pd(e, scale), in_range);
+    }
+#endif
+
+  }
+
+  void Boltzmann::clear(const double &inverse_temperature) {
+    m_weights.clear();
+    m_inverse_temperature = inverse_temperature;
+    m_max = -std::numeric_limits<double>::infinity();
+    m_sum = 0.0;
+  }
+
+  void Boltzmann::push_back(const double &value) {
+    const double scaled = value * m_inverse_temperature;
+    m_weights.push_back(scaled);
+    if(scaled > m_max)
+      m_max = scaled;
+  }
+
+  void Boltzmann::compute() {
+    double * const weights = m_weights.data();
+    const size_t size = m_weights.size();
+
+    if(!std::isfinite(m_max)) {
+      /// Infinitely preferred values share the probability mass; if no value is comparable, every value does
+      const bool uniform = m_max == -std::numeric_limits<double>::infinity();
+      for(size_t i = 0; i != size; ++i)
+        weights[i] = uniform || weights[i] == m_max ? 1.0 : 0.0;
+    }
+    else {
+      size_t i = 0;
+
+#ifdef CARLI_BOLTZMANN_SSE2
+      const __m128d max2 = _mm_set1_pd(m_max);
+      for(; i + 2 <= size; i += 2)
+        _mm_storeu_pd(weights + i, exp_nonpositive(_mm_sub_pd(_mm_loadu_pd(weights + i), max2)));
+#endif
+
+      for(; i != size; ++i)
+        weights[i] = exp_nonpositive(weights[i] - m_max);
+    }
+
+    m_sum = 0.0;
+    for(size_t i = 0; i != size; ++i)
+      m_sum += weights[i];
+  }
+
+  size_t Boltzmann::sample(const double &uniform) const {
+    assert(m_sum >= 1.0);
+
+    double value = m_sum * uniform;
+    size_t last = 0;
+    for(size_t i = 0, iend = m_weights.size(); i != iend; ++i) {
+      if(value < m_weights[i])
+        return i;
+      value -= m_weights[i];
+      if(m_weights[i] > 0.0)
+        last = i;
+    }
+
+    /// Rounding in the subtractions can leave a remainder past the end
+    return last;
+  }
+
+}
@@ -0,0 +1,44 @@
+#ifndef CARLI_BOLTZMANN_H
+#define CARLI_BOLTZMANN_H
+
+#include "linkage.h"
+
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+namespace Carli {
+
+  /// Boltzmann weights for a batch of values, exponentiated relative to their maximum (log-sum-exp) so that no exponent can overflow
+  class CARLI_LINKAGE Boltzmann {
+    Boltzmann(const Boltzmann &) = delete;
+    Boltzmann & operator=(const Boltzmann &) = delete;
+
+  public:
+    Boltzmann() {}
+
+    size_t size() const {return m_weights.size();}
+
+    /// Start a new batch, keeping the buffer for reuse
+    void clear(const double &inverse_temperature);
+    /// Add a value, scaled by the inverse temperature
+    void push_back(const double &value);
+    /// Exponentiate the batch; every weight falls in [0, 1] and the largest is exactly 1
+    void compute();
+
+    double sum() const {return m_sum;}
+    double probability(const size_t &index) const {return m_weights[index] / m_sum;}
+
+    /// Select an index by inverting the cumulative distribution at uniform in [0, 1)
+    size_t sample(const double &uniform) const;
+
+  private:
+    std::vector<double> m_weights;
+    double m_inverse_temperature = 1.0;
+    double m_max = -std::numeric_limits<double>::infinity();
+    double m_sum = 0.0;
+  };
+
+}
+
+#endif
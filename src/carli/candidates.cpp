@@ -0,0 +1,222 @@
+#include "candidates.h"
+
+#include <algorithm>
+
+namespace Carli {
+
+  Q_Value_List::Q_Value_List(const Q_Value_List &rhs) {
+    *this = rhs;
+  }
+
+  Q_Value_List::Q_Value_List(Q_Value_List &&rhs) noexcept {
+    *this = std::move(rhs);
+  }
+
+  Q_Value_List & Q_Value_List::operator=(const Q_Value_List &rhs) {
+    if(this != &rhs) {
+      clear();
+      if(rhs.m_heap.empty())
+        std::copy(rhs.m_inline, rhs.m_inline + rhs.m_size, m_inline);
+      else
+        m_heap = rhs.m_heap;
+      m_size = rhs.m_size;
+    }
+    return *this;
+  }
+
+  Q_Value_List & Q_Value_List::operator=(Q_Value_List &&rhs) noexcept {
+    if(this != &rhs) {
+      if(rhs.m_heap.empty()) {
+        *this = rhs;
+        rhs.clear();
+      }
+      else {
+        clear();
+        m_heap.swap(rhs.m_heap);
+        m_size = rhs.m_size;
+        rhs.m_size = 0;
+      }
+    }
+    return *this;
+  }
+
+  namespace {
+    bool created_before(const Q_Value_List::value_type &entry, const int64_t &creation_index) {
+      return entry.first->creation_index < creation_index;
+    }
+  }
+
+  Q_Value_List::iterator Q_Value_List::find(const tracked_ptr<Q_Value> &q_value) {
+    const iterator found = std::lower_bound(begin(), end(), q_value->creation_index, created_before);
+    return found != end() && found->first == q_value ? found : end();
+  }
+
+  Q_Value_List::const_iterator Q_Value_List::find(const tracked_ptr<Q_Value> &q_value) const {
+    const const_iterator found = std::lower_bound(begin(), end(), q_value->creation_index, created_before);
+    return found != end() && found->first == q_value ? found : end();
+  }
+
+  void Q_Value_List::insert(const tracked_ptr<Q_Value> &q_value) {
+    assert(q_value->creation_index > -1);
+    const iterator position = std::lower_bound(begin(), end(), q_value->creation_index, created_before);
+    if(position != end() && position->first == q_value) {
+      ++position->second;
+      return;
+    }
+    assert(position == end() || position->first->creation_index != q_value->creation_index);
+
+    const ptrdiff_t offset = position - begin();
+    if(!m_heap.empty())
+      m_heap.emplace(m_heap.begin() + offset, q_value, 1);
+    else if(m_size != inline_capacity) {
+      std::move_backward(position, end(), end() + 1);
+      *position = value_type(q_value, 1);
+    }
+    else {
+      m_heap.reserve(2 * inline_capacity);
+      for(auto &entry : m_inline) {
+        m_heap.push_back(entry);
+        entry = value_type();
+      }
+      m_heap.emplace(m_heap.begin() + offset, q_value, 1);
+    }
+
+    ++m_size;
+  }
+
+  void Q_Value_List::purge(const tracked_ptr<Q_Value> &q_value) {
+    const auto found = find(q_value);
+    if(found != end() && !--found->second)
+      erase(found);
+  }
+
+  void Q_Value_List::erase(const iterator &it) {
+    assert(it >= begin() && it < end());
+    if(m_heap.empty()) {
+      std::move(it + 1, end(), it);
+      *(end() - 1) = value_type();
+    }
+    else
+      m_heap.erase(m_heap.begin() + (it - begin()));
+
+    --m_size;
+  }
+
+  void Q_Value_List::clear() {
+    if(m_heap.empty())
+      std::fill(m_inline, m_inline + m_size, value_type());
+    else
+      m_heap.clear();
+    m_size = 0;
+  }
+
+  const Candidates::Candidate * Candidates::find(const Action &action) const {
+    if(action.m_candidate < 0) {
+      assert(std::none_of(m_candidates.begin(), m_candidates.end(), [&action](const Candidate &candidate)->bool {return *candidate.action == action;}));
+      return nullptr;
+    }
+
+    assert(action.m_candidates == this);
+    assert(m_candidates[size_t(action.m_candidate)].action.get() == &action);
+    return &m_candidates[size_t(action.m_candidate)];
+  }
+
+  const Q_Value_List & Candidates::operator[](const Action &action) const {
+    static const Q_Value_List empty;
+
+    const Candidate * const candidate = find(action);
+    return candidate ? candidate->q_values : empty;
+  }
+
+  void Candidates::insert(const Action_Ptr_C &action, const tracked_ptr<Q_Value> &q_value) {
+    if(action->m_candidate < 0) {
+      assert(std::none_of(m_candidates.begin(), m_candidates.end(), [&action](const Candidate &candidate)->bool {return *candidate.action == *action;}));
+      action->m_candidate = int64_t(m_candidates.size());
+#ifndef NDEBUG
+      action->m_candidates = this;
+#endif
+      m_candidates.emplace_back(action);
+      m_ordered_valid = false;
+    }
+
+    assert(action->m_candidates == this);
+    Candidate &candidate = m_candidates[size_t(action->m_candidate)];
+    assert(candidate.action == action);
+    candidate.q_values.insert(q_value);
+    invalidate(candidate);
+  }
+
+  void Candidates::purge(const Action_Ptr_C &action, const tracked_ptr<Q_Value> &q_value) {
+    if(action->m_candidate < 0)
+      return;
+
+    assert(action->m_candidates == this);
+    const size_t index = size_t(action->m_candidate);
+    assert(m_candidates[index].action == action);
+    auto &q_values = m_candidates[index].q_values;
+    q_values.purge(q_value);
+    invalidate(m_candidates[index]);
+    if(!q_values.empty())
+      return;
+
+    /// Keep the table dense by moving the last candidate into the vacancy
+    action->m_candidate = -1;
+#ifndef NDEBUG
+    action->m_candidates = nullptr;
+#endif
+    const size_t last = m_candidates.size() - 1;
+    if(index != last) {
+      m_candidates[index] = std::move(m_candidates[last]);
+      m_candidates[index].action->m_candidate = int64_t(index);
+    }
+    m_candidates.pop_back();
+    m_ordered_valid = false;
+  }
+
+  void Candidates::clear() {
+    for(const auto &candidate : m_candidates) {
+      candidate.action->m_candidate = -1;
+#ifndef NDEBUG
+      candidate.action->m_candidates = nullptr;
+#endif
+    }
+    m_candidates.clear();
+    m_ordered_valid = false;
+    invalidate();
+  }
+
+  const std::vector<const Candidates::Candidate *> & Candidates::ordered() const {
+    if(!m_ordered_valid) {
+      m_ordered.clear();
+      for(const auto &candidate : m_candidates)
+        m_ordered.push_back(&candidate);
+      std::sort(m_ordered.begin(), m_ordered.end(), [](const Candidate * const &lhs, const Candidate * const &rhs)->bool {return *lhs->action < *rhs->action;});
+      m_ordered_valid = true;
+    }
+
+    return m_ordered;
+  }
+
+  const Candidates::Sum * Candidates::find_sum(const Candidate &candidate, const Q_Value * const &parent, const Feature * const &axis, const int64_t &fringe_depth) const {
+    if(candidate.epoch != m_epoch)
+      return nullptr;
+
+    for(const auto &sum : candidate.sums) {
+      if(sum.parent == parent && sum.axis == axis && sum.fringe_depth == fringe_depth)
+        return &sum;
+    }
+
+    return nullptr;
+  }
+
+  const Candidates::Sum & Candidates::insert_sum(const Candidate &candidate, const Sum &sum) const {
+    if(candidate.epoch != m_epoch) {
+      candidate.sums.clear();
+      candidate.epoch = m_epoch;
+    }
+
+    candidate.sums.push_back(sum);
+    return candidate.sums.back();
+  }
+
+}
@@ -0,0 +1,135 @@
+#ifndef CARLI_CANDIDATES_H
+#define CARLI_CANDIDATES_H
+
+#include "action.h"
+#include "feature.h"
+#include "q_value.h"
+
+#include <algorithm>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace Carli {
+
+  /// The Q-values contributing to an action, each with the number of nodes contributing it, in the order of their creation; short lists are stored inline
+  class CARLI_LINKAGE Q_Value_List {
+  public:
+    typedef std::pair<tracked_ptr<Q_Value>, int64_t> value_type;
+    typedef value_type * iterator;
+    typedef const value_type * const_iterator;
+
+    Q_Value_List() {}
+    Q_Value_List(const Q_Value_List &rhs);
+    Q_Value_List(Q_Value_List &&rhs) noexcept;
+    Q_Value_List & operator=(const Q_Value_List &rhs);
+    Q_Value_List & operator=(Q_Value_List &&rhs) noexcept;
+
+    iterator begin() {return data();}
+    iterator end() {return data() + m_size;}
+    const_iterator begin() const {return data();}
+    const_iterator end() const {return data() + m_size;}
+
+    size_t size() const {return m_size;}
+    bool empty() const {return !m_size;}
+
+    iterator find(const tracked_ptr<Q_Value> &q_value);
+    const_iterator find(const tracked_ptr<Q_Value> &q_value) const;
+
+    /// Count one more contribution of the Q-value, shifting later entries over in O(k) for a list of k, kept short as it holds only the Q-values of nodes matching the action
+    void insert(const tracked_ptr<Q_Value> &q_value);
+    /// Count one less contribution of the Q-value, removing it when none remain
+    void purge(const tracked_ptr<Q_Value> &q_value);
+    /// Remove the entry outright
+    void erase(const iterator &it);
+
+    void clear();
+
+  private:
+    static constexpr size_t inline_capacity = 8;
+
+    value_type * data() {return m_heap.empty() ? m_inline : m_heap.data();}
+    const value_type * data() const {return m_heap.empty() ? m_inline : m_heap.data();}
+
+    value_type m_inline[inline_capacity];
+    std::vector<value_type> m_heap; ///< Holds every entry once the inline storage overflows, until emptied
+    size_t m_size = 0;
+  };
+
+  /// The actions available from the next state, stored contiguously for action selection
+  class CARLI_LINKAGE Candidates {
+    Candidates(const Candidates &) = delete;
+    Candidates & operator=(const Candidates &) = delete;
+
+  public:
+    /// A candidate's value as seen by a policy considering a fringe node
+    struct Sum {
+      const Q_Value * parent; ///< The fringe node's parent weight, or nullptr
+      const Feature * axis; ///< The fringe node's axis, or nullptr
+      int64_t fringe_depth;
+      bool includes_parent; ///< If false, the value is summed without regard to the axis
+      std::tuple<double, double, int64_t> value; ///< Sum, standard deviation, and minimum update count
+    };
+
+    struct Candidate {
+      Candidate(const Action_Ptr_C &action_) : action(action_) {}
+
+      Action_Ptr_C action;
+      Q_Value_List q_values;
+
+      mutable std::vector<Sum> sums; ///< Cached values, valid only while epoch matches that of the Candidates
+      mutable uint64_t epoch = 0;
+    };
+
+    typedef std::vector<Candidate>::const_iterator const_iterator;
+
+    Candidates() {}
+    ~Candidates() {clear();}
+
+    const_iterator begin() const {return m_candidates.begin();}
+    const_iterator end() const {return m_candidates.end();}
+
+    size_t size() const {return m_candidates.size();}
+    bool empty() const {return m_candidates.empty();}
+
+    /// The candidates in Action order, so that selection does not depend on the order in which they were inserted
+    const std::vector<const Candidate *> & ordered() const;
+
+    /// Get the Candidate for a canonical action, or nullptr
+    const Candidate * find(const Action &action) const;
+    /// Get the Q-values for a canonical action, or an empty list if it is not a candidate
+    const Q_Value_List & operator[](const Action &action) const;
+
+    void insert(const Action_Ptr_C &action, const tracked_ptr<Q_Value> &q_value);
+    /// Remove the action as a candidate once no Q-values remain for it
+    void purge(const Action_Ptr_C &action, const tracked_ptr<Q_Value> &q_value);
+
+    void clear();
+
+    /// Get a cached value for the candidate, or nullptr if it must be summed anew
+    const Sum * find_sum(const Candidate &candidate, const Q_Value * const &parent, const Feature * const &axis, const int64_t &fringe_depth) const;
+    const Sum & insert_sum(const Candidate &candidate, const Sum &sum) const;
+    /// Discard all cached values, e.g. after Q-values are restructured
+    void invalidate() {++m_epoch;}
+    /// Discard the cached values of the candidate only
+    static void invalidate(const Candidate &candidate) {candidate.epoch = 0;}
+    /// Discard the cached values of each candidate holding a Q-value for which touched returns true
+    template <typename PREDICATE>
+    void invalidate_if(const PREDICATE &touched) const {
+      for(const auto &candidate : m_candidates) {
+        if(candidate.epoch == m_epoch && std::any_of(candidate.q_values.begin(), candidate.q_values.end(), [&touched](const Q_Value_List::value_type &q)->bool {return touched(*q.first);}))
+          invalidate(candidate);
+      }
+    }
+
+  private:
+    std::vector<Candidate> m_candidates;
+    uint64_t m_epoch = 1;
+
+    mutable std::vector<const Candidate *> m_ordered; ///< Valid only while m_ordered_valid
+    mutable bool m_ordered_valid = true;
+  };
+
+}
+
+#endif
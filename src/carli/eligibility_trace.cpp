@@ -0,0 +1,123 @@
+#include "eligibility_trace.h"
+
+#include "feature.h"
+#include "q_value.h"
+
+#include <algorithm>
+#include <cassert>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CARLI_ELIGIBILITY_TRACE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace Carli {
+
+  void Eligibility_Trace::accumulate(Q_Value &q_value, const double &increment) {
+    if(q_value.eligible < 0) {
+      q_value.eligible = int64_t(m_q_values.size());
+      m_q_values.push_back(&q_value);
+      m_eligibility.push_back(0.0 + increment);
+      m_initialized.push_back(1);
+    }
+    else {
+      const size_t index = size_t(q_value.eligible);
+      assert(m_q_values[index] == &q_value);
+      m_eligibility[index] += increment;
+      m_initialized[index] = 1;
+    }
+  }
+
+  void Eligibility_Trace::erase(Q_Value &q_value) {
+    if(q_value.eligible < 0)
+      return;
+
+    const size_t index = size_t(q_value.eligible);
+    assert(m_q_values[index] == &q_value);
+    m_q_values[index] = nullptr;
+    m_eligibility[index] = 0.0;
+    m_initialized[index] = 0;
+    q_value.eligible = -1;
+    ++m_erased;
+  }
+
+  void Eligibility_Trace::clear() {
+    for(Q_Value * const q_value : m_q_values) {
+      if(q_value)
+        q_value->eligible = -1;
+    }
+    m_q_values.clear();
+    m_eligibility.clear();
+    m_initialized.clear();
+    m_erased = 0;
+  }
+
+  void Eligibility_Trace::scale(const double &factor) {
+    double * const eligibility = m_eligibility.data();
+    const size_t size = m_eligibility.size();
+    size_t i = 0;
+
+#ifdef CARLI_ELIGIBILITY_TRACE_SSE2
+    const __m128d factor2 = _mm_set1_pd(factor);
+    for(; i + 2 <= size; i += 2)
+      _mm_storeu_pd(eligibility + i, _mm_mul_pd(_mm_loadu_pd(eligibility + i), factor2));
+#endif
+
+    for(; i != size; ++i)
+      eligibility[i] *= factor;
+  }
+
+  void Eligibility_Trace::decay(const double &factor, const double &threshold) {
+    double * const eligibility = m_eligibility.data();
+    const size_t size = m_eligibility.size();
+    size_t i = 0;
+    bool expired = false;
+
+#ifdef CARLI_ELIGIBILITY_TRACE_SSE2
+    const __m128d factor2 = _mm_set1_pd(factor);
+    const __m128d threshold2 = _mm_set1_pd(threshold);
+    int expired2 = 0;
+    for(; i + 2 <= size; i += 2) {
+      const __m128d decayed = _mm_mul_pd(_mm_loadu_pd(eligibility + i), factor2);
+      _mm_storeu_pd(eligibility + i, decayed);
+      expired2 |= _mm_movemask_pd(_mm_cmplt_pd(decayed, threshold2));
+    }
+    expired = expired2 != 0;
+#endif
+
+    for(; i != size; ++i) {
+      eligibility[i] *= factor;
+      expired |= eligibility[i] < threshold;
+    }
+
+    std::fill(m_initialized.begin(), m_initialized.end(), uint8_t(0));
+
+    if(!expired && !m_erased)
+      return;
+
+    /// Stable compaction of the survivors, preserving their update order
+    size_t kept = 0;
+    for(i = 0; i != size; ++i) {
+      if(!m_q_values[i])
+        continue;
+      else if(eligibility[i] < threshold)
+        m_q_values[i]->eligible = -1;
+      else {
+        m_q_values[kept] = m_q_values[i];
+        eligibility[kept] = eligibility[i];
+        ++kept;
+      }
+    }
+    m_q_values.resize(kept);
+    m_eligibility.resize(kept);
+    m_initialized.resize(kept);
+    m_erased = 0;
+    reindex(0);
+  }
+
+  void Eligibility_Trace::reindex(const size_t &from) {
+    for(size_t i = from, iend = m_q_values.size(); i != iend; ++i)
+      m_q_values[i]->eligible = int64_t(i);
+  }
+
+}
@@ -0,0 +1,54 @@
+#ifndef CARLI_ELIGIBILITY_TRACE_H
+#define CARLI_ELIGIBILITY_TRACE_H
+
+#include "linkage.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Carli {
+
+  class Q_Value;
+
+  /// The Q-values eligible for updates, with their eligibilities stored contiguously so that the per-step decay runs as SIMD kernels
+  class CARLI_LINKAGE Eligibility_Trace {
+    Eligibility_Trace(const Eligibility_Trace &) = delete;
+    Eligibility_Trace & operator=(const Eligibility_Trace &) = delete;
+
+  public:
+    Eligibility_Trace() {}
+
+    /// Entries erased since the last decay still count until it compacts them
+    size_t size() const {return m_q_values.size();}
+    bool empty() const {return m_q_values.size() == m_erased;}
+
+    /// Entries are appended, so iterating from the back visits the most recently added Q-values first; nullptr if erased
+    Q_Value * q_value(const size_t &index) const {return m_q_values[index];}
+    double eligibility(const size_t &index) const {return m_eligibility[index];}
+    /// true if the Q-value received eligibility since the last decay
+    bool initialized(const size_t &index) const {return m_initialized[index] != 0;}
+
+    /// Add to the eligibility of the Q-value, adding it to the trace if it is not yet eligible
+    void accumulate(Q_Value &q_value, const double &increment);
+    /// Leave a tombstone with no eligibility in the Q-value's place, for the next decay to compact
+    void erase(Q_Value &q_value);
+    void clear();
+
+    /// Multiply every eligibility by the factor
+    void scale(const double &factor);
+    /// Multiply every eligibility by the factor and drop erased Q-values and those whose eligibility falls below the threshold
+    void decay(const double &factor, const double &threshold);
+
+  private:
+    void reindex(const size_t &from);
+
+    std::vector<Q_Value *> m_q_values;
+    size_t m_erased = 0; ///< Tombstones in m_q_values
+    std::vector<double> m_eligibility;
+    std::vector<uint8_t> m_initialized;
+  };
+
+}
+
+#endif
@@ -5,7 +5,8 @@
 #include <stdint.h>
 
 #include "action.h"
-#include "utility/getopt.h"
+#include "utility/runtime_context.h"
+#include "utility/serialize.h"
 
 namespace Carli {
 
@@ -13,7 +14,19 @@ namespace Carli {
   public:
     typedef double reward_type;
 
-    Environment()
+    Environment(Zeni::Runtime_Context &context = Zeni::Runtime_Context::get_current())
+     : m_context(context)
+    {
+    }
+
+    Environment(const Environment &rhs)
+     : std::enable_shared_from_this<Environment>(rhs),
+     m_context(rhs.m_context),
+     m_scenario(rhs.m_scenario),
+     m_altered(rhs.m_altered),
+     m_episode_count(rhs.m_episode_count),
+     m_step_count(rhs.m_step_count),
+     m_total_step_count(rhs.m_total_step_count)
     {
     }
 
@@ -47,6 +60,25 @@ namespace Carli {
       print_impl(os);
     }
 
+    /// Everything init() does not regenerate, between episodes, for checkpoints
+    void save(std::ostream &os) const {
+      Zeni::serialize(os, m_altered);
+      Zeni::serialize(os, m_episode_count);
+      Zeni::serialize(os, m_step_count);
+      Zeni::serialize(os, m_total_step_count);
+      save_impl(os);
+    }
+
+    void load(std::istream &is) {
+      Zeni::deserialize(is, m_altered);
+      Zeni::deserialize(is, m_episode_count);
+      Zeni::deserialize(is, m_step_count);
+      Zeni::deserialize(is, m_total_step_count);
+      load_impl(is);
+    }
+
+    Zeni::Runtime_Context & get_context() const {return m_context;} ///< Shared with the agent acting in this environment
+
     int64_t get_scenario() const {return m_scenario;}
     int64_t get_episode_count() const {return m_episode_count;}
     int64_t get_step_count() const {return m_step_count;}
@@ -60,13 +92,16 @@ namespace Carli {
     virtual void alter_impl() {}
     virtual std::pair<reward_type, reward_type> transition_impl(const Action &action) = 0;
     virtual void print_impl(std::ostream &os) const = 0;
+    virtual void save_impl(std::ostream &os) const = 0;
+    virtual void load_impl(std::istream &is) = 0;
 
-    const int64_t m_scenario = get_Option_Ranged<int64_t>(Options::get_global(), "scenario");
+    Zeni::Runtime_Context &m_context;
+    const int64_t m_scenario = get_Option_Ranged<int64_t>(m_context.get_options(), "scenario");
     bool m_altered = false;
 
     int64_t m_episode_count = -1;
     int64_t m_step_count = 0;
-    int64_t m_total_step_count = -dynamic_cast<const Option_Ranged<int64_t> &>(Options::get_global()["skip-steps"]).get_value();
+    int64_t m_total_step_count = -dynamic_cast<const Option_Ranged<int64_t> &>(m_context.get_options()["skip-steps"]).get_value();
   };
 
 }
@@ -2,14 +2,16 @@
 
 #include "experimental_output.h"
 #include "git.h"
+#include "parser/rete_parser.h"
 #include "utility/getopt.h"
-#include "utility/memory_pool.h"
+#include "utility/serialize.h"
 
 #include <csignal>
 #include <cstring>
 #include <ctime>
 #include <limits>
 #include <random>
+#include <sstream>
 
 namespace Carli {
 
@@ -27,14 +29,21 @@ namespace Carli {
 
   // static void run_agent(const function<shared_ptr<Environment> ()> &make_env, const function<shared_ptr<Agent> (const shared_ptr<Environment> &)> &make_agent);
 
-  Experiment::Experiment()
-   : cerr_bak(cerr.rdbuf()),
+  Experiment::Experiment(Zeni::Runtime_Context &context)
+   : m_context(context),
+   cerr_bak(cerr.rdbuf()),
    cout_bak(cout.rdbuf())
   {
-    cerr.setf(std::ios_base::fixed, std::ios_base::floatfield);
-    cout.setf(std::ios_base::fixed, std::ios_base::floatfield);
-    cerr.precision(9);
-    cout.precision(9);
+    cerr2file.setf(std::ios_base::fixed, std::ios_base::floatfield);
+    cout2file.setf(std::ios_base::fixed, std::ios_base::floatfield);
+    cerr2file.precision(9);
+    cout2file.precision(9);
+    if(owns_streams()) {
+      cerr.setf(std::ios_base::fixed, std::ios_base::floatfield);
+      cout.setf(std::ios_base::fixed, std::ios_base::floatfield);
+      cerr.precision(9);
+      cout.precision(9);
+    }
 
     Zeni::register_new_handler();
 
@@ -44,7 +53,7 @@ namespace Carli {
     else
       version_str = string("Built from revision ") + git_revision_string() + " (clean) on " __DATE__ " at " __TIME__ ".";
 
-    Options &options = Options::get_global();
+    Options &options = m_context.get_options();
 
     options.add_line("\n  " + version_str);
     options.add_line("\n  Print Information:");
@@ -67,16 +76,27 @@ namespace Carli {
     options.add('p', make_shared<Option_Ranged<int64_t>>("print-every", 1, true, numeric_limits<int64_t>::max(), true, 100), "How many steps per line of output.");
     options.add(     make_shared<Option_Ranged<bool>>("evaluate-optimality", false, true, true, true, false), "Evaluate optimality if supported.");
     options.add('r', make_shared<Option_String>("rules", "default"), "Which .carli rules should the agent load?");
+    options.add(     make_shared<Option_Ranged<bool>>("rules-lazy", false, true, true, true, false), "Leave rules beneath splits in compiled --rules unbuilt until those splits first match.");
     options.add(     make_shared<Option_String>("rules-out", ""), "Where should final .carli rules be saved?");
+    options.add(     make_shared<Option_String>("rules-out-binary", ""), "Where should final rules be saved compiled, for --rules to map without parsing?");
+    options.add(     make_shared<Option_String>("checkpoint", ""), "Where should checkpoints be journaled between episodes, for --resume?");
+    options.add(     make_shared<Option_Ranged<int64_t>>("checkpoint-every", 0, true, numeric_limits<int64_t>::max(), true, 10000), "How many steps between checkpoints, each waiting for the episode to end; 0 disables.");
+    options.add(     make_shared<Option_String>("resume", ""), "Which checkpoint journal should the run continue from? Other options must match the run that wrote it.");
     options.add(     make_shared<Option_Ranged<int64_t>>("scenario", 0, true, numeric_limits<int64_t>::max(), true, 0), "Which experimental scenario should be run, environment specific.");
     options.add('s', make_shared<Option_Ranged<int64_t>>("seed", numeric_limits<int64_t>::min(), true, numeric_limits<int64_t>::max(), true, std::random_device()()), "Random seed.");
     options.add(     make_shared<Option_Function>("stderr", 1, [this,&options](const Option::Arguments &args){
       this->cerr2file.open(args.at(0));
-      cerr.rdbuf(this->cerr2file.rdbuf());
+      if(this->owns_streams())
+        cerr.rdbuf(this->cerr2file.rdbuf());
+      else
+        m_context.set_err(this->cerr2file);
     }), "<file> Redirect stderr to <file>");
     options.add(     make_shared<Option_Function>("stdout", 1, [this,&options](const Option::Arguments &args){
       this->cout2file.open(args.at(0));
-      cout.rdbuf(this->cout2file.rdbuf());
+      if(this->owns_streams())
+        cout.rdbuf(this->cout2file.rdbuf());
+      else
+        m_context.set_out(this->cout2file);
     }), "<file> Redirect stdout to <file>");
     options.add(     make_shared<Option_Ranged<bool>>("terse-out", false, true, true, true, true), "Output rules using references, making them more consise but harder to read.");
     options.add_line("\n  Environment Options:");
@@ -150,6 +170,7 @@ namespace Carli {
     options.add(     make_shared<Option_Ranged<double>>("fringe-learning-scale", 0.0, false, 1.0, true, 0.3), "How quickly should the fringe learn relative to rest of the value function? (1.0 == same)");
     options.add(     make_shared<Option_Ranged<int64_t>>("mean-catde-queue-size", 0, true, numeric_limits<int64_t>::max(), true, 0), "How large of a working set to use for means and variances; 0 disables.");
     options.add(     make_shared<Option_Ranged<bool>>("output-dot", false, true, true, true, false), "Generate .dot files for the rete [pre/post]-[expansion/collapse].");
+    options.add(     make_shared<Option_Ranged<bool>>("print-pool-usage", false, true, true, true, false), "Print memory pool usage at the end of the run.");
     options.add(     make_shared<Option_Ranged<bool>>("rete-disable-node-sharing", false, true, true, true, false), "Disable sharing of rete beta nodes. Disable for purposes of performance comparison.");
     options.add(     make_shared<Option_Ranged<bool>>("rete-flush-wmes", false, true, true, true, false), "Flush all WMEs from step to step for purposes of performance comparison.");
     options.add(     make_shared<Option_Ranged<int64_t>>("value-function-cap", 0, true, numeric_limits<int64_t>::max(), true, 0), "The maximum number of weights allowed in the value functions; 0 disables.");
@@ -165,24 +186,28 @@ namespace Carli {
   }
 
   Experiment::~Experiment() {
-    cout.rdbuf(cout_bak);
-    cerr.rdbuf(cerr_bak);
+    if(owns_streams()) {
+      cout.rdbuf(cout_bak);
+      cerr.rdbuf(cerr_bak);
+    }
   }
 
   int64_t Experiment::take_args(int argc, const char * const * argv) {
-    Options &options = Options::get_global();
+    Options &options = m_context.get_options();
 
     options.get(argc, argv);
 
     const auto seed = uint32_t(dynamic_cast<const Option_Ranged<int64_t> &>(options["seed"]).get_value());
     const auto output = dynamic_cast<const Option_Itemized &>(options["output"]).get_value();
-    Zeni::Random::get().seed(seed);
+    m_context.get_random().seed(seed);
     if(output != "null")
-      cout << "SEED " << seed << endl;
+      m_context.get_out() << "SEED " << seed << endl;
 
-    std::ofstream seed_file("seed.txt");
-    if(seed_file)
-      seed_file << "SEED " << seed << endl;
+    if(owns_streams()) {
+      std::ofstream seed_file("seed.txt");
+      if(seed_file)
+        seed_file << "SEED " << seed << endl;
+    }
 
     return options.optind;
   }
@@ -190,37 +215,73 @@ namespace Carli {
   void Experiment::standard_run(const function<shared_ptr<Environment> ()> &make_env,
                                 const function<shared_ptr<Agent> (const shared_ptr<Environment> &)> &make_agent,
                                 const function<void (const shared_ptr<Agent> &)> &on_episode_termination) {
+    const Zeni::Runtime_Context::Scope scope(m_context);
+
     auto env = make_env();
     auto agent = make_agent(env);
 
-    Experimental_Output experimental_output(dynamic_cast<const Option_Ranged<int64_t> &>(Options::get_global()["print-every"]).get_value());
+    Experimental_Output experimental_output(m_context, dynamic_cast<const Option_Ranged<int64_t> &>(m_context.get_options()["print-every"]).get_value());
 
-    const auto num_episodes = dynamic_cast<const Option_Ranged<int64_t> &>(Options::get_global()["num-episodes"]).get_value();
-    const auto num_steps = dynamic_cast<const Option_Ranged<int64_t> &>(Options::get_global()["num-steps"]).get_value();
-    const auto step_cutoff = dynamic_cast<const Option_Ranged<int64_t> &>(Options::get_global()["step-cutoff"]).get_value();
-    const auto output = dynamic_cast<const Option_Itemized &>(Options::get_global()["output"]).get_value();
-    const auto evaluate_optimality = dynamic_cast<const Option_Ranged<bool> &>(Options::get_global()["evaluate-optimality"]).get_value() && env->supports_optimal() && output != "null";
+    const auto num_episodes = dynamic_cast<const Option_Ranged<int64_t> &>(m_context.get_options()["num-episodes"]).get_value();
+    const auto num_steps = dynamic_cast<const Option_Ranged<int64_t> &>(m_context.get_options()["num-steps"]).get_value();
+    const auto step_cutoff = dynamic_cast<const Option_Ranged<int64_t> &>(m_context.get_options()["step-cutoff"]).get_value();
+    const auto output = dynamic_cast<const Option_Itemized &>(m_context.get_options()["output"]).get_value();
+    const auto evaluate_optimality = dynamic_cast<const Option_Ranged<bool> &>(m_context.get_options()["evaluate-optimality"]).get_value() && env->supports_optimal() && output != "null";
 
-    int64_t total_steps = -dynamic_cast<const Option_Ranged<int64_t> &>(Options::get_global()["skip-steps"]).get_value();
+    int64_t total_steps = -dynamic_cast<const Option_Ranged<int64_t> &>(m_context.get_options()["skip-steps"]).get_value();
     if(total_steps > 0) {
       total_steps = 0;
       env->alter();
     }
 
+    int64_t episodes = 0;
     size_t successes = 0;
     size_t failures = 0;
-    for(int64_t episodes = 0; !num_episodes || episodes < num_episodes; ++episodes) {
+
+    const auto resume = dynamic_cast<const Option_String &>(m_context.get_options()["resume"]).get_value();
+    if(!resume.empty()) {
+      std::string state;
+      if(!Rete::rete_resume(*agent, resume, state))
+        throw runtime_error("Failed to resume from '" + resume + "'.");
+      std::istringstream is(state);
+      Zeni::deserialize(is, episodes);
+      Zeni::deserialize(is, total_steps);
+      Zeni::deserialize(is, successes);
+      Zeni::deserialize(is, failures);
+      experimental_output.load(is);
+    }
+
+    /// Checkpoints fall between episodes, after the first to end at least checkpoint-every steps after the last
+    const auto checkpoint = dynamic_cast<const Option_String &>(m_context.get_options()["checkpoint"]).get_value();
+    const auto checkpoint_every = dynamic_cast<const Option_Ranged<int64_t> &>(m_context.get_options()["checkpoint-every"]).get_value();
+    std::unique_ptr<Rete::Rete_Checkpointer> checkpointer;
+    if(!checkpoint.empty() && checkpoint_every)
+      checkpointer.reset(new Rete::Rete_Checkpointer(checkpoint, m_context.get_err()));
+    int64_t next_checkpoint = total_steps + checkpoint_every;
+
+    for(; !num_episodes || episodes < num_episodes; ++episodes) {
       if(num_steps && total_steps > -1 && total_steps >= num_steps)
         break;
 
+      if(checkpointer && total_steps >= next_checkpoint) {
+        std::ostringstream os;
+        Zeni::serialize(os, episodes);
+        Zeni::serialize(os, total_steps);
+        Zeni::serialize(os, successes);
+        Zeni::serialize(os, failures);
+        experimental_output.save(os);
+        checkpointer->checkpoint(*agent, os.str());
+        next_checkpoint = total_steps + checkpoint_every;
+      }
+
       env->init();
 #ifdef DEBUG_OUTPUT
-      cerr << *env;
+      m_context.get_err() << *env;
 #endif
 
       agent->init();
 #ifdef DEBUG_OUTPUT
-      cerr << *agent;
+      m_context.get_err() << *agent;
 #endif
 
       bool done = false;
@@ -235,13 +296,13 @@ namespace Carli {
         //          std::raise(SIGINT);
 
 #ifdef DEBUG_OUTPUT
-        cerr << *env << *agent;
+        m_context.get_err() << *env << *agent;
 #endif
 
         if(!total_steps) {
           env->alter();
           agent->reset_statistics();
-          if(dynamic_cast<const Option_Ranged<bool> &>(Options::get_global()["reset-update-counts"]).get_value())
+          if(dynamic_cast<const Option_Ranged<bool> &>(m_context.get_options()["reset-update-counts"]).get_value())
             agent->visit_reset_update_count();
         }
 
@@ -256,35 +317,38 @@ namespace Carli {
 
       if(agent->get_metastate() == Metastate::SUCCESS) {
         if(output == "simple")
-          cout << "SUCCESS";
+          m_context.get_out() << "SUCCESS";
         ++successes;
       }
       else {
         if(output == "simple")
-          cout << "FAILURE";
+          m_context.get_out() << "FAILURE";
         ++failures;
       }
 
       if(output == "simple") {
-        cout << " in " << agent->get_step_count() << " moves, yielding " << agent->get_total_reward() << " total reward";
+        m_context.get_out() << " in " << agent->get_step_count() << " moves, yielding " << agent->get_total_reward() << " total reward";
         if(evaluate_optimality)
-          cout << " out of " << env->optimal_reward();
-        cout << "." << endl;
+          m_context.get_out() << " out of " << env->optimal_reward();
+        m_context.get_out() << "." << endl;
       }
     }
 
     on_episode_termination(agent);
 
     if(output == "simple") {
-      cout << successes << " SUCCESSes" << endl;
-      cout << failures << " FAILUREs" << endl;
-      cout << agent->q_value_count << " Q-values" << endl;
+      m_context.get_out() << successes << " SUCCESSes" << endl;
+      m_context.get_out() << failures << " FAILUREs" << endl;
+      m_context.get_out() << agent->q_value_count << " Q-values" << endl;
 
   //    if(auto mca = dynamic_pointer_cast<Mountain_Car::Agent>(agent))
   //      mca->print_policy(cout, 32);
   //    else if(auto pwa = dynamic_pointer_cast<Puddle_World::Agent>(agent))
   //      pwa->print_policy(cout, 32);
     }
+
+    if(dynamic_cast<const Option_Ranged<bool> &>(m_context.get_options()["print-pool-usage"]).get_value())
+      m_context.get_pool_map().print_usage(m_context.get_out());
   //   else if(output == "experiment") {
   // //    if(auto cpa = dynamic_pointer_cast<Cart_Pole::Agent>(agent)) {
   // //      cpa->print_value_function_grid(cerr);
@@ -4,7 +4,7 @@
 #include "agent.h"
 #include "environment.h"
 #include "experimental_output.h"
-#include "utility/getopt.h"
+#include "utility/runtime_context.h"
 
 #include <fstream>
 #include <iostream>
@@ -14,7 +14,7 @@ namespace Carli {
 
   class CARLI_LINKAGE Experiment {
   public:
-    Experiment();
+    Experiment(Zeni::Runtime_Context &context = Zeni::Runtime_Context::get_current()); ///< Options are registered with, and runs execute within, the context
     virtual ~Experiment();
 
     int64_t take_args(int argc, const char * const * argv);
@@ -24,6 +24,9 @@ namespace Carli {
                       const std::function<void (const std::shared_ptr<Agent> &)> &on_episode_termination);
 
   private:
+    bool owns_streams() const {return &m_context == &Zeni::Runtime_Context::get_global();} ///< Only the process-wide context redirects std::cout and std::cerr or writes seed.txt
+
+    Zeni::Runtime_Context &m_context;
     std::streambuf * cerr_bak;
     std::streambuf * cout_bak;
     std::ofstream cerr2file;
@@ -1,6 +1,7 @@
 #include "experimental_output.h"
 
 #include "utility/getopt.h"
+#include "utility/serialize.h"
 
 #include <algorithm>
 #include <cfloat>
@@ -8,8 +9,9 @@
 
 namespace Carli {
 
-  Experimental_Output::Experimental_Output(const int64_t &print_every)
-   : m_print_every(print_every),
+  Experimental_Output::Experimental_Output(Zeni::Runtime_Context &context, const int64_t &print_every)
+   : m_context(context),
+   m_print_every(print_every),
    m_start(std::chrono::high_resolution_clock::now()),
    m_current(m_start)
   {
@@ -23,7 +25,7 @@ namespace Carli {
     m_simple_optimal_reward += optimal_reward;
 
     if(done) {
-      const std::string evaluate = dynamic_cast<const Option_Itemized &>(Options::get_global()["evaluate"]).get_value();
+      const std::string evaluate = dynamic_cast<const Option_Itemized &>(m_context.get_options()["evaluate"]).get_value();
       
       const double cumulative_reward_per_episode = m_cumulative_reward / episode_number;
       const double cumulative_optimal_per_episode = m_cumulative_optimal_reward / episode_number;
@@ -54,7 +56,7 @@ namespace Carli {
 
           m_print_count += s2;
           if(m_print_count == m_print_every) {
-            std::cout << steps << ' '
+            m_context.get_out() << steps << ' '
                       << m_cumulative_min << ' ' << m_cumulative_mean << ' ' << m_cumulative_max << ' '
                       << m_simple_min << ' ' << m_simple_mean << ' ' << m_simple_max << ' '
                       << q_value_count << ' ' << time_passed << ' ' << time_step << ' ';
@@ -62,17 +64,17 @@ namespace Carli {
             for(int64_t i = 1, iend = unrefinements.rbegin()->first; i <= iend; ++i) {
               const auto found = unrefinements.find(i);
               if(i != 1)
-                std::cout << ':';
+                m_context.get_out() << ':';
               if(found == unrefinements.end())
-                std::cout << 0;
+                m_context.get_out() << 0;
               else
-                std::cout << found->second;
+                m_context.get_out() << found->second;
             }
 
             if(evaluate_optimality)
-              std::cout << ' ' << m_cumulative_optimal << ' ' << m_simple_optimal;
+              m_context.get_out() << ' ' << m_cumulative_optimal << ' ' << m_simple_optimal;
 
-            std::cout << std::endl;
+            m_context.get_out() << std::endl;
 
             reset_stats();
           }
@@ -86,7 +88,7 @@ namespace Carli {
 
         const auto time_passed = prev_total.count() + (current_total.count() - prev_total.count());
 
-        std::cout << episode_number << ' '
+        m_context.get_out() << episode_number << ' '
                   << m_cumulative_min << ' ' << m_cumulative_mean << ' ' << m_cumulative_max << ' '
                   << m_simple_min << ' ' << m_simple_mean << ' ' << m_simple_max << ' '
                   << q_value_count << ' ' << time_passed << ' ' << time_step << ' ';
@@ -94,17 +96,17 @@ namespace Carli {
         for(int64_t i = 1, iend = unrefinements.rbegin()->first; i <= iend; ++i) {
           const auto found = unrefinements.find(i);
           if(i != 1)
-            std::cout << ':';
+            m_context.get_out() << ':';
           if(found == unrefinements.end())
-            std::cout << 0;
+            m_context.get_out() << 0;
           else
-            std::cout << found->second;
+            m_context.get_out() << found->second;
         }
 
         if(evaluate_optimality)
-          std::cout << ' ' << m_cumulative_optimal << ' ' << m_simple_optimal;
+          m_context.get_out() << ' ' << m_cumulative_optimal << ' ' << m_simple_optimal;
 
-        std::cout << std::endl;
+        m_context.get_out() << std::endl;
 
         reset_stats();
       }
@@ -116,6 +118,43 @@ namespace Carli {
     }
   }
 
+  void Experimental_Output::save(std::ostream &os) const {
+    Zeni::serialize(os, m_cumulative_reward);
+    Zeni::serialize(os, m_simple_reward);
+    Zeni::serialize(os, m_cumulative_optimal_reward);
+    Zeni::serialize(os, m_simple_optimal_reward);
+    Zeni::serialize(os, m_print_count);
+    Zeni::serialize(os, m_cumulative_min);
+    Zeni::serialize(os, m_cumulative_mean);
+    Zeni::serialize(os, m_cumulative_max);
+    Zeni::serialize(os, m_cumulative_optimal);
+    Zeni::serialize(os, m_simple_min);
+    Zeni::serialize(os, m_simple_mean);
+    Zeni::serialize(os, m_simple_max);
+    Zeni::serialize(os, m_simple_optimal);
+    Zeni::serialize(os, int64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(m_current - m_start).count()));
+  }
+
+  void Experimental_Output::load(std::istream &is) {
+    Zeni::deserialize(is, m_cumulative_reward);
+    Zeni::deserialize(is, m_simple_reward);
+    Zeni::deserialize(is, m_cumulative_optimal_reward);
+    Zeni::deserialize(is, m_simple_optimal_reward);
+    Zeni::deserialize(is, m_print_count);
+    Zeni::deserialize(is, m_cumulative_min);
+    Zeni::deserialize(is, m_cumulative_mean);
+    Zeni::deserialize(is, m_cumulative_max);
+    Zeni::deserialize(is, m_cumulative_optimal);
+    Zeni::deserialize(is, m_simple_min);
+    Zeni::deserialize(is, m_simple_mean);
+    Zeni::deserialize(is, m_simple_max);
+    Zeni::deserialize(is, m_simple_optimal);
+    int64_t elapsed;
+    Zeni::deserialize(is, elapsed);
+    m_current = std::chrono::high_resolution_clock::now();
+    m_start = m_current - std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(std::chrono::nanoseconds(elapsed));
+  }
+
   void Experimental_Output::reset_stats() {
     m_print_count = 0;
 
@@ -5,21 +5,28 @@
 #include <cstddef>
 #include <functional>
 #include <inttypes.h>
+#include <iosfwd>
 #include <map>
 
 #include "linkage.h"
+#include "utility/runtime_context.h"
 
 namespace Carli {
 
   class CARLI_LINKAGE Experimental_Output {
   public:
-    Experimental_Output(const int64_t &print_every = 1);
+    Experimental_Output(Zeni::Runtime_Context &context, const int64_t &print_every = 1); ///< Prints to the context's output
 
     void print(const int64_t &total_steps, const int64_t &episode_number, const int64_t &step_count, const double &reward, const bool &done, const int64_t &q_value_count, const std::map<int64_t, int64_t> &unrefinements, const bool &evaluate_optimality, const double &optimal_reward);
 
+    void save(std::ostream &os) const; ///< Running statistics and the time elapsed so far
+    void load(std::istream &is);
+
   private:
     void reset_stats();
 
+    Zeni::Runtime_Context &m_context;
+
     double m_cumulative_reward = 0.0;
     double m_simple_reward = 0.0;
     double m_cumulative_optimal_reward = 0.0;
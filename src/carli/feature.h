@@ -157,7 +157,7 @@ namespace Carli {
     }
 
     Rete::Symbol_Ptr_C symbol_constant() const {
-      return std::make_shared<Rete::Symbol_Constant_Int>(value);
+      return Rete::Symbol_Constant_Int::intern(value);
     }
 
     int64_t value;
@@ -234,9 +234,9 @@ namespace Carli {
       }
 
       if(integer_locked)
-        return std::make_shared<Rete::Symbol_Constant_Int>(int64_t(value));
+        return Rete::Symbol_Constant_Int::intern(int64_t(value));
       else
-        return std::make_shared<Rete::Symbol_Constant_Float>(value);
+        return Rete::Symbol_Constant_Float::intern(value);
     }
 
     double bound_lower; ///< inclusive
@@ -344,7 +344,7 @@ namespace Carli {
     }
 
     Rete::Symbol_Ptr_C symbol_constant() const {
-      return std::make_shared<Rete::Symbol_Constant_String>(value);
+      return Rete::Symbol_Constant_String::intern(value);
     }
 
     std::string value;
@@ -15,7 +15,7 @@ namespace Carli {
 
 #ifndef NDEBUG
   Node_Tracker & Node_Tracker::get() {
-    static Node_Tracker node_tracker;
+    static thread_local Node_Tracker node_tracker; ///< Agents on different threads track their nodes separately
     return node_tracker;
   }
 
@@ -85,7 +85,29 @@ namespace Carli {
   }
 #endif
 
+  Node::Node(Agent &agent_, const Rete::Rete_Action_Ptr &parent_action_, const Rete::Rete_Action_Ptr &rete_action_, const tracked_ptr<Q_Value> &q_value_weight_, const tracked_ptr<Q_Value> &q_value_fringe_)
+   : agent(agent_),
+   parent_action(parent_action_),
+   rete_action(rete_action_),
+   variables(rete_action_->get_variables()),
+   q_value_weight(q_value_weight_),
+   q_value_fringe(q_value_fringe_),
+   creation_index(agent_.next_creation_index()),
+   activation(this)
+  {
+    assert((q_value_weight && q_value_weight->depth == 1) || (q_value_fringe && q_value_fringe->depth == 1) || parent_action.lock());
+
+    /// Q-values passed on to the nodes refining or collapsing this one keep their places
+    if(q_value_weight && q_value_weight->creation_index < 0)
+      q_value_weight->creation_index = 2 * creation_index;
+    if(q_value_fringe && q_value_fringe->creation_index < 0)
+      q_value_fringe->creation_index = 2 * creation_index + 1;
+  }
+
   Node::~Node() {
+    if(activations)
+      deactivate();
+
     const auto pa_lock = parent_action.lock();
     if(pa_lock) {
       if(const auto split = dynamic_cast<Node_Split *>(pa_lock->data.get())) {
@@ -249,23 +271,16 @@ namespace Carli {
   }
 
   void Node::action(const Rete::WME_Token &token) {
-    const auto sft = shared_from_this();
-
-    auto na = agent.m_nodes_active.find(sft);
-    if(na != agent.m_nodes_active.end())
-      ++na->second;
-    else {
-      na = agent.m_nodes_activating.find(sft);
-      if(na != agent.m_nodes_activating.end())
-        ++na->second;
-      else
-        agent.m_nodes_activating[sft] = 1;
+    if(!activations++) {
+      activation.insert_before(agent.m_nodes_activating);
+      activated();
     }
 
+    const auto action = agent.get_action(variables, token);
     if(q_value_weight)
-      agent.insert_q_value_next(agent.get_action(*variables, token), q_value_weight);
+      agent.insert_q_value_next(action, q_value_weight);
     if(q_value_fringe)
-      agent.insert_q_value_next(agent.get_action(*variables, token), q_value_fringe);
+      agent.insert_q_value_next(action, q_value_fringe);
 
 //    if(q_value_fringe->depth != 1 && !parent_action.lock()) {
 //      std::cerr << "Expired parent action found for " << rete_action.lock()->get_name() << std::endl;
@@ -281,25 +296,14 @@ namespace Carli {
   }
 
   void Node::retraction(const Rete::WME_Token &token) {
-    const auto sft = shared_from_this();
-
-    auto na = agent.m_nodes_activating.find(sft);
-    if(na != agent.m_nodes_activating.end()) {
-      if(--na->second == 0)
-        agent.m_nodes_activating.erase(na);
-    }
-    else {
-      na = agent.m_nodes_active.find(sft);
-      if(na != agent.m_nodes_active.end()) {
-        if(--na->second == 0)
-          agent.m_nodes_active.erase(na);
-      }
-    }
+    if(activations && !--activations)
+      deactivate();
 
+    const auto action = agent.get_action(variables, token);
     if(q_value_weight)
-      agent.purge_q_value_next(agent.get_action(*variables, token), q_value_weight);
+      agent.purge_q_value_next(action, q_value_weight);
     if(q_value_fringe)
-      agent.purge_q_value_next(agent.get_action(*variables, token), q_value_fringe);
+      agent.purge_q_value_next(action, q_value_fringe);
 
 //    if(q_value_fringe->depth != 1 && !parent_action.lock()) {
 //      std::cerr << "Expired parent action found for " << rete_action.lock()->get_name() << std::endl;
@@ -307,6 +311,26 @@ namespace Carli {
 //    }
   }
 
+  void Node::modification(const Rete::WME_Token &old_token, const Rete::WME_Token &new_token) {
+    const auto old_action = agent.get_action(variables, old_token);
+    const auto new_action = agent.get_action(variables, new_token);
+    if(old_action == new_action)
+      return;
+
+    if(q_value_weight)
+      agent.purge_q_value_next(old_action, q_value_weight);
+    if(q_value_fringe)
+      agent.purge_q_value_next(old_action, q_value_fringe);
+    if(q_value_weight)
+      agent.insert_q_value_next(new_action, q_value_weight);
+    if(q_value_fringe)
+      agent.insert_q_value_next(new_action, q_value_fringe);
+  }
+
+  void Node::deactivate() {
+    activation.erase_from(agent.m_nodes_activating == &activation ? agent.m_nodes_activating : agent.m_nodes_active);
+  }
+
   Node_Split_Ptr Node::create_split(const Rete::Rete_Action_Ptr &parent_action_) {
     const auto ra_lock = rete_action.lock();
     const auto node_name = ra_lock->get_name();
@@ -337,12 +361,13 @@ namespace Carli {
       q_value_weight->type = Q_Value::Type::SPLIT;
       new_q_value_weight = q_value_weight;
     }
+    agent.invalidate_value_sums();
 
     q_value_fringe->catde_post_split = 0.0;
     delete_q_value_fringe = false;
 
     auto new_leaf = agent.make_standard_action(ra_lock->parent_left(), new_name, false, ra_lock->get_variables());
-    auto new_leaf_data = std::make_shared<Node_Split>(agent, parent_action_, new_leaf, new_q_value_weight, q_value_fringe);
+    auto new_leaf_data = std::allocate_shared<Node_Split>(Zeni::Pool_Allocator<Node_Split>(), agent, parent_action_, new_leaf, new_q_value_weight, q_value_fringe);
     new_leaf->data = new_leaf_data;
 
     if(q_value_weight) {
@@ -393,13 +418,14 @@ namespace Carli {
       q_value_weight->type = Q_Value::Type::UNSPLIT;
       new_q_value_weight = q_value_weight;
     }
+    agent.invalidate_value_sums();
 
     q_value_fringe->catde = 0.0;
     q_value_fringe->catde_post_split = 0.0;
     delete_q_value_fringe = false;
 
     auto new_leaf = agent.make_standard_action(ra_lock->parent_left(), new_name, false, ra_lock->get_variables());
-    auto new_leaf_data = std::make_shared<Node_Unsplit>(agent, parent_action_, new_leaf, new_q_value_weight, q_value_fringe);
+    auto new_leaf_data = std::allocate_shared<Node_Unsplit>(Zeni::Pool_Allocator<Node_Unsplit>(), agent, parent_action_, new_leaf, new_q_value_weight, q_value_fringe);
     new_leaf->data = new_leaf_data;
 
     if(q_value_weight) {
@@ -460,7 +486,7 @@ namespace Carli {
       for(auto node = ancestor_right; node != pa_lock->parent_left(); node = node->parent_left()) {
         rebase_right.push(node);
         if(dynamic_cast<Rete::Rete_Filter *>(node.get())) {
-          std::cerr << "Ancestral relationship failure: " << ra_lock->get_name() << std::endl;
+          agent.get_context().get_err() << "Ancestral relationship failure: " << ra_lock->get_name() << std::endl;
 //          const std::string rules_out_file = dynamic_cast<const Option_String &>(Options::get_global()["rules-out"]).get_value();
 //          if(!rules_out_file.empty()) {
 //            std::ofstream rules_out((rules_out_file + ".bak").c_str());
@@ -510,21 +536,21 @@ namespace Carli {
               rebase_index = std::make_pair(rv_first->first, Rete::WME_Token_Index(ancestor_left->get_size(), ancestor_left->get_token_size(), rv_first->second.column));
 
 #ifdef DEBUG_OUTPUT
-              std::cerr << "Variable introducer found!" << std::endl;
-              std::cerr << *lra_lock->get_variables() << std::endl;
-              lra_lock->print_rule(std::cerr);
-              std::cerr << *ra_lock->get_variables() << std::endl;
-              ra_lock->print_rule(std::cerr);
-              std::cerr << *lra_lock->get_variables() << std::endl;
-              variable_introducer->print_rule(std::cerr);
-              std::cerr << "Sizes: " << lra_lock->get_size() << ' ' << ra_lock->get_size() << ' ' << variable_introducer->get_size() << std::endl;
-              std::cerr << "Rebase Index: " << rebase_index.first << " at " << rebase_index.second << std::endl;
+              agent.get_context().get_err() << "Variable introducer found!" << std::endl;
+              agent.get_context().get_err() << *lra_lock->get_variables() << std::endl;
+              lra_lock->print_rule(agent.get_context().get_err());
+              agent.get_context().get_err() << *ra_lock->get_variables() << std::endl;
+              ra_lock->print_rule(agent.get_context().get_err());
+              agent.get_context().get_err() << *lra_lock->get_variables() << std::endl;
+              variable_introducer->print_rule(agent.get_context().get_err());
+              agent.get_context().get_err() << "Sizes: " << lra_lock->get_size() << ' ' << ra_lock->get_size() << ' ' << variable_introducer->get_size() << std::endl;
+              agent.get_context().get_err() << "Rebase Index: " << rebase_index.first << " at " << rebase_index.second << std::endl;
 #endif
 
               for(auto node = variable_introducer->parent_left()->parent_left(); node != vi_parent_action->parent_left(); node = node->parent_left()) {
                 rebase_right.push(node);
                 if(dynamic_cast<Rete::Rete_Filter *>(node.get())) {
-                  std::cerr << "Ancestral relationship failure: " << ra_lock->get_name() << std::endl;
+                  agent.get_context().get_err() << "Ancestral relationship failure: " << ra_lock->get_name() << std::endl;
 //                  const std::string rules_out_file = dynamic_cast<const Option_String &>(Options::get_global()["rules-out"]).get_value();
 //                  if(!rules_out_file.empty()) {
 //                    std::ofstream rules_out((rules_out_file + ".bak").c_str());
@@ -543,7 +569,7 @@ namespace Carli {
     assert(grammar == GRAMMAR_NORMAL || old_new_var_index.rete_row != -1);
 
 #ifdef DEBUG_OUTPUT
-    std::cerr << new_name << " is " << (grammar == GRAMMAR_HOG ? "" : grammar == GRAMMAR_NULL_HOG ? "null " : "not ") << "HOG" << std::endl;
+    agent.get_context().get_err() << new_name << " is " << (grammar == GRAMMAR_HOG ? "" : grammar == GRAMMAR_NULL_HOG ? "null " : "not ") << "HOG" << std::endl;
 #endif
 
     /// Handle HOG
@@ -569,10 +595,10 @@ namespace Carli {
 //       std::cerr << "Old variable: " << old_new_var_name << " at " << old_new_var_index << std::endl;
       
       if(!old_var_to_new_var.empty()) {
-        std::cerr << "Old variables";
+        agent.get_context().get_err() << "Old variables";
         for(auto oov : old_var_to_new_var)
-          std::cerr << " : " << oov.first.first << " at " << oov.first.second;
-        std::cerr << std::endl;
+          agent.get_context().get_err() << " : " << oov.first.first << " at " << oov.first.second;
+        agent.get_context().get_err() << std::endl;
       }
 #endif
 
@@ -603,10 +629,10 @@ namespace Carli {
       }
 
       if(!old_var_to_new_var.empty()) {
-        std::cerr << "New variables";
+        agent.get_context().get_err() << "New variables";
         for(auto oov : old_var_to_new_var)
-          std::cerr << " : " << oov.second.first << " at " << oov.second.second;
-        std::cerr << std::endl;
+          agent.get_context().get_err() << " : " << oov.second.first << " at " << oov.second.second;
+        agent.get_context().get_err() << std::endl;
       }
 #endif
 
@@ -634,7 +660,7 @@ namespace Carli {
         indices->insert(std::make_pair(new_new_var_name, nnvi));
 
 #ifdef DEBUG_OUTPUT
-        std::cerr << "Changing feature " << dynamic_cast<Feature_NullHOG_Data *>(new_feature)->value << " to " << new_new_var_name << std::endl;
+        agent.get_context().get_err() << "Changing feature " << dynamic_cast<Feature_NullHOG_Data *>(new_feature)->value << " to " << new_new_var_name << std::endl;
 #endif
         dynamic_cast<Feature_NullHOG_Data *>(new_feature)->value = new_new_var_name;
       }
@@ -650,7 +676,7 @@ namespace Carli {
           auto name = rt->first;
 
 #ifdef DEBUG_OUTPUT
-         std::cerr << "Reindexing " << name << " at " << rt->second << std::endl;
+         agent.get_context().get_err() << "Reindexing " << name << " at " << rt->second << std::endl;
 #endif
           //assert(!strcmp(name.c_str() + (name.size() - old_suffix.size()), old_suffix.c_str())); /// Other variables actually okay
           if(name.size() < old_suffix.size())
@@ -665,7 +691,7 @@ namespace Carli {
           index.token_row += new_new_var_index.token_row - old_new_var_index.token_row;
 
 #ifdef DEBUG_OUTPUT
-          std::cerr << "Reindexed " << name << " is " << index << std::endl;
+          agent.get_context().get_err() << "Reindexed " << name << " is " << index << std::endl;
 #endif
           indices->insert(std::make_pair(name, index));
         }
@@ -676,14 +702,14 @@ namespace Carli {
     }
 
 #ifdef DEBUG_OUTPUT
-    std::cerr << "Parent feature ";
+    agent.get_context().get_err() << "Parent feature ";
     if(leaf.q_value_fringe->feature)
-      std::cerr << *leaf.q_value_fringe->feature;
+      agent.get_context().get_err() << *leaf.q_value_fringe->feature;
     else
-      std::cerr << 0;
-    std::cerr << ", depth " << leaf.q_value_fringe->depth << std::endl;
+      agent.get_context().get_err() << 0;
+    agent.get_context().get_err() << ", depth " << leaf.q_value_fringe->depth << std::endl;
 
-    std::cerr << "Creating fringe node for " << *new_feature << std::endl;
+    agent.get_context().get_err() << "Creating fringe node for " << *new_feature << std::endl;
 #endif
 
     Rete::Variable_Indices_Ptr new_variables;
@@ -701,7 +727,7 @@ namespace Carli {
       assert(feature_enumerated_data || feature_ranged_data);
       /// Case 1. Refining of an existing variable
 #ifdef DEBUG_OUTPUT
-      std::cerr << "Fringe Case 1" << std::endl;
+      agent.get_context().get_err() << "Fringe Case 1" << std::endl;
 #endif
       if(feature_enumerated_data)
         new_test = agent.make_predicate_vc(feature_enumerated_data->get_predicate(), new_feature->axis, feature_enumerated_data->symbol_constant(), ancestor_left);
@@ -743,15 +769,15 @@ namespace Carli {
 
       if(grammar == GRAMMAR_NORMAL && case_2) {
 #ifdef DEBUG_OUTPUT
-        std::cerr << "Fringe Case 2" << std::endl;
+        agent.get_context().get_err() << "Fringe Case 2" << std::endl;
 #endif
         while(rebase_right.size() > 1)
           rebase_right.pop();
       }
       else {
 #ifdef DEBUG_OUTPUT
-        std::cerr << "Fringe Case 3" << std::endl;
-        std::cerr << "Rebase node count = " << rebase_right.size() << std::endl;
+        agent.get_context().get_err() << "Fringe Case 3" << std::endl;
+        agent.get_context().get_err() << "Rebase node count = " << rebase_right.size() << std::endl;
 #endif
       }
 
@@ -760,7 +786,7 @@ namespace Carli {
       const int64_t rebase_offset_from = grammar == GRAMMAR_NULL_HOG ? 0 : rebase_right.top()->parent_left()->get_size();
 
 #ifdef DEBUG_OUTPUT
-      std::cerr << "Offsets are " << rebase_rete_offset << " && " << rebase_token_offset << " starting at " << rebase_offset_from << std::endl;
+      agent.get_context().get_err() << "Offsets are " << rebase_rete_offset << " && " << rebase_token_offset << " starting at " << rebase_offset_from << std::endl;
 #endif
 
       int64_t null_hog_offset = 0;
@@ -769,7 +795,7 @@ namespace Carli {
         new_test = ancestor_right->parent_right();
 
 #ifdef DEBUG_OUTPUT
-        std::cerr << "Originals: " << old_new_var_index << " " << new_new_var_index << std::endl;
+        agent.get_context().get_err() << "Originals: " << old_new_var_index << " " << new_new_var_index << std::endl;
 #endif
         auto gp = ancestor_right->parent_left();
         null_hog_offset = gp->get_size();
@@ -781,7 +807,7 @@ namespace Carli {
         new_new_var_index.token_row = rebase_right.size() - 1;
         new_new_var_index.existential = false;
 #ifdef DEBUG_OUTPUT
-        std::cerr << "Replacements: " << old_new_var_index << " " << new_new_var_index << std::endl;
+        agent.get_context().get_err() << "Replacements: " << old_new_var_index << " " << new_new_var_index << std::endl;
 #endif
       }
 
@@ -793,7 +819,7 @@ namespace Carli {
         /// New exclusion between old_new and new_new for HOG
         if(grammar != GRAMMAR_NORMAL && rebase_right.empty()) {
 #ifdef DEBUG_OUTPUT
-          std::cerr << "  HOG Predicate" << std::endl;
+          agent.get_context().get_err() << "  HOG Predicate" << std::endl;
 #endif
 
 //          std::cerr << new_new_var_index << " != " << old_new_var_index << " for " << '[' << new_test->get_size() << ',' << new_test->get_token_size() << ']' << std::endl;
@@ -830,19 +856,19 @@ namespace Carli {
 
           if(dynamic_cast<Rete::Rete_Join *>(test.get())) {
 #ifdef DEBUG_OUTPUT
-            std::cerr << "  Join" << std::endl;
+            agent.get_context().get_err() << "  Join" << std::endl;
 #endif
             new_test = agent.make_join(*bindings_ptr, new_test, test->parent_right());
           }
           else if(dynamic_cast<Rete::Rete_Existential_Join *>(test.get())) {
 #ifdef DEBUG_OUTPUT
-            std::cerr << "  Existential Join" << std::endl;
+            agent.get_context().get_err() << "  Existential Join" << std::endl;
 #endif
             new_test = agent.make_existential_join(*bindings_ptr, new_test, test->parent_right());
           }
           else if(dynamic_cast<Rete::Rete_Negation_Join *>(test.get())) {
 #ifdef DEBUG_OUTPUT
-            std::cerr << "  Negation Join" << std::endl;
+            agent.get_context().get_err() << "  Negation Join" << std::endl;
 #endif
             if(grammar == GRAMMAR_NULL_HOG && rebase_right.empty()) {
               updated_bindings.insert(Rete::WME_Binding(null_hog_left_old_new_var_index, old_new_var_index));
@@ -854,7 +880,7 @@ namespace Carli {
         }
         else if(auto predicate_node = dynamic_cast<Rete::Rete_Predicate *>(test.get())) {
 #ifdef DEBUG_OUTPUT
-          std::cerr << "  Predicate" << std::endl;
+          agent.get_context().get_err() << "  Predicate" << std::endl;
 #endif
           if(grammar != GRAMMAR_NORMAL) {
             auto lhs_index = predicate_node->get_lhs_index();
@@ -873,7 +899,7 @@ namespace Carli {
                 rhs_index = old_new_var_index;
 
 #ifdef DEBUG_OUTPUT
-              std::cerr << "New Predicate Indices: " << lhs_index << " " << rhs_index << std::endl;
+              agent.get_context().get_err() << "New Predicate Indices: " << lhs_index << " " << rhs_index << std::endl;
 #endif
               new_test = agent.make_predicate_vv(predicate_node->get_predicate(), lhs_index, rhs_index, new_test);
             }
@@ -886,7 +912,7 @@ namespace Carli {
             }
 #ifdef DEBUG_OUTPUT
             if(new_lhs_index != predicate_node->get_lhs_index())
-              std::cerr << "    Updated lhs_index from " << predicate_node->get_lhs_index() << " to " << new_lhs_index << std::endl;
+              agent.get_context().get_err() << "    Updated lhs_index from " << predicate_node->get_lhs_index() << " to " << new_lhs_index << std::endl;
 #endif
 
             if(predicate_node->get_rhs())
@@ -897,7 +923,7 @@ namespace Carli {
         }
         else if(auto filter_node = dynamic_cast<Rete::Rete_Filter *>(test.get())) {
 #ifdef DEBUG_OUTPUT
-          std::cerr << "  Filter" << std::endl;
+          agent.get_context().get_err() << "  Filter" << std::endl;
 #endif
           if(grammar == GRAMMAR_NULL_HOG) {
             Rete::WME_Bindings bindings2;
@@ -931,12 +957,12 @@ namespace Carli {
         const int64_t new_token_size = new_test->get_token_size();
 
 #ifdef DEBUG_OUTPUT
-        std::cerr << "Values: " << leaf_size << ' ' << leaf_token_size << ' ' << old_size << ' ' << old_token_size << ' ' << new_size << ' ' << new_token_size << std::endl;
+        agent.get_context().get_err() << "Values: " << leaf_size << ' ' << leaf_token_size << ' ' << old_size << ' ' << old_token_size << ' ' << new_size << ' ' << new_token_size << std::endl;
 #endif
 
         for(const auto &variable : *variables) {
 #ifdef DEBUG_OUTPUT
-          std::cerr << "Considering Variable '" << variable.first << "' at " << variable.second << std::endl;
+          agent.get_context().get_err() << "Considering Variable '" << variable.first << "' at " << variable.second << std::endl;
 #endif
           if(variable.second.rete_row < parent_action.lock()->get_size())
             continue;
@@ -952,21 +978,21 @@ namespace Carli {
             auto new_index = variable.second;
 
 #ifdef DEBUG_OUTPUT
-            std::cerr << "new_index(" << variable.first << ") was " << new_index << std::endl;
+            agent.get_context().get_err() << "new_index(" << variable.first << ") was " << new_index << std::endl;
 #endif
 
             if(new_size >= old_size) {
               /// Offset forward
               new_index.rete_row += new_size - old_size;
 #ifdef DEBUG_OUTPUT
-              std::cerr << "new_index.rete_row offset forward " << new_size  << '-' << old_size << " = " << new_index << std::endl;
+              agent.get_context().get_err() << "new_index.rete_row offset forward " << new_size  << '-' << old_size << " = " << new_index << std::endl;
 #endif
             }
             else if(new_index.rete_row >= leaf_size) {
               /// Offset backward
               new_index.rete_row -= old_size - new_size;
 #ifdef DEBUG_OUTPUT
-              std::cerr << "new_index.rete_row offset backward " << old_size << '-' << new_size << " = " << new_index << std::endl;
+              agent.get_context().get_err() << "new_index.rete_row offset backward " << old_size << '-' << new_size << " = " << new_index << std::endl;
 #endif
             }
 
@@ -974,7 +1000,7 @@ namespace Carli {
               /// Offset forward
               new_index.token_row += new_token_size - old_token_size;
 #ifdef DEBUG_OUTPUT
-              std::cerr << "new_index.token_row offset forward " << new_token_size << '-' << old_token_size << " = " << new_index << std::endl;
+              agent.get_context().get_err() << "new_index.token_row offset forward " << new_token_size << '-' << old_token_size << " = " << new_index << std::endl;
 #endif
             }
             else if(new_index.token_row >= leaf_token_size) {
@@ -982,11 +1008,11 @@ namespace Carli {
 
               new_index.token_row -= new_token_size - leaf_token_size;
 #ifdef DEBUG_OUTPUT
-              std::cerr << "new_index.token_row offset backward " << new_token_size << '-' << leaf_token_size << " = " << new_index << std::endl;
+              agent.get_context().get_err() << "new_index.token_row offset backward " << new_token_size << '-' << leaf_token_size << " = " << new_index << std::endl;
 #endif
               if(new_index.token_row < leaf_token_size) {
 #ifdef DEBUG_OUTPUT
-                std::cerr << "new_index discarded" << std::endl;
+                agent.get_context().get_err() << "new_index discarded" << std::endl;
 #endif
                 /// Discard intermediate fringe variables which no longer exist post-collapse
                 continue;
@@ -1005,17 +1031,17 @@ namespace Carli {
                 assert(ft->second.existential);
                 if(!ft->second.existential) {
 
-                  std::cerr << *new_feature->indices << std::endl;
-                  std::cerr << new_feature->axis << std::endl;
-                  new_feature->print_axis(std::cerr);
-                  std::cerr << std::endl;
+                  agent.get_context().get_err() << *new_feature->indices << std::endl;
+                  agent.get_context().get_err() << new_feature->axis << std::endl;
+                  new_feature->print_axis(agent.get_context().get_err());
+                  agent.get_context().get_err() << std::endl;
 
-                  std::cerr << *lra_lock->get_variables() << std::endl;
-                  lra_lock->print_rule(std::cerr);
-                  std::cerr << *ra_lock->get_variables() << std::endl;
-                  ra_lock->print_rule(std::cerr);
+                  agent.get_context().get_err() << *lra_lock->get_variables() << std::endl;
+                  lra_lock->print_rule(agent.get_context().get_err());
+                  agent.get_context().get_err() << *ra_lock->get_variables() << std::endl;
+                  ra_lock->print_rule(agent.get_context().get_err());
 
-                  std::cerr << "New variable conflicts with existing variable." << std::endl;
+                  agent.get_context().get_err() << "New variable conflicts with existing variable." << std::endl;
                   abort();
                 }
               }
@@ -1026,7 +1052,7 @@ namespace Carli {
             for(auto binding : new_feature->bindings) {
               if(binding.first == variable.second) {
 #ifdef DEBUG_OUTPUT
-                std::cerr << "Update binding from " << binding.first << " to " << new_index << std::endl;
+                agent.get_context().get_err() << "Update binding from " << binding.first << " to " << new_index << std::endl;
 #endif
                 new_bindings.insert(std::make_pair(new_index, binding.second));
               }
@@ -1036,8 +1062,8 @@ namespace Carli {
             new_feature->bindings = std::move(new_bindings);
 
 #ifdef DEBUG_OUTPUT
-            std::cerr << new_feature->bindings << std::endl;
-            std::cerr << "new_index(" << variable.first << ") = " << new_index << std::endl;
+            agent.get_context().get_err() << new_feature->bindings << std::endl;
+            agent.get_context().get_err() << "new_index(" << variable.first << ") = " << new_index << std::endl;
 #endif
           }
         }
@@ -1054,7 +1080,7 @@ namespace Carli {
 //        assert(new_feature->axis.existential || new_feature->axis.token_row < new_token_size);
         if(new_feature->axis.rete_row != -1) {
 #ifdef DEBUG_OUTPUT
-          std::cerr << "old_feature->axis = " << new_feature->axis << std::endl;
+          agent.get_context().get_err() << "old_feature->axis = " << new_feature->axis << std::endl;
 #endif
           const int64_t index_offset = new_size - old_size;
           const int64_t token_index_offset = new_token_size - old_token_size;
@@ -1063,7 +1089,7 @@ namespace Carli {
           assert(new_feature->axis.rete_row > -1);
           assert(new_feature->axis.token_row > -1);
 #ifdef DEBUG_OUTPUT
-          std::cerr << "new_feature->axis = " << new_feature->axis << std::endl;
+          agent.get_context().get_err() << "new_feature->axis = " << new_feature->axis << std::endl;
           if(new_variables)
             assert(std::find_if(new_variables->begin(), new_variables->end(), [new_feature](const std::pair<std::string, Rete::WME_Token_Index> &ind){return ind.second == new_feature->axis;}) != new_variables->end());
           else
@@ -1092,25 +1118,25 @@ namespace Carli {
       new_feature->indices = new_variables ? new_variables : old_variables;
 
 #ifdef DEBUG_OUTPUT
-      std::cerr << q_value_fringe->feature->axis << "-->" << new_feature->axis << " && " << *q_value_fringe->feature->indices << "-->" << *new_feature->indices << std::endl;
+      agent.get_context().get_err() << q_value_fringe->feature->axis << "-->" << new_feature->axis << " && " << *q_value_fringe->feature->indices << "-->" << *new_feature->indices << std::endl;
 #endif
     }
 
     /// Create the actual action for the new fringe node
     auto new_action = agent.make_standard_action(new_test, new_name, false, new_feature->indices);
-    auto new_action_data = std::make_shared<Node_Fringe>(agent, lra_lock, new_action, leaf.q_value_fringe->depth + 1, new_feature);
+    auto new_action_data = std::allocate_shared<Node_Fringe>(Zeni::Pool_Allocator<Node_Fringe>(), agent, lra_lock, new_action, leaf.q_value_fringe->depth + 1, new_feature);
     new_action->data = new_action_data;
 
     /// Add to the appropriate parent list
     leaf.fringe_values[new_action_data->q_value_fringe->feature.get()].push_back(new_action_data);
 
 #ifdef DEBUG_OUTPUT
-    std::cerr << *new_feature->indices << std::endl;
-    std::cerr << new_feature->axis << std::endl;
-    new_feature->print_axis(std::cerr);
-    std::cerr << std::endl;
+    agent.get_context().get_err() << *new_feature->indices << std::endl;
+    agent.get_context().get_err() << new_feature->axis << std::endl;
+    new_feature->print_axis(agent.get_context().get_err());
+    agent.get_context().get_err() << std::endl;
 
-    new_action->print_rule(std::cerr);
+    new_action->print_rule(agent.get_context().get_err());
 #endif
 
     if(auto bindings = new_action->parent_left()->get_bindings()) {
@@ -1121,22 +1147,22 @@ namespace Carli {
 //           || grammar == GRAMMAR_HOG
            )
         {
-          std::cerr << "BINDING FAILURE!!!" << std::endl;
+          agent.get_context().get_err() << "BINDING FAILURE!!!" << std::endl;
 
-          std::cerr << *new_feature->indices << std::endl;
-          std::cerr << new_feature->axis << std::endl;
-          new_feature->print_axis(std::cerr);
-          std::cerr << std::endl;
+          agent.get_context().get_err() << *new_feature->indices << std::endl;
+          agent.get_context().get_err() << new_feature->axis << std::endl;
+          new_feature->print_axis(agent.get_context().get_err());
+          agent.get_context().get_err() << std::endl;
 
-          std::cerr << *lra_lock->get_variables() << std::endl;
-          lra_lock->print_rule(std::cerr);
-          std::cerr << *ra_lock->get_variables() << std::endl;
-          ra_lock->print_rule(std::cerr);
-          std::cerr << *new_action->get_variables() << std::endl;
-          new_action->print_rule(std::cerr);
+          agent.get_context().get_err() << *lra_lock->get_variables() << std::endl;
+          lra_lock->print_rule(agent.get_context().get_err());
+          agent.get_context().get_err() << *ra_lock->get_variables() << std::endl;
+          ra_lock->print_rule(agent.get_context().get_err());
+          agent.get_context().get_err() << *new_action->get_variables() << std::endl;
+          new_action->print_rule(agent.get_context().get_err());
 
-          std::cerr << binding << " of " << *bindings << std::endl;
-          std::cerr << new_new_var_index << ", " << old_new_var_index << ", " << prev_var_index << std::endl;
+          agent.get_context().get_err() << binding << " of " << *bindings << std::endl;
+          agent.get_context().get_err() << new_new_var_index << ", " << old_new_var_index << ", " << prev_var_index << std::endl;
 
           std::string s;
           std::getline(std::cin, s);
@@ -1159,7 +1185,7 @@ namespace Carli {
 
     /// Create the actual action for the new fringe node
     auto new_action = agent.make_standard_action(ra_lock->parent_left(), new_name, false, new_feature->indices);
-    auto new_action_data = std::make_shared<Node_Fringe>(agent, lra_lock, new_action, leaf.q_value_fringe->depth + 1, new_feature);
+    auto new_action_data = std::allocate_shared<Node_Fringe>(Zeni::Pool_Allocator<Node_Fringe>(), agent, lra_lock, new_action, leaf.q_value_fringe->depth + 1, new_feature);
     new_action->data = new_action_data;
 
     /// Add to the appropriate parent list
@@ -1174,6 +1200,7 @@ namespace Carli {
     assert(q_value_weight_->type == Q_Value::Type::SPLIT);
     ++agent.q_value_count;
     q_value_fringe->type_internal = true;
+    agent.invalidate_value_sums();
   }
 
   Node_Split::~Node_Split() {
@@ -1205,11 +1232,21 @@ namespace Carli {
       agent.respecialize(*rete_action.lock());
   }
 
+  void Node_Split::materialize_children() {
+    if(!deferred_children)
+      return;
+
+    const auto deferred = std::move(deferred_children);
+    deferred_children = nullptr;
+    deferred(*this);
+  }
+
   Node_Unsplit::Node_Unsplit(Agent &agent_, const Rete::Rete_Action_Ptr &parent_action_, const Rete::Rete_Action_Ptr &rete_action_, const int64_t &depth_, const tracked_ptr<Feature> &feature_)
     : Node(agent_, parent_action_, rete_action_, new Q_Value(Q_Value::Token(), Q_Value::Type::UNSPLIT, depth_, feature_, agent_.get_total_step_count()), new Q_Value(Q_Value::Token(), Q_Value::Type::FRINGE, depth_, feature_->clone(), agent_.get_total_step_count()))
   {
     ++agent.q_value_count;
     q_value_fringe->type_internal = true;
+    agent.invalidate_value_sums();
   }
 
   Node_Unsplit::Node_Unsplit(Agent &agent_, const Rete::Rete_Action_Ptr &parent_action_, const Rete::Rete_Action_Ptr &rete_action_, const tracked_ptr<Q_Value> &q_value_weight_, const tracked_ptr<Q_Value> &q_value_fringe_)
@@ -1218,6 +1255,7 @@ namespace Carli {
     assert(q_value_weight_->type == Q_Value::Type::UNSPLIT);
     ++agent.q_value_count;
     q_value_fringe->type_internal = true;
+    agent.invalidate_value_sums();
   }
 
   Node_Unsplit::~Node_Unsplit() {
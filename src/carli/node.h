@@ -1,12 +1,14 @@
 #ifndef CARLI_NODE_H
 #define CARLI_NODE_H
 
+#include "utility/linked_list.h"
 #include "utility/tracked_ptr.h"
 
 #include "action.h"
 #include "feature.h"
 #include "q_value.h"
 
+#include <functional>
 #include <map>
 
 namespace Carli {
@@ -61,7 +63,7 @@ namespace Carli {
   };
 #endif
 
-  class CARLI_LINKAGE Node : public std::enable_shared_from_this<Node>, public Zeni::Pool_Allocator<Node_Split>, public Rete::Rete_Data {
+  class CARLI_LINKAGE Node : public std::enable_shared_from_this<Node>, public Zeni::Pool_Allocator<Node>, public Rete::Rete_Data {
     Node(const Node &) = delete;
     Node & operator=(const Node &) = delete;
 
@@ -72,16 +74,9 @@ namespace Carli {
 
     enum Grammar {GRAMMAR_NORMAL, GRAMMAR_HOG, GRAMMAR_NULL_HOG};
 
-    Node(Agent &agent_, const Rete::Rete_Action_Ptr &parent_action_, const Rete::Rete_Action_Ptr &rete_action_, const tracked_ptr<Q_Value> &q_value_weight_, const tracked_ptr<Q_Value> &q_value_fringe_)
-     : agent(agent_),
-     parent_action(parent_action_),
-     rete_action(rete_action_),
-     variables(rete_action_->get_variables()),
-     q_value_weight(q_value_weight_),
-     q_value_fringe(q_value_fringe_)
-    {
-      assert((q_value_weight && q_value_weight->depth == 1) || (q_value_fringe && q_value_fringe->depth == 1) || parent_action.lock());
-    }
+    typedef Zeni::Linked_List<Node> List;
+
+    Node(Agent &agent_, const Rete::Rete_Action_Ptr &parent_action_, const Rete::Rete_Action_Ptr &rete_action_, const tracked_ptr<Q_Value> &q_value_weight_, const tracked_ptr<Q_Value> &q_value_fringe_);
 
     virtual ~Node();
 
@@ -101,8 +96,10 @@ namespace Carli {
     Rete::Rete_Node_Ptr_C get_suppress() const override;
 
     void action(const Rete::WME_Token &token);
+    virtual void activated() {} ///< The first token has matched
     virtual void decision() = 0;
     void retraction(const Rete::WME_Token &token);
+    void modification(const Rete::WME_Token &old_token, const Rete::WME_Token &new_token); ///< The match persists, so activations are unchanged
 
     Node_Split_Ptr create_split(const Rete::Rete_Action_Ptr &parent_action_);
     Node_Unsplit_Ptr create_unsplit(const Rete::Rete_Action_Ptr &parent_action_);
@@ -110,13 +107,20 @@ namespace Carli {
     Node_Fringe_Ptr recreate_fringe(Node_Unsplit &leaf);
 
     Agent &agent;
-    std::weak_ptr<Rete::Rete_Action> parent_action;
-    std::weak_ptr<Rete::Rete_Action> rete_action;
+    Rete::Rete_Action_Ptr_W parent_action;
+    Rete::Rete_Action_Ptr_W rete_action;
     Rete::Variable_Indices_Ptr_C variables;
     tracked_ptr<Q_Value> q_value_weight;
     bool delete_q_value_weight = true;
     tracked_ptr<Q_Value> q_value_fringe;
     bool delete_q_value_fringe = true;
+    int64_t creation_index; ///< From Agent::next_creation_index, unless restored from a checkpoint
+
+    int64_t activations = 0; ///< Number of tokens currently matched
+    List activation; ///< Link into the agent's active or activating nodes while activations > 0
+
+  private:
+    void deactivate();
   };
 
   class CARLI_LINKAGE Node_Split : public Node {
@@ -138,9 +142,13 @@ namespace Carli {
     std::list<Node_Ptr> descendants() {return Node::descendants();}
     void descendants(std::list<Node_Ptr> &descendants_) override;
 
+    void activated() override {materialize_children();}
     void decision() override;
 
+    void materialize_children(); ///< Build any children still deferred
+
     std::list<Node_Ptr_W> children; ///< Not cloned
+    std::function<void (Node_Split &)> deferred_children; ///< Builds the children left in a compiled rules file once this split first matches; not cloned
     Fringe_Axis_Selections fringe_axis_selections;
     int64_t fringe_axis_counter = 0;
     bool blacklist_full = false;
@@ -202,10 +210,9 @@ namespace Carli {
   };
 
   inline void __node_size_check() {
-    typedef Node::value_type pool_allocator_type;
-    static_assert(sizeof(pool_allocator_type) >= sizeof(Node_Split), "Pool size suboptimal.");
-    static_assert(sizeof(pool_allocator_type) >= sizeof(Node_Unsplit), "Pool size suboptimal.");
-    static_assert(sizeof(pool_allocator_type) >= sizeof(Node_Fringe), "Pool size suboptimal.");
+    static_assert(Zeni::Pool_Map::is_small(sizeof(Node_Split)), "Pool lookup hashed.");
+    static_assert(Zeni::Pool_Map::is_small(sizeof(Node_Unsplit)), "Pool lookup hashed.");
+    static_assert(Zeni::Pool_Map::is_small(sizeof(Node_Fringe)), "Pool lookup hashed.");
   }
 
 }
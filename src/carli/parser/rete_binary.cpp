@@ -0,0 +1,1698 @@
+#include "rete_parser.h"
+
+#include "../utility/serialize.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iterator>
+#include <list>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#ifdef _WINDOWS
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <io.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Rete {
+
+  namespace {
+
+    /// A header followed by records, each defining a symbol, a node, or a rule in terms of those before it
+    const char g_binary_magic[8] = {'C', 'A', 'R', 'L', 'I', 'R', 'B', '\n'};
+    const uint32_t g_binary_version = 1;
+    const uint32_t g_binary_byte_order = 0x01020304; ///< Fields are written in the byte order of the machine
+
+    enum class Binary_Record : uint8_t {
+      SYMBOL_FLOAT, SYMBOL_INT, SYMBOL_STRING, SYMBOL_IDENTIFIER, SYMBOL_VARIABLE,
+      VARIABLE_NAME,
+      FILTER, JOIN, EXISTENTIAL_JOIN, NEGATION_JOIN, EXISTENTIAL, NEGATION, PREDICATE_VC, PREDICATE_VV,
+      RULE,
+      RULE_STATE, EXCISE, STATE, ///< Checkpoint journals only
+      RULE_NAME_INDEX, TOTAL_STEP_COUNT, ///< Compiled templates only, where the header would have set them
+      OPTIONS ///< Checkpoint journals only, opening each compacted one
+    };
+
+    /// A header followed by segments, each framed by its size and checksum and holding the records of a checkpoint since the one before
+    const char g_checkpoint_magic[8] = {'C', 'A', 'R', 'L', 'I', 'C', 'P', '\n'};
+    const uint32_t g_checkpoint_version = 4;
+
+    uint64_t zigzag(const int64_t &value) {
+      return (uint64_t(value) << 1) ^ uint64_t(value >> 63);
+    }
+
+    int64_t unzigzag(const uint64_t &value) {
+      return int64_t(value >> 1) ^ -int64_t(value & 1);
+    }
+
+    uint64_t checksum(const char * const &data, const uint64_t &size) {
+      uint64_t hash = 0xcbf29ce484222325ull; ///< FNV-1a
+      for(uint64_t i = 0; i != size; ++i) {
+        hash ^= uint8_t(data[i]);
+        hash *= 0x100000001b3ull;
+      }
+      return hash;
+    }
+
+    /// The rules of a checkpoint journal by name, with the symbols, variable names, and nodes its segments have defined
+    struct Checkpoint_Image {
+      std::pair<const char *, const char *> node_record(const uint64_t &index) const {
+        const auto &record = node_records.at(index);
+        return std::make_pair(record.data(), record.data() + record.size());
+      }
+
+      std::vector<Symbol_Ptr_C> symbols;
+      std::vector<std::string> variable_names;
+      std::vector<std::string> node_records; ///< Each from its tag
+      std::map<std::string, std::pair<std::string, std::string>> rules; ///< Each RULE record past its tag, with the latest RULE_STATE for it
+      std::string state; ///< The latest STATE
+      std::string options; ///< The latest OPTIONS
+    };
+
+    class Binary_Writer {
+      Binary_Writer(const Binary_Writer &) = delete;
+      Binary_Writer & operator=(const Binary_Writer &) = delete;
+
+    public:
+      Binary_Writer(std::ostream &os)
+       : m_os(os)
+      {
+      }
+
+      /// Continue a journal, numbering definitions after the image's and referring to the nodes made from it that remain
+      Binary_Writer(std::ostream &os, const Checkpoint_Image &image, const std::unordered_map<uint64_t, Weak_Ptr<const Rete_Node>> &nodes);
+
+      template <typename TYPE>
+      void write(const TYPE &value) {
+        m_os.write(reinterpret_cast<const char *>(&value), sizeof(TYPE));
+      }
+
+      /// Indices, counts, and rows are mostly small, so they take 7 bits per byte
+      void write_varint(uint64_t value) {
+        for(; value > 0x7F; value >>= 7)
+          write(uint8_t(value | 0x80));
+        write(uint8_t(value));
+      }
+
+      void write(const std::string &str) {
+        write_varint(str.size());
+        m_os.write(str.data(), str.size());
+      }
+
+      void write(const WME_Token_Index &index) {
+        write_varint(zigzag(index.rete_row));
+        write_varint(zigzag(index.token_row));
+        write(index.column);
+        write(uint8_t(index.existential));
+      }
+
+      uint64_t symbol(const Symbol_Ptr_C &symbol);
+      uint64_t variable_name(const std::string &name); ///< Rules repeat the names of the variables they share with their parents
+      uint64_t node(const Rete_Node &node); ///< Write the node after its parents, in the order the parser makes them
+      void rule(const Rete_Action &action);
+
+      /// The nodes written or referred to, for the writer continuing the journal after this one
+      std::unordered_map<uint64_t, Weak_Ptr<const Rete_Node>> nodes() const;
+
+    private:
+      std::ostream &m_os;
+      std::unordered_map<Symbol_Ptr_C, uint64_t> m_symbols; ///< Held, so that no other symbol takes the address of one defined
+      std::unordered_map<std::string, uint64_t> m_variable_names;
+      std::unordered_map<const Rete_Node *, std::pair<uint64_t, Weak_Ptr<const Rete_Node>>> m_nodes; ///< Expired if another node may have taken the address
+      uint64_t m_symbol_count = 0;
+      uint64_t m_variable_name_count = 0;
+      uint64_t m_node_count = 0;
+    };
+
+    Binary_Writer::Binary_Writer(std::ostream &os, const Checkpoint_Image &image, const std::unordered_map<uint64_t, Weak_Ptr<const Rete_Node>> &nodes)
+     : m_os(os),
+     m_symbol_count(image.symbols.size()),
+     m_variable_name_count(image.variable_names.size()),
+     m_node_count(image.node_records.size())
+    {
+      for(uint64_t index = 0; index != image.symbols.size(); ++index)
+        m_symbols[image.symbols[index]] = index;
+      for(uint64_t index = 0; index != image.variable_names.size(); ++index)
+        m_variable_names[image.variable_names[index]] = index;
+      for(const auto &node : nodes) {
+        if(const auto locked = node.second.lock())
+          m_nodes[locked.get()] = std::make_pair(node.first, node.second);
+      }
+    }
+
+    std::unordered_map<uint64_t, Weak_Ptr<const Rete_Node>> Binary_Writer::nodes() const {
+      std::unordered_map<uint64_t, Weak_Ptr<const Rete_Node>> nodes;
+      for(const auto &node : m_nodes) {
+        if(!node.second.second.expired())
+          nodes[node.second.first] = node.second.second;
+      }
+      return nodes;
+    }
+
+    uint64_t Binary_Writer::symbol(const Symbol_Ptr_C &symbol) {
+      const auto found = m_symbols.find(symbol);
+      if(found != m_symbols.end())
+        return found->second;
+
+      if(const auto symbol_f = dynamic_cast<const Symbol_Constant_Float *>(symbol.get())) {
+        write(Binary_Record::SYMBOL_FLOAT);
+        write(symbol_f->value);
+      }
+      else if(const auto symbol_i = dynamic_cast<const Symbol_Constant_Int *>(symbol.get())) {
+        write(Binary_Record::SYMBOL_INT);
+        write(symbol_i->value);
+      }
+      else if(const auto symbol_s = dynamic_cast<const Symbol_Constant_String *>(symbol.get())) {
+        write(Binary_Record::SYMBOL_STRING);
+        write(symbol_s->value);
+      }
+      else if(const auto symbol_id = dynamic_cast<const Symbol_Identifier *>(symbol.get())) {
+        write(Binary_Record::SYMBOL_IDENTIFIER);
+        write(symbol_id->value);
+      }
+      else if(const auto symbol_v = dynamic_cast<const Symbol_Variable *>(symbol.get())) {
+        write(Binary_Record::SYMBOL_VARIABLE);
+        write(uint8_t(symbol_v->value));
+      }
+      else
+        abort();
+
+      const uint64_t index = m_symbol_count++;
+      m_symbols[symbol] = index;
+      return index;
+    }
+
+    uint64_t Binary_Writer::variable_name(const std::string &name) {
+      const auto found = m_variable_names.find(name);
+      if(found != m_variable_names.end())
+        return found->second;
+
+      write(Binary_Record::VARIABLE_NAME);
+      write(name);
+
+      const uint64_t index = m_variable_name_count++;
+      m_variable_names[name] = index;
+      return index;
+    }
+
+    uint64_t Binary_Writer::node(const Rete_Node &node) {
+      const auto found = m_nodes.find(&node);
+      if(found != m_nodes.end() && !found->second.second.expired())
+        return found->second.first;
+
+      if(const auto filter = dynamic_cast<const Rete_Filter *>(&node)) {
+        const auto &symbols = filter->get_wme().symbols;
+        const uint64_t first = symbol(symbols[0]);
+        const uint64_t second = symbol(symbols[1]);
+        const uint64_t third = symbol(symbols[2]);
+        write(Binary_Record::FILTER);
+        write_varint(first);
+        write_varint(second);
+        write_varint(third);
+      }
+      else if(const auto predicate = dynamic_cast<const Rete_Predicate *>(&node)) {
+        /// An interval routing tokens to the predicate is made along with it, so the input is its parent
+        const uint64_t parent = this->node(*predicate->parent_left());
+        if(predicate->get_rhs()) {
+          const uint64_t rhs = symbol(predicate->get_rhs());
+          write(Binary_Record::PREDICATE_VC);
+          write(uint8_t(predicate->get_predicate()));
+          write(predicate->get_lhs_index());
+          write_varint(rhs);
+        }
+        else {
+          write(Binary_Record::PREDICATE_VV);
+          write(uint8_t(predicate->get_predicate()));
+          write(predicate->get_lhs_index());
+          write(predicate->get_rhs_index());
+        }
+        write_varint(parent);
+      }
+      else if(const auto bindings = node.get_bindings()) {
+        const uint64_t left = this->node(*node.parent_left());
+        const uint64_t right = this->node(*node.parent_right());
+        if(dynamic_cast<const Rete_Join *>(&node))
+          write(Binary_Record::JOIN);
+        else if(dynamic_cast<const Rete_Existential_Join *>(&node))
+          write(Binary_Record::EXISTENTIAL_JOIN);
+        else if(dynamic_cast<const Rete_Negation_Join *>(&node))
+          write(Binary_Record::NEGATION_JOIN);
+        else
+          abort();
+        write_varint(left);
+        write_varint(right);
+        write_varint(bindings->size());
+        for(const auto &binding : *bindings) {
+          write(binding.first);
+          write(binding.second);
+        }
+      }
+      else {
+        const uint64_t parent = this->node(*node.parent_left());
+        if(dynamic_cast<const Rete_Existential *>(&node))
+          write(Binary_Record::EXISTENTIAL);
+        else if(dynamic_cast<const Rete_Negation *>(&node))
+          write(Binary_Record::NEGATION);
+        else
+          abort();
+        write_varint(parent);
+      }
+
+      const uint64_t index = m_node_count++;
+      m_nodes[&node] = std::make_pair(index, Weak_Ptr<const Rete_Node>(node.shared()));
+      return index;
+    }
+
+    void Binary_Writer::rule(const Rete_Action &action) {
+      const uint64_t parent = node(*action.parent_left());
+
+      const auto &variables = action.get_variables();
+      if(variables) {
+        for(const auto &variable : *variables)
+          variable_name(variable.first); ///< Define new names ahead of the record
+      }
+
+      write(Binary_Record::RULE);
+      write(action.get_name());
+      write_varint(parent);
+
+      write_varint(variables ? variables->size() : 0);
+      if(variables) {
+        for(const auto &variable : *variables) {
+          write_varint(variable_name(variable.first));
+          write(variable.second);
+        }
+      }
+
+      /// The flags and value of Node::print_flags and Node::print_action, unrounded
+      const auto node = dynamic_cast<const Carli::Node *>(action.data.get());
+      write(uint8_t(node != nullptr));
+      if(!node)
+        return;
+
+      const auto &q_value = node->q_value_weight ? node->q_value_weight : node->q_value_fringe;
+      write(q_value->creation_time);
+      write(q_value->depth);
+
+      if(dynamic_cast<const Carli::Node_Fringe *>(node))
+        write(std::string("fringe"));
+      else if(dynamic_cast<const Carli::Node_Split *>(node))
+        write(std::string("split"));
+      else
+        write(std::string("unsplit"));
+
+      write(int64_t(q_value->feature && q_value->feature->arity > -1 ? q_value->feature->arity : -1));
+
+      if(q_value->depth == 1)
+        write(std::string("nil"));
+      else {
+        const auto pal = node->parent_action.lock();
+        assert(pal);
+        write(pal ? pal->get_name() : std::string("nil"));
+      }
+
+      const auto feature_ranged = dynamic_cast<const Carli::Feature_Ranged_Data *>(q_value->feature.get());
+      write(uint8_t(feature_ranged != nullptr));
+      if(feature_ranged) {
+        write(feature_ranged->depth);
+        write(feature_ranged->bound_lower);
+        write(feature_ranged->bound_upper);
+        write(uint8_t(feature_ranged->integer_locked));
+      }
+
+      write(q_value->primary);
+      write(q_value->primary_mean2);
+      write(q_value->primary_variance);
+      write(q_value->secondary);
+      write(q_value->update_count);
+    }
+
+    /// A read-only view of a whole file, paged in as records are read
+    class Binary_Mapping {
+      Binary_Mapping(const Binary_Mapping &) = delete;
+      Binary_Mapping & operator=(const Binary_Mapping &) = delete;
+
+    public:
+      Binary_Mapping(const std::string &filename);
+      ~Binary_Mapping();
+
+      const char * data() const {return m_data;}
+      size_t size() const {return m_size;}
+
+    private:
+#ifdef _WINDOWS
+      HANDLE m_file = INVALID_HANDLE_VALUE;
+      HANDLE m_mapping = nullptr;
+#endif
+      const char * m_data = nullptr;
+      size_t m_size = 0;
+    };
+
+#ifdef _WINDOWS
+    Binary_Mapping::Binary_Mapping(const std::string &filename) {
+      m_file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+      if(m_file == INVALID_HANDLE_VALUE)
+        return;
+      LARGE_INTEGER size;
+      if(!GetFileSizeEx(m_file, &size) || !size.QuadPart)
+        return;
+      m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+      if(!m_mapping)
+        return;
+      m_data = static_cast<const char *>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+      if(m_data)
+        m_size = size_t(size.QuadPart);
+    }
+
+    Binary_Mapping::~Binary_Mapping() {
+      if(m_data)
+        UnmapViewOfFile(m_data);
+      if(m_mapping)
+        CloseHandle(m_mapping);
+      if(m_file != INVALID_HANDLE_VALUE)
+        CloseHandle(m_file);
+    }
+#else
+    Binary_Mapping::Binary_Mapping(const std::string &filename) {
+      const int fd = open(filename.c_str(), O_RDONLY);
+      if(fd == -1)
+        return;
+      struct stat st;
+      if(!fstat(fd, &st) && st.st_size) {
+        void * const data = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if(data != MAP_FAILED) {
+          m_data = static_cast<const char *>(data);
+          m_size = size_t(st.st_size);
+        }
+      }
+      close(fd);
+    }
+
+    Binary_Mapping::~Binary_Mapping() {
+      if(m_data)
+        munmap(const_cast<char *>(m_data), m_size);
+    }
+#endif
+
+    class Binary_Reader {
+      Binary_Reader(const Binary_Reader &) = delete;
+      Binary_Reader & operator=(const Binary_Reader &) = delete;
+
+    public:
+      Binary_Reader(const char * const &begin, const char * const &end)
+       : m_pos(begin),
+       m_end(end)
+      {
+      }
+
+      bool done() const {return m_pos == m_end;}
+      const char * position() const {return m_pos;}
+
+      template <typename TYPE>
+      TYPE read() {
+        TYPE value;
+        std::memcpy(&value, take(sizeof(TYPE)), sizeof(TYPE));
+        return value;
+      }
+
+      const char * read_bytes(const uint64_t &bytes) {
+        return take(bytes);
+      }
+
+      uint64_t read_varint() {
+        uint64_t value = 0;
+        for(int shift = 0; shift < 64; shift += 7) {
+          const auto byte = read<uint8_t>();
+          value |= uint64_t(byte & 0x7F) << shift;
+          if(!(byte & 0x80))
+            return value;
+        }
+        throw std::runtime_error("Invalid varint.");
+      }
+
+      std::string read_string() {
+        const auto size = read_varint();
+        return std::string(take(size), size);
+      }
+
+      WME_Token_Index read_index() {
+        const auto rete_row = unzigzag(read_varint());
+        const auto token_row = unzigzag(read_varint());
+        const auto column = read<int8_t>();
+        WME_Token_Index index(rete_row, token_row, column);
+        index.existential = read<uint8_t>() != 0;
+        return index;
+      }
+
+    private:
+      const char * take(const uint64_t &bytes) {
+        if(uint64_t(m_end - m_pos) < bytes)
+          throw std::runtime_error("Unexpected end of file.");
+        const char * const pos = m_pos;
+        m_pos += bytes;
+        return pos;
+      }
+
+      const char * m_pos;
+      const char * const m_end;
+    };
+
+    Rete_Predicate::Predicate read_predicate(Binary_Reader &reader) {
+      const auto predicate = reader.read<uint8_t>();
+      if(predicate > Rete_Predicate::LTE)
+        throw std::runtime_error("Invalid predicate.");
+      return Rete_Predicate::Predicate(predicate);
+    }
+
+    /// The symbols and variable names of a mapped file or compiled template, and where each of its nodes is defined, kept while any of its rules are deferred
+    struct Binary_Image {
+      Binary_Image(const std::string &filename_)
+       : filename(filename_),
+       mapping(new Binary_Mapping(filename_))
+      {
+      }
+
+      Binary_Image(const std::string &filename_, const std::shared_ptr<const std::string> &records_)
+       : filename(filename_),
+       records(records_)
+      {
+      }
+
+      const char * begin() const {return mapping ? mapping->data() : records->data();}
+      const char * end() const {return mapping ? mapping->data() + mapping->size() : records->data() + records->size();}
+      std::pair<const char *, const char *> node_record(const uint64_t &index) const {return std::make_pair(node_records.at(index), end());}
+
+      const std::string filename;
+      const std::unique_ptr<const Binary_Mapping> mapping;
+      const std::shared_ptr<const std::string> records; ///< Shared by every agent loading the template, each interning its own symbols from it
+      std::vector<Symbol_Ptr_C> symbols;
+      std::vector<std::string> variable_names;
+      std::vector<const char *> node_records;
+    };
+
+    /// Read a node record, making the node from the parents node resolves; agent is null to only skip past it
+    Rete_Node_Ptr read_node(Carli::Agent * const &agent, const Binary_Record &record, Binary_Reader &reader, const std::vector<Symbol_Ptr_C> &symbols, const std::function<Rete_Node_Ptr (const uint64_t &)> &node) {
+      switch(record) {
+        case Binary_Record::FILTER:
+        {
+          const auto &first = symbols.at(reader.read_varint());
+          const auto &second = symbols.at(reader.read_varint());
+          const auto &third = symbols.at(reader.read_varint());
+          return agent ? agent->make_filter(WME(first, second, third)) : nullptr;
+        }
+
+        case Binary_Record::JOIN:
+        case Binary_Record::EXISTENTIAL_JOIN:
+        case Binary_Record::NEGATION_JOIN:
+        {
+          const auto left = reader.read_varint();
+          const auto right = reader.read_varint();
+          WME_Bindings bindings;
+          for(auto count = reader.read_varint(); count; --count) {
+            const auto first = reader.read_index();
+            const auto second = reader.read_index();
+            bindings.insert(WME_Binding(first, second));
+          }
+
+          if(!agent)
+            return nullptr;
+          const auto left_node = node(left);
+          const auto right_node = node(right);
+          if(record == Binary_Record::JOIN)
+            return agent->make_join(bindings, left_node, right_node);
+          else if(record == Binary_Record::EXISTENTIAL_JOIN)
+            return agent->make_existential_join(bindings, left_node, right_node);
+          else
+            return agent->make_negation_join(bindings, left_node, right_node);
+        }
+
+        case Binary_Record::EXISTENTIAL:
+        {
+          const auto parent = reader.read_varint();
+          return agent ? agent->make_existential(node(parent)) : nullptr;
+        }
+
+        case Binary_Record::NEGATION:
+        {
+          const auto parent = reader.read_varint();
+          return agent ? agent->make_negation(node(parent)) : nullptr;
+        }
+
+        case Binary_Record::PREDICATE_VC:
+        {
+          const auto predicate = read_predicate(reader);
+          const auto lhs_index = reader.read_index();
+          const auto &rhs = symbols.at(reader.read_varint());
+          const auto parent = reader.read_varint();
+          return agent ? agent->make_predicate_vc(predicate, lhs_index, rhs, node(parent)) : nullptr;
+        }
+
+        case Binary_Record::PREDICATE_VV:
+        {
+          const auto predicate = read_predicate(reader);
+          const auto lhs_index = reader.read_index();
+          const auto rhs_index = reader.read_index();
+          const auto parent = reader.read_varint();
+          return agent ? agent->make_predicate_vv(predicate, lhs_index, rhs_index, node(parent)) : nullptr;
+        }
+
+        default:
+          abort();
+      }
+    }
+
+    /// Read a symbol or variable name record into the image; false for any other record
+    template <typename IMAGE>
+    bool read_definition(const Binary_Record &record, Binary_Reader &reader, IMAGE &image) {
+      switch(record) {
+        case Binary_Record::SYMBOL_FLOAT:
+          image.symbols.push_back(Symbol_Constant_Float::intern(reader.read<double>()));
+          return true;
+
+        case Binary_Record::SYMBOL_INT:
+          image.symbols.push_back(Symbol_Constant_Int::intern(reader.read<int64_t>()));
+          return true;
+
+        case Binary_Record::SYMBOL_STRING:
+          image.symbols.push_back(Symbol_Constant_String::intern(reader.read_string()));
+          return true;
+
+        case Binary_Record::SYMBOL_IDENTIFIER:
+          image.symbols.push_back(Symbol_Identifier::intern(reader.read_string()));
+          return true;
+
+        case Binary_Record::SYMBOL_VARIABLE:
+        {
+          const auto variable = reader.read<uint8_t>();
+          if(variable > Symbol_Variable::Third)
+            throw std::runtime_error("Invalid variable.");
+          image.symbols.push_back(make_pooled<Symbol_Variable>(Symbol_Variable::Variable(variable)));
+          return true;
+        }
+
+        case Binary_Record::VARIABLE_NAME:
+          image.variable_names.push_back(reader.read_string());
+          return true;
+
+        default:
+          return false;
+      }
+    }
+
+    /// Make a node after the parents it refers to, unless this pass already made it
+    template <typename IMAGE>
+    Rete_Node_Ptr build_node(Carli::Agent &agent, const IMAGE &image, std::unordered_map<uint64_t, Rete_Node_Ptr> &nodes, const uint64_t &index) {
+      const auto found = nodes.find(index);
+      if(found != nodes.end())
+        return found->second;
+
+      const auto record_bounds = image.node_record(index);
+      Binary_Reader reader(record_bounds.first, record_bounds.second);
+      const auto record = reader.read<Binary_Record>();
+      const auto node = read_node(&agent, record, reader, image.symbols, [&agent, &image, &nodes](const uint64_t &parent) {
+        return build_node(agent, image, nodes, parent);
+      });
+      nodes[index] = node;
+      return node;
+    }
+
+    /// The fields of a RULE record, the flags among them as Node::print_flags writes them
+    struct Binary_Rule {
+      std::string name;
+      uint64_t node = 0;
+      std::vector<std::pair<uint64_t, WME_Token_Index>> variables;
+
+      bool has_data = false;
+      int64_t creation_time = 0;
+      int64_t depth = 0;
+      std::string node_type;
+      int64_t arity = -1;
+      std::string parent_name;
+
+      bool ranged = false;
+      int64_t feature_depth = 0;
+      double bound_lower = 0.0;
+      double bound_upper = 0.0;
+      bool integer_locked = false;
+
+      Carli::Q_Value::Token value;
+    };
+
+    Binary_Rule read_rule(Binary_Reader &reader) {
+      Binary_Rule rule;
+
+      rule.name = reader.read_string();
+      rule.node = reader.read_varint();
+      for(auto count = reader.read_varint(); count; --count) {
+        const auto variable = reader.read_varint();
+        const auto index = reader.read_index();
+        rule.variables.push_back(std::make_pair(variable, index));
+      }
+
+      rule.has_data = reader.read<uint8_t>() != 0;
+      if(rule.has_data) {
+        rule.creation_time = reader.read<int64_t>();
+        rule.depth = reader.read<int64_t>();
+        rule.node_type = reader.read_string();
+        rule.arity = reader.read<int64_t>();
+        rule.parent_name = reader.read_string();
+
+        rule.ranged = reader.read<uint8_t>() != 0;
+        if(rule.ranged) {
+          rule.feature_depth = reader.read<int64_t>();
+          rule.bound_lower = reader.read<double>();
+          rule.bound_upper = reader.read<double>();
+          rule.integer_locked = reader.read<uint8_t>() != 0;
+        }
+
+        const auto primary = reader.read<double>();
+        const auto primary_mean2 = reader.read<double>();
+        const auto primary_variance = reader.read<double>();
+        const auto secondary = reader.read<double>();
+        const auto update_count = reader.read<int64_t>();
+        rule.value = Carli::Q_Value::Token(primary, primary_mean2, primary_variance, secondary, update_count);
+      }
+
+      return rule;
+    }
+
+    /// Rebuild the flags as the rule grammar would from the text Node::print_flags writes, then source the rule
+    const char * make_rule(Carli::Agent &agent, const Binary_Rule &rule, const Rete_Node_Ptr &node, const std::vector<std::string> &variable_names, bool &fatal) {
+      Parser_Rete_Node conditions(node, Variable_Indices());
+      for(const auto &variable : rule.variables)
+        conditions.second.insert(std::make_pair(variable_names.at(variable.first), variable.second));
+
+      Parser_Flag flags;
+      if(rule.has_data) {
+        Carli::Feature * feature = nullptr;
+        if(rule.ranged)
+          feature = new Carli::Feature_Ranged<Carli::Feature>(std::vector<WME>(), WME_Bindings(), WME_Token_Index(), nullptr, rule.arity, rule.bound_lower, rule.bound_upper, rule.feature_depth, Rete_Predicate::EQ, rule.integer_locked);
+        else if(rule.arity == 0)
+          feature = new Carli::Feature_NullHOG<Carli::Feature>(std::vector<WME>(), WME_Bindings(), WME_Token_Index(), nullptr, 0, "");
+        else if(rule.arity > 0 || rule.depth > 1)
+          feature = new Carli::Feature_Enumerated<Carli::Feature>(std::vector<WME>(), WME_Bindings(), WME_Token_Index(), nullptr, rule.arity, 0);
+
+        std::get<0>(flags) = std::make_shared<int64_t>(rule.creation_time);
+        if(feature)
+          std::get<1>(flags) = std::make_shared<std::tuple<int64_t, std::string, std::string, Carli::Feature *>>(rule.depth, rule.node_type, rule.parent_name, feature);
+        else
+          std::get<1>(flags) = std::make_shared<std::tuple<int64_t, std::string, std::string, Carli::Feature *>>(1, rule.node_type, "", nullptr);
+      }
+      else {
+        std::get<0>(flags) = std::make_shared<int64_t>(agent.get_total_step_count());
+        std::get<1>(flags) = std::make_shared<std::tuple<int64_t, std::string, std::string, Carli::Feature *>>();
+      }
+
+      return rete_make_rule(agent, Parser_Rule(conditions, rule.name, flags, rule.value), fatal);
+    }
+
+    /// A rule left in the mapped file until its parent split first activates, with the rules deferred beneath it
+    struct Binary_Deferred {
+      const char * record; ///< Just past its RULE tag
+      int64_t creation_index; ///< Reserved as the file was loaded, so that the rule is ordered as if it had been made then
+      std::list<Binary_Deferred> children;
+    };
+
+    bool materialize(Carli::Agent &agent, const std::shared_ptr<const Binary_Image> &image, std::unordered_map<uint64_t, Rete_Node_Ptr> &nodes, Binary_Deferred &deferred);
+
+    /// Leave children beneath a split until it first activates; beneath anything else, make them now
+    bool defer_children(Carli::Agent &agent, const std::shared_ptr<const Binary_Image> &image, std::unordered_map<uint64_t, Rete_Node_Ptr> &nodes, const std::string &name, const uint64_t &node, std::list<Binary_Deferred> &&children) {
+      if(children.empty())
+        return true;
+
+      const auto action = agent.get_rule(name);
+      if(const auto split = dynamic_cast<Carli::Node_Split *>(action ? action->data.get() : nullptr)) {
+        split->deferred_children = [image, node, children = std::move(children)](Carli::Node_Split &split_) mutable {
+          std::unordered_map<uint64_t, Rete_Node_Ptr> split_nodes;
+          split_nodes[node] = split_.rete_action.lock()->parent_left();
+          for(auto &child : children) {
+            if(!materialize(split_.agent, image, split_nodes, child))
+              throw std::runtime_error("Failed to make the rules deferred beneath '" + split_.rete_action.lock()->get_name() + "' from '" + image->filename + "'.");
+          }
+        };
+        return true;
+      }
+
+      for(auto &child : children) {
+        if(!materialize(agent, image, nodes, child))
+          return false;
+      }
+      return true;
+    }
+
+    /// Make a deferred rule from the file, then its children; false if the error reported is fatal
+    bool materialize(Carli::Agent &agent, const std::shared_ptr<const Binary_Image> &image, std::unordered_map<uint64_t, Rete_Node_Ptr> &nodes, Binary_Deferred &deferred) {
+      Binary_Reader reader(deferred.record, image->end());
+      const auto rule = read_rule(reader);
+
+      const int64_t creation_index = agent.get_creation_index();
+      agent.set_creation_index(deferred.creation_index);
+      bool fatal = false;
+      const char * const error = make_rule(agent, rule, build_node(agent, *image, nodes, rule.node), image->variable_names, fatal);
+      agent.set_creation_index(creation_index);
+      if(error) {
+        agent.get_context().get_out() << "rete-load error " << image->filename << ": " << error << std::endl;
+        return !fatal;
+      }
+
+      return defer_children(agent, image, nodes, rule.name, rule.node, std::move(deferred.children));
+    }
+
+    /// Replay the records of a rules file past its header, or of a compiled template, which has none; lazily, nodes are made only for the rules made, and rules beneath splits wait for those splits to first match
+    int load_image(Carli::Agent &agent, const std::shared_ptr<Binary_Image> &image, const bool &header, const bool &lazy) {
+      std::unordered_map<uint64_t, Rete_Node_Ptr> nodes;
+      std::unordered_map<std::string, Binary_Deferred *> deferred;
+      std::map<std::string, std::pair<uint64_t, std::list<Binary_Deferred>>> splits; ///< Deferred children of the splits made, by name
+
+      Binary_Reader reader(image->begin(), image->end());
+
+      Rete::Agenda::Locker locker(agent.get_agenda());
+
+      try {
+        if(header) {
+          if(std::memcmp(reader.read_bytes(sizeof(g_binary_magic)), g_binary_magic, sizeof(g_binary_magic)))
+            throw std::runtime_error("Not a compiled rules file.");
+          if(reader.read<uint32_t>() != g_binary_version)
+            throw std::runtime_error("Unsupported version.");
+          if(reader.read<uint32_t>() != g_binary_byte_order)
+            throw std::runtime_error("Written with a different byte order.");
+
+          agent.set_rule_name_index(reader.read<int64_t>());
+          agent.set_total_step_count(reader.read<int64_t>());
+        }
+
+        while(!reader.done()) {
+          const auto record = reader.read<Binary_Record>();
+          if(read_definition(record, reader, *image))
+            continue;
+
+          switch(record) {
+            case Binary_Record::FILTER:
+            case Binary_Record::JOIN:
+            case Binary_Record::EXISTENTIAL_JOIN:
+            case Binary_Record::NEGATION_JOIN:
+            case Binary_Record::EXISTENTIAL:
+            case Binary_Record::NEGATION:
+            case Binary_Record::PREDICATE_VC:
+            case Binary_Record::PREDICATE_VV:
+            {
+              const uint64_t index = image->node_records.size();
+              image->node_records.push_back(reader.position() - sizeof(Binary_Record));
+              const auto node = read_node(lazy ? nullptr : &agent, record, reader, image->symbols, [&nodes](const uint64_t &parent) {
+                return nodes.at(parent);
+              });
+              if(node)
+                nodes[index] = node;
+              break;
+            }
+
+            case Binary_Record::RULE:
+            {
+              const char * const position = reader.position();
+              const auto rule = read_rule(reader);
+
+              if(lazy && rule.has_data && rule.depth > 1) {
+                const auto parent = deferred.find(rule.parent_name);
+                const auto split = splits.find(rule.parent_name);
+                std::list<Binary_Deferred> * const siblings = parent != deferred.end() ? &parent->second->children : split != splits.end() ? &split->second.second : nullptr;
+                if(siblings) {
+                  siblings->push_back(Binary_Deferred{position, agent.next_creation_index(), std::list<Binary_Deferred>()});
+                  deferred[rule.name] = &siblings->back();
+                  break;
+                }
+              }
+
+              bool fatal = false;
+              if(const char * const error = make_rule(agent, rule, lazy ? build_node(agent, *image, nodes, rule.node) : nodes.at(rule.node), image->variable_names, fatal)) {
+                agent.get_context().get_out() << "rete-load error " << image->filename << ": " << error << std::endl;
+                if(fatal)
+                  return -1;
+              }
+              else if(lazy && rule.node_type == "split")
+                splits[rule.name].first = rule.node;
+              break;
+            }
+
+            case Binary_Record::RULE_NAME_INDEX:
+              agent.set_rule_name_index(reader.read<int64_t>());
+              break;
+
+            case Binary_Record::TOTAL_STEP_COUNT:
+              agent.set_total_step_count(reader.read<int64_t>());
+              break;
+
+            default:
+              throw std::runtime_error("Unknown record.");
+          }
+        }
+
+        for(auto &split : splits) {
+          if(!defer_children(agent, image, nodes, split.first, split.second.first, std::move(split.second.second)))
+            return -1;
+        }
+      }
+      catch(std::exception &ex) {
+        agent.get_context().get_out() << "rete-load error " << image->filename << ": " << ex.what() << std::endl;
+        return -1;
+      }
+
+      return 0;
+    }
+
+    void write_index(std::ostream &os, const WME_Token_Index &index) {
+      Zeni::serialize(os, index.rete_row);
+      Zeni::serialize(os, index.token_row);
+      Zeni::serialize(os, index.column);
+      Zeni::serialize(os, uint8_t(index.existential));
+    }
+
+    WME_Token_Index read_index(std::istream &is) {
+      int64_t rete_row;
+      int64_t token_row;
+      int8_t column;
+      uint8_t existential;
+      Zeni::deserialize(is, rete_row);
+      Zeni::deserialize(is, token_row);
+      Zeni::deserialize(is, column);
+      Zeni::deserialize(is, existential);
+      WME_Token_Index index(rete_row, token_row, column);
+      index.existential = existential != 0;
+      return index;
+    }
+
+    /// What Feature::compare_axis compares, with symbols defined ahead of the record
+    void write_axis(Binary_Writer &writer, std::ostream &os, const std::vector<WME> &conditions, const WME_Bindings &bindings) {
+      Zeni::serialize(os, uint64_t(conditions.size()));
+      for(const auto &condition : conditions) {
+        for(const auto &symbol : condition.symbols)
+          Zeni::serialize(os, writer.symbol(symbol));
+      }
+      Zeni::serialize(os, uint64_t(bindings.size()));
+      for(const auto &binding : bindings) {
+        write_index(os, binding.first);
+        write_index(os, binding.second);
+      }
+    }
+
+    void read_axis(std::istream &is, const std::vector<Symbol_Ptr_C> &symbols, std::vector<WME> &conditions, WME_Bindings &bindings) {
+      uint64_t count;
+      Zeni::deserialize(is, count);
+      conditions.clear();
+      while(count--) {
+        uint64_t indices[3];
+        for(auto &index : indices)
+          Zeni::deserialize(is, index);
+        conditions.push_back(WME(symbols.at(indices[0]), symbols.at(indices[1]), symbols.at(indices[2])));
+      }
+      Zeni::deserialize(is, count);
+      bindings.clear();
+      while(count--) {
+        const auto first = read_index(is);
+        const auto second = read_index(is);
+        bindings.insert(WME_Binding(first, second));
+      }
+    }
+
+    /// Everything about a Q-value that its RULE record rounds, fixes at creation, or leaves out
+    void write_q_value(Binary_Writer &writer, std::ostream &os, const tracked_ptr<Carli::Q_Value> &q_value) {
+      Zeni::serialize(os, uint8_t(bool(q_value)));
+      if(!q_value)
+        return;
+
+      Zeni::serialize(os, q_value->creation_index);
+      Zeni::serialize(os, q_value->primary);
+      Zeni::serialize(os, q_value->primary_mean2);
+      Zeni::serialize(os, q_value->primary_variance);
+      Zeni::serialize(os, q_value->secondary);
+      Zeni::serialize(os, q_value->update_count);
+      Zeni::serialize(os, q_value->creation_time);
+      Zeni::serialize(os, q_value->last_episode_fired);
+      Zeni::serialize(os, q_value->last_step_fired);
+      Zeni::serialize(os, q_value->pseudoepisode_count);
+      Zeni::serialize(os, q_value->depth);
+      Zeni::serialize(os, q_value->type_internal);
+      q_value->catde.save(os);
+      q_value->catde_post_split.save(os);
+#ifdef WHITESON_ADAPTIVE_TILE
+      Zeni::serialize(os, q_value->minbe);
+#endif
+
+      Zeni::serialize(os, uint8_t(bool(q_value->feature)));
+      if(q_value->feature) {
+        write_axis(writer, os, q_value->feature->conditions, q_value->feature->bindings);
+        write_index(os, q_value->feature->axis);
+      }
+    }
+
+    void read_q_value(std::istream &is, const std::vector<Symbol_Ptr_C> &symbols, const tracked_ptr<Carli::Q_Value> &q_value) {
+      uint8_t present;
+      Zeni::deserialize(is, present);
+      if(!present != !q_value)
+        throw std::runtime_error("Q-value missing from checkpointed rule.");
+      if(!q_value)
+        return;
+
+      Zeni::deserialize(is, q_value->creation_index);
+      Zeni::deserialize(is, q_value->primary);
+      Zeni::deserialize(is, q_value->primary_mean2);
+      Zeni::deserialize(is, q_value->primary_variance);
+      Zeni::deserialize(is, q_value->secondary);
+      Zeni::deserialize(is, q_value->update_count);
+      Zeni::deserialize(is, q_value->creation_time);
+      Zeni::deserialize(is, q_value->last_episode_fired);
+      Zeni::deserialize(is, q_value->last_step_fired);
+      Zeni::deserialize(is, q_value->pseudoepisode_count);
+      Zeni::deserialize(is, q_value->depth);
+      Zeni::deserialize(is, q_value->type_internal);
+      q_value->catde.load(is);
+      q_value->catde_post_split.load(is);
+#ifdef WHITESON_ADAPTIVE_TILE
+      Zeni::deserialize(is, q_value->minbe);
+#endif
+
+      Zeni::deserialize(is, present);
+      if(!present != !q_value->feature)
+        throw std::runtime_error("Feature missing from checkpointed rule.");
+      if(q_value->feature) {
+        read_axis(is, symbols, q_value->feature->conditions, q_value->feature->bindings);
+        q_value->feature->axis = read_index(is);
+      }
+    }
+
+    void write_fringe(Binary_Writer &writer, std::ostream &os, const Carli::Fringe_Values &fringe_values, const Carli::Fringe_Axis_Selections &selections, const int64_t &counter) {
+      Zeni::serialize(os, counter);
+
+      Zeni::serialize(os, uint64_t(selections.size()));
+      for(const auto &selection : selections) {
+        write_axis(writer, os, selection.first->conditions, selection.first->bindings);
+        Zeni::serialize(os, selection.second);
+      }
+
+      std::vector<std::vector<std::string>> axes;
+      for(const auto &fringe_axis : fringe_values) {
+        axes.emplace_back();
+        for(const auto &fringe : fringe_axis.second) {
+          if(const auto locked = fringe.lock())
+            axes.back().push_back(locked->rete_action.lock()->get_name());
+        }
+      }
+      Zeni::serialize(os, axes);
+    }
+
+    template <typename NODE>
+    std::shared_ptr<NODE> get_node(Carli::Agent &agent, const std::string &name) {
+      const auto action = agent.get_rule(name);
+      const auto node = action ? std::dynamic_pointer_cast<NODE>(action->data) : nullptr;
+      if(!node)
+        throw std::runtime_error("Checkpointed rule '" + name + "' missing.");
+      return node;
+    }
+
+    /// Replace the fringe of a node just made, ordered as it was, keyed by fringe nodes whose features are already restored
+    void read_fringe(std::istream &is, Carli::Agent &agent, const std::vector<Symbol_Ptr_C> &symbols, Carli::Fringe_Values &fringe_values, Carli::Fringe_Axis_Selections &selections, int64_t &counter) {
+      Zeni::deserialize(is, counter);
+
+      uint64_t count;
+      Zeni::deserialize(is, count);
+      while(count--) {
+        std::vector<WME> conditions;
+        WME_Bindings bindings;
+        read_axis(is, symbols, conditions, bindings);
+        int64_t selected;
+        Zeni::deserialize(is, selected);
+        selections[new Carli::Feature_Enumerated<Carli::Feature>(conditions, bindings, WME_Token_Index(), nullptr, -1, 0)] = selected;
+      }
+
+      std::vector<std::vector<std::string>> axes;
+      Zeni::deserialize(is, axes);
+      fringe_values.clear();
+      for(const auto &axis : axes) {
+        if(axis.empty())
+          continue;
+        std::list<Carli::Node_Fringe_Ptr_W> fringes;
+        for(const auto &name : axis)
+          fringes.push_back(get_node<Carli::Node_Fringe>(agent, name));
+        fringe_values[fringes.front().lock()->q_value_fringe->feature.get()] = std::move(fringes);
+      }
+    }
+
+    /// Everything a rule's node holds beyond its RULE record, naming its children and fringe nodes; empty for rules without nodes
+    std::string write_rule_state(Binary_Writer &writer, const Rete_Action &action) {
+      const auto node = dynamic_cast<const Carli::Node *>(action.data.get());
+      if(!node)
+        return std::string();
+
+      std::ostringstream os;
+      Zeni::serialize(os, node->creation_index);
+      write_q_value(writer, os, node->q_value_weight);
+      write_q_value(writer, os, node->q_value_fringe);
+
+      if(const auto split = dynamic_cast<const Carli::Node_Split *>(node)) {
+        Zeni::serialize(os, split->blacklist_full);
+        std::vector<std::string> children;
+        for(const auto &child : split->children) {
+          if(const auto locked = child.lock())
+            children.push_back(locked->rete_action.lock()->get_name());
+        }
+        Zeni::serialize(os, children);
+        write_fringe(writer, os, split->fringe_values, split->fringe_axis_selections, split->fringe_axis_counter);
+      }
+      else if(const auto unsplit = dynamic_cast<const Carli::Node_Unsplit *>(node))
+        write_fringe(writer, os, unsplit->fringe_values, unsplit->fringe_axis_selections, unsplit->fringe_axis_counter);
+
+      return os.str();
+    }
+
+    /// The children and fringe of a node, once every node has its Q-values and features
+    void read_rule_structure(std::istream &is, Carli::Agent &agent, const std::vector<Symbol_Ptr_C> &symbols, Carli::Node &node) {
+      if(const auto split = dynamic_cast<Carli::Node_Split *>(&node)) {
+        Zeni::deserialize(is, split->blacklist_full);
+        std::vector<std::string> children;
+        Zeni::deserialize(is, children);
+        split->children.clear();
+        for(const auto &name : children)
+          split->children.push_back(get_node<Carli::Node>(agent, name));
+        read_fringe(is, agent, symbols, split->fringe_values, split->fringe_axis_selections, split->fringe_axis_counter);
+      }
+      else if(const auto unsplit = dynamic_cast<Carli::Node_Unsplit *>(&node))
+        read_fringe(is, agent, symbols, unsplit->fringe_values, unsplit->fringe_axis_selections, unsplit->fringe_axis_counter);
+    }
+
+    /// The parent its RULE record names, which changes when fringe nodes move beneath a new split
+    std::string parent_name(const Rete_Action &action) {
+      const auto node = dynamic_cast<const Carli::Node *>(action.data.get());
+      const auto parent = node ? node->parent_action.lock() : nullptr;
+      return parent ? parent->get_name() : std::string();
+    }
+
+    /// Apply a segment of a checkpoint journal to the image of those before it
+    void apply_segment(Checkpoint_Image &image, const char * const &begin, const char * const &end) {
+      Binary_Reader reader(begin, end);
+      while(!reader.done()) {
+        const char * const position = reader.position();
+        const auto record = reader.read<Binary_Record>();
+        if(read_definition(record, reader, image))
+          continue;
+
+        switch(record) {
+          case Binary_Record::FILTER:
+          case Binary_Record::JOIN:
+          case Binary_Record::EXISTENTIAL_JOIN:
+          case Binary_Record::NEGATION_JOIN:
+          case Binary_Record::EXISTENTIAL:
+          case Binary_Record::NEGATION:
+          case Binary_Record::PREDICATE_VC:
+          case Binary_Record::PREDICATE_VV:
+            read_node(nullptr, record, reader, image.symbols, nullptr);
+            image.node_records.emplace_back(position, reader.position());
+            break;
+
+          case Binary_Record::RULE:
+          {
+            const char * const rule_begin = reader.position();
+            const auto rule = read_rule(reader);
+            image.rules[rule.name] = std::make_pair(std::string(rule_begin, reader.position()), std::string());
+            break;
+          }
+
+          case Binary_Record::RULE_STATE:
+          {
+            const auto found = image.rules.find(reader.read_string());
+            if(found == image.rules.end())
+              throw std::runtime_error("State for a rule never recorded.");
+            found->second.second = reader.read_string();
+            break;
+          }
+
+          case Binary_Record::EXCISE:
+            image.rules.erase(reader.read_string());
+            break;
+
+          case Binary_Record::STATE:
+            image.state = reader.read_string();
+            break;
+
+          case Binary_Record::OPTIONS:
+            image.options = reader.read_string();
+            break;
+
+          default:
+            throw std::runtime_error("Unknown record.");
+        }
+      }
+    }
+
+    /// The options of a run as Options::print writes them, but for those naming a journal to write or to resume from and how often to write it
+    std::string journaled_options(const Options &options) {
+      std::ostringstream printed;
+      options.print(printed);
+
+      std::istringstream is(printed.str());
+      std::ostringstream os;
+      for(std::string line; std::getline(is, line); ) {
+        if(line.compare(0, 15, "  checkpoint = ") && line.compare(0, 21, "  checkpoint-every = ") && line.compare(0, 11, "  resume = "))
+          os << line << std::endl;
+      }
+      return os.str();
+    }
+
+    /// The names of the options that differ between two journaled_options
+    std::string differing_options(const std::string &lhs, const std::string &rhs) {
+      std::set<std::string> lhs_lines;
+      std::set<std::string> rhs_lines;
+      std::string line;
+      for(std::istringstream is(lhs); std::getline(is, line); )
+        lhs_lines.insert(line);
+      for(std::istringstream is(rhs); std::getline(is, line); )
+        rhs_lines.insert(line);
+
+      std::vector<std::string> differing;
+      std::set_symmetric_difference(lhs_lines.begin(), lhs_lines.end(), rhs_lines.begin(), rhs_lines.end(), std::back_inserter(differing));
+
+      std::set<std::string> names;
+      for(const auto &differs : differing)
+        names.insert("--" + differs.substr(2, differs.find(" = ") - 2));
+
+      std::string joined;
+      for(const auto &name : names)
+        joined += (joined.empty() ? "" : " ") + name;
+      return joined;
+    }
+
+    /// Rebuild an agent just made and given its rules from the image, returning the state given with it
+    std::string restore(Carli::Agent &agent, const Checkpoint_Image &image) {
+      std::istringstream state(image.state);
+      uint64_t wme_count;
+      Zeni::deserialize(state, wme_count);
+      std::vector<WME_Ptr_C> wmes;
+      std::vector<WME_Ptr_C> wmes_supplied; ///< By the environment, which alone its next set_wmes may find stale
+      while(wme_count--) {
+        uint64_t indices[3];
+        for(auto &index : indices)
+          Zeni::deserialize(state, index);
+        wmes.push_back(WME::create(image.symbols.at(indices[0]), image.symbols.at(indices[1]), image.symbols.at(indices[2])));
+        bool supplied;
+        Zeni::deserialize(state, supplied);
+        if(supplied)
+          wmes_supplied.push_back(wmes.back());
+      }
+      std::vector<std::string> deferred_names;
+      Zeni::deserialize(state, deferred_names);
+      std::vector<int64_t> activating_order;
+      Zeni::deserialize(state, activating_order);
+      std::vector<int64_t> active_order;
+      Zeni::deserialize(state, active_order);
+      std::string agent_state;
+      std::string user_state;
+      Zeni::deserialize(state, agent_state);
+      Zeni::deserialize(state, user_state);
+
+      /// Parents are shallower than their children, and names fix the rest of the order however the journal was compacted
+      std::vector<Binary_Rule> rules;
+      rules.reserve(image.rules.size());
+      for(const auto &rule : image.rules) {
+        Binary_Reader reader(rule.second.first.data(), rule.second.first.data() + rule.second.first.size());
+        rules.push_back(read_rule(reader));
+      }
+      std::sort(rules.begin(), rules.end(), [](const Binary_Rule &lhs, const Binary_Rule &rhs) {
+        return lhs.depth < rhs.depth || (lhs.depth == rhs.depth && lhs.name < rhs.name);
+      });
+
+      {
+        Rete::Agenda::Locker locker(agent.get_agenda());
+
+        /// Splits still deferring their children keep them, as this agent loaded them from the same rules
+        std::map<std::string, std::function<void (Carli::Node_Split &)>> deferred;
+        for(const auto &action : agent.get_rules_by_rank()) {
+          if(const auto split = dynamic_cast<Carli::Node_Split *>(action->data.get())) {
+            if(split->deferred_children)
+              deferred[action->get_name()] = std::move(split->deferred_children);
+          }
+        }
+
+        agent.clear_wmes();
+        agent.excise_all();
+
+        std::unordered_map<uint64_t, Rete_Node_Ptr> nodes;
+        for(const auto &rule : rules) {
+          bool fatal = false;
+          if(const char * const error = make_rule(agent, rule, build_node(agent, image, nodes, rule.node), image.variable_names, fatal))
+            throw std::runtime_error(error);
+        }
+
+        std::list<std::pair<Carli::Node *, std::istringstream>> structures;
+        for(const auto &rule : image.rules) {
+          if(rule.second.second.empty())
+            continue;
+          const auto node = get_node<Carli::Node>(agent, rule.first);
+          structures.emplace_back(node.get(), std::istringstream(rule.second.second));
+          Zeni::deserialize(structures.back().second, node->creation_index);
+          read_q_value(structures.back().second, image.symbols, node->q_value_weight);
+          read_q_value(structures.back().second, image.symbols, node->q_value_fringe);
+        }
+        for(auto &structure : structures)
+          read_rule_structure(structure.second, agent, image.symbols, *structure.first);
+
+        for(const auto &name : deferred_names) {
+          const auto found = deferred.find(name);
+          if(found == deferred.end())
+            throw std::runtime_error("Children deferred beneath checkpointed rule '" + name + "' missing.");
+          get_node<Carli::Node_Split>(agent, name)->deferred_children = std::move(found->second);
+        }
+
+        agent.reset_wmes(wmes);
+        agent.set_wmes_supplied(wmes_supplied);
+      }
+
+      /// Every node matching again awaits a decision, but the run had already made those for all but the activating, and in its own order
+      std::unordered_map<int64_t, Carli::Node::List::list_pointer_type> matching;
+      for(auto node = agent.m_nodes_activating; node; node = node->next())
+        matching[node->get()->creation_index] = node;
+      for(auto node = agent.m_nodes_active; node; node = node->next())
+        matching[node->get()->creation_index] = node;
+      if(matching.size() != activating_order.size() + active_order.size())
+        throw std::runtime_error("Checkpointed activations do not match the restored rules.");
+      for(auto &node : matching)
+        node.second->erase_hard();
+      const auto relink = [&matching](Carli::Node::List::list_pointer_type &list, const std::vector<int64_t> &order) {
+        list = nullptr;
+        for(auto creation_index = order.rbegin(), cend = order.rend(); creation_index != cend; ++creation_index) {
+          const auto found = matching.find(*creation_index);
+          if(found == matching.end())
+            throw std::runtime_error("Checkpointed activations do not match the restored rules.");
+          found->second->insert_before(list);
+        }
+      };
+      relink(agent.m_nodes_activating, activating_order);
+      relink(agent.m_nodes_active, active_order);
+
+      std::istringstream agent_is(agent_state);
+      agent.load(agent_is);
+
+      return user_state;
+    }
+
+    /// Appends segments to a journal from a thread of its own, syncing each, or replaces the journal with a compacted one
+    class Checkpoint_Journal {
+      Checkpoint_Journal(const Checkpoint_Journal &) = delete;
+      Checkpoint_Journal & operator=(const Checkpoint_Journal &) = delete;
+
+    public:
+      Checkpoint_Journal(const std::string &filename, std::ostream &err)
+       : m_filename(filename),
+       m_err(err),
+       m_thread([this]() {run();})
+      {
+      }
+
+      ~Checkpoint_Journal() {
+        {
+          std::lock_guard<std::mutex> lock(m_mutex);
+          m_done = true;
+        }
+        m_ready.notify_one();
+        m_thread.join();
+        report();
+      }
+
+      bool broken() const {return m_broken;} ///< A write failed, so only a replacement can continue the journal
+
+      void append(std::string &&segment) {push(false, std::move(segment));}
+      void replace(std::string &&segment) {push(true, std::move(segment));} ///< Written beside the journal and renamed over it, so a crash leaves one or the other
+
+    private:
+      void push(const bool &replace, std::string &&segment) {
+        report();
+        {
+          std::lock_guard<std::mutex> lock(m_mutex);
+          m_queue.emplace_back(replace, std::move(segment));
+        }
+        m_ready.notify_one();
+      }
+
+      /// Errors from the writing thread wait for the agent's thread, so that the two never write to the stream at once
+      void report() {
+        std::vector<std::string> errors;
+        {
+          std::lock_guard<std::mutex> lock(m_mutex);
+          errors.swap(m_errors);
+        }
+        for(const auto &message : errors)
+          m_err << message << std::endl;
+      }
+
+      void error(const std::string &message) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_errors.push_back(message);
+      }
+
+      void run() {
+        for(;;) {
+          std::pair<bool, std::string> segment;
+          {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_ready.wait(lock, [this]() {return m_done || !m_queue.empty();});
+            if(m_queue.empty())
+              return;
+            segment = std::move(m_queue.front());
+            m_queue.pop_front();
+          }
+
+          if(segment.first || !m_broken)
+            m_broken = !write(segment.first, segment.second);
+        }
+      }
+
+      bool write(const bool &replace, const std::string &segment) {
+        const std::string filename = replace ? m_filename + ".tmp" : m_filename;
+        FILE * const file = std::fopen(filename.c_str(), replace ? "wb" : "ab");
+        if(!file) {
+          error("Failed to open file '" + filename + "' for checkpointing.");
+          return false;
+        }
+
+        const uint64_t size = segment.size();
+        const uint64_t sum = checksum(segment.data(), size);
+        bool written = true;
+        if(replace) {
+          written &= std::fwrite(g_checkpoint_magic, sizeof(g_checkpoint_magic), 1, file) == 1;
+          written &= std::fwrite(&g_checkpoint_version, sizeof(g_checkpoint_version), 1, file) == 1;
+          written &= std::fwrite(&g_binary_byte_order, sizeof(g_binary_byte_order), 1, file) == 1;
+        }
+        written &= std::fwrite(&size, sizeof(size), 1, file) == 1;
+        written &= std::fwrite(&sum, sizeof(sum), 1, file) == 1;
+        written &= !size || std::fwrite(segment.data(), size, 1, file) == 1;
+        written &= !std::fflush(file);
+#ifdef _WINDOWS
+        written &= !_commit(_fileno(file));
+#else
+        written &= !fsync(fileno(file));
+#endif
+        written &= !std::fclose(file);
+
+#ifdef _WINDOWS
+        if(written && replace)
+          written = MoveFileExA(filename.c_str(), m_filename.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+        if(written && replace)
+          written = !std::rename(filename.c_str(), m_filename.c_str());
+#endif
+
+        if(!written)
+          error("Failed to write checkpoint to '" + m_filename + "'.");
+        return written;
+      }
+
+      const std::string m_filename;
+      std::ostream &m_err;
+      std::mutex m_mutex;
+      std::condition_variable m_ready;
+      std::deque<std::pair<bool, std::string>> m_queue;
+      std::vector<std::string> m_errors; ///< From the writing thread, not yet reported
+      bool m_done = false;
+      std::atomic<bool> m_broken{false};
+      std::thread m_thread; ///< Last, to start once the rest is ready
+    };
+
+    /// A rule as the journal last recorded it
+    struct Checkpoint_Rule {
+      Weak_Ptr<const Rete_Action> action;
+      std::string parent;
+      std::string state;
+    };
+
+  }
+
+  bool rete_is_binary(const std::string &filename) {
+    char magic[sizeof(g_binary_magic)];
+    std::ifstream file(filename, std::ios::binary);
+    return file.read(magic, sizeof(magic)) && !std::memcmp(magic, g_binary_magic, sizeof(magic));
+  }
+
+  int rete_load_binary(Carli::Agent &agent, const std::string &filename) {
+    const auto image = std::make_shared<Binary_Image>(filename);
+    if(!image->begin()) {
+      agent.get_context().get_err() << "Failed to map file '" << filename << "' for loading." << std::endl;
+      return -1;
+    }
+
+    return load_image(agent, image, true, get_Option_Ranged<bool>(agent.get_context().get_options(), "rules-lazy"));
+  }
+
+  int rete_load_template(Carli::Agent &agent, const std::string &filename, const std::shared_ptr<const std::string> &records) {
+    /// Never lazily, so that every agent builds the text as the agent that parsed it did
+    return load_image(agent, std::make_shared<Binary_Image>(filename, records), false, false);
+  }
+
+  void rete_save_binary(const Carli::Agent &agent, std::ostream &os) {
+    Binary_Writer writer(os);
+
+    os.write(g_binary_magic, sizeof(g_binary_magic));
+    writer.write(g_binary_version);
+    writer.write(g_binary_byte_order);
+    writer.write(agent.get_rule_name_index());
+    writer.write(agent.get_total_step_count());
+
+    for(const auto &action : agent.get_rules_by_rank())
+      writer.rule(*action);
+  }
+
+  class Rete_Template_Writer::Impl {
+  public:
+    Impl()
+     : writer(os)
+    {
+    }
+
+    std::ostringstream os;
+    Binary_Writer writer;
+    bool valid = true;
+  };
+
+  Rete_Template_Writer::Rete_Template_Writer()
+   : m_impl(new Impl)
+  {
+  }
+
+  Rete_Template_Writer::~Rete_Template_Writer() {
+  }
+
+  bool Rete_Template_Writer::valid() const {
+    return m_impl->valid;
+  }
+
+  void Rete_Template_Writer::invalidate() {
+    m_impl->valid = false;
+  }
+
+  void Rete_Template_Writer::rule(const Rete_Action &action) {
+    m_impl->writer.rule(action);
+  }
+
+  void Rete_Template_Writer::rule_name_index(const int64_t &rule_name_index) {
+    m_impl->writer.write(Binary_Record::RULE_NAME_INDEX);
+    m_impl->writer.write(rule_name_index);
+  }
+
+  void Rete_Template_Writer::total_step_count(const int64_t &total_step_count) {
+    m_impl->writer.write(Binary_Record::TOTAL_STEP_COUNT);
+    m_impl->writer.write(total_step_count);
+  }
+
+  std::shared_ptr<const std::string> Rete_Template_Writer::records() const {
+    return m_impl->valid ? std::make_shared<const std::string>(m_impl->os.str()) : nullptr;
+  }
+
+  class Rete_Checkpointer::Impl {
+  public:
+    Impl(const std::string &filename, std::ostream &err)
+     : journal(filename, err)
+    {
+    }
+
+    Checkpoint_Journal journal;
+    Checkpoint_Image image;
+    std::unordered_map<uint64_t, Weak_Ptr<const Rete_Node>> nodes; ///< Those of the agent's nodes the image defines
+    std::map<std::string, Checkpoint_Rule> rules;
+    uint64_t journal_size = 0;
+    uint64_t compacted_size = 0;
+  };
+
+  Rete_Checkpointer::Rete_Checkpointer(const std::string &filename, std::ostream &err)
+   : m_impl(new Impl(filename, err))
+  {
+  }
+
+  Rete_Checkpointer::~Rete_Checkpointer() {
+  }
+
+  void Rete_Checkpointer::checkpoint(Carli::Agent &agent, const std::string &state) {
+    auto &impl = *m_impl;
+
+    /// Compact once the journal is twice the size compacting it last left it
+    const bool compact = !impl.journal_size || impl.journal.broken() || impl.journal_size > 2 * impl.compacted_size;
+    if(compact) {
+      impl.image = Checkpoint_Image();
+      impl.nodes.clear();
+      impl.rules.clear();
+    }
+
+    std::ostringstream segment;
+    {
+      Binary_Writer writer(segment, impl.image, impl.nodes);
+
+      if(compact) {
+        writer.write(Binary_Record::OPTIONS);
+        writer.write(journaled_options(agent.get_context().get_options()));
+      }
+
+      std::unordered_set<std::string> names;
+      std::vector<std::string> deferred_names;
+      for(const auto &action : agent.get_rules_by_rank()) {
+        const auto &name = action->get_name();
+        names.insert(name);
+
+        /// Left deferred, to be taken again from the rules file on resuming
+        const auto split = dynamic_cast<const Carli::Node_Split *>(action->data.get());
+        if(split && split->deferred_children)
+          deferred_names.push_back(name);
+
+        const auto parent = parent_name(*action);
+        const auto found = impl.rules.find(name);
+        const bool recorded = found != impl.rules.end() && found->second.action.lock() == action && found->second.parent == parent;
+        if(!recorded)
+          writer.rule(*action);
+
+        const auto rule_state = write_rule_state(writer, *action);
+        if(!rule_state.empty() && (!recorded || found->second.state != rule_state)) {
+          writer.write(Binary_Record::RULE_STATE);
+          writer.write(name);
+          writer.write(rule_state);
+        }
+      }
+
+      for(const auto &rule : impl.rules) {
+        if(names.find(rule.first) == names.end()) {
+          writer.write(Binary_Record::EXCISE);
+          writer.write(rule.first);
+        }
+      }
+
+      std::ostringstream os;
+      const auto wmes = agent.get_wmes();
+      Zeni::serialize(os, uint64_t(wmes.size()));
+      for(const auto &wme : wmes) {
+        for(const auto &symbol : wme->symbols)
+          Zeni::serialize(os, writer.symbol(symbol));
+        Zeni::serialize(os, agent.is_wme_supplied(wme));
+      }
+      Zeni::serialize(os, deferred_names);
+      /// Nodes activated since the last decisions still await theirs, and the next decisions follow the order of both lists
+      std::vector<int64_t> activating_order;
+      for(auto node = agent.m_nodes_activating; node; node = node->next())
+        activating_order.push_back(node->get()->creation_index);
+      std::vector<int64_t> active_order;
+      for(auto node = agent.m_nodes_active; node; node = node->next())
+        active_order.push_back(node->get()->creation_index);
+      Zeni::serialize(os, activating_order);
+      Zeni::serialize(os, active_order);
+      std::ostringstream agent_os;
+      agent.save(agent_os);
+      Zeni::serialize(os, agent_os.str());
+      Zeni::serialize(os, state);
+      writer.write(Binary_Record::STATE);
+      writer.write(os.str());
+
+      impl.nodes = writer.nodes();
+    }
+
+    auto bytes = segment.str();
+    const uint64_t framed_size = 2 * sizeof(uint64_t) + bytes.size();
+
+    try {
+      apply_segment(impl.image, bytes.data(), bytes.data() + bytes.size());
+    }
+    catch(std::exception &ex) {
+      throw std::runtime_error(std::string("rete-checkpoint error: ") + ex.what());
+    }
+
+    if(compact) {
+      impl.journal_size = impl.compacted_size = sizeof(g_checkpoint_magic) + sizeof(g_checkpoint_version) + sizeof(g_binary_byte_order) + framed_size;
+      impl.journal.replace(std::move(bytes));
+    }
+    else {
+      impl.journal_size += framed_size;
+      impl.journal.append(std::move(bytes));
+    }
+
+    impl.rules.clear();
+    for(const auto &rule : impl.image.rules) {
+      const auto action = agent.get_rule(rule.first);
+      impl.rules[rule.first] = Checkpoint_Rule{action, parent_name(*action), rule.second.second};
+    }
+  }
+
+  bool rete_resume(Carli::Agent &agent, const std::string &filename, std::string &state) {
+    const Binary_Mapping mapping(filename);
+    if(!mapping.data()) {
+      agent.get_context().get_err() << "Failed to map file '" << filename << "' for resuming." << std::endl;
+      return false;
+    }
+
+    try {
+      const char * const end = mapping.data() + mapping.size();
+      Binary_Reader reader(mapping.data(), end);
+      if(std::memcmp(reader.read_bytes(sizeof(g_checkpoint_magic)), g_checkpoint_magic, sizeof(g_checkpoint_magic)))
+        throw std::runtime_error("Not a checkpoint journal.");
+      if(reader.read<uint32_t>() != g_checkpoint_version)
+        throw std::runtime_error("Unsupported version.");
+      if(reader.read<uint32_t>() != g_binary_byte_order)
+        throw std::runtime_error("Written with a different byte order.");
+
+      /// A segment cut short or corrupted by a crash ends the journal, leaving the checkpoint before it
+      Checkpoint_Image image;
+      bool complete = false;
+      while(uint64_t(end - reader.position()) >= 2 * sizeof(uint64_t)) {
+        const auto size = reader.read<uint64_t>();
+        const auto sum = reader.read<uint64_t>();
+        if(uint64_t(end - reader.position()) < size)
+          break;
+        const char * const segment = reader.read_bytes(size);
+        if(checksum(segment, size) != sum)
+          break;
+        apply_segment(image, segment, segment + size);
+        complete = true;
+      }
+      if(!complete)
+        throw std::runtime_error("No complete checkpoint.");
+
+      const auto options = journaled_options(agent.get_context().get_options());
+      if(options != image.options)
+        throw std::runtime_error("Options differ from those of the run that wrote it: " + differing_options(options, image.options));
+
+      state = restore(agent, image);
+    }
+    catch(std::exception &ex) {
+      agent.get_context().get_out() << "rete-resume error " << filename << ": " << ex.what() << std::endl;
+      return false;
+    }
+
+    return true;
+  }
+
+}
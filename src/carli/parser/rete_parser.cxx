@@ -1,11 +1,307 @@
 #include "rete_parser.h"
 
+#include <mutex>
+
 namespace Rete {
 
+  namespace {
+
+    struct Rete_Templates {
+      std::mutex mutex;
+      bool enabled = false;
+      std::unordered_map<std::string, std::shared_ptr<const std::string>> records; ///< Null for files whose commands the records cannot replay
+    };
+
+    Rete_Templates & rete_templates() {
+      static Rete_Templates templates;
+      return templates;
+    }
+
+  }
+
   bool rete_get_exit() {
     return g_rete_exit;
   }
 
+  const char * rete_make_rule(Carli::Agent &agent, const Parser_Rule &rule, bool &fatal) {
+    const auto &parent =                            get<0>(rule).first;
+    const auto &variable_names =                    get<0>(rule).second;
+    const string &name =                            get<1>(rule);
+    const int64_t &timestamp =              *get<0>(get<2>(rule));
+    const int64_t &q_value_depth =   get<0>(*get<1>(get<2>(rule)));
+    const string &node_type =        get<1>(*get<1>(get<2>(rule)));
+    const string &parent_node_name = get<2>(*get<1>(get<2>(rule)));
+    const auto &feature =            get<3>(*get<1>(get<2>(rule)));
+    const auto &q_value_value =                     get<3>(rule);
+    const auto variable_indices = std::make_shared<Rete::Variable_Indices>(variable_names);
+    const auto parent_action = agent.get_rule(parent_node_name);
+
+    if(q_value_depth != 1 && !parent_action)
+      return "Parent action not found!";
+
+    if(q_value_depth != 1 && !feature) {
+      fatal = true;
+      return "Missing feature!";
+    }
+
+    const auto existing = agent.unname_rule(name, true);
+    if(existing) {
+      parent->suppress_destruction(true);
+      existing->destroy(agent);
+    }
+
+    Rete::Rete_Action_Ptr new_action;
+    if(node_type.empty()) {
+      /// Non-RL node
+      auto node = agent.make_action_retraction(name, true,
+                                               [&agent](const Rete::Rete_Action &action, const Rete::WME_Token &wme_vector) {
+                                                 agent.get_context().get_out() << wme_vector << "->" << action.get_name() << endl;
+                                               }, [&agent](const Rete::Rete_Action &action, const Rete::WME_Token &wme_vector) {
+                                                 agent.get_context().get_out() << wme_vector << "<-" << action.get_name() << endl;
+                                               }, parent, make_shared<Rete::Variable_Indices>());
+    }
+    else {
+      if(feature) {
+        auto test_node_rightmost = parent;
+        bool test_node_rightmost_existential = false;
+        while(test_node_rightmost->get_bindings()) {
+          test_node_rightmost_existential |= dynamic_cast<Rete::Rete_Existential_Join *>(test_node_rightmost.get()) || dynamic_cast<Rete::Rete_Negation_Join *>(test_node_rightmost.get());
+          test_node_rightmost = test_node_rightmost->parent_right();
+        }
+
+        /// Fill in Feature values / predicate tests
+        if(const auto feature_e = dynamic_cast<Carli::Feature_Enumerated<Carli::Feature> *>(feature)) {
+          /// TODO: Handle variable-to-variable relations
+          if(const auto predicate = dynamic_cast<Rete::Rete_Predicate *>(test_node_rightmost.get())) {
+            const auto rhs = predicate->get_rhs().get();
+            const auto symbol_i = dynamic_cast<const Rete::Symbol_Constant_Int *>(rhs);
+            assert(symbol_i);
+            feature_e->value = symbol_i->value;
+          }
+          else if(dynamic_cast<Rete::Rete_Existential_Join *>(parent.get()))
+            feature_e->value = true;
+          else if(dynamic_cast<Rete::Rete_Negation_Join *>(parent.get()))
+            feature_e->value = false;
+          else {
+            fatal = true;
+            return "Error reading enumerated feature value / predicate test.";
+          }
+        }
+        else if(const auto feature_r = dynamic_cast<Carli::Feature_Ranged<Carli::Feature> *>(feature)) {
+          const auto &predicate = dynamic_cast<Rete::Rete_Predicate &>(*test_node_rightmost);
+          switch(predicate.get_predicate()) {
+            case Rete::Rete_Predicate::GT:
+            case Rete::Rete_Predicate::GTE:
+            case Rete::Rete_Predicate::LT:
+            case Rete::Rete_Predicate::LTE:
+              feature_r->predicate = predicate.get_predicate();
+              break;
+
+            default:
+              fatal = true;
+              return "Invalid ranged feature predicate selection.";
+          }
+        }
+        else if(const auto feature_n = dynamic_cast<Carli::Feature_NullHOG<Carli::Feature> *>(feature)) {
+          /// TODO: Handle variable-to-variable relations
+          if(Rete::Rete_Node * node_ptr = dynamic_cast<Rete::Rete_Negation_Join *>(parent.get())) {
+            auto next_ptr = node_ptr->parent_right().get();
+            while(dynamic_cast<Rete::Rete_Predicate *>(next_ptr))
+              next_ptr = next_ptr->parent_left().get();
+            if(Rete::Rete_Join * const join_ptr = dynamic_cast<Rete::Rete_Join *>(next_ptr)) {
+              if(dynamic_cast<Rete::Rete_Filter *>(join_ptr->parent_right().get())) {
+                auto vt = variable_names.begin(); //, vend = variable.names.end();
+                auto pt = parent_action->get_variables()->begin(), pend = parent_action->get_variables()->end();
+                while(pt != pend && *vt == *pt)
+                  ++pt, ++vt;
+                feature_n->value = vt->first;
+              }
+              else {
+                fatal = true;
+                return "Error reading null HOG test (type 3).";
+              }
+            }
+            else if(dynamic_cast<Rete::Rete_Filter *>(next_ptr)) {
+              auto vt = variable_names.begin(); //, vend = variable.names.end();
+              auto pt = parent_action->get_variables()->begin(), pend = parent_action->get_variables()->end();
+              while(pt != pend && *vt == *pt)
+                ++pt, ++vt;
+              feature_n->value = vt->first;
+            }
+            else {
+              fatal = true;
+              return "Error reading null HOG test (type 2).";
+            }
+          }
+          else {
+            fatal = true;
+            return "Error reading null HOG test (type 1).";
+          }
+        }
+        else {
+          fatal = true;
+          return "Error reading enumerated/ranged feature value / predicate test.";
+        }
+
+        /// Determine Feature axes
+        if(const auto predicate = dynamic_cast<const Rete::Rete_Predicate *>(test_node_rightmost.get())) {
+          feature->axis = predicate->get_lhs_index();
+          feature->axis.existential = test_node_rightmost_existential;
+        }
+        else if(dynamic_cast<Rete::Rete_Existential_Join *>(parent.get()) ||
+                dynamic_cast<Rete::Rete_Negation_Join *>(parent.get()))
+        {
+          feature->axis = Rete::WME_Token_Index(-1, -1, -1);
+        }
+        else {
+          Rete::Rete_Node_Ptr test_node = parent;
+          const Rete::Rete_Filter * filter_node = dynamic_cast<const Rete::Rete_Filter *>(test_node->parent_right().get());
+          while(!filter_node) {
+            test_node = test_node->parent_right();
+            filter_node = dynamic_cast<const Rete::Rete_Filter *>(test_node->parent_right().get());
+          }
+
+          if(const auto bindings = test_node->get_bindings()) {
+            for(const auto binding : *bindings) {
+              if(binding.second == Rete::WME_Token_Index(0, 0, 0)) {
+                feature->axis = binding.first;
+                goto AXIS_FOUND;
+              }
+            }
+          }
+          fatal = true;
+          return "Error determining Feature axis.";
+          AXIS_FOUND:
+            ;
+        }
+
+        if(feature->get_depth() > 1) {
+          const auto predicate = dynamic_cast<const Rete::Rete_Predicate *>(parent.get());
+          assert(predicate);
+          if(predicate) {
+            auto ancestor = parent_action;
+            auto ancestor_prev = ancestor;
+            assert(ancestor && dynamic_cast<const Carli::Node *>(ancestor->data.get())->q_value_fringe->feature);
+            while(ancestor && dynamic_cast<const Carli::Node *>(ancestor->data.get())->q_value_fringe->feature &&
+                  ancestor->get_token_size() > predicate->get_lhs_index().token_row)
+            {
+              ancestor_prev = ancestor;
+              ancestor = dynamic_cast<const Carli::Node *>(ancestor->data.get())->parent_action.lock();
+            }
+
+            assert(ancestor);
+            if(ancestor) {
+              const auto ancestor_node = dynamic_cast<const Carli::Node *>(ancestor_prev->data.get());
+              assert(ancestor_node);
+              assert(ancestor_node->q_value_fringe);
+              assert(ancestor_node->q_value_fringe->feature);
+              feature->bindings = ancestor_node->q_value_fringe->feature->bindings;
+              feature->conditions = ancestor_node->q_value_fringe->feature->conditions;
+            }
+            else
+              feature->bindings.insert(std::make_pair(predicate->get_lhs_index(), Rete::WME_Token_Index(-1, -1, -1)));
+          }
+        }
+        else {
+          if(parent->get_bindings()) {
+            feature->bindings = *parent->get_bindings();
+            feature->conditions = parent->parent_right()->get_filter_wmes();
+          }
+          if(auto predicate = dynamic_cast<const Rete::Rete_Predicate *>(parent.get()))
+            feature->bindings.insert(std::make_pair(predicate->get_lhs_index(), Rete::WME_Token_Index(-1, -1, -1)));
+        }
+
+        if(feature->axis.rete_row != -1 && parent->get_bindings()) {
+          if(feature->axis.existential && dynamic_cast<const Carli::Feature_Ranged_Data *>(feature)) {
+            fatal = true;
+            return "Refineable feature illegally declared existential.";
+          }
+          feature->axis.rete_row += parent->parent_left()->get_size();
+          feature->axis.token_row += parent->parent_left()->get_token_size();
+        }
+        feature->indices = variable_indices;
+
+        //std::cerr << "LHS" << feature->axis << ' ' << *variable_indices << std::endl;
+      }
+
+      /// Make the new action
+      if(node_type != "fringe") {
+        Carli::Node_Ptr new_action_data;
+        if(node_type == "split") {
+          const auto new_q_value_weight = new Carli::Q_Value(q_value_value, Carli::Q_Value::Type::SPLIT, q_value_depth, feature ? feature->clone() : nullptr, timestamp);
+          const auto new_q_value_fringe = new Carli::Q_Value(Carli::Q_Value::Token() /** HACK: Not stored in written rules. */, Carli::Q_Value::Type::FRINGE, q_value_depth, feature, timestamp);
+          new_action = agent.make_standard_action(parent, name, true, variable_indices);
+          new_action_data = std::allocate_shared<Carli::Node_Split>(Zeni::Pool_Allocator<Carli::Node_Split>(), agent, parent_action, new_action, new_q_value_weight, new_q_value_fringe);
+          new_action->data = new_action_data;
+        }
+        else {
+          assert(node_type == "unsplit");
+          const auto new_q_value_weight = new Carli::Q_Value(q_value_value, Carli::Q_Value::Type::UNSPLIT, q_value_depth, feature ? feature->clone() : nullptr, timestamp);
+          const auto new_q_value_fringe = new Carli::Q_Value(Carli::Q_Value::Token() /** HACK: Not stored in written rules. */, Carli::Q_Value::Type::FRINGE, q_value_depth, feature, timestamp);
+          new_action = agent.make_standard_action(parent, name, true, variable_indices);
+          new_action_data = std::allocate_shared<Carli::Node_Unsplit>(Zeni::Pool_Allocator<Carli::Node_Unsplit>(), agent, parent_action, new_action, new_q_value_weight, new_q_value_fringe);
+          new_action->data = new_action_data;
+        }
+        if(parent_action) {
+          auto &parent_data = dynamic_cast<Carli::Node_Split &>(*parent_action->data);
+//#ifndef NDEBUG
+//                            std::cerr << "Adding child node link from " << parent_action->get_name() << " to " << new_action_data << std::endl;
+//#endif
+          parent_data.children.push_back(new_action_data);
+        }
+        else if(new_action_data->q_value_fringe->depth != 1) {
+          fatal = true;
+          return "Ancestral relationship specified in :feature not found.";
+        }
+#ifndef NDEBUG
+        Carli::Node_Tracker::get().create(*new_action);
+#endif
+      }
+      else {
+        const auto new_q_value_fringe = new Carli::Q_Value(q_value_value, Carli::Q_Value::Type::FRINGE, q_value_depth, feature, timestamp);
+        new_action = agent.make_standard_action(parent, name, true, variable_indices);
+        auto new_action_data = std::allocate_shared<Carli::Node_Fringe>(Zeni::Pool_Allocator<Carli::Node_Fringe>(), agent, parent_action, new_action, nullptr, new_q_value_fringe);
+        new_action->data = new_action_data;
+        if(parent_action) {
+          if(const auto &parent_data = dynamic_cast<Carli::Node_Split *>(parent_action->data.get()))
+            parent_data->fringe_values[feature].push_back(new_action_data);
+          else if(const auto &parent_data = dynamic_cast<Carli::Node_Unsplit *>(parent_action->data.get()))
+            parent_data->fringe_values[feature].push_back(new_action_data);
+          else {
+            fatal = true;
+            return "Parent data for fringe node inaccessible.";
+          }
+        }
+        else {
+          fatal = true;
+          return "Ancestral relationship specified in :feature fringe not found.";
+        }
+      }
+
+      if(!get_Option_Ranged<bool>(agent.get_context().get_options(), "rete-disable-node-sharing") && parent_action) {
+        bool ancestor_found = false;
+        auto ancestor = parent;
+        while(ancestor && !ancestor_found) {
+          if(ancestor == parent_action->parent_left())
+            ancestor_found = true;
+          else if(!dynamic_cast<Rete::Rete_Filter *>(ancestor.get()))
+            ancestor = ancestor->parent_left();
+          else
+            break;
+        }
+        if(!ancestor_found) {
+          fatal = true;
+          return "Illegal ancestral relationship specified in :feature.";
+        }
+      }
+    }
+
+
+    parent->suppress_destruction(false);
+
+    return nullptr;
+  }
+
   int rete_parse_file(Carli::Agent &agent, const string &filename, const std::string &source_path) {
     if(filename.empty())
       return -1;
@@ -24,6 +320,23 @@ namespace Rete {
 
     //cerr << "Sourcing '" << filename_part << "' from '" << source_path_full << '\'' << endl;
 
+    if(rete_is_binary(filename_full))
+      return rete_load_binary(agent, filename_full);
+
+    /// The first agent to parse a file with templates kept compiles it, and the rest replay its records
+    bool compile = false;
+    {
+      auto &templates = rete_templates();
+      std::lock_guard<std::mutex> lock(templates.mutex);
+      if(templates.enabled) {
+        const auto found = templates.records.find(filename_full);
+        if(found == templates.records.end())
+          compile = true;
+        else if(found->second)
+          return rete_load_template(agent, filename_full, found->second);
+      }
+    }
+
     FILE * file = fopen(filename_full.c_str(), "r");
     if(!file) {
       std::cerr << "Failed to open file '" << filename_full << "' for parsing." << std::endl;
@@ -43,6 +356,10 @@ namespace Rete {
 
     Rete::Agenda::Locker locker(agent.get_agenda());
 
+    Rete_Template_Writer writer;
+    Rete_Template_Writer * const outer_template = g_rete_template;
+    g_rete_template = compile ? &writer : nullptr;
+
     // retelex();
     do {
       rv = reteparse(yyscanner, agent, filename_full, source_path_full);
@@ -50,9 +367,17 @@ namespace Rete {
         break;
     } while (!feof(reteget_in(yyscanner)));
 
+    g_rete_template = outer_template;
+
     retelex_destroy(yyscanner);
     fclose(file);
 
+    if(compile && !rv) {
+      auto &templates = rete_templates();
+      std::lock_guard<std::mutex> lock(templates.mutex);
+      templates.records.emplace(filename_full, writer.records());
+    }
+
     return rv;
   }
 
@@ -83,4 +408,12 @@ namespace Rete {
     g_rete_exit = true;
   }
 
+  void rete_set_templates(const bool &templates) {
+    auto &kept = rete_templates();
+    std::lock_guard<std::mutex> lock(kept.mutex);
+    kept.enabled = templates;
+    if(!templates)
+      kept.records.clear();
+  }
+
 }
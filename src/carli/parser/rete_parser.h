@@ -5,14 +5,63 @@
 
 namespace Rete {
 
+  typedef std::tuple<std::shared_ptr<int64_t>, std::shared_ptr<std::tuple<int64_t, std::string, std::string, Carli::Feature *>>> Parser_Flag;
+  typedef std::pair<Rete_Node_Ptr, Variable_Indices> Parser_Rete_Node;
+  typedef std::tuple<Parser_Rete_Node, std::string, Parser_Flag, Carli::Q_Value::Token> Parser_Rule;
+
+  /// Journals an agent between episodes, writing in the background what changed since the last checkpoint
+  class PARSER_LINKAGE Rete_Checkpointer {
+    Rete_Checkpointer(const Rete_Checkpointer &) = delete;
+    Rete_Checkpointer & operator=(const Rete_Checkpointer &) = delete;
+
+  public:
+    Rete_Checkpointer(const std::string &filename, std::ostream &err); ///< Failures to write are reported to err, from the agent's thread
+    ~Rete_Checkpointer(); ///< Finishes writing queued checkpoints
+
+    /// Record rules, their values, working memory, the agent, and the caller's state, leaving the agent as it was; throws std::runtime_error if the record cannot be read back
+    /// Serializing and reading back happen on the calling thread, taking time in proportion to the rules whose values changed
+    void checkpoint(Carli::Agent &agent, const std::string &state);
+
+  private:
+    class Impl;
+    std::unique_ptr<Impl> m_impl;
+  };
+
+  /// Records the rules a text parse makes, and the counters it sets, as binary records that other agents load in place of parsing the text
+  class PARSER_LINKAGE Rete_Template_Writer {
+    Rete_Template_Writer(const Rete_Template_Writer &) = delete;
+    Rete_Template_Writer & operator=(const Rete_Template_Writer &) = delete;
+
+  public:
+    Rete_Template_Writer();
+    ~Rete_Template_Writer();
+
+    bool valid() const;
+    void invalidate(); ///< The parse did something the records cannot replay, so the file must be parsed every time
+
+    void rule(const Rete_Action &action);
+    void rule_name_index(const int64_t &rule_name_index);
+    void total_step_count(const int64_t &total_step_count);
+
+    std::shared_ptr<const std::string> records() const;
+
+  private:
+    class Impl;
+    std::unique_ptr<Impl> m_impl;
+  };
+
   PARSER_LINKAGE bool rete_get_exit();
+  PARSER_LINKAGE bool rete_is_binary(const std::string &filename); ///< Was the file written by rete_save_binary?
+  PARSER_LINKAGE int rete_load_binary(Carli::Agent &agent, const std::string &filename); ///< Map the file and replay its records, as rete_parse_file would the text it was saved alongside; with rules-lazy, rules beneath splits wait for those splits to first match
+  PARSER_LINKAGE int rete_load_template(Carli::Agent &agent, const std::string &filename, const std::shared_ptr<const std::string> &records); ///< Replay the records a Rete_Template_Writer made of the file, as rete_load_binary would without rules-lazy
+  /// Source a rule from its conditions and flags, as sp does; returns an error message, fatal unless only this rule was skipped
+  PARSER_LINKAGE const char * rete_make_rule(Carli::Agent &agent, const Parser_Rule &rule, bool &fatal);
   PARSER_LINKAGE int rete_parse_file(Carli::Agent &agent, const std::string &filename, const std::string &source_path = "");
   PARSER_LINKAGE int rete_parse_string(Carli::Agent &agent, const std::string &str, int &line_number);
+  PARSER_LINKAGE bool rete_resume(Carli::Agent &agent, const std::string &filename, std::string &state); ///< Restore the last complete checkpoint in a journal to an agent made with the same options, passing back the caller's state recorded with it
+  PARSER_LINKAGE void rete_save_binary(const Carli::Agent &agent, std::ostream &os); ///< Write the shared network, symbols, feature flags, and exact Q-values of every rule
   PARSER_LINKAGE void rete_set_exit();
-
-  typedef std::tuple<std::shared_ptr<int64_t>, std::shared_ptr<std::tuple<int64_t, std::string, std::string, Carli::Feature *>>> Parser_Flag;
-  typedef std::pair<Rete_Node_Ptr, Variable_Indices> Parser_Rete_Node;
-  typedef std::tuple<Parser_Rete_Node, std::string, Parser_Flag, Carli::Q_Value::Token> Parser_Rule;
+  PARSER_LINKAGE void rete_set_templates(const bool &templates); ///< Compile each text file parsed from then on into records the first time, so that agents sharing a process parse it only once
 
   inline int rete_parse_string(Carli::Agent &agent, const std::string &str) {
     int line_number = 1;
@@ -259,13 +259,20 @@ int reteparse (yyscan_t yyscanner, Carli::Agent &agent, const std::string &filen
 
 #include "lex.rete.hh"
 
-static volatile sig_atomic_t g_rete_exit = false;
+static thread_local volatile sig_atomic_t g_rete_exit = false; ///< Per thread, so that an exit command leaves agents parsing on other threads alone
+static thread_local Rete::Rete_Template_Writer * g_rete_template = nullptr; ///< Records the file being parsed, if it is to become a template
 
-static void reteerror(const YYLTYPE * const /*yylloc*/, yyscan_t const yyscanner, Rete::Rete_Agent &/*agent*/, const std::string &filename, const std::string &/*source_path*/, const char *msg) {
+/// The command just parsed is one the template cannot replay
+static void rete_uncompiled() {
+  if(g_rete_template)
+    g_rete_template->invalidate();
+}
+
+static void reteerror(const YYLTYPE * const /*yylloc*/, yyscan_t const yyscanner, Rete::Rete_Agent &agent, const std::string &filename, const std::string &/*source_path*/, const char *msg) {
   if(filename.empty())
-    cout << "rete-parse error: " << msg << endl;
+    agent.get_context().get_out() << "rete-parse error: " << msg << endl;
   else
-    cout << "rete-parse error " << filename << '(' << reteget_lineno(yyscanner) << "): " << msg << endl;
+    agent.get_context().get_out() << "rete-parse error " << filename << '(' << reteget_lineno(yyscanner) << "): " << msg << endl;
 }
 
 #line 267 "rules.tab.cpp" /* yacc.c:359  */
@@ -1537,27 +1544,31 @@ yyreduce:
 
   case 4:
 #line 145 "rules.yyy" /* yacc.c:1646  */
-    { agent.excise_rule(*(yyvsp[0].sval), true);
+    { rete_uncompiled();
+                          agent.excise_rule(*(yyvsp[0].sval), true);
                           delete (yyvsp[0].sval); }
 #line 1538 "rules.tab.cpp" /* yacc.c:1646  */
     break;
 
   case 5:
 #line 147 "rules.yyy" /* yacc.c:1646  */
-    { agent.excise_all(); }
+    { rete_uncompiled();
+                         agent.excise_all(); }
 #line 1544 "rules.tab.cpp" /* yacc.c:1646  */
     break;
 
   case 6:
 #line 148 "rules.yyy" /* yacc.c:1646  */
-    { g_rete_exit = true;
+    { rete_uncompiled();
+                   g_rete_exit = true;
                    YYACCEPT; }
 #line 1551 "rules.tab.cpp" /* yacc.c:1646  */
     break;
 
   case 7:
 #line 150 "rules.yyy" /* yacc.c:1646  */
-    { const auto wme = make_shared<Rete::WME>(*(yyvsp[-4].symbol_ptr), *(yyvsp[-2].symbol_ptr), *(yyvsp[-1].symbol_ptr));
+    { const auto wme = Rete::WME::create(*(yyvsp[-4].symbol_ptr), *(yyvsp[-2].symbol_ptr), *(yyvsp[-1].symbol_ptr));
+                                                          rete_uncompiled();
                                                           agent.insert_wme(wme);
                                                           delete (yyvsp[-4].symbol_ptr);
                                                           delete (yyvsp[-2].symbol_ptr);
@@ -1567,7 +1578,8 @@ yyreduce:
 
   case 8:
 #line 155 "rules.yyy" /* yacc.c:1646  */
-    { const auto wme = make_shared<Rete::WME>(*(yyvsp[-4].symbol_ptr), *(yyvsp[-2].symbol_ptr), *(yyvsp[-1].symbol_ptr));
+    { const auto wme = Rete::WME::create(*(yyvsp[-4].symbol_ptr), *(yyvsp[-2].symbol_ptr), *(yyvsp[-1].symbol_ptr));
+                                                          rete_uncompiled();
                                                           agent.remove_wme(wme);
                                                           delete (yyvsp[-4].symbol_ptr);
                                                           delete (yyvsp[-2].symbol_ptr);
@@ -1577,19 +1589,24 @@ yyreduce:
 
   case 9:
 #line 160 "rules.yyy" /* yacc.c:1646  */
-    { agent.set_rule_name_index((yyvsp[0].ival)); }
+    { if(g_rete_template)
+                                      g_rete_template->rule_name_index((yyvsp[0].ival));
+                                    agent.set_rule_name_index((yyvsp[0].ival)); }
 #line 1577 "rules.tab.cpp" /* yacc.c:1646  */
     break;
 
   case 10:
 #line 161 "rules.yyy" /* yacc.c:1646  */
-    { agent.set_total_step_count((yyvsp[0].ival)); }
+    { if(g_rete_template)
+                                       g_rete_template->total_step_count((yyvsp[0].ival));
+                                     agent.set_total_step_count((yyvsp[0].ival)); }
 #line 1583 "rules.tab.cpp" /* yacc.c:1646  */
     break;
 
   case 11:
 #line 162 "rules.yyy" /* yacc.c:1646  */
-    { const int rv = rete_parse_file(agent, *(yyvsp[0].sval), source_path);
+    { rete_uncompiled();
+                                       const int rv = rete_parse_file(agent, *(yyvsp[0].sval), source_path);
                                        if(rv) {
                                          ostringstream oss;
                                          oss << "Error sourcing '" << *(yyvsp[0].sval) << "'.";
@@ -1606,289 +1623,23 @@ yyreduce:
 
   case 12:
 #line 174 "rules.yyy" /* yacc.c:1646  */
-    { const auto &parent =                            get<0>(*(yyvsp[0].rule_ptr)).first;
-                      const auto &variable_names =                    get<0>(*(yyvsp[0].rule_ptr)).second;
-                      const string &name =                            get<1>(*(yyvsp[0].rule_ptr));
-                      const int64_t &timestamp =              *get<0>(get<2>(*(yyvsp[0].rule_ptr)));
-                      const int64_t &q_value_depth =   get<0>(*get<1>(get<2>(*(yyvsp[0].rule_ptr))));
-                      const string &node_type =        get<1>(*get<1>(get<2>(*(yyvsp[0].rule_ptr))));
-                      const string &parent_node_name = get<2>(*get<1>(get<2>(*(yyvsp[0].rule_ptr))));
-                      const auto &feature =            get<3>(*get<1>(get<2>(*(yyvsp[0].rule_ptr))));
-                      const auto &q_value_value =                     get<3>(*(yyvsp[0].rule_ptr));
-                      const auto variable_indices = std::make_shared<Rete::Variable_Indices>(variable_names);
-                      const auto parent_action = agent.get_rule(parent_node_name);
-
-                      if(q_value_depth != 1 && !parent_action) {
-                        reteerror(&yylloc, yyscanner, agent, filename, source_path, "Parent action not found!");
-                        delete (yyvsp[0].rule_ptr);
-                        break;
-                      }
-
-                      if(q_value_depth != 1 && !feature) {
-                        reteerror(&yylloc, yyscanner, agent, filename, source_path, "Missing feature!");
-                        delete (yyvsp[0].rule_ptr);
-                        YYABORT;
-                      }
-
-                      const auto existing = agent.unname_rule(name, true);
-                      if(existing) {
-                        parent->suppress_destruction(true);
-                        existing->destroy(agent);
-                      }
-
-                      Rete::Rete_Action_Ptr new_action;
-                      if(node_type.empty()) {
-                        /// Non-RL node
-                        auto node = agent.make_action_retraction(name, true,
-                                                                 [](const Rete::Rete_Action &action, const Rete::WME_Token &wme_vector) {
-                                                                   cout << wme_vector << "->" << action.get_name() << endl;
-                                                                 }, [](const Rete::Rete_Action &action, const Rete::WME_Token &wme_vector) {
-                                                                   cout << wme_vector << "<-" << action.get_name() << endl;
-                                                                 }, parent, make_shared<Rete::Variable_Indices>());
-                      }
-                      else {
-                        if(feature) {
-                          auto test_node_rightmost = parent;
-                          bool test_node_rightmost_existential = false;
-                          while(test_node_rightmost->get_bindings()) {
-                            test_node_rightmost_existential |= dynamic_cast<Rete::Rete_Existential_Join *>(test_node_rightmost.get()) || dynamic_cast<Rete::Rete_Negation_Join *>(test_node_rightmost.get());
-                            test_node_rightmost = test_node_rightmost->parent_right();
-                          }
-
-                          /// Fill in Feature values / predicate tests
-                          if(const auto feature_e = dynamic_cast<Carli::Feature_Enumerated<Carli::Feature> *>(feature)) {
-                            /// TODO: Handle variable-to-variable relations
-                            if(const auto predicate = dynamic_cast<Rete::Rete_Predicate *>(test_node_rightmost.get())) {
-                              const auto rhs = predicate->get_rhs().get();
-                              const auto symbol_i = dynamic_cast<const Rete::Symbol_Constant_Int *>(rhs);
-                              assert(symbol_i);
-                              feature_e->value = symbol_i->value;
-                            }
-                            else if(dynamic_cast<Rete::Rete_Existential_Join *>(parent.get()))
-                              feature_e->value = true;
-                            else if(dynamic_cast<Rete::Rete_Negation_Join *>(parent.get()))
-                              feature_e->value = false;
-                            else {
-                              reteerror(&yylloc, yyscanner, agent, filename, source_path, "Error reading enumerated feature value / predicate test.");
-                              YYABORT;
-                            }
-                          }
-                          else if(const auto feature_r = dynamic_cast<Carli::Feature_Ranged<Carli::Feature> *>(feature)) {
-                            const auto &predicate = dynamic_cast<Rete::Rete_Predicate &>(*test_node_rightmost);
-                            switch(predicate.get_predicate()) {
-                              case Rete::Rete_Predicate::GT:
-                              case Rete::Rete_Predicate::GTE:
-                              case Rete::Rete_Predicate::LT:
-                              case Rete::Rete_Predicate::LTE:
-                                feature_r->predicate = predicate.get_predicate();
-                                break;
-
-                              default:
-                                reteerror(&yylloc, yyscanner, agent, filename, source_path, "Invalid ranged feature predicate selection.");
-                                YYABORT;
-                            }
-                          }
-                          else if(const auto feature_n = dynamic_cast<Carli::Feature_NullHOG<Carli::Feature> *>(feature)) {
-                            /// TODO: Handle variable-to-variable relations
-                            if(Rete::Rete_Node * node_ptr = dynamic_cast<Rete::Rete_Negation_Join *>(parent.get())) {
-                              auto next_ptr = node_ptr->parent_right().get();
-                              while(dynamic_cast<Rete::Rete_Predicate *>(next_ptr))
-                                next_ptr = next_ptr->parent_left().get();
-                              if(Rete::Rete_Join * const join_ptr = dynamic_cast<Rete::Rete_Join *>(next_ptr)) {
-                                if(dynamic_cast<Rete::Rete_Filter *>(join_ptr->parent_right().get())) {
-                                  auto vt = variable_names.begin(); //, vend = variable.names.end();
-                                  auto pt = parent_action->get_variables()->begin(), pend = parent_action->get_variables()->end();
-                                  while(pt != pend && *vt == *pt)
-                                    ++pt, ++vt;
-                                  feature_n->value = vt->first;
-                                }
-                                else {
-                                  reteerror(&yylloc, yyscanner, agent, filename, source_path, "Error reading null HOG test (type 3).");
-                                  YYABORT;
-                                }
-                              }
-                              else if(dynamic_cast<Rete::Rete_Filter *>(next_ptr)) {
-                                auto vt = variable_names.begin(); //, vend = variable.names.end();
-                                auto pt = parent_action->get_variables()->begin(), pend = parent_action->get_variables()->end();
-                                while(pt != pend && *vt == *pt)
-                                  ++pt, ++vt;
-                                feature_n->value = vt->first;
-                              }
-                              else {
-                                reteerror(&yylloc, yyscanner, agent, filename, source_path, "Error reading null HOG test (type 2).");
-                                YYABORT;
-                              }
-                            }
-                            else {
-                              reteerror(&yylloc, yyscanner, agent, filename, source_path, "Error reading null HOG test (type 1).");
-                              YYABORT;
-                            }
-                          }
-                          else {
-                            reteerror(&yylloc, yyscanner, agent, filename, source_path, "Error reading enumerated/ranged feature value / predicate test.");
-                            YYABORT;
-                          }
-
-                          /// Determine Feature axes
-                          if(const auto predicate = dynamic_cast<const Rete::Rete_Predicate *>(test_node_rightmost.get())) {
-                            feature->axis = predicate->get_lhs_index();
-                            feature->axis.existential = test_node_rightmost_existential;
-                          }
-                          else if(dynamic_cast<Rete::Rete_Existential_Join *>(parent.get()) ||
-                                  dynamic_cast<Rete::Rete_Negation_Join *>(parent.get()))
-                          {
-                            feature->axis = Rete::WME_Token_Index(-1, -1, -1);
-                          }
-                          else {
-                            Rete::Rete_Node_Ptr test_node = parent;
-                            const Rete::Rete_Filter * filter_node = dynamic_cast<const Rete::Rete_Filter *>(test_node->parent_right().get());
-                            while(!filter_node) {
-                              test_node = test_node->parent_right();
-                              filter_node = dynamic_cast<const Rete::Rete_Filter *>(test_node->parent_right().get());
-                            }
-
-                            if(const auto bindings = test_node->get_bindings()) {
-                              for(const auto binding : *bindings) {
-                                if(binding.second == Rete::WME_Token_Index(0, 0, 0)) {
-                                  feature->axis = binding.first;
-                                  goto AXIS_FOUND;
-                                }
-                              }
-                            }
-                            reteerror(&yylloc, yyscanner, agent, filename, source_path, "Error determining Feature axis.");
-                            YYABORT;
-                            AXIS_FOUND:
-                              ;
-                          }
-
-                          if(feature->get_depth() > 1) {
-                            const auto predicate = dynamic_cast<const Rete::Rete_Predicate *>(parent.get());
-                            assert(predicate);
-                            if(predicate) {
-                              auto ancestor = parent_action;
-                              auto ancestor_prev = ancestor;
-                              assert(ancestor && dynamic_cast<const Carli::Node *>(ancestor->data.get())->q_value_fringe->feature);
-                              while(ancestor && dynamic_cast<const Carli::Node *>(ancestor->data.get())->q_value_fringe->feature &&
-                                    ancestor->get_token_size() > predicate->get_lhs_index().token_row)
-                              {
-                                ancestor_prev = ancestor;
-                                ancestor = dynamic_cast<const Carli::Node *>(ancestor->data.get())->parent_action.lock();
-                              }
-
-                              assert(ancestor);
-                              if(ancestor) {
-                                const auto ancestor_node = dynamic_cast<const Carli::Node *>(ancestor_prev->data.get());
-                                assert(ancestor_node);
-                                assert(ancestor_node->q_value_fringe);
-                                assert(ancestor_node->q_value_fringe->feature);
-                                feature->bindings = ancestor_node->q_value_fringe->feature->bindings;
-                                feature->conditions = ancestor_node->q_value_fringe->feature->conditions;
-                              }
-                              else
-                                feature->bindings.insert(std::make_pair(predicate->get_lhs_index(), Rete::WME_Token_Index(-1, -1, -1)));
-                            }
-                          }
-                          else {
-                            if(parent->get_bindings()) {
-                              feature->bindings = *parent->get_bindings();
-                              feature->conditions = parent->parent_right()->get_filter_wmes();
-                            }
-                            if(auto predicate = dynamic_cast<const Rete::Rete_Predicate *>(parent.get()))
-                              feature->bindings.insert(std::make_pair(predicate->get_lhs_index(), Rete::WME_Token_Index(-1, -1, -1)));
-                          }
-
-                          if(feature->axis.rete_row != -1 && parent->get_bindings()) {
-                            if(feature->axis.existential && dynamic_cast<const Carli::Feature_Ranged_Data *>(feature)) {
-                              reteerror(&yylloc, yyscanner, agent, filename, source_path, "Refineable feature illegally declared existential.");
-                              YYABORT;
-                            }
-                            feature->axis.rete_row += parent->parent_left()->get_size();
-                            feature->axis.token_row += parent->parent_left()->get_token_size();
-                          }
-                          feature->indices = variable_indices;
-
-                          //std::cerr << "LHS" << feature->axis << ' ' << *variable_indices << std::endl;
-                        }
-
-                        /// Make the new action
-                        if(node_type != "fringe") {
-                          Carli::Node_Ptr new_action_data;
-                          if(node_type == "split") {
-                            const auto new_q_value_weight = new Carli::Q_Value(q_value_value, Carli::Q_Value::Type::SPLIT, q_value_depth, feature ? feature->clone() : nullptr, timestamp);
-                            const auto new_q_value_fringe = new Carli::Q_Value(Carli::Q_Value::Token() /** HACK: Not stored in written rules. */, Carli::Q_Value::Type::FRINGE, q_value_depth, feature, timestamp);
-                            new_action = agent.make_standard_action(parent, name, true, variable_indices);
-                            new_action_data = std::make_shared<Carli::Node_Split>(agent, parent_action, new_action, new_q_value_weight, new_q_value_fringe);
-                            new_action->data = new_action_data;
-                          }
-                          else {
-                            assert(node_type == "unsplit");
-                            const auto new_q_value_weight = new Carli::Q_Value(q_value_value, Carli::Q_Value::Type::UNSPLIT, q_value_depth, feature ? feature->clone() : nullptr, timestamp);
-                            const auto new_q_value_fringe = new Carli::Q_Value(Carli::Q_Value::Token() /** HACK: Not stored in written rules. */, Carli::Q_Value::Type::FRINGE, q_value_depth, feature, timestamp);
-                            new_action = agent.make_standard_action(parent, name, true, variable_indices);
-                            new_action_data = std::make_shared<Carli::Node_Unsplit>(agent, parent_action, new_action, new_q_value_weight, new_q_value_fringe);
-                            new_action->data = new_action_data;
-                          }
-                          if(parent_action) {
-                            auto &parent_data = dynamic_cast<Carli::Node_Split &>(*parent_action->data);
-//#ifndef NDEBUG
-//                            std::cerr << "Adding child node link from " << parent_action->get_name() << " to " << new_action_data << std::endl;
-//#endif
-                            parent_data.children.push_back(new_action_data);
-                          }
-                          else if(new_action_data->q_value_fringe->depth != 1) {
-                            reteerror(&yylloc, yyscanner, agent, filename, source_path, "Ancestral relationship specified in :feature not found.");
-                            YYABORT;
-                          }
-#ifndef NDEBUG
-                          Carli::Node_Tracker::get().create(*new_action);
-#endif
-                        }
-                        else {
-                          const auto new_q_value_fringe = new Carli::Q_Value(q_value_value, Carli::Q_Value::Type::FRINGE, q_value_depth, feature, timestamp);
-                          new_action = agent.make_standard_action(parent, name, true, variable_indices);
-                          auto new_action_data = std::make_shared<Carli::Node_Fringe>(agent, parent_action, new_action, nullptr, new_q_value_fringe);
-                          new_action->data = new_action_data;
-                          if(parent_action) {
-                            if(const auto &parent_data = dynamic_cast<Carli::Node_Split *>(parent_action->data.get()))
-                              parent_data->fringe_values[feature].push_back(new_action_data);
-                            else if(const auto &parent_data = dynamic_cast<Carli::Node_Unsplit *>(parent_action->data.get()))
-                              parent_data->fringe_values[feature].push_back(new_action_data);
-                            else {
-                              reteerror(&yylloc, yyscanner, agent, filename, source_path, "Parent data for fringe node inaccessible.");
-                              YYABORT;
-                            }
-                          }
-                          else {
-                            reteerror(&yylloc, yyscanner, agent, filename, source_path, "Ancestral relationship specified in :feature fringe not found.");
-                            YYABORT;
-                          }
-                        }
-
-                        if(!get_Option_Ranged<bool>(Options::get_global(), "rete-disable-node-sharing") && parent_action) {
-                          bool ancestor_found = false;
-                          auto ancestor = parent;
-                          while(ancestor && !ancestor_found) {
-                            if(ancestor == parent_action->parent_left())
-                              ancestor_found = true;
-                            else if(!dynamic_cast<Rete::Rete_Filter *>(ancestor.get()))
-                              ancestor = ancestor->parent_left();
-                            else
-                              break;
-                          }
-                          if(!ancestor_found) {
-                            reteerror(&yylloc, yyscanner, agent, filename, source_path, "Illegal ancestral relationship specified in :feature.");
-                            YYABORT;
-                          }
-                        }
-                      }
-
-                      parent->suppress_destruction(false);
-                      delete (yyvsp[0].rule_ptr); }
-#line 1883 "rules.tab.cpp" /* yacc.c:1646  */
+    { bool fatal = false;
+                      const char * const error = rete_make_rule(agent, *(yyvsp[0].rule_ptr), fatal);
+                      if(error)
+                        rete_uncompiled();
+                      else if(g_rete_template)
+                        g_rete_template->rule(*agent.get_rule(get<1>(*(yyvsp[0].rule_ptr))));
+                      delete (yyvsp[0].rule_ptr);
+                      if(error) {
+                        reteerror(&yylloc, yyscanner, agent, filename, source_path, error);
+                        if(fatal)
+                          YYABORT;
+                      } }
+#line 1613 "rules.tab.cpp" /* yacc.c:1646  */
     break;
 
   case 13:
-#line 454 "rules.yyy" /* yacc.c:1646  */
+#line 184 "rules.yyy" /* yacc.c:1646  */
     { if(!get<0>(*(yyvsp[-2].flag_ptr)))
                                             get<0>(*(yyvsp[-2].flag_ptr)) = make_shared<int64_t>(agent.get_total_step_count());
                                           if(!get<1>(*(yyvsp[-2].flag_ptr)))
@@ -1897,11 +1648,11 @@ yyreduce:
                                           delete (yyvsp[-3].sval);
                                           delete (yyvsp[-2].flag_ptr);
                                           delete (yyvsp[-1].rete_node_ptr); }
-#line 1896 "rules.tab.cpp" /* yacc.c:1646  */
+#line 1626 "rules.tab.cpp" /* yacc.c:1646  */
     break;
 
   case 14:
-#line 463 "rules.yyy" /* yacc.c:1646  */
+#line 193 "rules.yyy" /* yacc.c:1646  */
     { if(!get<0>(*(yyvsp[-9].flag_ptr)))
             get<0>(*(yyvsp[-9].flag_ptr)) = make_shared<int64_t>(agent.get_total_step_count());
           if(!get<1>(*(yyvsp[-9].flag_ptr)))
@@ -1910,11 +1661,11 @@ yyreduce:
           delete (yyvsp[-10].sval);
           delete (yyvsp[-9].flag_ptr);
           delete (yyvsp[-8].rete_node_ptr); }
-#line 1909 "rules.tab.cpp" /* yacc.c:1646  */
+#line 1639 "rules.tab.cpp" /* yacc.c:1646  */
     break;
 
   case 15:
-#line 472 "rules.yyy" /* yacc.c:1646  */
+#line 202 "rules.yyy" /* yacc.c:1646  */
     { if(!get<0>(*(yyvsp[-5].flag_ptr)))
             get<0>(*(yyvsp[-5].flag_ptr)) = make_shared<int64_t>(agent.get_total_step_count());
           if(!get<1>(*(yyvsp[-5].flag_ptr)))
@@ -1923,28 +1674,28 @@ yyreduce:
           delete (yyvsp[-6].sval);
           delete (yyvsp[-5].flag_ptr);
           delete (yyvsp[-4].rete_node_ptr); }
-#line 1922 "rules.tab.cpp" /* yacc.c:1646  */
+#line 1652 "rules.tab.cpp" /* yacc.c:1646  */
     break;
 
   case 16:
-#line 483 "rules.yyy" /* yacc.c:1646  */
+#line 213 "rules.yyy" /* yacc.c:1646  */
     { (yyval.flag_ptr) = new tuple<shared_ptr<int64_t>, shared_ptr<tuple<int64_t, string, string, Carli::Feature *>>>; }
-#line 1928 "rules.tab.cpp" /* yacc.c:1646  */
+#line 1658 "rules.tab.cpp" /* yacc.c:1646  */
     break;
 
   case 17:
-#line 484 "rules.yyy" /* yacc.c:1646  */
+#line 214 "rules.yyy" /* yacc.c:1646  */
     { if(get<0>(*(yyvsp[-2].flag_ptr))) {
                                      reteerror(&yylloc, yyscanner, agent, filename, source_path, "Flag :creation-time set more than once.");
                                      YYABORT;
                                    }
                                    (yyval.flag_ptr) = (yyvsp[-2].flag_ptr);
                                    get<0>(*(yyval.flag_ptr)) = make_shared<int64_t>((yyvsp[0].ival)); }
-#line 1939 "rules.tab.cpp" /* yacc.c:1646  */
+#line 1669 "rules.tab.cpp" /* yacc.c:1646  */
     break;
 
   case 18:
-#line 490 "rules.yyy" /* yacc.c:1646  */
+#line 220 "rules.yyy" /* yacc.c:1646  */
     { if(get<1>(*(yyvsp[-8].flag_ptr))) {
                                                                     reteerror(&yylloc, yyscanner, agent, filename, source_path, "Flag :feature set more than once.");
                                                                     YYABORT;
@@ -1957,11 +1708,11 @@ yyreduce:
                                                                   get<1>(*(yyval.flag_ptr)) = make_shared<tuple<int64_t, string, string, Carli::Feature *>>((yyvsp[-6].ival), *(yyvsp[-5].sval), *(yyvsp[-3].sval), new Carli::Feature_Ranged<Carli::Feature>(vector<Rete::WME>() /*FIXUP Later*/, Rete::WME_Bindings() /*FIXUP later*/, Rete::WME_Token_Index() /*FIXUP later*/, nullptr /*FIXUP later*/, (yyvsp[-4].ival), (yyvsp[-1].fval), (yyvsp[0].fval), (yyvsp[-2].ival), Rete::Rete_Predicate::EQ /*FIXUP later*/, false));
                                                                   delete (yyvsp[-5].sval);
                                                                   delete (yyvsp[-3].sval); }
-#line 1956 "rules.tab.cpp" /* yacc.c:1646  */
+#line 1686 "rules.tab.cpp" /* yacc.c:1646  */
     break;
 
   case 19:
-#line 502 "rules.yyy" /* yacc.c:1646  */
+#line 232 "rules.yyy" /* yacc.c:1646  */
     { if(get<1>(*(yyvsp[-8].flag_ptr))) {
                                                                 reteerror(&yylloc, yyscanner, agent, filename, source_path, "Flag :feature set more than once.");
                                                                 YYABORT;
@@ -1974,11 +1725,11 @@ yyreduce:
                                                               get<1>(*(yyval.flag_ptr)) = make_shared<tuple<int64_t, string, string, Carli::Feature *>>((yyvsp[-6].ival), *(yyvsp[-5].sval), *(yyvsp[-3].sval), new Carli::Feature_Ranged<Carli::Feature>(vector<Rete::WME>() /*FIXUP Later*/, Rete::WME_Bindings() /*FIXUP later*/, Rete::WME_Token_Index() /*FIXUP later*/, nullptr /*FIXUP later*/, (yyvsp[-4].ival), (yyvsp[-1].ival), (yyvsp[0].ival), (yyvsp[-2].ival), Rete::Rete_Predicate::EQ /*FIXUP later*/, true));
                                                               delete (yyvsp[-5].sval);
                                                               delete (yyvsp[-3].sval); }
-#line 1973 "rules.tab.cpp" /* yacc.c:1646  */
+#line 1703 "rules.tab.cpp" /* yacc.c:1646  */
     break;
 
   case 20:
-#line 514 "rules.yyy" /* yacc.c:1646  */
+#line 244 "rules.yyy" /* yacc.c:1646  */
     { if(get<1>(*(yyvsp[-5].flag_ptr))) {
                                                     reteerror(&yylloc, yyscanner, agent, filename, source_path, "Flag :feature set more than once.");
                                                     YYABORT;
@@ -1998,11 +1749,11 @@ yyreduce:
                                                     get<1>(*(yyval.flag_ptr)) = make_shared<tuple<int64_t, string, string, Carli::Feature *>>((yyvsp[-3].ival), *(yyvsp[-2].sval), *(yyvsp[0].sval), new Carli::Feature_Enumerated<Carli::Feature>(vector<Rete::WME>() /*FIXUP Later*/, Rete::WME_Bindings() /*FIXUP later*/, Rete::WME_Token_Index() /*FIXUP later*/, nullptr /*FIXUP later*/, (yyvsp[-1].ival), 0 /*FIXUP later*/));
                                                   delete (yyvsp[-2].sval);
                                                   delete (yyvsp[0].sval); }
-#line 1997 "rules.tab.cpp" /* yacc.c:1646  */
+#line 1727 "rules.tab.cpp" /* yacc.c:1646  */
     break;
 
   case 21:
-#line 533 "rules.yyy" /* yacc.c:1646  */
+#line 263 "rules.yyy" /* yacc.c:1646  */
     { if(get<1>(*(yyvsp[-7].flag_ptr))) {
                                                                 reteerror(&yylloc, yyscanner, agent, filename, source_path, "Flag :feature set more than once.");
                                                                 YYABORT;
@@ -2011,11 +1762,11 @@ yyreduce:
                                                               get<1>(*(yyval.flag_ptr)) = make_shared<tuple<int64_t, string, string, Carli::Feature *>>((yyvsp[-5].ival), *(yyvsp[-4].sval), *(yyvsp[-3].sval), new Carli::Feature_Ranged<Carli::Feature>(vector<Rete::WME>() /*FIXUP Later*/, Rete::WME_Bindings() /*FIXUP later*/, Rete::WME_Token_Index() /*FIXUP later*/, nullptr /*FIXUP later*/, -1, (yyvsp[-1].fval), (yyvsp[0].fval), (yyvsp[-2].ival), Rete::Rete_Predicate::EQ /*FIXUP later*/, false));
                                                               delete (yyvsp[-4].sval);
                                                               delete (yyvsp[-3].sval); }
-#line 2010 "rules.tab.cpp" /* yacc.c:1646  */
+#line 1740 "rules.tab.cpp" /* yacc.c:1646  */
     break;
 
   case 22:
-#line 541 "rules.yyy" /* yacc.c:1646  */
+#line 271 "rules.yyy" /* yacc.c:1646  */
     { if(get<1>(*(yyvsp[-7].flag_ptr))) {
                                                             reteerror(&yylloc, yyscanner, agent, filename, source_path, "Flag :feature set more than once.");
                                                             YYABORT;
@@ -2024,11 +1775,11 @@ yyreduce:
                                                           get<1>(*(yyval.flag_ptr)) = make_shared<tuple<int64_t, string, string, Carli::Feature *>>((yyvsp[-5].ival), *(yyvsp[-4].sval), *(yyvsp[-3].sval), new Carli::Feature_Ranged<Carli::Feature>(vector<Rete::WME>() /*FIXUP Later*/, Rete::WME_Bindings() /*FIXUP later*/, Rete::WME_Token_Index() /*FIXUP later*/, nullptr /*FIXUP later*/, -1, (yyvsp[-1].ival), (yyvsp[0].ival), (yyvsp[-2].ival), Rete::Rete_Predicate::EQ /*FIXUP later*/, true));
                                                           delete (yyvsp[-4].sval);
                                                           delete (yyvsp[-3].sval); }
-#line 2023 "rules.tab.cpp" /* yacc.c:1646  */
+#line 1753 "rules.tab.cpp" /* yacc.c:1646  */
     break;
 
   case 23:
-#line 549 "rules.yyy" /* yacc.c:1646  */
+#line 279 "rules.yyy" /* yacc.c:1646  */
     { if(get<1>(*(yyvsp[-4].flag_ptr))) {
                                                 reteerror(&yylloc, yyscanner, agent, filename, source_path, "Flag :feature set more than once.");
                                                 YYABORT;
@@ -2040,56 +1791,56 @@ yyreduce:
                                                 get<1>(*(yyval.flag_ptr)) = make_shared<tuple<int64_t, string, string, Carli::Feature *>>(1, *(yyvsp[-1].sval), "", nullptr);
                                               delete (yyvsp[-1].sval);
                                               delete (yyvsp[0].sval); }
-#line 2039 "rules.tab.cpp" /* yacc.c:1646  */
+#line 1769 "rules.tab.cpp" /* yacc.c:1646  */
     break;
 
   case 24:
-#line 562 "rules.yyy" /* yacc.c:1646  */
+#line 292 "rules.yyy" /* yacc.c:1646  */
     { (yyval.rete_node_ptr) = (yyvsp[0].rete_node_ptr); }
-#line 2045 "rules.tab.cpp" /* yacc.c:1646  */
+#line 1775 "rules.tab.cpp" /* yacc.c:1646  */
     break;
 
   case 25:
-#line 563 "rules.yyy" /* yacc.c:1646  */
+#line 293 "rules.yyy" /* yacc.c:1646  */
     { (yyval.rete_node_ptr) = Rete_Node_Ptr_and_Variables(Rete::Rete_Node_Ptr(agent.make_existential((yyvsp[0].rete_node_ptr)->first)), Rete::Variable_Indices()); delete (yyvsp[0].rete_node_ptr); }
-#line 2051 "rules.tab.cpp" /* yacc.c:1646  */
+#line 1781 "rules.tab.cpp" /* yacc.c:1646  */
     break;
 
   case 26:
-#line 564 "rules.yyy" /* yacc.c:1646  */
+#line 294 "rules.yyy" /* yacc.c:1646  */
     { (yyval.rete_node_ptr) = Rete_Node_Ptr_and_Variables(Rete::Rete_Node_Ptr(agent.make_negation((yyvsp[0].rete_node_ptr)->first)), Rete::Variable_Indices()); delete (yyvsp[0].rete_node_ptr); }
-#line 2057 "rules.tab.cpp" /* yacc.c:1646  */
+#line 1787 "rules.tab.cpp" /* yacc.c:1646  */
     break;
 
   case 27:
-#line 567 "rules.yyy" /* yacc.c:1646  */
+#line 297 "rules.yyy" /* yacc.c:1646  */
     { const Rete::Variable_Indices variables(merge_variables((yyvsp[-1].rete_node_ptr)->second, (yyvsp[-1].rete_node_ptr)->first->get_size(), (yyvsp[-1].rete_node_ptr)->first->get_token_size(), (yyvsp[0].rete_node_ptr)->second, false));
                               (yyval.rete_node_ptr) = Rete_Node_Ptr_and_Variables(Rete::Rete_Node_Ptr(agent.make_join(join_bindings((yyvsp[-1].rete_node_ptr)->second, (yyvsp[0].rete_node_ptr)->second), (yyvsp[-1].rete_node_ptr)->first, (yyvsp[0].rete_node_ptr)->first)), variables);
                               delete (yyvsp[-1].rete_node_ptr);
                               delete (yyvsp[0].rete_node_ptr); }
-#line 2066 "rules.tab.cpp" /* yacc.c:1646  */
+#line 1796 "rules.tab.cpp" /* yacc.c:1646  */
     break;
 
   case 28:
-#line 571 "rules.yyy" /* yacc.c:1646  */
+#line 301 "rules.yyy" /* yacc.c:1646  */
     { const Rete::Variable_Indices variables(merge_variables((yyvsp[-2].rete_node_ptr)->second, (yyvsp[-2].rete_node_ptr)->first->get_size(), (yyvsp[-2].rete_node_ptr)->first->get_token_size(), (yyvsp[0].rete_node_ptr)->second, true));
                                     (yyval.rete_node_ptr) = Rete_Node_Ptr_and_Variables(Rete::Rete_Node_Ptr(agent.make_existential_join(join_bindings((yyvsp[-2].rete_node_ptr)->second, (yyvsp[0].rete_node_ptr)->second), (yyvsp[-2].rete_node_ptr)->first, (yyvsp[0].rete_node_ptr)->first)), variables);
                                     delete (yyvsp[-2].rete_node_ptr);
                                     delete (yyvsp[0].rete_node_ptr); }
-#line 2075 "rules.tab.cpp" /* yacc.c:1646  */
+#line 1805 "rules.tab.cpp" /* yacc.c:1646  */
     break;
 
   case 29:
-#line 575 "rules.yyy" /* yacc.c:1646  */
+#line 305 "rules.yyy" /* yacc.c:1646  */
     { const Rete::Variable_Indices variables(merge_variables((yyvsp[-2].rete_node_ptr)->second, (yyvsp[-2].rete_node_ptr)->first->get_size(), (yyvsp[-2].rete_node_ptr)->first->get_token_size(), (yyvsp[0].rete_node_ptr)->second, true));
                                     (yyval.rete_node_ptr) = Rete_Node_Ptr_and_Variables(Rete::Rete_Node_Ptr(agent.make_negation_join(join_bindings((yyvsp[-2].rete_node_ptr)->second, (yyvsp[0].rete_node_ptr)->second), (yyvsp[-2].rete_node_ptr)->first, (yyvsp[0].rete_node_ptr)->first)), variables);
                                     delete (yyvsp[-2].rete_node_ptr);
                                     delete (yyvsp[0].rete_node_ptr); }
-#line 2084 "rules.tab.cpp" /* yacc.c:1646  */
+#line 1814 "rules.tab.cpp" /* yacc.c:1646  */
     break;
 
   case 30:
-#line 579 "rules.yyy" /* yacc.c:1646  */
+#line 309 "rules.yyy" /* yacc.c:1646  */
     { const auto lhs_index = find_index((yyvsp[-5].rete_node_ptr)->second, *(yyvsp[-3].sval));
                                                             if(lhs_index.column > 2) {
                                                               reteerror(&yylloc, yyscanner, agent, filename, source_path, "Unbound variable tested by predicate.");
@@ -2099,11 +1850,11 @@ yyreduce:
                                                             delete (yyvsp[-5].rete_node_ptr);
                                                             delete (yyvsp[-3].sval);
                                                             delete (yyvsp[-1].symbol_ptr); }
-#line 2098 "rules.tab.cpp" /* yacc.c:1646  */
+#line 1828 "rules.tab.cpp" /* yacc.c:1646  */
     break;
 
   case 31:
-#line 588 "rules.yyy" /* yacc.c:1646  */
+#line 318 "rules.yyy" /* yacc.c:1646  */
     { const auto lhs_index = find_index((yyvsp[-5].rete_node_ptr)->second, *(yyvsp[-3].sval));
                                                      const auto rhs_index = find_index((yyvsp[-5].rete_node_ptr)->second, *(yyvsp[-1].sval));
                                                      if(lhs_index.column > 2 || rhs_index.column > 2) {
@@ -2114,157 +1865,157 @@ yyreduce:
                                                      delete (yyvsp[-5].rete_node_ptr);
                                                      delete (yyvsp[-3].sval);
                                                      delete (yyvsp[-1].sval); }
-#line 2113 "rules.tab.cpp" /* yacc.c:1646  */
+#line 1843 "rules.tab.cpp" /* yacc.c:1646  */
     break;
 
   case 32:
-#line 598 "rules.yyy" /* yacc.c:1646  */
+#line 328 "rules.yyy" /* yacc.c:1646  */
     { (yyval.rete_node_ptr) = (yyvsp[0].rete_node_ptr); }
-#line 2119 "rules.tab.cpp" /* yacc.c:1646  */
+#line 1849 "rules.tab.cpp" /* yacc.c:1646  */
     break;
 
   case 33:
-#line 601 "rules.yyy" /* yacc.c:1646  */
+#line 331 "rules.yyy" /* yacc.c:1646  */
     { (yyval.rete_node_ptr) = (yyvsp[-1].rete_node_ptr); }
-#line 2125 "rules.tab.cpp" /* yacc.c:1646  */
+#line 1855 "rules.tab.cpp" /* yacc.c:1646  */
     break;
 
   case 34:
-#line 602 "rules.yyy" /* yacc.c:1646  */
+#line 332 "rules.yyy" /* yacc.c:1646  */
     { const auto referenced_action = agent.get_rule(*(yyvsp[0].sval));
                  (yyval.rete_node_ptr) = Rete_Node_Ptr_and_Variables(referenced_action->parent_left(), *referenced_action->get_variables());
                  delete (yyvsp[0].sval); }
-#line 2133 "rules.tab.cpp" /* yacc.c:1646  */
+#line 1863 "rules.tab.cpp" /* yacc.c:1646  */
     break;
 
   case 35:
-#line 607 "rules.yyy" /* yacc.c:1646  */
+#line 337 "rules.yyy" /* yacc.c:1646  */
     { (yyval.rete_node_ptr) = (yyvsp[0].rete_node_ptr); }
-#line 2139 "rules.tab.cpp" /* yacc.c:1646  */
+#line 1869 "rules.tab.cpp" /* yacc.c:1646  */
     break;
 
   case 36:
-#line 608 "rules.yyy" /* yacc.c:1646  */
+#line 338 "rules.yyy" /* yacc.c:1646  */
     { (yyval.rete_node_ptr) = (yyvsp[0].rete_node_ptr); }
-#line 2145 "rules.tab.cpp" /* yacc.c:1646  */
+#line 1875 "rules.tab.cpp" /* yacc.c:1646  */
     break;
 
   case 37:
-#line 611 "rules.yyy" /* yacc.c:1646  */
-    { (yyval.rete_node_ptr) = Rete_Node_Ptr_and_Variables(Rete::Rete_Node_Ptr(agent.make_filter(Rete::WME(make_shared<Rete::Symbol_Variable>(Rete::Symbol_Variable::First), *(yyvsp[-2].symbol_ptr), *(yyvsp[-1].symbol_ptr)))), Rete::Variable_Indices({{std::make_pair(*(yyvsp[-4].sval), Rete::WME_Token_Index(0, 0, 0))}})); delete (yyvsp[-4].sval); delete (yyvsp[-2].symbol_ptr); delete (yyvsp[-1].symbol_ptr); }
-#line 2151 "rules.tab.cpp" /* yacc.c:1646  */
+#line 341 "rules.yyy" /* yacc.c:1646  */
+    { (yyval.rete_node_ptr) = Rete_Node_Ptr_and_Variables(Rete::Rete_Node_Ptr(agent.make_filter(Rete::WME(Rete::make_pooled<Rete::Symbol_Variable>(Rete::Symbol_Variable::First), *(yyvsp[-2].symbol_ptr), *(yyvsp[-1].symbol_ptr)))), Rete::Variable_Indices({{std::make_pair(*(yyvsp[-4].sval), Rete::WME_Token_Index(0, 0, 0))}})); delete (yyvsp[-4].sval); delete (yyvsp[-2].symbol_ptr); delete (yyvsp[-1].symbol_ptr); }
+#line 1881 "rules.tab.cpp" /* yacc.c:1646  */
     break;
 
   case 38:
-#line 612 "rules.yyy" /* yacc.c:1646  */
-    { (yyval.rete_node_ptr) = Rete_Node_Ptr_and_Variables(Rete::Rete_Node_Ptr(agent.make_filter(Rete::WME(make_shared<Rete::Symbol_Variable>(Rete::Symbol_Variable::First), *(yyvsp[-2].symbol_ptr), make_shared<Rete::Symbol_Variable>(*(yyvsp[-4].sval) == *(yyvsp[-1].sval) ? Rete::Symbol_Variable::First : Rete::Symbol_Variable::Third)))), Rete::Variable_Indices({{std::make_pair(*(yyvsp[-4].sval), Rete::WME_Token_Index(0, 0, 0)), std::make_pair(*(yyvsp[-1].sval), Rete::WME_Token_Index(0, 0, 2))}})); delete (yyvsp[-4].sval); delete (yyvsp[-2].symbol_ptr); delete (yyvsp[-1].sval); }
-#line 2157 "rules.tab.cpp" /* yacc.c:1646  */
+#line 342 "rules.yyy" /* yacc.c:1646  */
+    { (yyval.rete_node_ptr) = Rete_Node_Ptr_and_Variables(Rete::Rete_Node_Ptr(agent.make_filter(Rete::WME(Rete::make_pooled<Rete::Symbol_Variable>(Rete::Symbol_Variable::First), *(yyvsp[-2].symbol_ptr), Rete::make_pooled<Rete::Symbol_Variable>(*(yyvsp[-4].sval) == *(yyvsp[-1].sval) ? Rete::Symbol_Variable::First : Rete::Symbol_Variable::Third)))), Rete::Variable_Indices({{std::make_pair(*(yyvsp[-4].sval), Rete::WME_Token_Index(0, 0, 0)), std::make_pair(*(yyvsp[-1].sval), Rete::WME_Token_Index(0, 0, 2))}})); delete (yyvsp[-4].sval); delete (yyvsp[-2].symbol_ptr); delete (yyvsp[-1].sval); }
+#line 1887 "rules.tab.cpp" /* yacc.c:1646  */
     break;
 
   case 39:
-#line 613 "rules.yyy" /* yacc.c:1646  */
-    { (yyval.rete_node_ptr) = Rete_Node_Ptr_and_Variables(Rete::Rete_Node_Ptr(agent.make_filter(Rete::WME(make_shared<Rete::Symbol_Variable>(Rete::Symbol_Variable::First), make_shared<Rete::Symbol_Variable>(*(yyvsp[-4].sval) == *(yyvsp[-2].sval) ? Rete::Symbol_Variable::First : Rete::Symbol_Variable::Second), *(yyvsp[-1].symbol_ptr)))), Rete::Variable_Indices({{std::make_pair(*(yyvsp[-4].sval), Rete::WME_Token_Index(0, 0, 0)), std::make_pair(*(yyvsp[-2].sval), Rete::WME_Token_Index(0, 0, 1))}})); delete (yyvsp[-4].sval); delete (yyvsp[-2].sval); delete (yyvsp[-1].symbol_ptr); }
-#line 2163 "rules.tab.cpp" /* yacc.c:1646  */
+#line 343 "rules.yyy" /* yacc.c:1646  */
+    { (yyval.rete_node_ptr) = Rete_Node_Ptr_and_Variables(Rete::Rete_Node_Ptr(agent.make_filter(Rete::WME(Rete::make_pooled<Rete::Symbol_Variable>(Rete::Symbol_Variable::First), Rete::make_pooled<Rete::Symbol_Variable>(*(yyvsp[-4].sval) == *(yyvsp[-2].sval) ? Rete::Symbol_Variable::First : Rete::Symbol_Variable::Second), *(yyvsp[-1].symbol_ptr)))), Rete::Variable_Indices({{std::make_pair(*(yyvsp[-4].sval), Rete::WME_Token_Index(0, 0, 0)), std::make_pair(*(yyvsp[-2].sval), Rete::WME_Token_Index(0, 0, 1))}})); delete (yyvsp[-4].sval); delete (yyvsp[-2].sval); delete (yyvsp[-1].symbol_ptr); }
+#line 1893 "rules.tab.cpp" /* yacc.c:1646  */
     break;
 
   case 40:
-#line 614 "rules.yyy" /* yacc.c:1646  */
-    { (yyval.rete_node_ptr) = Rete_Node_Ptr_and_Variables(Rete::Rete_Node_Ptr(agent.make_filter(Rete::WME(make_shared<Rete::Symbol_Variable>(Rete::Symbol_Variable::First), make_shared<Rete::Symbol_Variable>(*(yyvsp[-4].sval) == *(yyvsp[-2].sval) ? Rete::Symbol_Variable::First : Rete::Symbol_Variable::Second), make_shared<Rete::Symbol_Variable>(*(yyvsp[-4].sval) == *(yyvsp[-1].sval) ? Rete::Symbol_Variable::First : *(yyvsp[-2].sval) == *(yyvsp[-1].sval) ? Rete::Symbol_Variable::Second : Rete::Symbol_Variable::Third)))), Rete::Variable_Indices({{std::make_pair(*(yyvsp[-4].sval), Rete::WME_Token_Index(0, 0, 0)), std::make_pair(*(yyvsp[-2].sval), Rete::WME_Token_Index(0, 0, 1)), std::make_pair(*(yyvsp[-1].sval), Rete::WME_Token_Index(0, 0, 2))}})); delete (yyvsp[-4].sval); delete (yyvsp[-2].sval); delete (yyvsp[-1].sval); }
-#line 2169 "rules.tab.cpp" /* yacc.c:1646  */
+#line 344 "rules.yyy" /* yacc.c:1646  */
+    { (yyval.rete_node_ptr) = Rete_Node_Ptr_and_Variables(Rete::Rete_Node_Ptr(agent.make_filter(Rete::WME(Rete::make_pooled<Rete::Symbol_Variable>(Rete::Symbol_Variable::First), Rete::make_pooled<Rete::Symbol_Variable>(*(yyvsp[-4].sval) == *(yyvsp[-2].sval) ? Rete::Symbol_Variable::First : Rete::Symbol_Variable::Second), Rete::make_pooled<Rete::Symbol_Variable>(*(yyvsp[-4].sval) == *(yyvsp[-1].sval) ? Rete::Symbol_Variable::First : *(yyvsp[-2].sval) == *(yyvsp[-1].sval) ? Rete::Symbol_Variable::Second : Rete::Symbol_Variable::Third)))), Rete::Variable_Indices({{std::make_pair(*(yyvsp[-4].sval), Rete::WME_Token_Index(0, 0, 0)), std::make_pair(*(yyvsp[-2].sval), Rete::WME_Token_Index(0, 0, 1)), std::make_pair(*(yyvsp[-1].sval), Rete::WME_Token_Index(0, 0, 2))}})); delete (yyvsp[-4].sval); delete (yyvsp[-2].sval); delete (yyvsp[-1].sval); }
+#line 1899 "rules.tab.cpp" /* yacc.c:1646  */
     break;
 
   case 41:
-#line 617 "rules.yyy" /* yacc.c:1646  */
+#line 347 "rules.yyy" /* yacc.c:1646  */
     { (yyval.symbol_ptr) = (yyvsp[0].symbol_ptr); }
-#line 2175 "rules.tab.cpp" /* yacc.c:1646  */
+#line 1905 "rules.tab.cpp" /* yacc.c:1646  */
     break;
 
   case 42:
-#line 618 "rules.yyy" /* yacc.c:1646  */
+#line 348 "rules.yyy" /* yacc.c:1646  */
     { (yyval.symbol_ptr) = (yyvsp[0].symbol_ptr); }
-#line 2181 "rules.tab.cpp" /* yacc.c:1646  */
+#line 1911 "rules.tab.cpp" /* yacc.c:1646  */
     break;
 
   case 43:
-#line 621 "rules.yyy" /* yacc.c:1646  */
-    { (yyval.symbol_ptr) = new Rete::Symbol_Ptr_C(make_shared<Rete::Symbol_Identifier>(*(yyvsp[0].sval))); delete (yyvsp[0].sval); }
-#line 2187 "rules.tab.cpp" /* yacc.c:1646  */
+#line 351 "rules.yyy" /* yacc.c:1646  */
+    { (yyval.symbol_ptr) = new Rete::Symbol_Ptr_C(Rete::Symbol_Identifier::intern(*(yyvsp[0].sval))); delete (yyvsp[0].sval); }
+#line 1917 "rules.tab.cpp" /* yacc.c:1646  */
     break;
 
   case 44:
-#line 624 "rules.yyy" /* yacc.c:1646  */
-    { (yyval.symbol_ptr) = new Rete::Symbol_Ptr_C(make_shared<Rete::Symbol_Constant_Float>((yyvsp[0].fval))); }
-#line 2193 "rules.tab.cpp" /* yacc.c:1646  */
+#line 354 "rules.yyy" /* yacc.c:1646  */
+    { (yyval.symbol_ptr) = new Rete::Symbol_Ptr_C(Rete::Symbol_Constant_Float::intern((yyvsp[0].fval))); }
+#line 1923 "rules.tab.cpp" /* yacc.c:1646  */
     break;
 
   case 45:
-#line 625 "rules.yyy" /* yacc.c:1646  */
-    { (yyval.symbol_ptr) = new Rete::Symbol_Ptr_C(make_shared<Rete::Symbol_Constant_Int>((yyvsp[0].ival))); }
-#line 2199 "rules.tab.cpp" /* yacc.c:1646  */
+#line 355 "rules.yyy" /* yacc.c:1646  */
+    { (yyval.symbol_ptr) = new Rete::Symbol_Ptr_C(Rete::Symbol_Constant_Int::intern((yyvsp[0].ival))); }
+#line 1929 "rules.tab.cpp" /* yacc.c:1646  */
     break;
 
   case 46:
-#line 626 "rules.yyy" /* yacc.c:1646  */
-    { (yyval.symbol_ptr) = new Rete::Symbol_Ptr_C(make_shared<Rete::Symbol_Constant_String>(*(yyvsp[0].sval))); delete (yyvsp[0].sval); }
-#line 2205 "rules.tab.cpp" /* yacc.c:1646  */
+#line 356 "rules.yyy" /* yacc.c:1646  */
+    { (yyval.symbol_ptr) = new Rete::Symbol_Ptr_C(Rete::Symbol_Constant_String::intern(*(yyvsp[0].sval))); delete (yyvsp[0].sval); }
+#line 1935 "rules.tab.cpp" /* yacc.c:1646  */
     break;
 
   case 47:
-#line 629 "rules.yyy" /* yacc.c:1646  */
+#line 359 "rules.yyy" /* yacc.c:1646  */
     { (yyval.fval) = double((yyvsp[0].ival)); }
-#line 2211 "rules.tab.cpp" /* yacc.c:1646  */
+#line 1941 "rules.tab.cpp" /* yacc.c:1646  */
     break;
 
   case 48:
-#line 630 "rules.yyy" /* yacc.c:1646  */
+#line 360 "rules.yyy" /* yacc.c:1646  */
     { (yyval.fval) = (yyvsp[0].fval); }
-#line 2217 "rules.tab.cpp" /* yacc.c:1646  */
+#line 1947 "rules.tab.cpp" /* yacc.c:1646  */
     break;
 
   case 49:
-#line 633 "rules.yyy" /* yacc.c:1646  */
+#line 363 "rules.yyy" /* yacc.c:1646  */
     { (yyval.sval) = (yyvsp[0].sval); }
-#line 2223 "rules.tab.cpp" /* yacc.c:1646  */
+#line 1953 "rules.tab.cpp" /* yacc.c:1646  */
     break;
 
   case 50:
-#line 634 "rules.yyy" /* yacc.c:1646  */
+#line 364 "rules.yyy" /* yacc.c:1646  */
     { (yyval.sval) = (yyvsp[0].sval); }
-#line 2229 "rules.tab.cpp" /* yacc.c:1646  */
+#line 1959 "rules.tab.cpp" /* yacc.c:1646  */
     break;
 
   case 51:
-#line 637 "rules.yyy" /* yacc.c:1646  */
+#line 367 "rules.yyy" /* yacc.c:1646  */
     { (yyval.sval) = (yyvsp[-1].sval); }
-#line 2235 "rules.tab.cpp" /* yacc.c:1646  */
+#line 1965 "rules.tab.cpp" /* yacc.c:1646  */
     break;
 
   case 52:
-#line 640 "rules.yyy" /* yacc.c:1646  */
+#line 370 "rules.yyy" /* yacc.c:1646  */
     { (yyval.sval) = (yyvsp[-1].sval); *(yyval.sval) += (yyvsp[0].cval); }
-#line 2241 "rules.tab.cpp" /* yacc.c:1646  */
+#line 1971 "rules.tab.cpp" /* yacc.c:1646  */
     break;
 
   case 53:
-#line 641 "rules.yyy" /* yacc.c:1646  */
+#line 371 "rules.yyy" /* yacc.c:1646  */
     { (yyval.sval) = (yyvsp[-1].sval); *(yyval.sval) += *(yyvsp[0].sval); delete (yyvsp[0].sval); }
-#line 2247 "rules.tab.cpp" /* yacc.c:1646  */
+#line 1977 "rules.tab.cpp" /* yacc.c:1646  */
     break;
 
   case 54:
-#line 642 "rules.yyy" /* yacc.c:1646  */
+#line 372 "rules.yyy" /* yacc.c:1646  */
     { (yyval.sval) = new string; *(yyval.sval) += (yyvsp[0].cval); }
-#line 2253 "rules.tab.cpp" /* yacc.c:1646  */
+#line 1983 "rules.tab.cpp" /* yacc.c:1646  */
     break;
 
   case 55:
-#line 643 "rules.yyy" /* yacc.c:1646  */
+#line 373 "rules.yyy" /* yacc.c:1646  */
     { (yyval.sval) = (yyvsp[0].sval); }
-#line 2259 "rules.tab.cpp" /* yacc.c:1646  */
+#line 1989 "rules.tab.cpp" /* yacc.c:1646  */
     break;
 
 
-#line 2263 "rules.tab.cpp" /* yacc.c:1646  */
+#line 1993 "rules.tab.cpp" /* yacc.c:1646  */
       default: break;
     }
   /* User semantic actions sometimes alter yychar, and that requires
@@ -2499,7 +2250,7 @@ yyreturn:
 #endif
   return yyresult;
 }
-#line 646 "rules.yyy" /* yacc.c:1906  */
+#line 376 "rules.yyy" /* yacc.c:1906  */
 
 
 #include "rete_parser.cxx"
@@ -40,6 +40,9 @@ project "carli"
       postbuildcommands { [[cp carli.dll marioai\classes\]] }
   end
 
+  configuration "linux"
+    linkoptions { "-pthread" }
+
   configuration { "macosx", "Debug*" }
     linkoptions { "-install_name @rpath/libcarli_d.dylib" }
   configuration { "macosx", "Release*" }
@@ -34,7 +34,6 @@ namespace Carli {
      primary_mean2(std::get<1>(value)),
      primary_variance(std::get<2>(value)),
      secondary(std::get<3>(value)),
-     eligible(this),
      feature(feature_)
     {
       update_totals();
@@ -86,8 +85,9 @@ namespace Carli {
     bool type_internal = false;
 
     /** Not cloned **/
-    bool eligibility_init = false;
-    double eligibility = -1.0;
+    int64_t creation_index = -1; ///< Orders Q-values wherever they are listed; set by the first Node to hold this one
+    int64_t eligible = -1; ///< Index into the agent's Eligibility_Trace, or -1 if not eligible
+    uint64_t updated = 0; ///< The agent's td_update count as of the last update to change this value
     double credit = 1.0;
   //  double weight = 1.0;
 
@@ -107,8 +107,6 @@ namespace Carli {
 
     double t0; ///< temp "register"
 
-    List eligible;
-
     tracked_ptr<Feature> feature;
 
   private:
@@ -8,18 +8,40 @@ namespace Rete {
 //#ifdef DEBUG_OUTPUT
 //    std::cerr << "Inserting " << *wme_token << std::endl;std::tuple<Rete_Action_Ptr_C, WME_Token_Ptr_C, bool>, Zeni::Pool_Allocator<std::tuple<Rete_Action_Ptr_C, WME_Token_Ptr_C, bool>>
 //#endif
-    agenda.insert(std::make_pair(action, wme_token));
+    if(Rete_Action_to_Agenda::agenda_slots(*action).emplace(wme_token.get(), int64_t(agenda.size())).second)
+      agenda.push_back(Activation{action, wme_token});
     run();
   }
 
   void Agenda::insert_retraction(const Rete_Action_Ptr_C &action, const WME_Token_Ptr_C &wme_token) {
-    const auto found = agenda.find(std::make_pair(action, wme_token));
-    if(found != agenda.end())
-      agenda.erase(found);
+    const int64_t slot = find(*action, wme_token);
+    if(slot != -1)
+      cancel(slot);
     else
       Rete_Action_to_Agenda::retraction(*action)(*action, *wme_token);
   }
 
+  void Agenda::insert_modification(const Rete_Action_Ptr_C &action, const WME_Token_Ptr_C &old_token, const WME_Token_Ptr_C &new_token) {
+    const int64_t slot = find(*action, old_token);
+    if(slot != -1) {
+      /// The old match never fired, so fire the new one in its place
+      auto &slots = Rete_Action_to_Agenda::agenda_slots(*action);
+      if(slots.emplace(new_token.get(), slot).second) {
+        slots.erase(old_token.get());
+        agenda[slot].wme_token = new_token;
+      }
+      else
+        cancel(slot);
+      run();
+    }
+    else if(const auto &modification = Rete_Action_to_Agenda::modification(*action))
+      modification(*action, *old_token, *new_token);
+    else {
+      Rete_Action_to_Agenda::retraction(*action)(*action, *old_token);
+      insert_action(action, new_token);
+    }
+  }
+
   void Agenda::lock() {
     ++m_locked;
     ++m_manually_locked;
@@ -36,15 +58,46 @@ namespace Rete {
       return;
     ++m_locked;
 
-    while(!agenda.empty()) {
-      const auto front_iterator = agenda.begin();
-      const auto front = *front_iterator;
-      agenda.erase(front_iterator);
-      Rete_Action_to_Agenda::action(*front.first)(*front.first, *front.second);
+    try {
+      while(m_next != int64_t(agenda.size())) {
+        const int64_t slot = m_next++;
+        if(!agenda[slot].action)
+          continue;
+        /// Copied out, since firing may grow the agenda
+        const Rete_Action_Ptr_C action = agenda[slot].action;
+        const WME_Token_Ptr_C wme_token = agenda[slot].wme_token;
+        cancel(slot);
+        Rete_Action_to_Agenda::action(*action)(*action, *wme_token);
+      }
+    }
+    catch(...) {
+      /// Activations left pending still fire the next time the agenda runs
+      --m_locked;
+      throw;
     }
 
+    agenda.clear();
+    m_next = 0;
+
     assert(m_locked);
     --m_locked;
   }
 
+  int64_t Agenda::find(const Rete_Action &action, const WME_Token_Ptr_C &wme_token) const {
+    const auto &slots = Rete_Action_to_Agenda::agenda_slots(action);
+    const auto found = slots.find(wme_token.get());
+    return found != slots.end() ? found->second : -1;
+  }
+
+  void Agenda::cancel(const int64_t &slot) {
+#ifndef NDEBUG
+    const size_t erased =
+#endif
+      Rete_Action_to_Agenda::agenda_slots(*agenda[slot].action).erase(agenda[slot].wme_token.get());
+    assert(erased == 1);
+
+    agenda[slot].action.reset();
+    agenda[slot].wme_token.reset();
+  }
+
 }
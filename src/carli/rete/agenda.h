@@ -5,13 +5,15 @@
 
 #include <cassert>
 #include <cstddef>
-#include <functional>
-#include <list>
+#include <exception>
+#include <vector>
 
 namespace Rete {
 
   class Rete_Node;
 
+  /// Fires activations in the order they were inserted
+  /// Each Rete_Action indexes the slots of its pending activations by token, so retractions find and cancel them in constant time
   class RETE_LINKAGE Agenda {
     Agenda(Agenda &);
     Agenda & operator=(Agenda &);
@@ -23,31 +25,45 @@ namespace Rete {
 
     public:
       Locker(Agenda &agenda)
-       : m_agenda(agenda)
+       : m_agenda(agenda),
+       m_uncaught(std::uncaught_exceptions())
       {
         m_agenda.lock();
       }
 
-      ~Locker() {
+      /// Actions may throw, but are not run while the stack unwinds from another exception
+      ~Locker() noexcept(false) {
         m_agenda.unlock();
-        m_agenda.run();
+        if(std::uncaught_exceptions() == m_uncaught)
+          m_agenda.run();
       }
 
     private:
       Agenda &m_agenda;
+      int m_uncaught;
     };
 
     Agenda() {}
 
     void insert_action(const Rete_Action_Ptr_C &action, const WME_Token_Ptr_C &wme_token);
     void insert_retraction(const Rete_Action_Ptr_C &action, const WME_Token_Ptr_C &wme_token);
+    void insert_modification(const Rete_Action_Ptr_C &action, const WME_Token_Ptr_C &old_token, const WME_Token_Ptr_C &new_token);
 
     void lock();
     void unlock();
     void run();
 
   private:
-    std::unordered_set<std::pair<Rete_Action_Ptr_C, WME_Token_Ptr_C>> agenda;
+    struct Activation {
+      Rete_Action_Ptr_C action; ///< Null once fired or cancelled
+      WME_Token_Ptr_C wme_token;
+    };
+
+    int64_t find(const Rete_Action &action, const WME_Token_Ptr_C &wme_token) const; ///< Slot of a pending activation, or -1
+    void cancel(const int64_t &slot); ///< Releases the activation and unlinks it from its action
+
+    std::vector<Activation> agenda; ///< Cleared once drained, retaining its capacity
+    int64_t m_next = 0; ///< Slot of the next activation to fire
     int64_t m_locked = 0;
     int64_t m_manually_locked = 0;
   };
@@ -0,0 +1,269 @@
+#ifndef RETE_INTRUSIVE_PTR_H
+#define RETE_INTRUSIVE_PTR_H
+
+#include "../utility/memory_pool.h"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+
+namespace Rete {
+
+  template <typename T>
+  class Intrusive_Ptr;
+  template <typename T>
+  class Intrusive_Weak_Ptr;
+
+  /// Base for objects owned through Intrusive_Ptr; the count is deliberately non-atomic since each agent is single-threaded
+  class Intrusive_Counted {
+    template <typename T>
+    friend class Intrusive_Ptr;
+
+  public:
+    Intrusive_Counted() {}
+
+    int64_t use_count() const {return m_use_count;}
+
+  protected:
+    /// A copy is a new object, counted from zero as std::enable_shared_from_this would have it
+    Intrusive_Counted(const Intrusive_Counted &) {}
+    Intrusive_Counted & operator=(const Intrusive_Counted &) {return *this;}
+
+    ~Intrusive_Counted() {}
+
+  private:
+    void expire() const {}
+
+    mutable int64_t m_use_count = 0;
+  };
+
+  /// Outlives its object for as long as any Intrusive_Weak_Ptr refers to it
+  struct Intrusive_Weak_Count : public Zeni::Pool_Allocator<Intrusive_Weak_Count> {
+    bool expired = false;
+    int64_t count = 1; ///< Intrusive_Weak_Ptrs, plus one for the object while it lives
+  };
+
+  /// Base for objects that Intrusive_Weak_Ptr can also refer to; the shared count is allocated by the first of them
+  class Intrusive_Weak_Counted : public Intrusive_Counted {
+    template <typename T>
+    friend class Intrusive_Ptr;
+    template <typename T>
+    friend class Intrusive_Weak_Ptr;
+
+  public:
+    Intrusive_Weak_Counted() {}
+
+  protected:
+    Intrusive_Weak_Counted(const Intrusive_Weak_Counted &) : Intrusive_Counted() {}
+    Intrusive_Weak_Counted & operator=(const Intrusive_Weak_Counted &) {return *this;}
+
+    ~Intrusive_Weak_Counted() {
+      if(m_weak) {
+        m_weak->expired = true;
+        if(!--m_weak->count)
+          delete m_weak;
+      }
+    }
+
+  private:
+    /// Called as the last Intrusive_Ptr lets go, so that no Intrusive_Weak_Ptr can lock the object during its destruction
+    void expire() const {
+      if(m_weak)
+        m_weak->expired = true;
+    }
+
+    Intrusive_Weak_Count * weak_count() const {
+      if(!m_weak)
+        m_weak = new Intrusive_Weak_Count;
+      return m_weak;
+    }
+
+    mutable Intrusive_Weak_Count * m_weak = nullptr;
+  };
+
+  /// A subset of the std::shared_ptr interface over an Intrusive_Counted object, with no separate control block
+  template <typename T>
+  class Intrusive_Ptr {
+    template <typename U>
+    friend class Intrusive_Ptr;
+
+  public:
+    typedef T element_type;
+
+    Intrusive_Ptr() : m_ptr(nullptr) {}
+    Intrusive_Ptr(std::nullptr_t) : m_ptr(nullptr) {}
+    explicit Intrusive_Ptr(T * const &ptr) : m_ptr(ptr) {retain();}
+
+    Intrusive_Ptr(const Intrusive_Ptr &rhs) : m_ptr(rhs.m_ptr) {retain();}
+    Intrusive_Ptr(Intrusive_Ptr &&rhs) : m_ptr(rhs.m_ptr) {rhs.m_ptr = nullptr;}
+    template <typename U>
+    Intrusive_Ptr(const Intrusive_Ptr<U> &rhs) : m_ptr(rhs.m_ptr) {retain();}
+    template <typename U>
+    Intrusive_Ptr(Intrusive_Ptr<U> &&rhs) : m_ptr(rhs.m_ptr) {rhs.m_ptr = nullptr;}
+
+    ~Intrusive_Ptr() {release();}
+
+    Intrusive_Ptr & operator=(Intrusive_Ptr rhs) {
+      std::swap(m_ptr, rhs.m_ptr);
+      return *this;
+    }
+
+    void reset() {
+      release();
+      m_ptr = nullptr;
+    }
+
+    /// Give up ownership without releasing, e.g. for a handle to an object that does not live on the heap
+    T * detach() {
+      T * const ptr = m_ptr;
+      m_ptr = nullptr;
+      return ptr;
+    }
+
+    T * get() const {return m_ptr;}
+    T & operator*() const {assert(m_ptr); return *m_ptr;}
+    T * operator->() const {assert(m_ptr); return m_ptr;}
+    explicit operator bool() const {return m_ptr != nullptr;}
+
+    int64_t use_count() const {return m_ptr ? m_ptr->use_count() : 0;}
+
+  private:
+    void retain() const {
+      if(m_ptr)
+        ++m_ptr->m_use_count;
+    }
+
+    void release() const {
+      if(m_ptr && !--m_ptr->m_use_count) {
+        m_ptr->expire();
+        delete m_ptr;
+      }
+    }
+
+    T * m_ptr;
+  };
+
+  /// A subset of the std::weak_ptr interface over an Intrusive_Weak_Counted object
+  template <typename T>
+  class Intrusive_Weak_Ptr {
+    template <typename U>
+    friend class Intrusive_Weak_Ptr;
+
+  public:
+    Intrusive_Weak_Ptr() : m_ptr(nullptr), m_count(nullptr) {}
+    template <typename U>
+    Intrusive_Weak_Ptr(const Intrusive_Ptr<U> &rhs) : m_ptr(rhs.get()), m_count(m_ptr ? m_ptr->weak_count() : nullptr) {retain();}
+
+    Intrusive_Weak_Ptr(const Intrusive_Weak_Ptr &rhs) : m_ptr(rhs.m_ptr), m_count(rhs.m_count) {retain();}
+    template <typename U>
+    Intrusive_Weak_Ptr(const Intrusive_Weak_Ptr<U> &rhs) : m_ptr(rhs.m_ptr), m_count(rhs.m_count) {retain();}
+
+    ~Intrusive_Weak_Ptr() {release();}
+
+    Intrusive_Weak_Ptr & operator=(Intrusive_Weak_Ptr rhs) {
+      std::swap(m_ptr, rhs.m_ptr);
+      std::swap(m_count, rhs.m_count);
+      return *this;
+    }
+
+    void reset() {
+      release();
+      m_ptr = nullptr;
+      m_count = nullptr;
+    }
+
+    bool expired() const {return !m_count || m_count->expired;}
+    Intrusive_Ptr<T> lock() const {return expired() ? Intrusive_Ptr<T>() : Intrusive_Ptr<T>(m_ptr);}
+
+  private:
+    void retain() const {
+      if(m_count)
+        ++m_count->count;
+    }
+
+    void release() const {
+      if(m_count && !--m_count->count)
+        delete m_count;
+    }
+
+    T * m_ptr;
+    Intrusive_Weak_Count * m_count;
+  };
+
+  template <typename T, typename U>
+  bool operator==(const Intrusive_Ptr<T> &lhs, const Intrusive_Ptr<U> &rhs) {return lhs.get() == rhs.get();}
+  template <typename T, typename U>
+  bool operator!=(const Intrusive_Ptr<T> &lhs, const Intrusive_Ptr<U> &rhs) {return lhs.get() != rhs.get();}
+  template <typename T, typename U>
+  bool operator<(const Intrusive_Ptr<T> &lhs, const Intrusive_Ptr<U> &rhs) {return std::less<const void *>()(lhs.get(), rhs.get());}
+  template <typename T>
+  bool operator==(const Intrusive_Ptr<T> &lhs, std::nullptr_t) {return !lhs;}
+  template <typename T>
+  bool operator!=(const Intrusive_Ptr<T> &lhs, std::nullptr_t) {return bool(lhs);}
+  template <typename T>
+  bool operator==(std::nullptr_t, const Intrusive_Ptr<T> &rhs) {return !rhs;}
+  template <typename T>
+  bool operator!=(std::nullptr_t, const Intrusive_Ptr<T> &rhs) {return bool(rhs);}
+
+  template <typename T, typename... Args>
+  Intrusive_Ptr<T> make_intrusive(Args &&... args) {
+    return Intrusive_Ptr<T>(new T(std::forward<Args>(args)...));
+  }
+
+  /// Rete::*_pointer_cast accept either handle, so that callers compile whichever the build selects
+  using std::const_pointer_cast;
+  using std::dynamic_pointer_cast;
+  using std::static_pointer_cast;
+
+  template <typename T, typename U>
+  Intrusive_Ptr<T> const_pointer_cast(const Intrusive_Ptr<U> &ptr) {
+    return Intrusive_Ptr<T>(const_cast<T *>(ptr.get()));
+  }
+
+  template <typename T, typename U>
+  Intrusive_Ptr<T> dynamic_pointer_cast(const Intrusive_Ptr<U> &ptr) {
+    return Intrusive_Ptr<T>(dynamic_cast<T *>(ptr.get()));
+  }
+
+  template <typename T, typename U>
+  Intrusive_Ptr<T> static_pointer_cast(const Intrusive_Ptr<U> &ptr) {
+    return Intrusive_Ptr<T>(static_cast<T *>(ptr.get()));
+  }
+
+  /// Handles to symbols, WMEs, tokens and nodes: non-atomic Intrusive_Ptrs with --intrusive-ptr=true, std::shared_ptrs otherwise
+#ifdef RETE_INTRUSIVE_PTR
+  template <typename T>
+  using Shared_Ptr = Intrusive_Ptr<T>;
+  template <typename T>
+  using Weak_Ptr = Intrusive_Weak_Ptr<T>;
+#else
+  template <typename T>
+  using Shared_Ptr = std::shared_ptr<T>;
+  template <typename T>
+  using Weak_Ptr = std::weak_ptr<T>;
+#endif
+
+  /// Allocate from the Pool_Allocator of TYPE, under whichever handle the build selects
+  template <typename TYPE, typename... Args>
+  Shared_Ptr<TYPE> make_pooled(Args &&... args) {
+#ifdef RETE_INTRUSIVE_PTR
+    return make_intrusive<TYPE>(std::forward<Args>(args)...);
+#else
+    return std::allocate_shared<TYPE>(Zeni::Pool_Allocator<TYPE>(), std::forward<Args>(args)...);
+#endif
+  }
+
+}
+
+namespace std {
+  template <typename T> struct hash<Rete::Intrusive_Ptr<T>> {
+    size_t operator()(const Rete::Intrusive_Ptr<T> &ptr) const {
+      return std::hash<T *>()(ptr.get());
+    }
+  };
+}
+
+#endif
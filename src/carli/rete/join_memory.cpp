@@ -0,0 +1,299 @@
+#include "join_memory.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace Rete {
+
+  /// Buckets beyond this size, e.g. those of joins that bind nothing, find tokens through a Token_Index
+  static const size_t g_index_threshold = 32;
+
+  bool Join_Memory::Match::insert(const bool &from_left, const WME_Token_Ptr_C &token) {
+    if(find(from_left, *token) >= 0)
+      return false;
+
+    Token_Vector &tokens = from_left ? first : second;
+    Token_Index &index = from_left ? first_index : second_index;
+    tokens.push_back(token);
+    if(index.built())
+      index.insert(tokens, tokens.size() - 1);
+    else if(tokens.size() > g_index_threshold)
+      index.build(tokens);
+
+    return true;
+  }
+
+  int64_t Join_Memory::Match::find(const bool &from_left, const WME_Token &token) const {
+    const Token_Vector &tokens = from_left ? first : second;
+    const Token_Index &index = from_left ? first_index : second_index;
+    if(index.built())
+      return index.find(tokens, token);
+
+    for(size_t i = 0, iend = tokens.size(); i != iend; ++i) {
+      if(*tokens[i] == token)
+        return int64_t(i);
+    }
+    return -1;
+  }
+
+  void Join_Memory::Match::erase(const bool &from_left, const size_t &position) {
+    Token_Vector &tokens = from_left ? first : second;
+    Token_Index &index = from_left ? first_index : second_index;
+    assert(position < tokens.size());
+    const size_t last = tokens.size() - 1;
+
+    if(index.built()) {
+      index.erase(tokens, position);
+      if(position != last)
+        index.relabel(tokens, last, position);
+    }
+
+    if(position != last)
+      tokens[position] = std::move(tokens[last]);
+    tokens.pop_back();
+
+    if(from_left) {
+      if(!outputs.empty()) {
+        if(position != last)
+          outputs[position] = std::move(outputs[last]);
+        outputs.pop_back();
+      }
+    }
+    else {
+      for(auto &row : outputs) {
+        if(position != last)
+          row[position] = std::move(row[last]);
+        row.pop_back();
+      }
+    }
+  }
+
+  void Join_Memory::Match::replace(const bool &from_left, const size_t &position, const WME_Token_Ptr_C &token) {
+    Token_Vector &tokens = from_left ? first : second;
+    Token_Index &index = from_left ? first_index : second_index;
+    assert(position < tokens.size());
+
+    if(index.built())
+      index.erase(tokens, position);
+    tokens[position] = token;
+    if(index.built())
+      index.insert(tokens, position);
+  }
+
+  void Join_Memory::Token_Index::build(const Token_Vector &tokens) {
+    size_t size = 16;
+    while(size < 2 * tokens.size())
+      size *= 2;
+    m_shift = 64;
+    for(size_t s = size; s > 1; s >>= 1)
+      --m_shift;
+
+    m_slots.assign(size, 0u);
+    for(size_t position = 0, pend = tokens.size(); position != pend; ++position)
+      place(tokens[position]->get_hash(), position);
+  }
+
+  int64_t Join_Memory::Token_Index::find(const Token_Vector &tokens, const WME_Token &token) const {
+    const size_t mask = m_slots.size() - 1;
+    for(size_t slot = home(token.get_hash()); m_slots[slot]; slot = (slot + 1) & mask) {
+      const size_t position = m_slots[slot] - 1;
+      if(*tokens[position] == token)
+        return int64_t(position);
+    }
+    return -1;
+  }
+
+  void Join_Memory::Token_Index::insert(const Token_Vector &tokens, const size_t &position) {
+    if(2 * tokens.size() > m_slots.size())
+      build(tokens);
+    else
+      place(tokens[position]->get_hash(), position);
+  }
+
+  void Join_Memory::Token_Index::erase(const Token_Vector &tokens, const size_t &position) {
+    /// Backward shift deletion, as in Join_Memory::erase
+    const size_t mask = m_slots.size() - 1;
+    size_t hole = slot_of(tokens, position);
+    m_slots[hole] = 0;
+    for(size_t slot = (hole + 1) & mask; m_slots[slot]; slot = (slot + 1) & mask) {
+      const size_t desired = home(tokens[m_slots[slot] - 1]->get_hash());
+      if(((slot - desired) & mask) >= ((slot - hole) & mask)) {
+        m_slots[hole] = m_slots[slot];
+        m_slots[slot] = 0;
+        hole = slot;
+      }
+    }
+  }
+
+  void Join_Memory::Token_Index::relabel(const Token_Vector &tokens, const size_t &from, const size_t &to) {
+    m_slots[slot_of(tokens, from)] = uint32_t(to + 1);
+  }
+
+  size_t Join_Memory::Token_Index::home(const size_t &hash) const {
+    return size_t((uint64_t(hash) * 0x9E3779B97F4A7C15ull) >> m_shift);
+  }
+
+  size_t Join_Memory::Token_Index::slot_of(const Token_Vector &tokens, const size_t &position) const {
+    const size_t mask = m_slots.size() - 1;
+    size_t slot = home(tokens[position]->get_hash());
+    while(m_slots[slot] != position + 1)
+      slot = (slot + 1) & mask;
+    return slot;
+  }
+
+  void Join_Memory::Token_Index::place(const size_t &hash, const size_t &position) {
+    const size_t mask = m_slots.size() - 1;
+    size_t slot = home(hash);
+    while(m_slots[slot])
+      slot = (slot + 1) & mask;
+    m_slots[slot] = uint32_t(position + 1);
+  }
+
+  Join_Memory::Join_Memory(const WME_Bindings &bindings) {
+    m_left.reserve(bindings.size());
+    m_right.reserve(bindings.size());
+    for(const auto &binding : bindings) {
+      m_left.push_back(binding.first);
+      m_right.push_back(binding.second);
+    }
+  }
+
+  Join_Memory::Match & Join_Memory::insert(const WME_Token_Ptr_C &token, const bool &from_left) {
+    const size_t hash = hash_key(*token, from_left);
+    const int64_t found = probe(hash, *token, from_left);
+    if(found >= 0)
+      return m_entries[size_t(found)];
+
+    if(2 * (m_entries.size() + 1) > m_slots.size())
+      grow();
+
+    m_entries.emplace_back(hash, token, from_left);
+    size_t slot = home(hash);
+    while(m_slots[slot])
+      slot = (slot + 1) & (m_slots.size() - 1);
+    m_slots[slot] = uint32_t(m_entries.size());
+
+    return m_entries.back();
+  }
+
+  Join_Memory::Match * Join_Memory::find(const WME_Token &token, const bool &from_left) {
+    const int64_t found = probe(hash_key(token, from_left), token, from_left);
+    return found >= 0 ? &m_entries[size_t(found)] : nullptr;
+  }
+
+  void Join_Memory::erase(Match * const &match) {
+    assert(match && match->empty());
+    const size_t index = size_t(static_cast<Entry *>(match) - m_entries.data());
+    assert(index < m_entries.size());
+
+    /// Backward shift deletion keeps probe sequences intact without tombstones
+    const size_t mask = m_slots.size() - 1;
+    size_t hole = slot_of(index);
+    m_slots[hole] = 0;
+    for(size_t slot = (hole + 1) & mask; m_slots[slot]; slot = (slot + 1) & mask) {
+      const size_t desired = home(m_entries[m_slots[slot] - 1].hash);
+      if(((slot - desired) & mask) >= ((slot - hole) & mask)) {
+        m_slots[hole] = m_slots[slot];
+        m_slots[slot] = 0;
+        hole = slot;
+      }
+    }
+
+    /// Keep m_entries dense by moving the last entry into the vacancy
+    const size_t last = m_entries.size() - 1;
+    if(index != last) {
+      m_slots[slot_of(last)] = uint32_t(index + 1);
+      m_entries[index] = std::move(m_entries[last]);
+    }
+    m_entries.pop_back();
+  }
+
+  void Join_Memory::clear() {
+    m_entries.clear();
+    std::fill(m_slots.begin(), m_slots.end(), 0u);
+  }
+
+  template <int64_t ARITY>
+  size_t Join_Memory::hash_key(const WME_Token &token, const bool &from_left) const {
+    const WME_Token_Index * const indices = from_left ? m_left.data() : m_right.data();
+    const int64_t arity = ARITY >= 0 ? ARITY : int64_t(m_left.size());
+    size_t hash = 0;
+    for(int64_t i = 0; i != arity; ++i)
+      hash = hash_combine(hash, token[indices[i]]->hash());
+    return hash;
+  }
+
+  template <int64_t ARITY>
+  bool Join_Memory::equal_key(const Entry &entry, const WME_Token &token, const bool &from_left) const {
+    const WME_Token_Index * const lhs_indices = entry.key_from_left ? m_left.data() : m_right.data();
+    const WME_Token_Index * const rhs_indices = from_left ? m_left.data() : m_right.data();
+    const int64_t arity = ARITY >= 0 ? ARITY : int64_t(m_left.size());
+    for(int64_t i = 0; i != arity; ++i) {
+      if(*(*entry.key)[lhs_indices[i]] != *token[rhs_indices[i]])
+        return false;
+    }
+    return true;
+  }
+
+  template <int64_t ARITY>
+  int64_t Join_Memory::probe(const size_t &hash, const WME_Token &token, const bool &from_left) const {
+    if(m_entries.empty())
+      return -1;
+    const size_t mask = m_slots.size() - 1;
+    for(size_t slot = home(hash); m_slots[slot]; slot = (slot + 1) & mask) {
+      const size_t index = m_slots[slot] - 1;
+      const Entry &entry = m_entries[index];
+      if(entry.hash == hash && equal_key<ARITY>(entry, token, from_left))
+        return int64_t(index);
+    }
+    return -1;
+  }
+
+  size_t Join_Memory::hash_key(const WME_Token &token, const bool &from_left) const {
+    switch(m_left.size()) {
+      case 0: return 0;
+      case 1: return hash_key<1>(token, from_left);
+      case 2: return hash_key<2>(token, from_left);
+      case 3: return hash_key<3>(token, from_left);
+      default: return hash_key<-1>(token, from_left);
+    }
+  }
+
+  int64_t Join_Memory::probe(const size_t &hash, const WME_Token &token, const bool &from_left) const {
+    switch(m_left.size()) {
+      case 0: return probe<0>(hash, token, from_left);
+      case 1: return probe<1>(hash, token, from_left);
+      case 2: return probe<2>(hash, token, from_left);
+      case 3: return probe<3>(hash, token, from_left);
+      default: return probe<-1>(hash, token, from_left);
+    }
+  }
+
+  size_t Join_Memory::home(const size_t &hash) const {
+    return size_t((uint64_t(hash) * 0x9E3779B97F4A7C15ull) >> m_shift);
+  }
+
+  size_t Join_Memory::slot_of(const size_t &entry) const {
+    const size_t mask = m_slots.size() - 1;
+    size_t slot = home(m_entries[entry].hash);
+    while(m_slots[slot] != entry + 1)
+      slot = (slot + 1) & mask;
+    return slot;
+  }
+
+  void Join_Memory::grow() {
+    const size_t size = m_slots.empty() ? 8 : 2 * m_slots.size();
+    m_shift = 64;
+    for(size_t s = size; s > 1; s >>= 1)
+      --m_shift;
+
+    m_slots.assign(size, 0u);
+    for(size_t index = 0, iend = m_entries.size(); index != iend; ++index) {
+      size_t slot = home(m_entries[index].hash);
+      while(m_slots[slot])
+        slot = (slot + 1) & (size - 1);
+      m_slots[slot] = uint32_t(index + 1);
+    }
+  }
+
+}
@@ -0,0 +1,109 @@
+#ifndef RETE_JOIN_MEMORY_H
+#define RETE_JOIN_MEMORY_H
+
+#include "wme_token.h"
+
+#include <vector>
+
+namespace Rete {
+
+  /// Beta memory shared by the join nodes: tokens from both inputs, bucketed by the symbols they bind
+  class RETE_LINKAGE Join_Memory {
+    Join_Memory(const Join_Memory &);
+    Join_Memory & operator=(const Join_Memory &);
+
+  public:
+    typedef std::vector<WME_Token_Ptr_C> Token_Vector;
+
+    /// Open addressing table of 1 + positions into the tokens of one input, built once they outgrow a linear scan
+    class Token_Index {
+    public:
+      bool built() const {return !m_slots.empty();}
+
+      void build(const Token_Vector &tokens);
+      int64_t find(const Token_Vector &tokens, const WME_Token &token) const;
+      /// Index tokens[position], which has just been added
+      void insert(const Token_Vector &tokens, const size_t &position);
+      /// Unindex tokens[position] while it is still present
+      void erase(const Token_Vector &tokens, const size_t &position);
+      /// Record that tokens[from] is about to move to position to
+      void relabel(const Token_Vector &tokens, const size_t &from, const size_t &to);
+
+    private:
+      size_t home(const size_t &hash) const;
+      size_t slot_of(const Token_Vector &tokens, const size_t &position) const;
+      void place(const size_t &hash, const size_t &position);
+
+      std::vector<uint32_t> m_slots;
+      int m_shift = 64;
+    };
+
+    struct Match {
+      Token_Vector first; ///< Tokens from the left input
+      Token_Vector second; ///< Tokens from the right input
+      std::vector<Token_Vector> outputs; ///< Rete_Join only: outputs[i][j] is the join of first[i] and second[j]
+
+      bool empty() const {return first.empty() && second.empty();}
+
+      /// Return false if the token was already present
+      bool insert(const bool &from_left, const WME_Token_Ptr_C &token);
+      /// Get the position of the token, or -1
+      int64_t find(const bool &from_left, const WME_Token &token) const;
+      /// Move the last token of the input, and its outputs, into the vacated position
+      void erase(const bool &from_left, const size_t &position);
+      /// Substitute a token for the one at the position
+      void replace(const bool &from_left, const size_t &position, const WME_Token_Ptr_C &token);
+
+    private:
+      Token_Index first_index;
+      Token_Index second_index;
+    };
+
+    Join_Memory(const WME_Bindings &bindings);
+
+    /// Get the Match for the token's bound symbols, creating it if needed; invalidated by subsequent insert/erase
+    Match & insert(const WME_Token_Ptr_C &token, const bool &from_left);
+    /// Get the Match for the token's bound symbols, or nullptr
+    Match * find(const WME_Token &token, const bool &from_left);
+    /// Release a Match that has been emptied
+    void erase(Match * const &match);
+
+    void clear();
+
+  private:
+    struct Entry : public Match {
+      Entry(const size_t &hash_, const WME_Token_Ptr_C &key_, const bool &key_from_left_)
+        : hash(hash_), key(key_), key_from_left(key_from_left_)
+      {
+      }
+
+      size_t hash;
+      WME_Token_Ptr_C key; ///< Supplies the bound symbols for the lifetime of the Entry
+      bool key_from_left;
+    };
+
+    template <int64_t ARITY>
+    size_t hash_key(const WME_Token &token, const bool &from_left) const;
+    template <int64_t ARITY>
+    bool equal_key(const Entry &entry, const WME_Token &token, const bool &from_left) const;
+    template <int64_t ARITY>
+    int64_t probe(const size_t &hash, const WME_Token &token, const bool &from_left) const;
+
+    size_t hash_key(const WME_Token &token, const bool &from_left) const;
+    int64_t probe(const size_t &hash, const WME_Token &token, const bool &from_left) const;
+
+    size_t home(const size_t &hash) const;
+    size_t slot_of(const size_t &entry) const;
+    void grow();
+
+    std::vector<WME_Token_Index> m_left; ///< Binding indices into tokens from the left input
+    std::vector<WME_Token_Index> m_right; ///< Binding indices into tokens from the right input
+
+    std::vector<Entry> m_entries;
+    std::vector<uint32_t> m_slots; ///< Open addressing (linear probing) table of 1 + indices into m_entries; 0 marks an empty slot
+    int m_shift = 64;
+  };
+
+}
+
+#endif
@@ -5,6 +5,7 @@
 #include "rete_existential.h"
 #include "rete_existential_join.h"
 #include "rete_filter.h"
+#include "rete_interval.h"
 #include "rete_join.h"
 #include "rete_negation.h"
 #include "rete_negation_join.h"
@@ -12,15 +13,15 @@
 
 namespace Rete {
   inline void __rete_node_size_check() {
-    typedef Rete_Node::value_type pool_allocator_type;
-    static_assert(sizeof(pool_allocator_type) >= sizeof(Rete_Action), "Pool size suboptimal.");
-    static_assert(sizeof(pool_allocator_type) >= sizeof(Rete_Existential), "Pool size suboptimal.");
-    static_assert(sizeof(pool_allocator_type) >= sizeof(Rete_Existential_Join), "Pool size suboptimal.");
-    static_assert(sizeof(pool_allocator_type) >= sizeof(Rete_Filter), "Pool size suboptimal.");
-    static_assert(sizeof(pool_allocator_type) >= sizeof(Rete_Join), "Pool size suboptimal.");
-    static_assert(sizeof(pool_allocator_type) >= sizeof(Rete_Negation), "Pool size suboptimal.");
-    static_assert(sizeof(pool_allocator_type) >= sizeof(Rete_Negation_Join), "Pool size suboptimal.");
-    static_assert(sizeof(pool_allocator_type) >= sizeof(Rete_Predicate), "Pool size suboptimal.");
+    static_assert(Zeni::Pool_Map::is_small(sizeof(Rete_Action)), "Pool lookup hashed.");
+    static_assert(Zeni::Pool_Map::is_small(sizeof(Rete_Existential)), "Pool lookup hashed.");
+    static_assert(Zeni::Pool_Map::is_small(sizeof(Rete_Existential_Join)), "Pool lookup hashed.");
+    static_assert(Zeni::Pool_Map::is_small(sizeof(Rete_Filter)), "Pool lookup hashed.");
+    static_assert(Zeni::Pool_Map::is_small(sizeof(Rete_Interval)), "Pool lookup hashed.");
+    static_assert(Zeni::Pool_Map::is_small(sizeof(Rete_Join)), "Pool lookup hashed.");
+    static_assert(Zeni::Pool_Map::is_small(sizeof(Rete_Negation)), "Pool lookup hashed.");
+    static_assert(Zeni::Pool_Map::is_small(sizeof(Rete_Negation_Join)), "Pool lookup hashed.");
+    static_assert(Zeni::Pool_Map::is_small(sizeof(Rete_Predicate)), "Pool lookup hashed.");
   }
 }
 
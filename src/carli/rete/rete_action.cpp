@@ -99,6 +99,24 @@ namespace Rete {
     return input_tokens.empty();
   }
 
+  bool Rete_Action::modify_wme_token(Rete_Agent &agent, const WME_Token_Ptr_C &old_token, const WME_Token_Ptr_C &new_token, const Rete_Node * const &from) {
+    assert(from == input);
+
+    auto found = input_tokens.find(old_token);
+    if(found == input_tokens.end()) {
+      insert_wme_token(agent, new_token, from);
+      return false;
+    }
+
+    const WME_Token_Ptr_C modified = *found;
+    input_tokens.erase(found);
+    const auto inserted = input_tokens.insert(new_token);
+
+    agent.get_agenda().insert_modification(debuggable_pointer_cast<Rete_Action>(shared()), modified, *inserted.first);
+
+    return false;
+  }
+
   bool Rete_Action::matches_wme_token(const WME_Token_Ptr_C &wme_token) const {
     return input_tokens.find(wme_token) != input_tokens.end();
   }
@@ -176,7 +194,7 @@ namespace Rete {
 
   Rete_Action_Ptr Rete_Action::find_existing(const Action &/*action_*/, const Action &/*retraction_*/, const Rete_Node_Ptr &/*out*/) {
 //       for(auto &o : out->get_outputs()) {
-//         if(auto existing_action = std::dynamic_pointer_cast<Rete_Action>(o)) {
+//         if(auto existing_action = dynamic_pointer_cast<Rete_Action>(o)) {
 //           if(action_ == existing_action->action && retraction_ == existing_action->retraction)
 //             return existing_action;
 //         }
@@ -189,6 +207,8 @@ namespace Rete {
     assert(action && !action->input);
     action->input = out.get();
     action->variables = variables;
+    if(variables)
+      variables->resolve();
     action->height = out->get_height() + 1;
     action->token_owner = out->get_token_owner();
     action->size = out->get_size();
@@ -3,6 +3,8 @@
 
 #include "rete_node.h"
 
+#include <unordered_map>
+
 namespace Rete {
 
   class RETE_LINKAGE Rete_Action : public Rete_Node {
@@ -14,6 +16,8 @@ namespace Rete {
 
   public:
     typedef std::function<void (const Rete_Action &rete_action, const WME_Token &wme_token)> Action;
+    typedef std::function<void (const Rete_Action &rete_action, const WME_Token &old_token, const WME_Token &new_token)> Modification;
+    typedef std::unordered_map<const WME_Token *, int64_t, std::hash<const WME_Token *>, std::equal_to<const WME_Token *>, Zeni::Pool_Allocator<std::pair<const WME_Token * const, int64_t>>> Agenda_Slots;
 
     Rete_Action(const std::string &name_,
                 const Action &action_ = [](const Rete_Action &, const WME_Token &){},
@@ -36,6 +40,7 @@ namespace Rete {
 
     void insert_wme_token(Rete_Agent &agent, const WME_Token_Ptr_C &wme_token, const Rete_Node * const &from) override;
     bool remove_wme_token(Rete_Agent &agent, const WME_Token_Ptr_C &wme_token, const Rete_Node * const &from) override;
+    bool modify_wme_token(Rete_Agent &agent, const WME_Token_Ptr_C &old_token, const WME_Token_Ptr_C &new_token, const Rete_Node * const &from) override;
     bool matches_wme_token(const WME_Token_Ptr_C &wme_token) const;
 
     void pass_tokens(Rete_Agent &agent, Rete_Node * const &) override;
@@ -67,6 +72,11 @@ namespace Rete {
       retraction = retraction_;
     }
 
+    /// Without a modification, a modified match is retracted and then fired again
+    void set_modification(const Modification &modification_) {
+      modification = modification_;
+    }
+
   private:
     Rete_Node * input = nullptr;
     Variable_Indices_Ptr_C variables;
@@ -74,6 +84,8 @@ namespace Rete {
     const std::string name;
     Action action;
     Action retraction;
+    Modification modification;
+    mutable Agenda_Slots agenda_slots; ///< Slots of this action's pending activations on the Agenda, by token
     bool excised = false;
   };
 
@@ -89,6 +101,14 @@ namespace Rete {
     static const Rete_Action::Action & retraction(const Rete_Action &rete_action) {
       return rete_action.retraction;
     }
+
+    static const Rete_Action::Modification & modification(const Rete_Action &rete_action) {
+      return rete_action.modification;
+    }
+
+    static Rete_Action::Agenda_Slots & agenda_slots(const Rete_Action &rete_action) {
+      return rete_action.agenda_slots;
+    }
   };
 
 }
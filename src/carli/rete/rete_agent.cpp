@@ -1,5 +1,6 @@
 #include "rete_agent.h"
 
+#include <algorithm>
 #include <iostream>
 #include <map>
 
@@ -20,7 +21,20 @@ namespace Rete {
     }
   }
 
-  Rete_Agent::Rete_Agent()
+  size_t Rete_Agent::Alpha_Hash::operator()(const Alpha_Key &key) const {
+    return hash_combine(hash_combine(key[0] ? key[0]->hash() : 0, key[1] ? key[1]->hash() : 0), key[2] ? key[2]->hash() : 0);
+  }
+
+  bool Rete_Agent::Alpha_Eq::operator()(const Alpha_Key &lhs, const Alpha_Key &rhs) const {
+    for(int i = 0; i != 3; ++i) {
+      if(lhs[i] != rhs[i] && (!lhs[i] || !rhs[i] || *lhs[i] != *rhs[i]))
+        return false;
+    }
+    return true;
+  }
+
+  Rete_Agent::Rete_Agent(Zeni::Runtime_Context &context)
+   : m_context(context)
   {
   }
 
@@ -34,7 +48,7 @@ namespace Rete {
     if(auto existing = Rete_Action::find_existing(action, [](const Rete_Action &, const WME_Token &){}, out))
       return existing;
 //      std::cerr << "DEBUG: make_action" << std::endl;
-    auto action_fun = std::make_shared<Rete_Action>(name, action, [](const Rete_Action &, const WME_Token &){});
+    auto action_fun = make_pooled<Rete_Action>(name, action, [](const Rete_Action &, const WME_Token &){});
     bind_to_action(*this, action_fun, out, variables);
 //      std::cerr << "END: make_action" << std::endl;
     source_rule(action_fun, user_action);
@@ -47,7 +61,7 @@ namespace Rete {
 
     if(auto existing = Rete_Action::find_existing(action, retraction, out))
       return existing;
-    auto action_fun = std::make_shared<Rete_Action>(name, action, retraction);
+    auto action_fun = make_pooled<Rete_Action>(name, action, retraction);
     bind_to_action(*this, action_fun, out, variables);
     source_rule(action_fun, user_action);
     return action_fun;
@@ -56,9 +70,9 @@ namespace Rete {
   Rete_Existential_Ptr Rete_Agent::make_existential(const Rete_Node_Ptr &out) {
     CPU_Accumulator cpu_accumulator(*this);
 
-    if(auto existing = Rete_Existential::find_existing(out))
+    if(auto existing = Rete_Existential::find_existing(*this, out))
       return existing;
-    auto existential = std::make_shared<Rete_Existential>();
+    auto existential = make_pooled<Rete_Existential>();
     bind_to_existential(*this, existential, out);
     return existential;
   }
@@ -66,9 +80,9 @@ namespace Rete {
   Rete_Existential_Join_Ptr Rete_Agent::make_existential_join(const WME_Bindings &bindings, const Rete_Node_Ptr &out0, const Rete_Node_Ptr &out1) {
     CPU_Accumulator cpu_accumulator(*this);
 
-    if(auto existing = Rete_Existential_Join::find_existing(bindings, out0, out1))
+    if(auto existing = Rete_Existential_Join::find_existing(*this, bindings, out0, out1))
       return existing;
-    auto existential_join = std::make_shared<Rete_Existential_Join>(bindings);
+    auto existential_join = make_pooled<Rete_Existential_Join>(bindings);
     bind_to_existential_join(*this, existential_join, out0, out1);
     return existential_join;
   }
@@ -76,29 +90,36 @@ namespace Rete {
   Rete_Filter_Ptr Rete_Agent::make_filter(const WME &wme) {
     CPU_Accumulator cpu_accumulator(*this);
 
-    auto filter = std::make_shared<Rete_Filter>(wme);
+    auto filter = make_pooled<Rete_Filter>(wme);
 
-    if(!get_Option_Ranged<bool>(Options::get_global(), "rete-disable-node-sharing")) {
-      for(auto &existing_filter : filters) {
-        if(*existing_filter == *filter)
-          return existing_filter;
-      }
-    }
+    if(auto existing = Rete_Filter::find_existing(*this, *filter))
+      return existing;
 
     bind_to_filter(*this, filter);
 
     this->filters.push_back(filter);
+    alpha_insert(filter.get());
     for(auto &w : this->working_memory.wmes)
       filter->insert_wme(*this, w);
     return filter;
   }
 
+  Rete_Interval_Ptr Rete_Agent::make_interval(const WME_Token_Index &index, const Rete_Node_Ptr &out) {
+    CPU_Accumulator cpu_accumulator(*this);
+
+    if(auto existing = Rete_Interval::find_existing(*this, index, out))
+      return existing;
+    auto interval = make_pooled<Rete_Interval>(index);
+    bind_to_interval(*this, interval, out);
+    return interval;
+  }
+
   Rete_Join_Ptr Rete_Agent::make_join(const WME_Bindings &bindings, const Rete_Node_Ptr &out0, const Rete_Node_Ptr &out1) {
     CPU_Accumulator cpu_accumulator(*this);
 
-    if(auto existing = Rete_Join::find_existing(bindings, out0, out1))
+    if(auto existing = Rete_Join::find_existing(*this, bindings, out0, out1))
       return existing;
-    auto join = std::make_shared<Rete_Join>(bindings);
+    auto join = make_pooled<Rete_Join>(bindings);
     bind_to_join(*this, join, out0, out1);
     return join;
   }
@@ -106,9 +127,9 @@ namespace Rete {
   Rete_Negation_Ptr Rete_Agent::make_negation(const Rete_Node_Ptr &out) {
     CPU_Accumulator cpu_accumulator(*this);
 
-    if(auto existing = Rete_Negation::find_existing(out))
+    if(auto existing = Rete_Negation::find_existing(*this, out))
       return existing;
-    auto negation = std::make_shared<Rete_Negation>();
+    auto negation = make_pooled<Rete_Negation>();
     bind_to_negation(*this, negation, out);
     return negation;
   }
@@ -116,9 +137,9 @@ namespace Rete {
   Rete_Negation_Join_Ptr Rete_Agent::make_negation_join(const WME_Bindings &bindings, const Rete_Node_Ptr &out0, const Rete_Node_Ptr &out1) {
     CPU_Accumulator cpu_accumulator(*this);
 
-    if(auto existing = Rete_Negation_Join::find_existing(bindings, out0, out1))
+    if(auto existing = Rete_Negation_Join::find_existing(*this, bindings, out0, out1))
       return existing;
-    auto negation_join = std::make_shared<Rete_Negation_Join>(bindings);
+    auto negation_join = make_pooled<Rete_Negation_Join>(bindings);
     bind_to_negation_join(*this, negation_join, out0, out1);
     return negation_join;
   }
@@ -126,19 +147,28 @@ namespace Rete {
   Rete_Predicate_Ptr Rete_Agent::make_predicate_vc(const Rete_Predicate::Predicate &pred, const WME_Token_Index &lhs_index, const Symbol_Ptr_C &rhs, const Rete_Node_Ptr &out) {
     CPU_Accumulator cpu_accumulator(*this);
 
-    if(auto existing = Rete_Predicate::find_existing(pred, lhs_index, rhs, out))
+    /// Sibling range predicates on one axis share an interval index once there are two of them
+    Rete_Node_Ptr parent = out;
+    if(Rete_Interval::indexes(pred, rhs)) {
+      if(auto interval = Rete_Interval::find_existing(*this, lhs_index, out))
+        parent = interval;
+      else if(!Rete_Predicate::find_existing(*this, pred, lhs_index, rhs, out) && Rete_Interval::find_sibling(lhs_index, out))
+        parent = make_interval(lhs_index, out);
+    }
+
+    if(auto existing = Rete_Predicate::find_existing(*this, pred, lhs_index, rhs, parent))
       return existing;
-    auto predicate = std::make_shared<Rete_Predicate>(pred, lhs_index, rhs);
-    bind_to_predicate(*this, predicate, out);
+    auto predicate = make_pooled<Rete_Predicate>(pred, lhs_index, rhs);
+    bind_to_predicate(*this, predicate, parent);
     return predicate;
   }
 
   Rete_Predicate_Ptr Rete_Agent::make_predicate_vv(const Rete_Predicate::Predicate &pred, const WME_Token_Index &lhs_index, const WME_Token_Index &rhs_index, const Rete_Node_Ptr &out) {
     CPU_Accumulator cpu_accumulator(*this);
 
-    if(auto existing = Rete_Predicate::find_existing(pred, lhs_index, rhs_index, out))
+    if(auto existing = Rete_Predicate::find_existing(*this, pred, lhs_index, rhs_index, out))
       return existing;
-    auto predicate = std::make_shared<Rete_Predicate>(pred, lhs_index, rhs_index);
+    auto predicate = make_pooled<Rete_Predicate>(pred, lhs_index, rhs_index);
     bind_to_predicate(*this, predicate, out);
     return predicate;
   }
@@ -157,21 +187,39 @@ namespace Rete {
     return rv;
   }
 
+  std::vector<Rete_Action_Ptr_C> Rete_Agent::get_rules_by_rank() const {
+    std::map<std::pair<int64_t, std::string>, Rete_Action_Ptr_C> ordered_rules;
+    for(auto it = rules.begin(), iend = rules.end(); it != iend; ++it)
+      ordered_rules.emplace(std::make_pair(it->second->data? it->second->data->rank() : 0, it->first), it->second);
+
+    std::vector<Rete_Action_Ptr_C> rv;
+    rv.reserve(ordered_rules.size());
+    for(const auto &rule : ordered_rules)
+      rv.push_back(rule.second);
+    return rv;
+  }
+
   void Rete_Agent::excise_all() {
     Agenda::Locker locker(agenda);
 
     CPU_Accumulator cpu_accumulator(*this);
 
     filters.clear();
-    rules.clear();
+    for(auto &buckets : alpha_buckets)
+      buckets.clear();
+    shared_nodes.clear();
+    decltype(rules)().swap(rules);
   }
 
   void Rete_Agent::excise_filter(const Rete_Filter_Ptr &filter) {
     CPU_Accumulator cpu_accumulator(*this);
 
     const auto found = std::find(filters.begin(), filters.end(), filter);
-    if(found != filters.end())
+    if(found != filters.end()) {
+      alpha_erase(filter.get());
+      erase_shared(*filter);
       filters.erase(found);
+    }
   }
 
   void Rete_Agent::excise_rule(const std::string &name, const bool &user_command) {
@@ -191,7 +239,7 @@ namespace Rete {
       rules.erase(found);
       action->destroy(*this);
       if(user_command)
-        std::cerr << '#';
+        get_context().get_err() << '#';
     }
   }
 
@@ -213,7 +261,7 @@ namespace Rete {
       ptr = found->second;
       rules.erase(found);
       if(user_command)
-        std::cerr << '#';
+        get_context().get_err() << '#';
     }
     return ptr;
   }
@@ -224,19 +272,19 @@ namespace Rete {
 
     if(working_memory.wmes.find(wme) != working_memory.wmes.end()) {
 #ifdef DEBUG_OUTPUT
-      std::cerr << "rete.already_inserted" << *wme << std::endl;
+      get_context().get_err() << "rete.already_inserted" << *wme << std::endl;
 #endif
       return;
     }
 
-    //const auto wme_clone = std::make_shared<WME>(Symbol_Ptr_C(wme->symbols[0]->clone()), Symbol_Ptr_C(wme->symbols[1]->clone()), Symbol_Ptr_C(wme->symbols[2]->clone()));
+    //const auto wme_clone = WME::create(Symbol_Ptr_C(wme->symbols[0]->clone()), Symbol_Ptr_C(wme->symbols[1]->clone()), Symbol_Ptr_C(wme->symbols[2]->clone()));
 
     Agenda::Locker locker(agenda);
     working_memory.wmes.insert(wme);
 #ifdef DEBUG_OUTPUT
-    std::cerr << "rete.insert" << *wme << std::endl;
+    get_context().get_err() << "rete.insert" << *wme << std::endl;
 #endif
-    for(auto &filter : filters)
+    for(auto &filter : alpha_match(*wme))
       filter->insert_wme(*this, wme);
   }
 
@@ -248,7 +296,7 @@ namespace Rete {
 
     if(found == working_memory.wmes.end()) {
 #ifdef DEBUG_OUTPUT
-      std::cerr << "rete.already_removed" << *wme << std::endl;
+      get_context().get_err() << "rete.already_removed" << *wme << std::endl;
 #endif
       return;
     }
@@ -256,9 +304,9 @@ namespace Rete {
     Agenda::Locker locker(agenda);
     working_memory.wmes.erase(found);
 #ifdef DEBUG_OUTPUT
-    std::cerr << "rete.remove" << *wme << std::endl;
+    get_context().get_err() << "rete.remove" << *wme << std::endl;
 #endif
-    for(auto &filter : filters)
+    for(auto &filter : alpha_match(*wme))
       filter->remove_wme(*this, wme);
   }
 
@@ -268,10 +316,105 @@ namespace Rete {
     CPU_Accumulator cpu_accumulator(*this);
 
     for(auto &wme : working_memory.wmes) {
-      for(auto &filter : filters)
+      for(auto &filter : alpha_match(*wme))
         filter->remove_wme(*this, wme);
     }
     working_memory.wmes.clear();
+    wmes_set.clear();
+  }
+
+  std::vector<WME_Ptr_C> Rete_Agent::get_wmes() const {
+    return std::vector<WME_Ptr_C>(working_memory.wmes.begin(), working_memory.wmes.end());
+  }
+
+  void Rete_Agent::reset_wmes(const std::vector<WME_Ptr_C> &wmes) {
+    Agenda::Locker locker(agenda);
+
+    clear_wmes();
+    decltype(working_memory.wmes)().swap(working_memory.wmes);
+
+    for(const auto &wme : wmes)
+      insert_wme(wme);
+  }
+
+  void Rete_Agent::set_wmes(const std::vector<WME_Ptr_C> &wmes) {
+    Agenda::Locker locker(agenda);
+
+    CPU_Accumulator cpu_accumulator(*this);
+
+    /// Only WMEs a previous call supplied go stale, leaving those that rules inserted alone
+    for(const auto &wme : wmes)
+      wmes_next.insert(wme.get());
+    for(const auto &wme : working_memory.wmes) {
+      if(wmes_next.find(wme.get()) == wmes_next.end() && wmes_set.find(wme) != wmes_set.end())
+        wmes_stale.push_back(wme);
+    }
+    wmes_next.clear();
+
+    for(const auto &wme : wmes)
+      insert_wme(wme);
+
+    for(const auto &wme : wmes_stale)
+      remove_wme(wme);
+    wmes_stale.clear();
+
+    set_wmes_supplied(wmes);
+  }
+
+  void Rete_Agent::set_wmes_supplied(const std::vector<WME_Ptr_C> &wmes) {
+    wmes_set.clear();
+    wmes_set.insert(wmes.begin(), wmes.end());
+  }
+
+  void Rete_Agent::update_wmes(const std::vector<WME_Ptr_C> &removals, const std::vector<WME_Ptr_C> &insertions) {
+    Agenda::Locker locker(agenda);
+
+    CPU_Accumulator cpu_accumulator(*this);
+
+    for(const auto &wme : insertions)
+      insert_wme(wme);
+    for(const auto &wme : removals)
+      remove_wme(wme);
+  }
+
+  WME_Ptr_C Rete_Agent::modify_wme(const WME_Ptr_C &wme, const Symbol_Ptr_C &value) {
+    const auto modified = WME::create(wme->symbols[0], wme->symbols[1], value);
+
+    auto found = working_memory.wmes.find(wme);
+    if(found == working_memory.wmes.end()) {
+      insert_wme(modified);
+      return modified;
+    }
+    if(**found == *modified)
+      return *found;
+
+    Agenda::Locker locker(agenda);
+
+    const WME_Ptr_C original = *found;
+    working_memory.wmes.erase(found);
+    const auto inserted = working_memory.wmes.insert(modified);
+#ifdef DEBUG_OUTPUT
+    get_context().get_err() << "rete.modify" << *original << " to " << *modified << std::endl;
+#endif
+
+    alpha_modified = alpha_match(*original);
+    if(inserted.second) {
+      for(auto &filter : alpha_match(*modified)) {
+        const auto ft = std::find(alpha_modified.begin(), alpha_modified.end(), filter);
+        if(ft == alpha_modified.end())
+          filter->insert_wme(*this, modified);
+        else {
+          filter->modify_wme(*this, original, modified);
+          *ft = nullptr;
+        }
+      }
+    }
+    for(auto &filter : alpha_modified) {
+      if(filter)
+        filter->remove_wme(*this, original);
+    }
+
+    return *inserted.first;
   }
 
   size_t Rete_Agent::rete_size() const {
@@ -370,21 +513,19 @@ namespace Rete {
   }
 
   void Rete_Agent::rete_print_rules(std::ostream &os) const {
-    std::multimap<int64_t, Rete_Action_Ptr_C> ordered_rules;
-    for(auto it = rules.begin(), iend = rules.end(); it != iend; ++it)
-      ordered_rules.insert(std::make_pair(it->second->data? it->second->data->rank() : 0, it->second));
+    const auto ordered_rules = get_rules_by_rank();
 
     auto it = ordered_rules.begin();
     const auto iend = ordered_rules.end();
 
     if(it == iend)
       return;
-    it->second->print_rule(os);
+    (*it)->print_rule(os);
     ++it;
 
     for(; it != iend; ++it) {
       os << std::endl;
-      it->second->print_rule(os);
+      (*it)->print_rule(os);
     }
   }
 
@@ -402,10 +543,87 @@ namespace Rete {
     }
   }
 
+  int Rete_Agent::alpha_mask(const Rete_Filter &filter) {
+    return (filter.is_constant(Rete_Filter::LEFT) ? 1 : 0) |
+           (filter.is_constant(Rete_Filter::CENTER) ? 2 : 0) |
+           (filter.is_constant(Rete_Filter::RIGHT) ? 4 : 0);
+  }
+
+  Rete_Agent::Alpha_Key Rete_Agent::alpha_key(const WME &wme, const int &mask) {
+    return {{mask & 1 ? wme.symbols[0].get() : nullptr,
+             mask & 2 ? wme.symbols[1].get() : nullptr,
+             mask & 4 ? wme.symbols[2].get() : nullptr}};
+  }
+
+  void Rete_Agent::insert_shared(Rete_Node &node, const size_t &key) {
+    node.share_key = key;
+    shared_nodes.insert(std::make_pair(key, &node));
+  }
+
+  void Rete_Agent::erase_shared(Rete_Node &node) {
+    for(auto range = shared_nodes.equal_range(node.share_key); range.first != range.second; ++range.first) {
+      if(range.first->second == &node) {
+        shared_nodes.erase(range.first);
+        break;
+      }
+    }
+  }
+
+  void Rete_Agent::alpha_insert(Rete_Filter * const &filter) {
+    const int mask = alpha_mask(*filter);
+    alpha_buckets[mask][alpha_key(filter->get_wme(), mask)].push_back(Alpha_Entry(alpha_order++, filter));
+  }
+
+  void Rete_Agent::alpha_erase(Rete_Filter * const &filter) {
+    const int mask = alpha_mask(*filter);
+    auto &buckets = alpha_buckets[mask];
+    const Alpha_Key key = alpha_key(filter->get_wme(), mask);
+    const auto bucket = buckets.find(key);
+    if(bucket == buckets.end())
+      return;
+    const auto found = std::find_if(bucket->second.begin(), bucket->second.end(), [&filter](const Alpha_Entry &entry) {
+      return entry.second == filter;
+    });
+    if(found != bucket->second.end())
+      bucket->second.erase(found);
+    if(bucket->second.empty())
+      buckets.erase(bucket);
+    else if(bucket->first == key) {
+      /// The key borrowed its symbols from the erased filter; rekey using a remaining one
+      auto node = buckets.extract(bucket);
+      node.key() = alpha_key(node.mapped().front().second->get_wme(), mask);
+      buckets.insert(std::move(node));
+    }
+  }
+
+  const std::vector<Rete_Filter *> & Rete_Agent::alpha_match(const WME &wme) {
+    alpha_scratch.clear();
+    int nonempty = 0;
+    for(int mask = 0; mask != 8; ++mask) {
+      const auto &buckets = alpha_buckets[mask];
+      if(buckets.empty())
+        continue;
+      const auto bucket = buckets.find(alpha_key(wme, mask));
+      if(bucket != buckets.end()) {
+        alpha_scratch.insert(alpha_scratch.end(), bucket->second.begin(), bucket->second.end());
+        ++nonempty;
+      }
+    }
+
+    /// Preserve filter creation order across buckets so that token propagation order is unchanged
+    if(nonempty > 1)
+      std::sort(alpha_scratch.begin(), alpha_scratch.end());
+
+    alpha_matches.clear();
+    for(const auto &entry : alpha_scratch)
+      alpha_matches.push_back(entry.second);
+    return alpha_matches;
+  }
+
   void Rete_Agent::source_rule(const Rete_Action_Ptr &action, const bool &user_command) {
     CPU_Accumulator cpu_accumulator(*this);
 
-    const auto output = dynamic_cast<const Option_Itemized &>(Options::get_global()["output"]).get_value();
+    const auto output = dynamic_cast<const Option_Itemized &>(get_context().get_options()["output"]).get_value();
 
     auto found = rules.find(action->get_name());
     if(found == rules.end()) {
@@ -421,11 +639,11 @@ namespace Rete {
       assert(found->second != action);
       found->second->destroy(*this);
       if(user_command && output != "null")
-        std::cerr << '#';
+        get_context().get_err() << '#';
       found->second = action;
     }
     if(user_command && output != "null")
-      std::cerr << '*';
+      get_context().get_err() << '*';
   }
 
 }
@@ -4,8 +4,11 @@
 #include "agenda.h"
 #include "rete.h"
 #include "wme_set.h"
+#include "../utility/runtime_context.h"
+#include <array>
 #include <chrono>
 #include <unordered_map>
+#include <vector>
 
 namespace Rete {
 
@@ -26,23 +29,28 @@ namespace Rete {
       Rete_Agent &agent;
     };
 
-    Rete_Agent();
+    Rete_Agent(Zeni::Runtime_Context &context = Zeni::Runtime_Context::get_current());
     ~Rete_Agent();
 
+    Zeni::Runtime_Context & get_context() const {return m_context;} ///< Supplies options and memory pools
+
     Rete_Action_Ptr make_action(const std::string &name, const bool &user_action, const Rete_Action::Action &action, const Rete_Node_Ptr &out, const Variable_Indices_Ptr_C &variables);
     Rete_Action_Ptr make_action_retraction(const std::string &name, const bool &user_action, const Rete_Action::Action &action, const Rete_Action::Action &retraction, const Rete_Node_Ptr &out, const Variable_Indices_Ptr_C &variables);
     Rete_Existential_Ptr make_existential(const Rete_Node_Ptr &out);
     Rete_Existential_Join_Ptr make_existential_join(const WME_Bindings &bindings, const Rete_Node_Ptr &out0, const Rete_Node_Ptr &out1);
     Rete_Filter_Ptr make_filter(const WME &wme);
+    Rete_Interval_Ptr make_interval(const WME_Token_Index &index, const Rete_Node_Ptr &out);
     Rete_Join_Ptr make_join(const WME_Bindings &bindings, const Rete_Node_Ptr &out0, const Rete_Node_Ptr &out1);
     Rete_Negation_Ptr make_negation(const Rete_Node_Ptr &out);
     Rete_Negation_Join_Ptr make_negation_join(const WME_Bindings &bindings, const Rete_Node_Ptr &out0, const Rete_Node_Ptr &out1);
+    /// Range predicates against numeric constants share an interval index with their siblings on the same axis
     Rete_Predicate_Ptr make_predicate_vc(const Rete_Predicate::Predicate &pred, const WME_Token_Index &lhs_index, const Symbol_Ptr_C &rhs, const Rete_Node_Ptr &out);
     Rete_Predicate_Ptr make_predicate_vv(const Rete_Predicate::Predicate &pred, const WME_Token_Index &lhs_index, const WME_Token_Index &rhs_index, const Rete_Node_Ptr &out);
 
     Agenda & get_agenda() {return agenda;}
     Rete_Action_Ptr get_rule(const std::string &name);
     std::set<std::string> get_rule_names() const;
+    std::vector<Rete_Action_Ptr_C> get_rules_by_rank() const; ///< Rules that others refine come first, then by name, as rete_print_rules writes them
     int64_t get_rule_name_index() const {return rule_name_index;}
     void set_rule_name_index(const int64_t &rule_name_index_) {rule_name_index = rule_name_index_;}
 
@@ -55,6 +63,18 @@ namespace Rete {
     void insert_wme(const WME_Ptr_C &wme);
     void remove_wme(const WME_Ptr_C &wme);
     void clear_wmes();
+    std::vector<WME_Ptr_C> get_wmes() const; ///< In working memory's iteration order
+    /// Clear working memory into a fresh container and insert wmes in order, so its iteration order depends on them alone
+    void reset_wmes(const std::vector<WME_Ptr_C> &wmes);
+    /// Make working memory match the next state, inserting new WMEs in the order given before removing those the last call supplied but these do not
+    void set_wmes(const std::vector<WME_Ptr_C> &wmes);
+    bool is_wme_supplied(const WME_Ptr_C &wme) const {return wmes_set.find(wme) != wmes_set.end();} ///< Given to the last set_wmes
+    void set_wmes_supplied(const std::vector<WME_Ptr_C> &wmes); ///< As if given to the last set_wmes, when restoring working memory
+    /// Apply a delta to working memory, inserting before removing as set_wmes does
+    void update_wmes(const std::vector<WME_Ptr_C> &removals, const std::vector<WME_Ptr_C> &insertions);
+    /// Replace the value of a WME, returning the replacement; every token holding it is rebuilt in each node it reaches, and filters, predicates, actions, and joins whose bindings are unchanged substitute the rebuilt token without retracting their outputs
+    /// Predicates retest only when a compared symbol changed, while other nodes insert the rebuilt token and then remove the old one
+    WME_Ptr_C modify_wme(const WME_Ptr_C &wme, const Symbol_Ptr_C &value);
 
     double rete_cpu_time() const {return m_cpu_time;}
     size_t rete_size() const;
@@ -63,6 +83,20 @@ namespace Rete {
     void rete_print_firing_counts(std::ostream &os) const;
     void rete_print_matches(std::ostream &os) const;
 
+    /// Node sharing index: nodes are hashed on their kind, parents and tests, and the match confirms a candidate
+    template <typename NODE, typename MATCHES>
+    Shared_Ptr<NODE> find_shared(const size_t &key, const MATCHES &matches) const {
+      for(auto range = shared_nodes.equal_range(key); range.first != range.second; ++range.first) {
+        if(auto node = dynamic_cast<NODE *>(range.first->second)) {
+          if(matches(*node))
+            return static_pointer_cast<NODE>(node->shared());
+        }
+      }
+      return nullptr;
+    }
+    void insert_shared(Rete_Node &node, const size_t &key);
+    void erase_shared(Rete_Node &node); ///< Called as a node detaches from the network
+
     template <typename VISITOR>
     VISITOR visit_preorder(VISITOR visitor, const bool &strict) {
       visitor_value = visitor_value != 1 ? 1 : 2;
@@ -80,10 +114,37 @@ namespace Rete {
   private:
     void source_rule(const Rete_Action_Ptr &action, const bool &user_command);
 
+    /// Alpha network index: filters are bucketed by their constant symbols, with variables as wildcards (nullptr)
+    typedef std::array<const Symbol *, 3> Alpha_Key;
+    struct Alpha_Hash {
+      size_t operator()(const Alpha_Key &key) const;
+    };
+    struct Alpha_Eq {
+      bool operator()(const Alpha_Key &lhs, const Alpha_Key &rhs) const;
+    };
+    typedef std::pair<int64_t, Rete_Filter *> Alpha_Entry; ///< (creation order, filter)
+    typedef std::unordered_map<Alpha_Key, std::vector<Alpha_Entry>, Alpha_Hash, Alpha_Eq> Alpha_Buckets;
+
+    static int alpha_mask(const Rete_Filter &filter);
+    static Alpha_Key alpha_key(const WME &wme, const int &mask);
+    void alpha_insert(Rete_Filter * const &filter);
+    void alpha_erase(Rete_Filter * const &filter);
+    const std::vector<Rete_Filter *> & alpha_match(const WME &wme);
+
+    Zeni::Runtime_Context &m_context;
     Rete_Node::Filters filters;
+    std::unordered_multimap<size_t, Rete_Node *> shared_nodes;
+    std::array<Alpha_Buckets, 8> alpha_buckets;
+    int64_t alpha_order = 0;
+    std::vector<Alpha_Entry> alpha_scratch;
+    std::vector<Rete_Filter *> alpha_matches;
+    std::vector<Rete_Filter *> alpha_modified; ///< Scratch space for modify_wme
     std::unordered_map<std::string, Rete_Action_Ptr> rules;
     int64_t rule_name_index = 0;
     WME_Set working_memory;
+    std::unordered_set<const WME *, hash_deref<WME>, compare_deref_eq> wmes_next; ///< Scratch space for set_wmes
+    std::vector<WME_Ptr_C> wmes_stale; ///< Scratch space for set_wmes
+    std::unordered_set<WME_Ptr_C, hash_deref<WME>, compare_deref_eq> wmes_set; ///< Supplied by the last set_wmes, and so removed by the next unless supplied again
     intptr_t visitor_value = 0;
 
     double m_cpu_time = 0.0;
@@ -1,9 +1,12 @@
 #include "rete_existential.h"
 #include "rete_action.h"
+#include "rete_agent.h"
+
+#include <typeinfo>
 
 namespace Rete {
 
-  Rete_Existential::Rete_Existential() : output_token(std::make_shared<WME_Token>()) {}
+  Rete_Existential::Rete_Existential() : output_token(WME_Token::create()) {}
 
   void Rete_Existential::destroy(Rete_Agent &agent, const Rete_Node_Ptr &output) {
     erase_output(output);
@@ -12,6 +15,7 @@ namespace Rete {
       //output_name(std::cerr, 3);
       //std::cerr << std::endl;
 
+      agent.erase_shared(*this);
       input->destroy(agent, shared());
     }
   }
@@ -125,16 +129,17 @@ namespace Rete {
     return input->get_filter_wmes();
   }
 
-  Rete_Existential_Ptr Rete_Existential::find_existing(const Rete_Node_Ptr &out) {
-    if(get_Option_Ranged<bool>(Options::get_global(), "rete-disable-node-sharing"))
+  Rete_Existential_Ptr Rete_Existential::find_existing(Rete_Agent &agent, const Rete_Node_Ptr &out) {
+    if(get_Option_Ranged<bool>(agent.get_context().get_options(), "rete-disable-node-sharing"))
       return nullptr;
 
-    for(auto &o : out->get_outputs_all()) {
-      if(auto existing_existential = std::dynamic_pointer_cast<Rete_Existential>(o))
-        return existing_existential;
-    }
+    return agent.find_shared<Rete_Existential>(share_hash(out.get()), [&](const Rete_Existential &existing_existential) {
+      return existing_existential.input == out.get();
+    });
+  }
 
-    return nullptr;
+  size_t Rete_Existential::share_hash(const Rete_Node * const &out) {
+    return hash_combine(typeid(Rete_Existential).hash_code(), std::hash<const Rete_Node *>()(out));
   }
 
   void bind_to_existential(Rete_Agent &agent, const Rete_Existential_Ptr &existential, const Rete_Node_Ptr &out) {
@@ -144,6 +149,7 @@ namespace Rete {
     existential->token_owner = out->get_token_owner();
     existential->size = out->get_size();
     existential->token_size = out->get_token_size();
+    agent.insert_shared(*existential, Rete_Existential::share_hash(out.get()));
     out->insert_output_enabled(existential);
     out->pass_tokens(agent, existential.get());
   }
@@ -44,7 +44,8 @@ namespace Rete {
 
     std::vector<WME> get_filter_wmes() const override;
 
-    static Rete_Existential_Ptr find_existing(const Rete_Node_Ptr &out);
+    static Rete_Existential_Ptr find_existing(Rete_Agent &agent, const Rete_Node_Ptr &out);
+    static size_t share_hash(const Rete_Node * const &out);
 
   private:
     Rete_Node * input = nullptr;
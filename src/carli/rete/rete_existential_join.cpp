@@ -1,15 +1,19 @@
 #include "rete_existential_join.h"
 
 #include "rete_action.h"
+#include "rete_agent.h"
 #include "rete_existential.h"
 #include "rete_negation.h"
 
+#include <typeinfo>
+
 #undef RETE_LR_UNLINKING
 
 namespace Rete {
 
   Rete_Existential_Join::Rete_Existential_Join(WME_Bindings bindings_)
-   : bindings(bindings_)
+   : bindings(bindings_),
+   matching(bindings)
   {
   }
 
@@ -20,6 +24,7 @@ namespace Rete {
       //output_name(std::cerr, 3);
       //std::cerr << std::endl;
 
+      agent.erase_shared(*this);
       auto i0 = input0->shared();
       auto i1 = input1->shared();
       auto o = shared();
@@ -60,12 +65,11 @@ namespace Rete {
       }
 #endif
 
-      auto &match = matching[std::make_pair(wme_token, true)];
-      const auto inserted = match.first.insert(wme_token);
-      if(inserted.second) {
+      auto &match = matching.insert(wme_token, true);
+      if(match.insert(true, wme_token)) {
         ++input0_count;
         if(!match.second.empty())
-          join_tokens(agent, *inserted.first);
+          join_tokens(agent, wme_token);
       }
     }
     if(from == input1) {
@@ -80,9 +84,8 @@ namespace Rete {
       }
 #endif
 
-      auto &match = matching[std::make_pair(wme_token, false)];
-      const auto inserted = match.second.insert(wme_token);
-      if(inserted.second) {
+      auto &match = matching.insert(wme_token, false);
+      if(match.insert(false, wme_token)) {
         ++input1_count;
         if(match.second.size() == 1u) {
           for(const auto &other : match.first)
@@ -98,38 +101,38 @@ namespace Rete {
     bool emptied = false;
 
     if(from == input0) {
-      const auto index = std::make_pair(wme_token, true);
-      auto &match = matching[index];
-      auto found2 = match.first.find(wme_token);
+      if(const auto match = matching.find(*wme_token, true)) {
+        const int64_t found2 = match->find(true, *wme_token);
 
-      if(found2 != match.first.end()) {
-        if(!match.second.empty())
-          unjoin_tokens(agent, *found2);
-        match.first.erase(found2);
+        if(found2 >= 0) {
+          if(!match->second.empty())
+            unjoin_tokens(agent, match->first[size_t(found2)]);
+          match->erase(true, size_t(found2));
 
-        emptied ^= !--input0_count;
-      }
+          emptied ^= !--input0_count;
+        }
 
-      if(match.first.empty() && match.second.empty())
-        matching.erase(index);
+        if(match->empty())
+          matching.erase(match);
+      }
     }
     if(from == input1) {
-      const auto index = std::make_pair(wme_token, false);
-      auto &match = matching[index];
-      auto found2 = match.second.find(wme_token);
-
-      if(found2 != match.second.end()) {
-        if(match.second.size() == 1) {
-          for(auto &other : match.first)
-            unjoin_tokens(agent, other);
+      if(const auto match = matching.find(*wme_token, false)) {
+        const int64_t found2 = match->find(false, *wme_token);
+
+        if(found2 >= 0) {
+          if(match->second.size() == 1) {
+            for(auto &other : match->first)
+              unjoin_tokens(agent, other);
+          }
+          match->erase(false, size_t(found2));
+
+          emptied ^= !--input1_count;
         }
-        match.second.erase(found2);
 
-        emptied ^= !--input1_count;
+        if(match->empty())
+          matching.erase(match);
       }
-
-      if(match.second.empty() && match.first.empty())
-        matching.erase(index);
     }
 
     return emptied;
@@ -220,20 +223,17 @@ namespace Rete {
     return filter_wmes0;
   }
 
-  Rete_Existential_Join_Ptr Rete_Existential_Join::find_existing(const WME_Bindings &bindings, const Rete_Node_Ptr &out0, const Rete_Node_Ptr &out1) {
-    if(get_Option_Ranged<bool>(Options::get_global(), "rete-disable-node-sharing"))
+  Rete_Existential_Join_Ptr Rete_Existential_Join::find_existing(Rete_Agent &agent, const WME_Bindings &bindings, const Rete_Node_Ptr &out0, const Rete_Node_Ptr &out1) {
+    if(get_Option_Ranged<bool>(agent.get_context().get_options(), "rete-disable-node-sharing"))
       return nullptr;
 
-    for(auto &o0 : out0->get_outputs_all()) {
-      if(auto existing_existential_join = std::dynamic_pointer_cast<Rete_Existential_Join>(o0)) {
-        if(std::find(out1->get_outputs_all().begin(), out1->get_outputs_all().end(), existing_existential_join) != out1->get_outputs_all().end()) {
-          if(bindings == existing_existential_join->bindings)
-            return existing_existential_join;
-        }
-      }
-    }
+    return agent.find_shared<Rete_Existential_Join>(share_hash(bindings, out0.get(), out1.get()), [&](const Rete_Existential_Join &existing_existential_join) {
+      return existing_existential_join.input0 == out0.get() && existing_existential_join.input1 == out1.get() && existing_existential_join.bindings == bindings;
+    });
+  }
 
-    return nullptr;
+  size_t Rete_Existential_Join::share_hash(const WME_Bindings &bindings, const Rete_Node * const &out0, const Rete_Node * const &out1) {
+    return hash_combine(hash_combine(hash_combine(typeid(Rete_Existential_Join).hash_code(), std::hash<const Rete_Node *>()(out0)), std::hash<const Rete_Node *>()(out1)), hash_container<WME_Binding>()(bindings));
   }
 
   void Rete_Existential_Join::join_tokens(Rete_Agent &agent, const WME_Token_Ptr_C &lhs) {
@@ -306,14 +306,15 @@ namespace Rete {
 
   void bind_to_existential_join(Rete_Agent &agent, const Rete_Existential_Join_Ptr &join, const Rete_Node_Ptr &out0, const Rete_Node_Ptr &out1) {
     assert(join && !join->input0 && !join->input1);
-    assert(!std::dynamic_pointer_cast<Rete_Existential>(out0));
-    assert(!std::dynamic_pointer_cast<Rete_Negation>(out0));
+    assert(!dynamic_pointer_cast<Rete_Existential>(out0));
+    assert(!dynamic_pointer_cast<Rete_Negation>(out0));
     join->input0 = out0.get();
     join->input1 = out1.get();
     join->height = std::max(out0->get_height(), out1->get_height()) + 1;
     join->token_owner = out0->get_token_owner();
     join->size = out0->get_size() + out1->get_size();
     join->token_size = out0->get_token_size();
+    agent.insert_shared(*join, Rete_Existential_Join::share_hash(join->bindings, out0.get(), out1.get()));
 
     out0->insert_output_enabled(join);
     if(out0 != out1)
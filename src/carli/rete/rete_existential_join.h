@@ -1,6 +1,7 @@
 #ifndef RETE_EXISTENTIAL_JOIN_H
 #define RETE_EXISTENTIAL_JOIN_H
 
+#include "join_memory.h"
 #include "rete_node.h"
 
 namespace Rete {
@@ -43,7 +44,8 @@ namespace Rete {
 
     std::vector<WME> get_filter_wmes() const override;
 
-    static Rete_Existential_Join_Ptr find_existing(const WME_Bindings &bindings, const Rete_Node_Ptr &out0, const Rete_Node_Ptr &out1);
+    static Rete_Existential_Join_Ptr find_existing(Rete_Agent &agent, const WME_Bindings &bindings, const Rete_Node_Ptr &out0, const Rete_Node_Ptr &out1);
+    static size_t share_hash(const WME_Bindings &bindings, const Rete_Node * const &out0, const Rete_Node * const &out1);
 
     virtual const WME_Bindings * get_bindings() const override {return &bindings;}
 
@@ -62,12 +64,7 @@ namespace Rete {
     int64_t input0_count = 0;
     int64_t input1_count = 0;
 
-    std::unordered_map<std::pair<WME_Token_Ptr_C, bool>, std::pair<Tokens, Tokens>, std::function<size_t (const std::pair<WME_Token_Ptr_C, bool> &)>, std::function<bool (const std::pair<WME_Token_Ptr_C, bool> &, const std::pair<WME_Token_Ptr_C, bool> &)>> matching
-      = std::unordered_map<std::pair<WME_Token_Ptr_C, bool>, std::pair<Tokens, Tokens>, std::function<size_t (const std::pair<WME_Token_Ptr_C, bool> &)>, std::function<bool (const std::pair<WME_Token_Ptr_C, bool> &, const std::pair<WME_Token_Ptr_C, bool> &)>>(0, [this](const std::pair<WME_Token_Ptr_C, bool> &itoken)->size_t{
-        return itoken.first->hash_bindings(itoken.second, this->bindings);
-      }, [this](const std::pair<WME_Token_Ptr_C, bool> &lhs, const std::pair<WME_Token_Ptr_C, bool> &rhs)->bool{
-        return lhs.first->eval_bindings(lhs.second, this->bindings, *rhs.first, rhs.second);
-      });
+    Join_Memory matching;
     Tokens output_tokens;
 
     struct Data {
@@ -3,13 +3,15 @@
 #include "rete_action.h"
 #include "rete_agent.h"
 
+#include <typeinfo>
+
 namespace Rete {
 
   Rete_Filter::Rete_Filter(const WME &wme_)
     : m_wme(wme_)
   {
     for(int i = 0; i != 3; ++i)
-      m_variable[i] = std::dynamic_pointer_cast<const Symbol_Variable>(m_wme.symbols[i]);
+      m_variable[i] = dynamic_pointer_cast<const Symbol_Variable>(m_wme.symbols[i]);
   }
 
   const WME & Rete_Filter::get_wme() const {
@@ -19,7 +21,7 @@ namespace Rete {
   void Rete_Filter::destroy(Rete_Agent &agent, const Rete_Node_Ptr &output) {
     erase_output(output);
     if(!destruction_suppressed && outputs_all.empty())
-      agent.excise_filter(std::static_pointer_cast<Rete_Filter>(shared()));
+      agent.excise_filter(static_pointer_cast<Rete_Filter>(shared()));
   }
 
   Rete_Filter_Ptr_C Rete_Filter::get_filter(const int64_t &
@@ -28,7 +30,7 @@ namespace Rete {
 #endif
                                                                 ) const {
     assert(index == 0);
-    return std::dynamic_pointer_cast<const Rete_Filter>(shared_from_this());
+    return dynamic_pointer_cast<const Rete_Filter>(shared());
   }
 
   const Rete_Node::Tokens & Rete_Filter::get_output_tokens() const {
@@ -40,18 +42,10 @@ namespace Rete {
   }
 
   void Rete_Filter::insert_wme(Rete_Agent &agent, const WME_Ptr_C &wme) {
-    for(int i = 0; i != 3; ++i)
-      if(!m_variable[i] && *m_wme.symbols[i] != *wme->symbols[i])
-        return;
-
-    if(m_variable[0] && m_variable[1] && *m_variable[0] == *m_variable[1] && *wme->symbols[0] != *wme->symbols[1])
-      return;
-    if(m_variable[0] && m_variable[2] && *m_variable[0] == *m_variable[2] && *wme->symbols[0] != *wme->symbols[2])
-      return;
-    if(m_variable[1] && m_variable[2] && *m_variable[1] == *m_variable[2] && *wme->symbols[1] != *wme->symbols[2])
+    if(!test_wme(*wme))
       return;
 
-    const auto inserted = tokens.insert(std::make_shared<WME_Token>(wme));
+    const auto inserted = tokens.insert(WME_Token::create(wme));
     if(inserted.second) {
       for(auto &output : *outputs_enabled)
         output.ptr->insert_wme_token(agent, *inserted.first, this);
@@ -59,7 +53,15 @@ namespace Rete {
   }
 
   void Rete_Filter::remove_wme(Rete_Agent &agent, const WME_Ptr_C &wme) {
-    auto found = tokens.find(std::make_shared<WME_Token>(wme));
+    /// A non-owning handle to a stack token avoids allocating a token just for the lookup
+    const WME_Token probe(wme);
+#ifdef RETE_INTRUSIVE_PTR
+    WME_Token_Ptr_C probe_ptr(&probe);
+    auto found = tokens.find(probe_ptr);
+    probe_ptr.detach();
+#else
+    auto found = tokens.find(WME_Token_Ptr_C(WME_Token_Ptr_C(), &probe));
+#endif
     if(found != tokens.end()) {
       for(auto ot = outputs_enabled->begin(), oend = outputs_enabled->end(); ot != oend; ) {
         if((*ot)->remove_wme_token(agent, *found, this))
@@ -71,6 +73,32 @@ namespace Rete {
     }
   }
 
+  void Rete_Filter::modify_wme(Rete_Agent &agent, const WME_Ptr_C &old_wme, const WME_Ptr_C &new_wme) {
+    if(!test_wme(*new_wme)) {
+      remove_wme(agent, old_wme);
+      return;
+    }
+
+    const WME_Token probe(old_wme);
+#ifdef RETE_INTRUSIVE_PTR
+    WME_Token_Ptr_C probe_ptr(&probe);
+    auto found = tokens.find(probe_ptr);
+    probe_ptr.detach();
+#else
+    auto found = tokens.find(WME_Token_Ptr_C(WME_Token_Ptr_C(), &probe));
+#endif
+    if(found == tokens.end()) {
+      insert_wme(agent, new_wme);
+      return;
+    }
+
+    const WME_Token_Ptr_C old_token = *found;
+    tokens.erase(found);
+    const auto inserted = tokens.insert(WME_Token::create(new_wme));
+    assert(inserted.second);
+    modify_output_tokens(agent, old_token, *inserted.first);
+  }
+
   void Rete_Filter::insert_wme_token(Rete_Agent &, const WME_Token_Ptr_C &, const Rete_Node * const &) {
     abort();
   }
@@ -135,12 +163,53 @@ namespace Rete {
     return std::vector<WME>(1, m_wme);
   }
 
-  void bind_to_filter(Rete_Agent &/*agent*/, const Rete_Filter_Ptr &filter) {
+  bool Rete_Filter::test_wme(const WME &wme) const {
+    for(int i = 0; i != 3; ++i)
+      if(!m_variable[i] && *m_wme.symbols[i] != *wme.symbols[i])
+        return false;
+
+    if(m_variable[0] && m_variable[1] && *m_variable[0] == *m_variable[1] && *wme.symbols[0] != *wme.symbols[1])
+      return false;
+    if(m_variable[0] && m_variable[2] && *m_variable[0] == *m_variable[2] && *wme.symbols[0] != *wme.symbols[2])
+      return false;
+    if(m_variable[1] && m_variable[2] && *m_variable[1] == *m_variable[2] && *wme.symbols[1] != *wme.symbols[2])
+      return false;
+
+    return true;
+  }
+
+  Rete_Filter_Ptr Rete_Filter::find_existing(Rete_Agent &agent, const Rete_Filter &filter) {
+    if(get_Option_Ranged<bool>(agent.get_context().get_options(), "rete-disable-node-sharing"))
+      return nullptr;
+
+    return agent.find_shared<Rete_Filter>(filter.share_hash(), [&filter](const Rete_Filter &existing_filter) {
+      return existing_filter == filter;
+    });
+  }
+
+  size_t Rete_Filter::share_hash() const {
+    /// Variables hash by the first position sharing their name, mirroring operator==
+    size_t h = typeid(Rete_Filter).hash_code();
+    for(int i = 0; i != 3; ++i) {
+      if(m_variable[i]) {
+        int first = 0;
+        while(!m_variable[first] || !(*m_variable[first] == *m_variable[i]))
+          ++first;
+        h = hash_combine(h, std::hash<int>()(first));
+      }
+      else
+        h = hash_combine(h, m_wme.symbols[i]->hash());
+    }
+    return h;
+  }
+
+  void bind_to_filter(Rete_Agent &agent, const Rete_Filter_Ptr &filter) {
     assert(filter);
     filter->height = 1;
     filter->token_owner = filter;
     filter->size = 1;
     filter->token_size = 1;
+    agent.insert_shared(*filter, filter->share_hash());
   }
 
 }
@@ -15,6 +15,7 @@ namespace Rete {
     Rete_Filter(const WME &wme_);
 
     const WME & get_wme() const;
+    bool is_constant(const Index &index) const {return !m_variable[index];}
 
     void destroy(Rete_Agent &agent, const Rete_Node_Ptr &output) override;
 
@@ -30,6 +31,7 @@ namespace Rete {
 
     void insert_wme(Rete_Agent &agent, const WME_Ptr_C &wme);
     void remove_wme(Rete_Agent &agent, const WME_Ptr_C &wme);
+    void modify_wme(Rete_Agent &agent, const WME_Ptr_C &old_wme, const WME_Ptr_C &new_wme);
 
     void insert_wme_token(Rete_Agent &agent, const WME_Token_Ptr_C &, const Rete_Node * const &) override;
     bool remove_wme_token(Rete_Agent &agent, const WME_Token_Ptr_C &, const Rete_Node * const &) override;
@@ -49,7 +51,12 @@ namespace Rete {
 
     std::vector<WME> get_filter_wmes() const override;
 
+    static Rete_Filter_Ptr find_existing(Rete_Agent &agent, const Rete_Filter &filter);
+    size_t share_hash() const;
+
   private:
+    bool test_wme(const WME &wme) const;
+
     WME m_wme;
     std::array<Symbol_Variable_Ptr_C, 3> m_variable;
     Tokens tokens;
@@ -0,0 +1,250 @@
+#include "rete_interval.h"
+
+#include "rete_agent.h"
+#include "rete_existential.h"
+#include "rete_negation.h"
+
+#include <typeinfo>
+
+namespace Rete {
+
+  namespace {
+
+    struct Threshold_Less {
+      bool operator()(const std::pair<Symbol_Ptr_C, Rete_Predicate *> &lhs, const std::pair<Symbol_Ptr_C, Rete_Predicate *> &rhs) const {
+        return *lhs.first < *rhs.first;
+      }
+
+      bool operator()(const Symbol &lhs, const std::pair<Symbol_Ptr_C, Rete_Predicate *> &rhs) const {
+        return lhs < *rhs.first;
+      }
+
+      bool operator()(const std::pair<Symbol_Ptr_C, Rete_Predicate *> &lhs, const Symbol &rhs) const {
+        return *lhs.first < rhs;
+      }
+    };
+
+  }
+
+  Rete_Interval::Rete_Interval(const WME_Token_Index &index_)
+   : m_index(index_)
+  {
+    assert(m_index.rete_row >= m_index.token_row);
+  }
+
+  void Rete_Interval::destroy(Rete_Agent &agent, const Rete_Node_Ptr &output) {
+    for(auto thresholds : {&m_lower, &m_upper}) {
+      for(auto tt = thresholds->begin(), tend = thresholds->end(); tt != tend; ++tt) {
+        if(tt->second == output.get()) {
+          thresholds->erase(tt);
+          break;
+        }
+      }
+    }
+    outputs_all.erase(std::find(outputs_all.begin(), outputs_all.end(), output));
+
+    if(!destruction_suppressed && outputs_all.empty()) {
+      agent.erase_shared(*this);
+      input->destroy(agent, shared());
+    }
+  }
+
+  Rete_Filter_Ptr_C Rete_Interval::get_filter(const int64_t &index) const {
+    return input->get_filter(index);
+  }
+
+  const Rete_Node::Tokens & Rete_Interval::get_output_tokens() const {
+    return input->get_output_tokens();
+  }
+
+  bool Rete_Interval::has_output_tokens() const {
+    return input->has_output_tokens();
+  }
+
+  void Rete_Interval::insert_wme_token(Rete_Agent &agent, const WME_Token_Ptr_C &wme_token, const Rete_Node * const &
+#ifndef NDEBUG
+                                                                                                                     from
+#endif
+                                                                                                                         ) {
+    assert(from == input);
+
+    const Symbol &value = *(*wme_token)[m_index];
+
+    for(auto tt = m_lower.cbegin(), tend = lower_end(value); tt != tend; ++tt)
+      tt->second->insert_wme_token(agent, wme_token, this);
+    for(auto tt = upper_begin(value), tend = m_upper.cend(); tt != tend; ++tt)
+      tt->second->insert_wme_token(agent, wme_token, this);
+  }
+
+  bool Rete_Interval::remove_wme_token(Rete_Agent &agent, const WME_Token_Ptr_C &wme_token, const Rete_Node * const &
+#ifndef NDEBUG
+                                                                                                                     from
+#endif
+                                                                                                                         ) {
+    assert(from == input);
+
+    const Symbol &value = *(*wme_token)[m_index];
+
+    for(auto tt = m_lower.cbegin(), tend = lower_end(value); tt != tend; ++tt) {
+      if(tt->second->remove_wme_token(agent, wme_token, this))
+        tt->second->disconnect(agent, this);
+    }
+    for(auto tt = upper_begin(value), tend = m_upper.cend(); tt != tend; ++tt) {
+      if(tt->second->remove_wme_token(agent, wme_token, this))
+        tt->second->disconnect(agent, this);
+    }
+
+    return false;
+  }
+
+  bool Rete_Interval::modify_wme_token(Rete_Agent &agent, const WME_Token_Ptr_C &old_token, const WME_Token_Ptr_C &new_token, const Rete_Node * const &
+#ifndef NDEBUG
+                                                                                                                                                       from
+#endif
+                                                                                                                                                           ) {
+    assert(from == input);
+
+    const Symbol &old_value = *(*old_token)[m_index];
+    const Symbol &new_value = *(*new_token)[m_index];
+
+    /// Every predicate that held the old token or may accept the new one
+    const auto lower_old = lower_end(old_value);
+    const auto lower_new = lower_end(new_value);
+    const auto upper_old = upper_begin(old_value);
+    const auto upper_new = upper_begin(new_value);
+
+    for(auto tt = m_lower.cbegin(), tend = std::max(lower_old, lower_new); tt != tend; ++tt) {
+      if(tt->second->modify_wme_token(agent, old_token, new_token, this))
+        tt->second->disconnect(agent, this);
+    }
+    for(auto tt = std::min(upper_old, upper_new), tend = m_upper.cend(); tt != tend; ++tt) {
+      if(tt->second->modify_wme_token(agent, old_token, new_token, this))
+        tt->second->disconnect(agent, this);
+    }
+
+    return false;
+  }
+
+  void Rete_Interval::pass_tokens(Rete_Agent &agent, Rete_Node * const &output) {
+    for(auto &wme_token : input->get_output_tokens())
+      output->insert_wme_token(agent, wme_token, this);
+  }
+
+  void Rete_Interval::unpass_tokens(Rete_Agent &agent, Rete_Node * const &output) {
+    for(auto &wme_token : input->get_output_tokens())
+      output->remove_wme_token(agent, wme_token, this);
+  }
+
+  bool Rete_Interval::operator==(const Rete_Node &rhs) const {
+    if(auto interval = dynamic_cast<const Rete_Interval *>(&rhs))
+      return m_index == interval->m_index && input == interval->input;
+    return false;
+  }
+
+  void Rete_Interval::print_details(std::ostream &os) const {
+    os << "  " << intptr_t(this) << " [label=\"" << m_index << " &isin; [,)\"];" << std::endl;
+
+    os << "  " << intptr_t(input) << " -> " << intptr_t(this) << " [color=red];" << std::endl;
+  }
+
+  void Rete_Interval::print_rule(std::ostream &os, const Variable_Indices_Ptr_C &indices, const Rete_Node_Ptr_C &suppress) const {
+    input->print_rule(os, indices, suppress);
+  }
+
+  void Rete_Interval::output_name(std::ostream &os, const int64_t &depth) const {
+    os << "IV(" << m_index << ',';
+    if(input && depth)
+      input->output_name(os, depth - 1);
+    os << ')';
+  }
+
+  bool Rete_Interval::is_active() const {
+    return input->has_output_tokens();
+  }
+
+  std::vector<WME> Rete_Interval::get_filter_wmes() const {
+    return input->get_filter_wmes();
+  }
+
+  bool Rete_Interval::indexes(const Rete_Predicate::Predicate &predicate, const Symbol_Ptr_C &rhs) {
+    switch(predicate) {
+      case Rete_Predicate::GT:
+      case Rete_Predicate::GTE:
+      case Rete_Predicate::LT:
+      case Rete_Predicate::LTE:
+        break;
+      default:
+        return false;
+    }
+
+    /// Numeric constants are totally ordered among themselves, so a sorted threshold list agrees with the predicates' own tests
+    if(auto rhs_float = dynamic_cast<const Symbol_Constant_Float *>(rhs.get()))
+      return rhs_float->value == rhs_float->value;
+    return dynamic_cast<const Symbol_Constant_Int *>(rhs.get()) != nullptr;
+  }
+
+  Rete_Interval_Ptr Rete_Interval::find_existing(Rete_Agent &agent, const WME_Token_Index &index, const Rete_Node_Ptr &out) {
+    return agent.find_shared<Rete_Interval>(share_hash(index, out.get()), [&](const Rete_Interval &existing_interval) {
+      return existing_interval.input == out.get() && existing_interval.m_index == index;
+    });
+  }
+
+  size_t Rete_Interval::share_hash(const WME_Token_Index &index, const Rete_Node * const &out) {
+    return hash_combine(hash_combine(typeid(Rete_Interval).hash_code(), std::hash<const Rete_Node *>()(out)), std::hash<WME_Token_Index>()(index));
+  }
+
+  Rete_Predicate_Ptr Rete_Interval::find_sibling(const WME_Token_Index &index, const Rete_Node_Ptr &out) {
+    for(auto &o : out->get_outputs_all()) {
+      if(auto predicate = dynamic_pointer_cast<Rete_Predicate>(o)) {
+        if(index == predicate->get_lhs_index() && predicate->get_rhs() && indexes(predicate->get_predicate(), predicate->get_rhs()))
+          return predicate;
+      }
+    }
+
+    return nullptr;
+  }
+
+  Rete_Interval::Thresholds::const_iterator Rete_Interval::lower_end(const Symbol &value) const {
+    /// Values incomparable with the thresholds (e.g. strings) route to everything, and the predicates reject them
+    return std::upper_bound(m_lower.cbegin(), m_lower.cend(), value, Threshold_Less());
+  }
+
+  Rete_Interval::Thresholds::const_iterator Rete_Interval::upper_begin(const Symbol &value) const {
+    return std::lower_bound(m_upper.cbegin(), m_upper.cend(), value, Threshold_Less());
+  }
+
+  void Rete_Interval::insert_predicate(const Rete_Predicate_Ptr &predicate) {
+    assert(indexes(predicate->get_predicate(), predicate->get_rhs()));
+    assert(predicate->get_lhs_index() == m_index);
+
+    auto &thresholds = predicate->get_predicate() == Rete_Predicate::GT || predicate->get_predicate() == Rete_Predicate::GTE ? m_lower : m_upper;
+    const auto threshold = std::make_pair(predicate->get_rhs(), predicate.get());
+    thresholds.insert(std::upper_bound(thresholds.begin(), thresholds.end(), threshold, Threshold_Less()), threshold);
+
+    outputs_all.push_back(predicate);
+  }
+
+  void bind_to_interval(Rete_Agent &agent, const Rete_Interval_Ptr &interval, const Rete_Node_Ptr &out) {
+    assert(interval);
+    assert(!dynamic_pointer_cast<Rete_Existential>(out));
+    assert(!dynamic_pointer_cast<Rete_Negation>(out));
+    interval->input = out.get();
+    interval->height = out->get_height();
+    interval->token_owner = out->get_token_owner();
+    interval->size = out->get_size();
+    interval->token_size = out->get_token_size();
+    agent.insert_shared(*interval, Rete_Interval::share_hash(interval->m_index, out.get()));
+
+    /// Predicates already bound to out are adopted along with the tokens they hold, so nothing needs to be passed
+    while(const auto predicate = Rete_Interval::find_sibling(interval->m_index, out)) {
+      out->erase_output(predicate);
+      predicate->interval = interval.get();
+      interval->insert_predicate(predicate);
+      agent.erase_shared(*predicate);
+      agent.insert_shared(*predicate, Rete_Predicate::share_hash(predicate->m_predicate, predicate->m_lhs_index, predicate->m_rhs, interval.get()));
+    }
+
+    out->insert_output_enabled(interval);
+  }
+
+}
@@ -0,0 +1,78 @@
+#ifndef RETE_INTERVAL_H
+#define RETE_INTERVAL_H
+
+#include "rete_predicate.h"
+
+#include <vector>
+
+namespace Rete {
+
+  /// Routes tokens to sibling range predicates comparing one WME_Token_Index against numeric constants
+  /// Thresholds are kept sorted, so only predicates that can pass (or held the token) are visited
+  class RETE_LINKAGE Rete_Interval : public Rete_Node {
+    Rete_Interval(const Rete_Interval &);
+    Rete_Interval & operator=(const Rete_Interval &);
+
+    friend RETE_LINKAGE void bind_to_interval(Rete_Agent &agent, const Rete_Interval_Ptr &interval, const Rete_Node_Ptr &out);
+    friend RETE_LINKAGE void bind_to_predicate(Rete_Agent &agent, const Rete_Predicate_Ptr &predicate, const Rete_Node_Ptr &out);
+
+  public:
+    Rete_Interval(const WME_Token_Index &index_);
+
+    void destroy(Rete_Agent &agent, const Rete_Node_Ptr &output) override;
+
+    Rete_Node_Ptr_C parent_left() const override {return input->shared();}
+    Rete_Node_Ptr_C parent_right() const override {return input->shared();}
+    Rete_Node_Ptr parent_left() override {return input->shared();}
+    Rete_Node_Ptr parent_right() override {return input->shared();}
+
+    Rete_Filter_Ptr_C get_filter(const int64_t &index) const override;
+
+    const Tokens & get_output_tokens() const override;
+    bool has_output_tokens() const override;
+
+    void insert_wme_token(Rete_Agent &agent, const WME_Token_Ptr_C &wme_token, const Rete_Node * const &from) override;
+    bool remove_wme_token(Rete_Agent &agent, const WME_Token_Ptr_C &wme_token, const Rete_Node * const &from) override; ///< Holds no tokens of its own, so never reports removing the last
+    bool modify_wme_token(Rete_Agent &agent, const WME_Token_Ptr_C &old_token, const WME_Token_Ptr_C &new_token, const Rete_Node * const &from) override;
+
+    void pass_tokens(Rete_Agent &agent, Rete_Node * const &output) override;
+    void unpass_tokens(Rete_Agent &agent, Rete_Node * const &output) override;
+
+    bool operator==(const Rete_Node &rhs) const override;
+
+    void print_details(std::ostream &os) const override; ///< Formatted for dot: http://www.graphviz.org/content/dot-language
+
+    void print_rule(std::ostream &os, const Variable_Indices_Ptr_C &indices, const Rete_Node_Ptr_C &suppress) const override;
+
+    void output_name(std::ostream &os, const int64_t &depth) const override;
+
+    bool is_active() const override;
+
+    std::vector<WME> get_filter_wmes() const override;
+
+    static bool indexes(const Rete_Predicate::Predicate &predicate, const Symbol_Ptr_C &rhs); ///< Can a constant range predicate be routed by an interval index?
+    static Rete_Interval_Ptr find_existing(Rete_Agent &agent, const WME_Token_Index &index, const Rete_Node_Ptr &out);
+    static size_t share_hash(const WME_Token_Index &index, const Rete_Node * const &out);
+    static Rete_Predicate_Ptr find_sibling(const WME_Token_Index &index, const Rete_Node_Ptr &out); ///< A predicate an interval on index would adopt
+
+    const WME_Token_Index & get_index() const {return m_index;}
+
+  private:
+    typedef std::vector<std::pair<Symbol_Ptr_C, Rete_Predicate *>> Thresholds;
+
+    Thresholds::const_iterator lower_end(const Symbol &value) const; ///< GT and GTE predicates before this can pass
+    Thresholds::const_iterator upper_begin(const Symbol &value) const; ///< LT and LTE predicates from this on can pass
+
+    void insert_predicate(const Rete_Predicate_Ptr &predicate);
+
+    WME_Token_Index m_index;
+    Thresholds m_lower; ///< GT and GTE, sorted by threshold
+    Thresholds m_upper; ///< LT and LTE, sorted by threshold
+    Rete_Node * input = nullptr;
+  };
+
+  RETE_LINKAGE void bind_to_interval(Rete_Agent &agent, const Rete_Interval_Ptr &interval, const Rete_Node_Ptr &out);
+
+}
+
+#endif
@@ -1,6 +1,7 @@
 #include "rete_join.h"
 
 #include "rete_action.h"
+#include "rete_agent.h"
 #include "rete_existential.h"
 #include "rete_negation.h"
 
@@ -11,7 +12,8 @@
 namespace Rete {
 
   Rete_Join::Rete_Join(WME_Bindings bindings_)
-   : bindings(bindings_)
+   : bindings(bindings_),
+   matching(bindings)
   {
   }
 
@@ -22,6 +24,7 @@ namespace Rete {
       //output_name(std::cerr, 3);
       //std::cerr << std::endl;
 
+      agent.erase_shared(*this);
       auto i0 = input0;
       auto i1 = input1;
       auto o = shared();
@@ -65,13 +68,15 @@ namespace Rete {
       }
 #endif
 
-      auto &match = matching[std::make_pair(wme_token, true)];
-      const auto inserted = match.first.insert(wme_token);
-      if(inserted.second) {
+      auto &match = matching.insert(wme_token, true);
+      if(match.insert(true, wme_token)) {
         ++input0_count;
+        match.outputs.emplace_back();
+        match.outputs.back().reserve(match.second.size());
         for(const auto &other : match.second) {
 //          std::cerr << "Savings: " << match.second.size() << " / " << input1_tokens.size() << std::endl;
-          join_tokens(agent, *inserted.first, other);
+          const auto output = join_tokens(agent, wme_token, other);
+          match.outputs.back().push_back(output);
         }
       }
 //      for(const auto &other : input1_tokens) {
@@ -105,13 +110,13 @@ namespace Rete {
       }
 #endif
 
-      auto &match = matching[std::make_pair(wme_token, false)];
-      const auto inserted = match.second.insert(wme_token);
-      if(inserted.second) {
+      auto &match = matching.insert(wme_token, false);
+      if(match.insert(false, wme_token)) {
         ++input1_count;
-        for(const auto &other : match.first) {
+        for(size_t i = 0, iend = match.first.size(); i != iend; ++i) {
 //          std::cerr << "Savings: " << match.first.size() << " / " << input0_tokens.size() << std::endl;
-          join_tokens(agent, other, *inserted.first);
+          const auto output = join_tokens(agent, match.first[i], wme_token);
+          match.outputs[i].push_back(output);
         }
       }
 //      for(const auto &other : input0_tokens) {
@@ -138,71 +143,86 @@ namespace Rete {
     bool emptied = false;
 
     if(from == input0) {
-      const auto index = std::make_pair(wme_token, true);
-      auto &match = matching[index];
-      auto found2 = match.first.find(wme_token);
+      if(const auto match = matching.find(*wme_token, true)) {
+        const int64_t found2 = match->find(true, *wme_token);
 
-      if(found2 != match.first.end()) {
-        for(const auto &other : match.second) {
-          auto found_output = output_tokens.find(join_wme_tokens(*found2, other));
-          if(found_output != output_tokens.end()) {
-            for(auto ot = outputs_all.begin(), oend = outputs_all.end(); ot != oend; ) {
-              if((*ot)->remove_wme_token(agent, (*found_output), this))
-                (*ot++)->disconnect(agent, this);
-              else
-                ++ot;
-            }
-            output_tokens.erase(found_output);
-          }
-        }
-        match.first.erase(found2);
+        if(found2 >= 0) {
+          for(const auto &output : match->outputs[size_t(found2)])
+            unjoin_token(agent, output);
+          match->erase(true, size_t(found2));
 //          for(const auto &other : input1_tokens) {
 //            auto found_output = find_deref(output_tokens, join_wme_tokens(wme_token, other));
 //            if(found_output != output_tokens.end())
 //              abort();
 //          }
 
-        emptied ^= !--input0_count;
-      }
+          emptied ^= !--input0_count;
+        }
 
-      if(match.first.empty() && match.second.empty())
-        matching.erase(index);
+        if(match->empty())
+          matching.erase(match);
+      }
     }
     if(from == input1) {
-      const auto index = std::make_pair(wme_token, false);
-      auto &match = matching[index];
-      auto found2 = match.second.find(wme_token);
-
-      if(found2 != match.second.end()) {
-        for(const auto &other : match.first) {
-          auto found_output = output_tokens.find(join_wme_tokens(other, *found2));
-          if(found_output != output_tokens.end()) {
-            for(auto ot = outputs_all.begin(), oend = outputs_all.end(); ot != oend; ) {
-              if((*ot)->remove_wme_token(agent, (*found_output), this))
-                (*ot++)->disconnect(agent, this);
-              else
-                ++ot;
-            }
-            output_tokens.erase(found_output);
-          }
-        }
-        match.second.erase(found2);
+      if(const auto match = matching.find(*wme_token, false)) {
+        const int64_t found2 = match->find(false, *wme_token);
+
+        if(found2 >= 0) {
+          for(const auto &row : match->outputs)
+            unjoin_token(agent, row[size_t(found2)]);
+          match->erase(false, size_t(found2));
 //          for(const auto &other : input0_tokens) {
 //            auto found_output = find_deref(output_tokens, join_wme_tokens(wme_token, other));
 //            if(found_output != output_tokens.end())
 //              abort();
 //          }
 
-        emptied ^= !--input1_count;
-      }
+          emptied ^= !--input1_count;
+        }
 
-      if(match.second.empty() && match.first.empty())
-        matching.erase(index);
+        if(match->empty())
+          matching.erase(match);
+      }
     }
 
     return emptied;
   }
 
+  bool Rete_Join::modify_wme_token(Rete_Agent &agent, const WME_Token_Ptr_C &old_token, const WME_Token_Ptr_C &new_token, const Rete_Node * const &from) {
+    assert(from == input0 || from == input1);
+
+    /// If the bound symbols are unchanged, the token keeps its partners and its joins can be substituted in place
+    const bool from_left = from == input0;
+    bool rebound = input0 == input1;
+    for(const auto &binding : bindings) {
+      const auto &index = from_left ? binding.first : binding.second;
+      rebound |= *(*old_token)[index] != *(*new_token)[index];
+    }
+
+    Join_Memory::Match * const match = rebound ? nullptr : matching.find(*old_token, from_left);
+    if(!match)
+      return Rete_Node::modify_wme_token(agent, old_token, new_token, from);
+
+    const int64_t found = match->find(from_left, *old_token);
+    if(found < 0)
+      return Rete_Node::modify_wme_token(agent, old_token, new_token, from);
+
+    const size_t index = size_t(found);
+    match->replace(from_left, index, new_token);
+
+    if(from_left) {
+      auto &row = match->outputs[index];
+      for(size_t j = 0, jend = row.size(); j != jend; ++j)
+        row[j] = rejoin_token(agent, row[j], join_wme_tokens(new_token, match->second[j]));
+    }
+    else {
+      for(size_t i = 0, iend = match->first.size(); i != iend; ++i)
+        match->outputs[i][index] = rejoin_token(agent, match->outputs[i][index], join_wme_tokens(match->first[i], new_token));
+    }
+
+    return false;
+  }
+
   bool Rete_Join::operator==(const Rete_Node &rhs) const {
     if(auto join = dynamic_cast<const Rete_Join *>(&rhs))
       return bindings == join->bindings && input0 == join->input0 && input1 == join->input1;
@@ -287,23 +307,20 @@ namespace Rete {
     return filter_wmes0;
   }
 
-  Rete_Join_Ptr Rete_Join::find_existing(const WME_Bindings &bindings, const Rete_Node_Ptr &out0, const Rete_Node_Ptr &out1) {
-    if(get_Option_Ranged<bool>(Options::get_global(), "rete-disable-node-sharing"))
+  Rete_Join_Ptr Rete_Join::find_existing(Rete_Agent &agent, const WME_Bindings &bindings, const Rete_Node_Ptr &out0, const Rete_Node_Ptr &out1) {
+    if(get_Option_Ranged<bool>(agent.get_context().get_options(), "rete-disable-node-sharing"))
       return nullptr;
 
-    for(auto &o0 : out0->get_outputs_all()) {
-      if(auto existing_join = std::dynamic_pointer_cast<Rete_Join>(o0)) {
-        if(std::find(out1->get_outputs_all().begin(), out1->get_outputs_all().end(), existing_join) != out1->get_outputs_all().end()) {
-          if(bindings == existing_join->bindings)
-            return existing_join;
-        }
-      }
-    }
+    return agent.find_shared<Rete_Join>(share_hash(bindings, out0.get(), out1.get()), [&](const Rete_Join &existing_join) {
+      return existing_join.input0 == out0.get() && existing_join.input1 == out1.get() && existing_join.bindings == bindings;
+    });
+  }
 
-    return nullptr;
+  size_t Rete_Join::share_hash(const WME_Bindings &bindings, const Rete_Node * const &out0, const Rete_Node * const &out1) {
+    return hash_combine(hash_combine(hash_combine(typeid(Rete_Join).hash_code(), std::hash<const Rete_Node *>()(out0)), std::hash<const Rete_Node *>()(out1)), hash_container<WME_Binding>()(bindings));
   }
 
-  void Rete_Join::join_tokens(Rete_Agent &agent, const WME_Token_Ptr_C &lhs, const WME_Token_Ptr_C &rhs) {
+  WME_Token_Ptr_C Rete_Join::join_tokens(Rete_Agent &agent, const WME_Token_Ptr_C &lhs, const WME_Token_Ptr_C &rhs) {
 //    for(auto &binding : bindings) {
 //      if(*(*lhs)[binding.first] != *(*rhs)[binding.second])
 //        return;
@@ -319,11 +336,44 @@ namespace Rete {
       for(auto &output : *outputs_enabled)
         output.ptr->insert_wme_token(agent, (*token.first), this);
     }
+
+    return *token.first;
+  }
+
+  void Rete_Join::unjoin_token(Rete_Agent &agent, const WME_Token_Ptr_C &output) {
+    /// The hash is cached in the token and equality only compares pointers, so this neither allocates nor rehashes
+    auto found_output = output_tokens.find(output);
+    if(found_output != output_tokens.end()) {
+      for(auto ot = outputs_all.begin(), oend = outputs_all.end(); ot != oend; ) {
+        if((*ot)->remove_wme_token(agent, (*found_output), this))
+          (*ot++)->disconnect(agent, this);
+        else
+          ++ot;
+      }
+      output_tokens.erase(found_output);
+    }
+  }
+
+  WME_Token_Ptr_C Rete_Join::rejoin_token(Rete_Agent &agent, const WME_Token_Ptr_C &old_output, const WME_Token_Ptr_C &new_output) {
+    const auto found_output = output_tokens.find(old_output);
+    if(found_output == output_tokens.end()) {
+      /// Joins with empty tokens share an output, which has then already been substituted
+      const auto substituted = output_tokens.find(new_output);
+      assert(substituted != output_tokens.end());
+      return *substituted;
+    }
+    output_tokens.erase(found_output);
+
+    const auto token = output_tokens.insert(new_output);
+    assert(token.second);
+    modify_output_tokens(agent, old_output, *token.first);
+
+    return *token.first;
   }
 
   WME_Token_Ptr_C Rete_Join::join_wme_tokens(const WME_Token_Ptr_C lhs, const WME_Token_Ptr_C &rhs) const {
     if(rhs->size())
-      return std::make_shared<WME_Token>(lhs, rhs);
+      return WME_Token::create(lhs, rhs);
     else
       return lhs;
   }
@@ -397,14 +447,15 @@ namespace Rete {
 
   void bind_to_join(Rete_Agent &agent, const Rete_Join_Ptr &join, const Rete_Node_Ptr &out0, const Rete_Node_Ptr &out1) {
     assert(join && !join->input0 && !join->input1);
-    assert(!std::dynamic_pointer_cast<Rete_Existential>(out0));
-    assert(!std::dynamic_pointer_cast<Rete_Negation>(out0));
+    assert(!dynamic_pointer_cast<Rete_Existential>(out0));
+    assert(!dynamic_pointer_cast<Rete_Negation>(out0));
     join->input0 = out0.get();
     join->input1 = out1.get();
     join->height = std::max(out0->get_height(), out1->get_height()) + 1;
     join->token_owner = join;
     join->size = out0->get_size() + out1->get_size();
     join->token_size = out0->get_token_size() + out1->get_token_size();
+    agent.insert_shared(*join, Rete_Join::share_hash(join->bindings, out0.get(), out1.get()));
 
 #ifdef RETE_LR_UNLINKING
     if(!out1->has_output_tokens()) {
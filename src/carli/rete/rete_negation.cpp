@@ -1,11 +1,14 @@
 #include "rete_negation.h"
 
 #include "rete_action.h"
+#include "rete_agent.h"
+
+#include <typeinfo>
 
 namespace Rete {
 
   Rete_Negation::Rete_Negation()
-    : output_token(std::make_shared<WME_Token>())
+    : output_token(WME_Token::create())
   {
     output_tokens.insert(output_token);
   }
@@ -17,6 +20,7 @@ namespace Rete {
       //output_name(std::cerr, 3);
       //std::cerr << std::endl;
 
+      agent.erase_shared(*this);
       input->destroy(agent, shared());
     }
   }
@@ -126,16 +130,17 @@ namespace Rete {
     return input->get_filter_wmes();
   }
 
-  Rete_Negation_Ptr Rete_Negation::find_existing(const Rete_Node_Ptr &out) {
-    if(get_Option_Ranged<bool>(Options::get_global(), "rete-disable-node-sharing"))
+  Rete_Negation_Ptr Rete_Negation::find_existing(Rete_Agent &agent, const Rete_Node_Ptr &out) {
+    if(get_Option_Ranged<bool>(agent.get_context().get_options(), "rete-disable-node-sharing"))
       return nullptr;
 
-    for(auto &o : out->get_outputs_all()) {
-      if(auto existing_negation = std::dynamic_pointer_cast<Rete_Negation>(o))
-        return existing_negation;
-    }
+    return agent.find_shared<Rete_Negation>(share_hash(out.get()), [&](const Rete_Negation &existing_negation) {
+      return existing_negation.input == out.get();
+    });
+  }
 
-    return nullptr;
+  size_t Rete_Negation::share_hash(const Rete_Node * const &out) {
+    return hash_combine(typeid(Rete_Negation).hash_code(), std::hash<const Rete_Node *>()(out));
   }
 
   void bind_to_negation(Rete_Agent &agent, const Rete_Negation_Ptr &negation, const Rete_Node_Ptr &out) {
@@ -145,6 +150,7 @@ namespace Rete {
     negation->token_owner = out->get_token_owner();
     negation->size = out->get_size();
     negation->token_size = out->get_token_size();
+    agent.insert_shared(*negation, Rete_Negation::share_hash(out.get()));
     out->insert_output_enabled(negation);
     out->pass_tokens(agent, negation.get());
   }
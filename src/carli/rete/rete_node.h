@@ -21,33 +21,47 @@ namespace Rete {
   class Rete_Existential;
   class Rete_Existential_Join;
   class Rete_Filter;
+  class Rete_Interval;
   class Rete_Join;
   class Rete_Negation;
   class Rete_Negation_Join;
   class Rete_Node;
   class Rete_Predicate;
 
-  typedef std::shared_ptr<const Rete_Action> Rete_Action_Ptr_C;
+  typedef Shared_Ptr<const Rete_Action> Rete_Action_Ptr_C;
   typedef std::shared_ptr<const Rete_Data> Rete_Data_Ptr_C;
-  typedef std::shared_ptr<const Rete_Existential> Rete_Existential_Ptr_C;
-  typedef std::shared_ptr<const Rete_Existential_Join> Rete_Existential_Join_Ptr_C;
-  typedef std::shared_ptr<const Rete_Filter> Rete_Filter_Ptr_C;
-  typedef std::shared_ptr<const Rete_Join> Rete_Join_Ptr_C;
-  typedef std::shared_ptr<const Rete_Negation> Rete_Negation_Ptr_C;
-  typedef std::shared_ptr<const Rete_Negation_Join> Rete_Negation_Join_Ptr_C;
-  typedef std::shared_ptr<const Rete_Node> Rete_Node_Ptr_C;
-  typedef std::shared_ptr<const Rete_Predicate> Rete_Predicate_Ptr_C;
-
-  typedef std::shared_ptr<Rete_Action> Rete_Action_Ptr;
+  typedef Shared_Ptr<const Rete_Existential> Rete_Existential_Ptr_C;
+  typedef Shared_Ptr<const Rete_Existential_Join> Rete_Existential_Join_Ptr_C;
+  typedef Shared_Ptr<const Rete_Filter> Rete_Filter_Ptr_C;
+  typedef Shared_Ptr<const Rete_Interval> Rete_Interval_Ptr_C;
+  typedef Shared_Ptr<const Rete_Join> Rete_Join_Ptr_C;
+  typedef Shared_Ptr<const Rete_Negation> Rete_Negation_Ptr_C;
+  typedef Shared_Ptr<const Rete_Negation_Join> Rete_Negation_Join_Ptr_C;
+  typedef Shared_Ptr<const Rete_Node> Rete_Node_Ptr_C;
+  typedef Shared_Ptr<const Rete_Predicate> Rete_Predicate_Ptr_C;
+
+  typedef Shared_Ptr<Rete_Action> Rete_Action_Ptr;
   typedef std::shared_ptr<Rete_Data> Rete_Data_Ptr;
-  typedef std::shared_ptr<Rete_Existential> Rete_Existential_Ptr;
-  typedef std::shared_ptr<Rete_Existential_Join> Rete_Existential_Join_Ptr;
-  typedef std::shared_ptr<Rete_Filter> Rete_Filter_Ptr;
-  typedef std::shared_ptr<Rete_Join> Rete_Join_Ptr;
-  typedef std::shared_ptr<Rete_Negation> Rete_Negation_Ptr;
-  typedef std::shared_ptr<Rete_Negation_Join> Rete_Negation_Join_Ptr;
-  typedef std::shared_ptr<Rete_Node> Rete_Node_Ptr;
-  typedef std::shared_ptr<Rete_Predicate> Rete_Predicate_Ptr;
+  typedef Shared_Ptr<Rete_Existential> Rete_Existential_Ptr;
+  typedef Shared_Ptr<Rete_Existential_Join> Rete_Existential_Join_Ptr;
+  typedef Shared_Ptr<Rete_Filter> Rete_Filter_Ptr;
+  typedef Shared_Ptr<Rete_Interval> Rete_Interval_Ptr;
+  typedef Shared_Ptr<Rete_Join> Rete_Join_Ptr;
+  typedef Shared_Ptr<Rete_Negation> Rete_Negation_Ptr;
+  typedef Shared_Ptr<Rete_Negation_Join> Rete_Negation_Join_Ptr;
+  typedef Shared_Ptr<Rete_Node> Rete_Node_Ptr;
+  typedef Shared_Ptr<Rete_Predicate> Rete_Predicate_Ptr;
+
+  typedef Weak_Ptr<Rete_Action> Rete_Action_Ptr_W;
+  typedef Weak_Ptr<Rete_Existential> Rete_Existential_Ptr_W;
+  typedef Weak_Ptr<Rete_Existential_Join> Rete_Existential_Join_Ptr_W;
+  typedef Weak_Ptr<Rete_Filter> Rete_Filter_Ptr_W;
+  typedef Weak_Ptr<Rete_Interval> Rete_Interval_Ptr_W;
+  typedef Weak_Ptr<Rete_Join> Rete_Join_Ptr_W;
+  typedef Weak_Ptr<Rete_Negation> Rete_Negation_Ptr_W;
+  typedef Weak_Ptr<Rete_Negation_Join> Rete_Negation_Join_Ptr_W;
+  typedef Weak_Ptr<Rete_Node> Rete_Node_Ptr_W;
+  typedef Weak_Ptr<Rete_Predicate> Rete_Predicate_Ptr_W;
 
   class RETE_LINKAGE Rete_Data {
     Rete_Data(const Rete_Data &);
@@ -68,15 +82,21 @@ namespace Rete {
     virtual Rete_Node_Ptr_C get_suppress() const = 0;
   };
 
-  class RETE_LINKAGE Rete_Node : public std::enable_shared_from_this<Rete_Node>, public Zeni::Pool_Allocator<char [512]>
+#ifdef RETE_INTRUSIVE_PTR
+  class RETE_LINKAGE Rete_Node : public Intrusive_Weak_Counted, public Zeni::Pool_Allocator<Rete_Node>
+#else
+  class RETE_LINKAGE Rete_Node : public std::enable_shared_from_this<Rete_Node>, public Zeni::Pool_Allocator<Rete_Node>
+#endif
   {
     Rete_Node(const Rete_Node &);
     Rete_Node & operator=(const Rete_Node &);
 
+    friend class Rete_Agent;
     friend RETE_LINKAGE void bind_to_action(Rete_Agent &agent, const Rete_Action_Ptr &action, const Rete_Node_Ptr &out);
     friend RETE_LINKAGE void bind_to_existential(Rete_Agent &agent, const Rete_Existential_Ptr &existential, const Rete_Node_Ptr &out);
     friend RETE_LINKAGE void bind_to_existential_join(Rete_Agent &agent, const Rete_Existential_Join_Ptr &join, const Rete_Node_Ptr &out0, const Rete_Node_Ptr &out1);
     friend RETE_LINKAGE void bind_to_filter(Rete_Agent &agent, const Rete_Filter_Ptr &filter);
+    friend RETE_LINKAGE void bind_to_interval(Rete_Agent &agent, const Rete_Interval_Ptr &interval, const Rete_Node_Ptr &out);
     friend RETE_LINKAGE void bind_to_join(Rete_Agent &agent, const Rete_Join_Ptr &join, const Rete_Node_Ptr &out0, const Rete_Node_Ptr &out1);
     friend RETE_LINKAGE void bind_to_negation(Rete_Agent &agent, const Rete_Negation_Ptr &negation, const Rete_Node_Ptr &out);
     friend RETE_LINKAGE void bind_to_negation_join(Rete_Agent &agent, const Rete_Negation_Join_Ptr &join, const Rete_Node_Ptr &out0, const Rete_Node_Ptr &out1);
@@ -139,12 +159,13 @@ namespace Rete {
       destruction_suppressed = suppress;
     }
 
-    std::shared_ptr<const Rete_Node> shared() const {
-      return shared_from_this();
-    }
-    std::shared_ptr<Rete_Node> shared() {
-      return shared_from_this();
-    }
+#ifdef RETE_INTRUSIVE_PTR
+    Rete_Node_Ptr_C shared() const {return Rete_Node_Ptr_C(this);}
+    Rete_Node_Ptr shared() {return Rete_Node_Ptr(this);}
+#else
+    Rete_Node_Ptr_C shared() const {return shared_from_this();}
+    Rete_Node_Ptr shared() {return shared_from_this();}
+#endif
 
     const Output_Ptrs & get_outputs_all() const {
       return outputs_all;
@@ -167,6 +188,11 @@ namespace Rete {
 
     virtual void insert_wme_token(Rete_Agent &agent, const WME_Token_Ptr_C &wme_token, const Rete_Node * const &from) = 0;
     virtual bool remove_wme_token(Rete_Agent &agent, const WME_Token_Ptr_C &wme_token, const Rete_Node * const &from) = 0; ///< Returns true if removed the last
+    /// Replace a token whose WME had its value modified; by default an insertion followed by a removal. Returns true if removed the last
+    virtual bool modify_wme_token(Rete_Agent &agent, const WME_Token_Ptr_C &old_token, const WME_Token_Ptr_C &new_token, const Rete_Node * const &from) {
+      insert_wme_token(agent, new_token, from);
+      return remove_wme_token(agent, old_token, from);
+    }
 
     virtual void disconnect(Rete_Agent &/*agent*/, const Rete_Node * const &/*from*/) {}
 
@@ -247,18 +273,28 @@ namespace Rete {
     Rete_Data_Ptr data;
 
   protected:
+    void modify_output_tokens(Rete_Agent &agent, const WME_Token_Ptr_C &old_token, const WME_Token_Ptr_C &new_token) {
+      for(auto ot = outputs_enabled->begin(), oend = outputs_enabled->end(); ot != oend; ) {
+        if((*ot)->modify_wme_token(agent, old_token, new_token, this))
+          (*ot++)->disconnect(agent, this);
+        else
+          ++ot;
+      }
+    }
+
     bool destruction_suppressed = false;
     Output_Ptrs outputs_all;
     Outputs outputs_enabled;
     Outputs outputs_disabled;
 
     int64_t height = 0;
-    std::weak_ptr<const Rete_Node> token_owner;
+    Weak_Ptr<const Rete_Node> token_owner;
     int64_t size = -1;
     int64_t token_size = -1;
 
   private:
     intptr_t visitor_value = 0;
+    size_t share_key = 0; ///< Structural hash under which the Rete_Agent indexes this node for sharing
   };
 
 }
@@ -1,10 +1,13 @@
 #include "rete_predicate.h"
 
 #include "rete_action.h"
+#include "rete_agent.h"
 #include "rete_existential.h"
+#include "rete_interval.h"
 #include "rete_negation.h"
 
 #include <sstream>
+#include <typeinfo>
 
 namespace Rete {
 
@@ -32,7 +35,11 @@ namespace Rete {
       //output_name(std::cerr, 3);
       //std::cerr << std::endl;
 
-      input->destroy(agent, shared());
+      agent.erase_shared(*this);
+      if(interval)
+        interval->destroy(agent, shared());
+      else
+        input->destroy(agent, shared());
     }
   }
 
@@ -53,16 +60,10 @@ namespace Rete {
                                                                                                                       from
 #endif
                                                                                                                           ) {
-    assert(from == input);
+    assert(from == input || from == interval);
 
-    if(m_rhs) {
-      if(!test_predicate((*wme_token)[m_lhs_index], m_rhs))
-        return;
-    }
-    else {
-      if(!test_predicate((*wme_token)[m_lhs_index], (*wme_token)[m_rhs_index]))
-        return;
-    }
+    if(!test_predicate(*wme_token))
+      return;
 
     const auto inserted = tokens.insert(wme_token);
     if(inserted.second) {
@@ -76,7 +77,7 @@ namespace Rete {
                                                                                                                       from
 #endif
                                                                                                                           ) {
-    assert(from == input);
+    assert(from == input || from == interval);
 
     auto found = tokens.find(wme_token);
     if(found != tokens.end()) {
@@ -92,6 +93,27 @@ namespace Rete {
     return tokens.empty();
   }
 
+  bool Rete_Predicate::modify_wme_token(Rete_Agent &agent, const WME_Token_Ptr_C &old_token, const WME_Token_Ptr_C &new_token, const Rete_Node * const &from) {
+    assert(from == input || from == interval);
+
+    const auto found = tokens.find(old_token);
+    const bool passed = found != tokens.end();
+    /// Only a change to one of the compared symbols can flip the outcome
+    const bool passes = same_operands(*old_token, *new_token) ? passed : test_predicate(*new_token);
+
+    if(passed && passes) {
+      tokens.erase(found);
+      tokens.insert(new_token);
+      modify_output_tokens(agent, old_token, new_token);
+    }
+    else if(passed)
+      return remove_wme_token(agent, old_token, from);
+    else if(passes)
+      insert_wme_token(agent, new_token, from);
+
+    return tokens.empty();
+  }
+
   void Rete_Predicate::pass_tokens(Rete_Agent &agent, Rete_Node * const &output) {
     for(auto &wme_token : tokens)
       output->insert_wme_token(agent, wme_token, this);
@@ -133,7 +155,7 @@ namespace Rete {
       os << m_rhs_index;
     os << "\"];" << std::endl;
 
-    os << "  " << intptr_t(input) << " -> " << intptr_t(this) << " [color=red];" << std::endl;
+    os << "  " << intptr_t(interval ? interval : input) << " -> " << intptr_t(this) << " [color=red];" << std::endl;
   }
 
   void Rete_Predicate::print_rule(std::ostream &os, const Variable_Indices_Ptr_C &indices, const Rete_Node_Ptr_C &suppress) const {
@@ -195,37 +217,35 @@ namespace Rete {
     return input->get_filter_wmes();
   }
 
-  Rete_Predicate_Ptr Rete_Predicate::find_existing(const Predicate &predicate, const WME_Token_Index &lhs_index, const WME_Token_Index &rhs_index, const Rete_Node_Ptr &out) {
-    for(auto &o : out->get_outputs_all()) {
-      if(auto existing_predicate = std::dynamic_pointer_cast<Rete_Predicate>(o)) {
-        if(predicate == existing_predicate->m_predicate &&
-           lhs_index == existing_predicate->m_lhs_index &&
-           rhs_index == existing_predicate->m_rhs_index)
-        {
-          return existing_predicate;
-        }
-      }
-    }
-
-    return nullptr;
+  Rete_Predicate_Ptr Rete_Predicate::find_existing(Rete_Agent &agent, const Predicate &predicate, const WME_Token_Index &lhs_index, const WME_Token_Index &rhs_index, const Rete_Node_Ptr &out) {
+    return agent.find_shared<Rete_Predicate>(share_hash(predicate, lhs_index, rhs_index, out.get()), [&](const Rete_Predicate &existing_predicate) {
+      return existing_predicate.parent() == out.get() &&
+             predicate == existing_predicate.m_predicate &&
+             lhs_index == existing_predicate.m_lhs_index &&
+             !existing_predicate.m_rhs &&
+             rhs_index == existing_predicate.m_rhs_index;
+    });
   }
 
-  Rete_Predicate_Ptr Rete_Predicate::find_existing(const Predicate &predicate, const WME_Token_Index &lhs_index, const Symbol_Ptr_C &rhs, const Rete_Node_Ptr &out) {
-    if(get_Option_Ranged<bool>(Options::get_global(), "rete-disable-node-sharing"))
+  Rete_Predicate_Ptr Rete_Predicate::find_existing(Rete_Agent &agent, const Predicate &predicate, const WME_Token_Index &lhs_index, const Symbol_Ptr_C &rhs, const Rete_Node_Ptr &out) {
+    if(get_Option_Ranged<bool>(agent.get_context().get_options(), "rete-disable-node-sharing"))
       return nullptr;
 
-    for(auto &o : out->get_outputs_all()) {
-      if(auto existing_predicate = std::dynamic_pointer_cast<Rete_Predicate>(o)) {
-        if(predicate == existing_predicate->m_predicate &&
-           lhs_index == existing_predicate->m_lhs_index &&
-           *rhs == *existing_predicate->m_rhs)
-        {
-          return existing_predicate;
-        }
-      }
-    }
+    return agent.find_shared<Rete_Predicate>(share_hash(predicate, lhs_index, rhs, out.get()), [&](const Rete_Predicate &existing_predicate) {
+      return existing_predicate.parent() == out.get() &&
+             predicate == existing_predicate.m_predicate &&
+             lhs_index == existing_predicate.m_lhs_index &&
+             existing_predicate.m_rhs &&
+             *rhs == *existing_predicate.m_rhs;
+    });
+  }
 
-    return nullptr;
+  size_t Rete_Predicate::share_hash(const Predicate &predicate, const WME_Token_Index &lhs_index, const WME_Token_Index &rhs_index, const Rete_Node * const &out) {
+    return hash_combine(hash_combine(hash_combine(hash_combine(typeid(Rete_Predicate).hash_code(), std::hash<const Rete_Node *>()(out)), std::hash<int>()(predicate)), std::hash<WME_Token_Index>()(lhs_index)), std::hash<WME_Token_Index>()(rhs_index));
+  }
+
+  size_t Rete_Predicate::share_hash(const Predicate &predicate, const WME_Token_Index &lhs_index, const Symbol_Ptr_C &rhs, const Rete_Node * const &out) {
+    return hash_combine(hash_combine(hash_combine(hash_combine(typeid(Rete_Predicate).hash_code(), std::hash<const Rete_Node *>()(out)), std::hash<int>()(predicate)), std::hash<WME_Token_Index>()(lhs_index)), rhs->hash());
   }
 
   std::string Rete_Predicate::get_predicate_str() const {
@@ -252,17 +272,42 @@ namespace Rete {
     }
   }
 
+  bool Rete_Predicate::test_predicate(const WME_Token &wme_token) const {
+    return test_predicate(wme_token[m_lhs_index], m_rhs ? m_rhs : wme_token[m_rhs_index]);
+  }
+
+  bool Rete_Predicate::same_operands(const WME_Token &lhs, const WME_Token &rhs) const {
+    return lhs[m_lhs_index] == rhs[m_lhs_index] && (m_rhs || lhs[m_rhs_index] == rhs[m_rhs_index]);
+  }
+
+  const Rete_Node * Rete_Predicate::parent() const {
+    if(interval)
+      return interval;
+    return input;
+  }
+
   void bind_to_predicate(Rete_Agent &agent, const Rete_Predicate_Ptr &predicate, const Rete_Node_Ptr &out) {
     assert(predicate);
-    assert(!std::dynamic_pointer_cast<Rete_Existential>(out));
-    assert(!std::dynamic_pointer_cast<Rete_Negation>(out));
+    assert(!dynamic_pointer_cast<Rete_Existential>(out));
+    assert(!dynamic_pointer_cast<Rete_Negation>(out));
     predicate->input = out.get();
     predicate->height = out->get_height() + 1;
     predicate->token_owner = out->get_token_owner();
     predicate->size = out->get_size() + 1;
     predicate->token_size = out->get_token_size();
 
-    out->insert_output_enabled(predicate);
+    if(auto interval = dynamic_pointer_cast<Rete_Interval>(out)) {
+      /// The interval stands in for its input, which remains the parent of the predicate
+      predicate->input = interval->input;
+      predicate->interval = interval.get();
+      interval->insert_predicate(predicate);
+    }
+    else
+      out->insert_output_enabled(predicate);
+    if(predicate->m_rhs)
+      agent.insert_shared(*predicate, Rete_Predicate::share_hash(predicate->m_predicate, predicate->m_lhs_index, predicate->m_rhs, out.get()));
+    else
+      agent.insert_shared(*predicate, Rete_Predicate::share_hash(predicate->m_predicate, predicate->m_lhs_index, predicate->m_rhs_index, out.get()));
     out->pass_tokens(agent, predicate.get());
   }
 
@@ -9,6 +9,7 @@ namespace Rete {
     Rete_Predicate(const Rete_Predicate &);
     Rete_Predicate & operator=(const Rete_Predicate &);
 
+    friend RETE_LINKAGE void bind_to_interval(Rete_Agent &agent, const Rete_Interval_Ptr &interval, const Rete_Node_Ptr &out);
     friend RETE_LINKAGE void bind_to_predicate(Rete_Agent &agent, const Rete_Predicate_Ptr &predicate, const Rete_Node_Ptr &out);
 
   public:
@@ -31,6 +32,7 @@ namespace Rete {
 
     void insert_wme_token(Rete_Agent &agent, const WME_Token_Ptr_C &wme_token, const Rete_Node * const &from) override;
     bool remove_wme_token(Rete_Agent &agent, const WME_Token_Ptr_C &wme_token, const Rete_Node * const &from) override;
+    bool modify_wme_token(Rete_Agent &agent, const WME_Token_Ptr_C &old_token, const WME_Token_Ptr_C &new_token, const Rete_Node * const &from) override;
 
     void pass_tokens(Rete_Agent &agent, Rete_Node * const &output) override;
     void unpass_tokens(Rete_Agent &agent, Rete_Node * const &output) override;
@@ -47,8 +49,10 @@ namespace Rete {
 
     std::vector<WME> get_filter_wmes() const override;
 
-    static Rete_Predicate_Ptr find_existing(const Predicate &predicate, const WME_Token_Index &lhs_index, const WME_Token_Index &rhs_index, const Rete_Node_Ptr &out);
-    static Rete_Predicate_Ptr find_existing(const Predicate &predicate, const WME_Token_Index &lhs_index, const Symbol_Ptr_C &rhs, const Rete_Node_Ptr &out);
+    static Rete_Predicate_Ptr find_existing(Rete_Agent &agent, const Predicate &predicate, const WME_Token_Index &lhs_index, const WME_Token_Index &rhs_index, const Rete_Node_Ptr &out);
+    static Rete_Predicate_Ptr find_existing(Rete_Agent &agent, const Predicate &predicate, const WME_Token_Index &lhs_index, const Symbol_Ptr_C &rhs, const Rete_Node_Ptr &out);
+    static size_t share_hash(const Predicate &predicate, const WME_Token_Index &lhs_index, const WME_Token_Index &rhs_index, const Rete_Node * const &out);
+    static size_t share_hash(const Predicate &predicate, const WME_Token_Index &lhs_index, const Symbol_Ptr_C &rhs, const Rete_Node * const &out);
 
     const WME_Token_Index & get_lhs_index() const {return m_lhs_index;}
     const Predicate & get_predicate() const {return m_predicate;}
@@ -58,12 +62,16 @@ namespace Rete {
 
   private:
     bool test_predicate(const Symbol_Ptr_C &lhs, const Symbol_Ptr_C &rhs) const;
+    bool test_predicate(const WME_Token &wme_token) const;
+    bool same_operands(const WME_Token &lhs, const WME_Token &rhs) const; ///< Are the symbols being compared identical in both tokens?
+    const Rete_Node * parent() const; ///< The interval if routed, otherwise the input
 
     Predicate m_predicate;
     WME_Token_Index m_lhs_index;
     WME_Token_Index m_rhs_index;
     Symbol_Ptr_C m_rhs;
     Rete_Node * input = nullptr;
+    Rete_Interval * interval = nullptr; ///< Routes tokens from input when set
     Tokens tokens;
   };
 
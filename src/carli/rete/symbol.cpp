@@ -0,0 +1,132 @@
+#include "symbol.h"
+
+#include "../utility/runtime_context.h"
+
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+namespace Rete {
+
+  namespace {
+
+    /// Maps values to their canonical symbols without keeping them alive; expired entries are pruned as the table grows
+    template <typename KEY, typename SYMBOL>
+    class Symbol_Table {
+      Symbol_Table(const Symbol_Table &);
+      Symbol_Table & operator=(const Symbol_Table &);
+
+    public:
+      Symbol_Table() {}
+
+      template <typename VALUE>
+      Shared_Ptr<const SYMBOL> intern(const KEY &key, const VALUE &value) {
+        auto &entry = m_symbols[key];
+        auto symbol = entry.lock();
+        if(!symbol) {
+          symbol = make_pooled<SYMBOL>(value);
+          entry = symbol;
+          if(m_symbols.size() >= m_prune_size)
+            prune();
+        }
+        return symbol;
+      }
+
+    private:
+      void prune() {
+        for(auto st = m_symbols.begin(), send = m_symbols.end(); st != send; ) {
+          if(st->second.expired())
+            st = m_symbols.erase(st);
+          else
+            ++st;
+        }
+        m_prune_size = std::max(size_t(64), 2 * m_symbols.size());
+      }
+
+      std::unordered_map<KEY, Weak_Ptr<const SYMBOL>> m_symbols;
+      size_t m_prune_size = 64;
+    };
+
+    /// Interned symbols are compared by address, so each Runtime_Context keeps its own tables rather than sharing them across threads
+    struct Symbol_Tables {
+      Symbol_Table<uint64_t, Symbol_Constant_Float> floats;
+      Symbol_Table<int64_t, Symbol_Constant_Int> ints;
+      Symbol_Table<std::string, Symbol_Constant_String> strings;
+      Symbol_Table<std::string, Symbol_Identifier> identifiers;
+    };
+
+    Symbol_Tables & symbol_tables() {
+      return Zeni::Runtime_Context::get_current().get_local<Symbol_Tables>();
+    }
+
+    /// Slots are static members shared by every agent in the process, so registration is locked; a deque keeps names in place as it grows
+    struct Variable_Slot_Registry {
+      std::mutex mutex;
+      std::unordered_map<std::string, size_t> ids;
+      std::deque<std::string> names;
+    };
+
+    Variable_Slot_Registry & variable_slot_registry() {
+      static Variable_Slot_Registry registry;
+      return registry;
+    }
+
+    size_t variable_slot_id(const std::string &name) {
+      auto &registry = variable_slot_registry();
+      std::lock_guard<std::mutex> lock(registry.mutex);
+      const auto inserted = registry.ids.insert(std::make_pair(name, registry.ids.size()));
+      if(inserted.second)
+        registry.names.push_back(name);
+      return inserted.first->second;
+    }
+
+  }
+
+  Variable_Slot::Variable_Slot(const std::string &name_)
+   : id(variable_slot_id(name_))
+  {
+  }
+
+  const std::string & Variable_Slot::name() const {
+    return name(id);
+  }
+
+  size_t Variable_Slot::count() {
+    auto &registry = variable_slot_registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    return registry.names.size();
+  }
+
+  const std::string & Variable_Slot::name(const size_t &id_) {
+    auto &registry = variable_slot_registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    return registry.names[id_];
+  }
+
+  void Variable_Indices::resolve() const {
+    for(size_t id = m_slots.size(), count = Variable_Slot::count(); id != count; ++id) {
+      const auto found = find(Variable_Slot::name(id));
+      m_slots.push_back(found != end() ? std::make_pair(found->second, true) : std::make_pair(WME_Token_Index(), false));
+    }
+  }
+
+  Symbol_Constant_Float_Ptr_C Symbol_Constant_Float::intern(const double &value_) {
+    uint64_t key; ///< Keyed by representation so that 0.0 and -0.0 remain distinct
+    std::memcpy(&key, &value_, sizeof(key));
+    return symbol_tables().floats.intern(key, value_);
+  }
+
+  Symbol_Constant_Int_Ptr_C Symbol_Constant_Int::intern(const int64_t &value_) {
+    return symbol_tables().ints.intern(value_, value_);
+  }
+
+  Symbol_Constant_String_Ptr_C Symbol_Constant_String::intern(const std::string &value_) {
+    return symbol_tables().strings.intern(value_, value_);
+  }
+
+  Symbol_Identifier_Ptr_C Symbol_Identifier::intern(const std::string &value_) {
+    return symbol_tables().identifiers.intern(value_, value_);
+  }
+
+}
@@ -1,13 +1,16 @@
 #ifndef RETE_SYMBOL_H
 #define RETE_SYMBOL_H
 
-#include "../utility/memory_pool.h"
-
+#include "intrusive_ptr.h"
 #include "utility.h"
 
 #include <array>
+#include <cassert>
+#include <cmath>
 #include <map>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "../linkage.h"
 
@@ -56,7 +59,51 @@ namespace Rete {
     int8_t column;
     bool existential = false;
   };
-  typedef std::multimap<std::string, WME_Token_Index> Variable_Indices;
+
+  /// A variable name registered once, so that actions can extract their parameters by slot instead of by name
+  class RETE_LINKAGE Variable_Slot {
+    Variable_Slot(const Variable_Slot &);
+    Variable_Slot & operator=(const Variable_Slot &);
+
+  public:
+    explicit Variable_Slot(const std::string &name_);
+
+    const std::string & name() const;
+
+    static size_t count();
+    static const std::string & name(const size_t &id_);
+
+    const size_t id;
+  };
+
+  class RETE_LINKAGE Variable_Indices : public std::multimap<std::string, WME_Token_Index> {
+  public:
+    typedef std::multimap<std::string, WME_Token_Index> Map;
+
+    using Map::Map;
+
+    Variable_Indices() {}
+    Variable_Indices(const Variable_Indices &rhs) : Map(rhs) {}
+    Variable_Indices & operator=(const Variable_Indices &rhs) {
+      Map::operator=(rhs);
+      m_slots.clear();
+      return *this;
+    }
+
+    /// Resolve every registered slot to its index; the variables must not change afterward
+    void resolve() const;
+
+    /// Get the index bound to the slot, as find(slot.name()) would
+    const WME_Token_Index & operator[](const Variable_Slot &slot) const {
+      if(slot.id >= m_slots.size())
+        resolve();
+      assert(m_slots[slot.id].second);
+      return m_slots[slot.id].first;
+    }
+
+  private:
+    mutable std::vector<std::pair<WME_Token_Index, bool>> m_slots; ///< Indexed by Variable_Slot::id; false if unbound
+  };
   typedef std::shared_ptr<Variable_Indices> Variable_Indices_Ptr;
 
 }
@@ -75,28 +122,34 @@ namespace Rete {
   class Symbol_Identifier;
   class Symbol_Variable;
 
-  typedef std::shared_ptr<const Symbol> Symbol_Ptr_C;
-  typedef std::shared_ptr<const Symbol_Constant> Symbol_Constant_Ptr_C;
-  typedef std::shared_ptr<const Symbol_Constant_Float> Symbol_Constant_Float_Ptr_C;
-  typedef std::shared_ptr<const Symbol_Constant_Int> Symbol_Constant_Int_Ptr_C;
-  typedef std::shared_ptr<const Symbol_Constant_String> Symbol_Constant_String_Ptr_C;
-  typedef std::shared_ptr<const Symbol_Identifier> Symbol_Identifier_Ptr_C;
-  typedef std::shared_ptr<const Symbol_Variable> Symbol_Variable_Ptr_C;
+  typedef Shared_Ptr<const Symbol> Symbol_Ptr_C;
+  typedef Shared_Ptr<const Symbol_Constant> Symbol_Constant_Ptr_C;
+  typedef Shared_Ptr<const Symbol_Constant_Float> Symbol_Constant_Float_Ptr_C;
+  typedef Shared_Ptr<const Symbol_Constant_Int> Symbol_Constant_Int_Ptr_C;
+  typedef Shared_Ptr<const Symbol_Constant_String> Symbol_Constant_String_Ptr_C;
+  typedef Shared_Ptr<const Symbol_Identifier> Symbol_Identifier_Ptr_C;
+  typedef Shared_Ptr<const Symbol_Variable> Symbol_Variable_Ptr_C;
   typedef std::shared_ptr<const Variable_Indices> Variable_Indices_Ptr_C;
 
-  class RETE_LINKAGE Symbol : public Zeni::Pool_Allocator<char [48]>
+#ifdef RETE_INTRUSIVE_PTR
+  class RETE_LINKAGE Symbol : public Intrusive_Weak_Counted, public Zeni::Pool_Allocator<Symbol>
+#else
+  class RETE_LINKAGE Symbol : public Zeni::Pool_Allocator<Symbol>
+#endif
   {
     Symbol(const Symbol &);
     Symbol & operator=(const Symbol &);
 
   public:
-    Symbol() {}
+    Symbol(const size_t &hashval_) : m_hashval(hashval_) {}
     virtual ~Symbol() {}
 
     virtual Symbol * clone() const = 0;
 
-    virtual bool operator==(const Symbol &rhs) const = 0;
-    virtual bool operator!=(const Symbol &rhs) const = 0;
+    /// Interned symbols compare by identity; the cached hash rejects nearly every other mismatch without dispatch
+    bool operator==(const Symbol &rhs) const {return this == &rhs || (m_hashval == rhs.m_hashval && equals(rhs));}
+    bool operator!=(const Symbol &rhs) const {return this != &rhs && (m_hashval != rhs.m_hashval || !equals(rhs));}
+    virtual bool equals(const Symbol &rhs) const = 0;
     virtual bool operator<(const Symbol &rhs) const = 0;
     virtual bool operator<=(const Symbol &rhs) const = 0;
     virtual bool operator>(const Symbol &rhs) const = 0;
@@ -141,9 +194,12 @@ namespace Rete {
     virtual bool operator==(const int64_t &) const {return false;}
     virtual bool operator==(const std::string &) const {return false;}
 
-    virtual size_t hash() const = 0;
+    size_t hash() const {return m_hashval;}
     virtual std::ostream & print(std::ostream &os) const = 0;
     virtual std::ostream & print(std::ostream &os, const Variable_Indices_Ptr_C &indices) const = 0;
+
+  private:
+    const size_t m_hashval;
   };
 
   class RETE_LINKAGE Symbol_Constant : public Symbol {
@@ -151,7 +207,7 @@ namespace Rete {
     Symbol_Constant & operator=(const Symbol_Constant &);
 
   public:
-    Symbol_Constant() {}
+    Symbol_Constant(const size_t &hashval_) : Symbol(hashval_) {}
   };
 
   class RETE_LINKAGE Symbol_Constant_Float : public Symbol_Constant {
@@ -159,12 +215,15 @@ namespace Rete {
     Symbol_Constant_Float & operator=(const Symbol_Constant_Float &);
 
   public:
-    Symbol_Constant_Float(const double &value_) : value(value_) {}
+    Symbol_Constant_Float(const double &value_) : Symbol_Constant(hash_value(value_)), value(value_) {}
+
+    static Symbol_Constant_Float_Ptr_C intern(const double &value_);
 
     Symbol_Constant_Float * clone() const override {return new Symbol_Constant_Float(value);}
 
-    bool operator==(const Symbol &rhs) const override {return rhs == *this;}
-    bool operator!=(const Symbol &rhs) const override {return rhs != *this;}
+    using Symbol::operator==;
+    using Symbol::operator!=;
+    bool equals(const Symbol &rhs) const override {return rhs == *this;}
     bool operator>(const Symbol &rhs) const override {return rhs < *this;}
     bool operator>=(const Symbol &rhs) const override {return rhs <= *this;}
     bool operator<(const Symbol &rhs) const override {return rhs > *this;}
@@ -193,8 +252,11 @@ namespace Rete {
 
     bool operator==(const double &value_) const override {return value_ == value;}
 
-    size_t hash() const override {
-      return std::hash<double>()(value);
+    /// Integral values hash as Symbol_Constant_Int does, since the two compare equal
+    static size_t hash_value(const double &value_) {
+      if(value_ == std::floor(value_) && value_ >= -9.2e18 && value_ <= 9.2e18)
+        return std::hash<int64_t>()(int64_t(value_));
+      return std::hash<double>()(value_);
     }
 
     virtual std::ostream & print(std::ostream &os) const override {
@@ -213,12 +275,15 @@ namespace Rete {
     Symbol_Constant_Int & operator=(const Symbol_Constant_Int &);
 
   public:
-    Symbol_Constant_Int(const int64_t &value_) : value(value_) {}
+    Symbol_Constant_Int(const int64_t &value_) : Symbol_Constant(std::hash<int64_t>()(value_)), value(value_) {}
+
+    static Symbol_Constant_Int_Ptr_C intern(const int64_t &value_);
 
     Symbol_Constant_Int * clone() const override {return new Symbol_Constant_Int(value);}
 
-    bool operator==(const Symbol &rhs) const override {return rhs == *this;}
-    bool operator!=(const Symbol &rhs) const override {return rhs != *this;}
+    using Symbol::operator==;
+    using Symbol::operator!=;
+    bool equals(const Symbol &rhs) const override {return rhs == *this;}
     bool operator>(const Symbol &rhs) const override {return rhs < *this;}
     bool operator>=(const Symbol &rhs) const override {return rhs <= *this;}
     bool operator<(const Symbol &rhs) const override {return rhs > *this;}
@@ -247,10 +312,6 @@ namespace Rete {
 
     bool operator==(const int64_t &value_) const override {return value_ == value;}
 
-    size_t hash() const override {
-      return std::hash<int64_t>()(value);
-    }
-
     virtual std::ostream & print(std::ostream &os) const override {
       return os << value;
     }
@@ -274,12 +335,15 @@ namespace Rete {
     Symbol_Constant_String & operator=(const Symbol_Constant_String &);
 
   public:
-    Symbol_Constant_String(const std::string &value_) : value(value_) {}
+    Symbol_Constant_String(const std::string &value_) : Symbol_Constant(std::hash<std::string>()(value_)), value(value_) {}
+
+    static Symbol_Constant_String_Ptr_C intern(const std::string &value_);
 
     Symbol_Constant_String * clone() const override {return new Symbol_Constant_String(value);}
 
-    bool operator==(const Symbol &rhs) const override {return rhs == *this;}
-    bool operator!=(const Symbol &rhs) const override {return rhs != *this;}
+    using Symbol::operator==;
+    using Symbol::operator!=;
+    bool equals(const Symbol &rhs) const override {return rhs == *this;}
     bool operator>(const Symbol &rhs) const override {return rhs < *this;}
     bool operator>=(const Symbol &rhs) const override {return rhs <= *this;}
     bool operator<(const Symbol &rhs) const override {return rhs > *this;}
@@ -303,10 +367,6 @@ namespace Rete {
 
     bool operator==(const std::string &value_) const override {return value_ == value;}
 
-    size_t hash() const override {
-      return std::hash<std::string>()(value);
-    }
-
     virtual std::ostream & print(std::ostream &os) const override {
       if(value.find_first_of(" \t\r\n") == std::string::npos)
         return os << value;
@@ -326,12 +386,15 @@ namespace Rete {
     Symbol_Identifier & operator=(const Symbol_Identifier &);
 
   public:
-    Symbol_Identifier(const std::string &value_) : value(value_) {}
+    Symbol_Identifier(const std::string &value_) : Symbol(std::hash<std::string>()(value_)), value(value_) {}
+
+    static Symbol_Identifier_Ptr_C intern(const std::string &value_);
 
     Symbol_Identifier * clone() const override {return new Symbol_Identifier(value);}
 
-    bool operator==(const Symbol &rhs) const override {return rhs == *this;}
-    bool operator!=(const Symbol &rhs) const override {return rhs != *this;}
+    using Symbol::operator==;
+    using Symbol::operator!=;
+    bool equals(const Symbol &rhs) const override {return rhs == *this;}
     bool operator>(const Symbol &rhs) const override {return rhs < *this;}
     bool operator>=(const Symbol &rhs) const override {return rhs <= *this;}
     bool operator<(const Symbol &rhs) const override {return rhs > *this;}
@@ -355,10 +418,6 @@ namespace Rete {
 
     bool operator==(const std::string &value_) const override {return value_ == value;}
 
-    size_t hash() const override {
-      return std::hash<std::string>()(value);
-    }
-
     virtual std::ostream & print(std::ostream &os) const override {
       return os << value;
     }
@@ -377,12 +436,13 @@ namespace Rete {
   public:
     enum Variable {First, Second, Third};
 
-    Symbol_Variable(const Variable &value_) : value(value_) {}
+    Symbol_Variable(const Variable &value_) : Symbol(std::hash<size_t>()(value_)), value(value_) {}
 
     Symbol_Variable * clone() const override {return new Symbol_Variable(value);}
 
-    bool operator==(const Symbol &rhs) const override {return rhs == *this;}
-    bool operator!=(const Symbol &rhs) const override {return rhs != *this;}
+    using Symbol::operator==;
+    using Symbol::operator!=;
+    bool equals(const Symbol &rhs) const override {return rhs == *this;}
     bool operator>(const Symbol &rhs) const override {return rhs < *this;}
     bool operator>=(const Symbol &rhs) const override {return rhs <= *this;}
     bool operator<(const Symbol &rhs) const override {return rhs > *this;}
@@ -404,10 +464,6 @@ namespace Rete {
     bool operator>(const Symbol_Identifier &) const override {return true;}
     bool operator>=(const Symbol_Identifier &) const override {return true;}
 
-    size_t hash() const override {
-      return std::hash<size_t>()(value);
-    }
-
     virtual std::ostream & print(std::ostream &os) const override {
       os.put('<');
       os << value;
@@ -432,12 +488,11 @@ namespace Rete {
   };
 
   inline void __symbol_size_check() {
-    typedef Symbol::value_type pool_allocator_type;
-    static_assert(sizeof(pool_allocator_type) >= sizeof(Symbol_Constant_Float), "Pool size suboptimal.");
-    static_assert(sizeof(pool_allocator_type) >= sizeof(Symbol_Constant_Int), "Pool size suboptimal.");
-    static_assert(sizeof(pool_allocator_type) >= sizeof(Symbol_Constant_String), "Pool size suboptimal.");
-    static_assert(sizeof(pool_allocator_type) >= sizeof(Symbol_Identifier), "Pool size suboptimal.");
-    static_assert(sizeof(pool_allocator_type) >= sizeof(Symbol_Variable), "Pool size suboptimal.");
+    static_assert(Zeni::Pool_Map::is_small(sizeof(Symbol_Constant_Float)), "Pool lookup hashed.");
+    static_assert(Zeni::Pool_Map::is_small(sizeof(Symbol_Constant_Int)), "Pool lookup hashed.");
+    static_assert(Zeni::Pool_Map::is_small(sizeof(Symbol_Constant_String)), "Pool lookup hashed.");
+    static_assert(Zeni::Pool_Map::is_small(sizeof(Symbol_Identifier)), "Pool lookup hashed.");
+    static_assert(Zeni::Pool_Map::is_small(sizeof(Symbol_Variable)), "Pool lookup hashed.");
   }
 
 }
@@ -470,6 +525,11 @@ namespace std {
       return std::hash<size_t>()(variable);
     }
   };
+  template <> struct hash<Rete::WME_Token_Index> {
+    size_t operator()(const Rete::WME_Token_Index &index) const {
+      return Rete::hash_combine(Rete::hash_combine(Rete::hash_combine(std::hash<int64_t>()(index.rete_row), std::hash<int64_t>()(index.token_row)), std::hash<int8_t>()(index.column)), std::hash<bool>()(index.existential));
+    }
+  };
 }
 
 #endif
@@ -9,16 +9,25 @@
 namespace Rete {
 
   class WME;
-  typedef std::shared_ptr<const WME> WME_Ptr_C;
-  typedef std::shared_ptr<WME> WME_Ptr;
+  typedef Shared_Ptr<const WME> WME_Ptr_C;
+  typedef Shared_Ptr<WME> WME_Ptr;
 
+#ifdef RETE_INTRUSIVE_PTR
+  class RETE_LINKAGE WME : public Intrusive_Counted, public Zeni::Pool_Allocator<WME> {
+#else
   class RETE_LINKAGE WME : public Zeni::Pool_Allocator<WME> {
+#endif
   public:
     typedef std::array<Symbol_Ptr_C, 3> WME_Symbols;
 
     WME() {}
     WME(const Symbol_Ptr_C &first, const Symbol_Ptr_C &second, const Symbol_Ptr_C &third);
 
+    template <typename... Args>
+    static WME_Ptr create(Args &&... args) {
+      return make_pooled<WME>(std::forward<Args>(args)...);
+    }
+
     bool operator==(const WME &rhs) const;
     bool operator<(const WME &rhs) const;
 
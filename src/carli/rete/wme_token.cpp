@@ -2,12 +2,15 @@
 
 #include "rete_node.h"
 
+#include <algorithm>
 #include <iostream>
 
 namespace Rete {
 
   WME_Token::WME_Token()
    : m_size(0),
+   m_rows(nullptr),
+   m_row(nullptr),
    m_hashval(size_t(-1))
   {
   }
@@ -15,17 +18,42 @@ namespace Rete {
   WME_Token::WME_Token(const WME_Ptr_C &wme)
    : m_size(1),
    m_wme(wme),
+   m_rows(&m_row),
+   m_row(m_wme.get()),
    m_hashval(std::hash<WME>()(*m_wme))
   {
   }
 
+  /// Hashed by content rather than by address, so that token memories iterate alike in every process
   WME_Token::WME_Token(const WME_Token_Ptr_C &first, const WME_Token_Ptr_C &second)
    : m_wme_token(first, second),
    m_size(first->m_size + second->m_size),
-   m_hashval(hash_combine(std::hash<WME_Token_Ptr_C>()(m_wme_token.first), std::hash<WME_Token_Ptr_C>()(m_wme_token.second)))
+   m_row(nullptr),
+   m_hashval(hash_combine(first->m_hashval, second->m_hashval))
   {
     assert(first->m_size);
     assert(second->m_size);
+
+#ifndef DISABLE_POOL_ALLOCATOR
+    m_rows = reinterpret_cast<const WME **>(Zeni::Pool_Map::get().get_Pool(m_size * sizeof(const WME *)).get());
+    if(!m_rows)
+      throw std::bad_alloc();
+#else
+    m_rows = new const WME * [m_size];
+#endif
+    std::copy(first->m_rows, first->m_rows + first->m_size, m_rows);
+    std::copy(second->m_rows, second->m_rows + second->m_size, m_rows + first->m_size);
+  }
+
+  WME_Token::~WME_Token() {
+    if(m_rows != &m_row) {
+#ifndef DISABLE_POOL_ALLOCATOR
+      if(m_rows)
+        Zeni::Pool::give_to_owner(m_rows);
+#else
+      delete [] m_rows;
+#endif
+    }
   }
 
   bool WME_Token::operator==(const WME_Token &rhs) const {
@@ -66,24 +94,6 @@ namespace Rete {
     return hashval;
   }
 
-  const Symbol_Ptr_C & WME_Token::operator[](const WME_Token_Index &index) const {
-    if(m_wme) {
-      assert(index.token_row == 0);
-      assert(index.column < 3);
-
-      return m_wme->symbols[index.column];
-    }
-    else {
-      assert(index.token_row < m_size);
-
-      const auto first_size = m_wme_token.first->m_size;
-      if(index.token_row < first_size)
-        return (*m_wme_token.first)[index];
-      else
-        return (*m_wme_token.second)[WME_Token_Index(index.rete_row, index.token_row - first_size, index.column)];
-    }
-  }
-
 //  std::pair<Variable_Indices_Ptr_C, Variable_Indices_Ptr_C> split_Variable_Indices(const WME_Bindings &bindings, const Variable_Indices_Ptr_C &indices, const int64_t &offset) {
 ////    std::pair<Variable_Indices_Ptr, Variable_Indices_Ptr> rv =
 ////      std::make_pair(std::make_shared<Variable_Indices>(), std::make_shared<Variable_Indices>());
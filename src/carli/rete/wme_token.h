@@ -1,6 +1,7 @@
 #ifndef WME_TOKEN_H
 #define WME_TOKEN_H
 
+#include "intrusive_ptr.h"
 #include "wme.h"
 #include "utility.h"
 #include <cassert>
@@ -9,19 +10,37 @@ namespace Rete {
 
   class Rete_Node;
   class WME_Token;
-  typedef std::shared_ptr<const WME_Token> WME_Token_Ptr_C;
-  typedef std::shared_ptr<WME_Token> WME_Token_Ptr;
+  typedef Shared_Ptr<const WME_Token> WME_Token_Ptr_C;
+  typedef Shared_Ptr<WME_Token> WME_Token_Ptr;
   typedef std::pair<WME_Token_Index, WME_Token_Index> WME_Binding;
   typedef std::set<WME_Binding> WME_Bindings;
 
+#ifdef RETE_INTRUSIVE_PTR
+  class RETE_LINKAGE WME_Token : public Intrusive_Counted, public Zeni::Pool_Allocator<WME_Token> {
+#else
   class RETE_LINKAGE WME_Token : public std::enable_shared_from_this<WME_Token>, public Zeni::Pool_Allocator<WME_Token> {
+#endif
+    WME_Token(const WME_Token &);
+    WME_Token & operator=(const WME_Token &);
+
   public:
     WME_Token();
     WME_Token(const WME_Ptr_C &wme);
     WME_Token(const WME_Token_Ptr_C &first, const WME_Token_Ptr_C &second);
+    ~WME_Token();
 
+    template <typename... Args>
+    static WME_Token_Ptr create(Args &&... args) {
+      return make_pooled<WME_Token>(std::forward<Args>(args)...);
+    }
+
+#ifdef RETE_INTRUSIVE_PTR
+    WME_Token_Ptr_C shared() const {return WME_Token_Ptr_C(this);}
+    WME_Token_Ptr shared() {return WME_Token_Ptr(this);}
+#else
     WME_Token_Ptr_C shared() const {return shared_from_this();}
     WME_Token_Ptr shared() {return shared_from_this();}
+#endif
 
     const WME_Ptr_C & get_wme() const {
       assert(m_size == 1);
@@ -42,7 +61,17 @@ namespace Rete {
 
     std::ostream & print(std::ostream &os) const;
 
-    const Symbol_Ptr_C & operator[](const WME_Token_Index &index) const;
+    const Symbol_Ptr_C & operator[](const WME_Token_Index &index) const {
+      assert(index.token_row < m_size);
+      assert(index.column < 3);
+      return m_rows[index.token_row]->symbols[index.column];
+    }
+
+    /// Get the symbol bound to a variable slot, as the type the caller expects
+    template <typename SYMBOL>
+    const SYMBOL & get(const Variable_Indices &variables, const Variable_Slot &slot) const {
+      return debuggable_cast<const SYMBOL &>(*(*this)[variables[slot]]);
+    }
 
   private:
     std::pair<WME_Token_Ptr_C, WME_Token_Ptr_C> m_wme_token;
@@ -50,6 +79,10 @@ namespace Rete {
 
     WME_Ptr_C m_wme;
 
+    /// Flattened rows, kept alive by m_wme / m_wme_token; points at m_row for single-row tokens
+    const WME ** m_rows;
+    const WME * m_row;
+
     size_t m_hashval;
   };
 
@@ -1,6 +1,7 @@
 #include "getopt.h"
 
+#include "runtime_context.h"
+
 Options & Options::get_global() {
-  static Options g_options;
-  return g_options;
+  return Zeni::Runtime_Context::get_current().get_options();
 }
@@ -64,7 +64,7 @@ private:
 
 class UTILITY_LINKAGE Options {
 public:
-  static Options & get_global();
+  static Options & get_global(); ///< The options of the Zeni::Runtime_Context current on this thread
 
   Options(const std::string &name_ = "a.out")
    : name(name_),
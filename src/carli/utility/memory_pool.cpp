@@ -1,7 +1,16 @@
 #include "memory_pool.h"
 
+#include "runtime_context.h"
+
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <new>
+
 namespace Zeni {
 
+  static std::mutex g_new_handler_mutex;
+  static std::mutex g_orphan_mutex; ///< Orphaned slabs may have their blocks freed from any thread
   static bool g_unregistered = true;
   static std::new_handler g_old_new_handler = nullptr;
 
@@ -14,7 +23,138 @@ namespace Zeni {
     }
   }
 
+  namespace {
+
+    void * allocate_slab(const size_t &bytes) {
+#ifdef _WINDOWS
+      return _aligned_malloc(bytes, Pool::slab_size);
+#else
+      return aligned_alloc(Pool::slab_size, bytes);
+#endif
+    }
+
+    void free_slab(void * const &slab) {
+#ifdef _WINDOWS
+      _aligned_free(slab);
+#else
+      free(slab);
+#endif
+    }
+
+  }
+
+  const size_t Pool::slab_header = (sizeof(Slab) + 15) / 16 * 16;
+
+  Pool_Map & Pool_Map::get() {
+    return Runtime_Context::get_current().get_pool_map();
+  }
+
+  Pool::Pool(const size_t &size_) throw()
+    : size((std::max(sizeof(void *), size_) + sizeof(void *) - 1) / sizeof(void *) * sizeof(void *))
+  {
+  }
+
+  Pool::~Pool() throw() {
+    clear();
+
+    for(Slab * const head : {partial, full}) {
+      for(Slab * slab = head; slab; slab = slab->next)
+        slab->pool = nullptr;
+    }
+  }
+
+  size_t Pool::clear() throw() {
+    size_t count = 0;
+    for(Slab * slab = partial; slab; ) {
+      Slab * const next = slab->next;
+      if(!slab->in_use) {
+        release(slab);
+        --empty;
+        ++count;
+      }
+      slab = next;
+    }
+    return count;
+  }
+
+  void * Pool::get_from_new_slab() throw() {
+    const size_t slab_bytes = get_slab_bytes();
+    void * const memory = allocate_slab(slab_bytes);
+    if(!memory)
+      return nullptr;
+
+    Slab * const slab = new (memory) Slab;
+    slab->pool = this;
+    slab->available = nullptr;
+    slab->unused = reinterpret_cast<char *>(memory) + slab_header;
+    slab->capacity = std::max(size_t(1), (slab_size - slab_header) / size);
+    slab->end = slab->unused + slab->capacity * size;
+    slab->in_use = 0;
+    link(partial, slab);
+    slab->listed = true;
+
+    ++empty;
+    capacity += slab->capacity;
+    ++slabs;
+    bytes += slab_bytes;
+
+    return get();
+  }
+
+  void Pool::release(Slab * const &slab) throw() {
+    assert_owner(slab);
+    unlink(slab->listed ? partial : full, slab);
+
+    capacity -= slab->capacity;
+    --slabs;
+    bytes -= get_slab_bytes();
+
+    free_slab(slab);
+  }
+
+  void Pool::give_orphaned(Slab * const &slab) throw() {
+    std::lock_guard<std::mutex> lock(g_orphan_mutex);
+    if(!--slab->in_use)
+      free_slab(slab);
+  }
+
+  Pool::Usage Pool::usage() const {
+    Usage rv;
+    rv.size = size;
+    rv.live = live;
+    rv.free = capacity - live;
+    rv.peak = peak;
+    rv.slabs = slabs;
+    rv.bytes = bytes;
+    return rv;
+  }
+
+  std::vector<Pool::Usage> Pool_Map::usage() const {
+    const std::map<size_t, const Pool *> pools(m_pools.begin(), m_pools.end());
+
+    std::vector<Pool::Usage> rv;
+    rv.reserve(pools.size());
+    for(const auto &pool : pools)
+      rv.push_back(pool.second->usage());
+    return rv;
+  }
+
+  void Pool_Map::print_usage(std::ostream &os) const {
+    size_t live_bytes = 0;
+    size_t slab_bytes = 0;
+    os << "Pool usage: size live free peak slabs bytes" << std::endl;
+    for(const auto &usage : this->usage()) {
+      if(!usage.peak)
+        continue;
+      os << "  " << usage.size << ' ' << usage.live << ' ' << usage.free << ' ' << usage.peak << ' ' << usage.slabs << ' ' << usage.bytes << std::endl;
+      live_bytes += usage.live * usage.size;
+      slab_bytes += usage.bytes;
+    }
+    os << "  total " << live_bytes << " bytes live in " << slab_bytes << " bytes of slabs" << std::endl;
+  }
+
   void register_new_handler(const bool &force_reregister) {
+    std::lock_guard<std::mutex> lock(g_new_handler_mutex); ///< Experiments may be constructed on several threads at once
     if(g_unregistered || force_reregister) {
       g_old_new_handler = std::set_new_handler(new_handler);
       g_unregistered = false;
@@ -2,11 +2,14 @@
 #define ZENI_MEMORY_POOL_H
 
 #include <algorithm>
+#include <array>
 #include <cstddef>
 #include <cstdlib>
 #include <inttypes.h>
+#include <iosfwd>
 #include <limits>
 #include <unordered_map>
+#include <vector>
 
 #include "../linkage.h"
 
@@ -16,66 +19,112 @@ namespace Zeni {
     Pool(const Pool &rhs) = delete;
     Pool & operator=(const Pool &rhs) = delete;
 
+    /// Header at the start of every slab; slabs are aligned to slab_size so a block finds its slab by masking its address
+    struct Slab {
+      Pool * pool; ///< nullptr once orphaned by the destruction of its Pool
+      Slab * prev; ///< Neighbors in the Pool's list of slabs with blocks to spare, or of full slabs
+      Slab * next;
+      void * available; ///< Blocks given back to this slab
+      char * unused; ///< Blocks never yet handed out begin here
+      char * end;
+      size_t in_use;
+      size_t capacity;
+      bool listed; ///< true if in the list of slabs with blocks to spare
+    };
+
   public:
-    Pool(const size_t &size_) throw()
-      : size(std::max(sizeof(void *), size_)),
-      available(nullptr)
-    {
-    }
+    static constexpr size_t slab_size = 64 * 1024;
+
+    struct Usage {
+      size_t size; ///< Size of each memory block
+      size_t live; ///< Memory blocks currently handed out
+      size_t free; ///< Memory blocks available in allocated slabs
+      size_t peak; ///< High-water mark of live
+      size_t slabs;
+      size_t bytes; ///< Memory held by slabs
+    };
 
-    ~Pool() throw() {
-      clear();
-    }
+    Pool(const size_t &size_) throw();
+    /// Orphan any slabs still holding live memory blocks, so that they are freed once their last block is freed
+    ~Pool() throw();
 
-    /// free any cached memory blocks; return a count of the number of blocks freed
-    size_t clear() throw() {
-      size_t count = 0;
-      while(available) {
-        void * const ptr = available;
-        available = *reinterpret_cast<void **>(reinterpret_cast<size_t *>(available) + 1);
-        free(ptr);
-        ++count;
-      }
-      return count;
-    }
+    /// free every slab with no live memory blocks; return a count of the number of slabs freed
+    size_t clear() throw();
 
-    /// get a cached memory block or allocate one as needed
+    /// get a memory block from a slab with one to spare, allocating a new slab as needed
     void * get() throw() {
-      if(available) {
-        void * const ptr = available;
-        available = *reinterpret_cast<void **>(reinterpret_cast<size_t *>(available) + 1);
-#ifndef NDEBUG
-        fill(reinterpret_cast<size_t *>(ptr) + 1, 0xFA57F00D);
-#endif
-        return reinterpret_cast<size_t *>(ptr) + 1;
+      Slab * const slab = partial;
+      if(!slab)
+        return get_from_new_slab();
+
+      void * ptr;
+      if(slab->available) {
+        ptr = slab->available;
+        slab->available = *reinterpret_cast<void **>(ptr);
       }
       else {
-        void * ptr = malloc(sizeof(size_t) + size);
+        ptr = slab->unused;
+        slab->unused += size;
+      }
+
+      if(!slab->in_use++)
+        --empty;
+      if(!slab->available && slab->end - slab->unused < ptrdiff_t(size)) {
+        unlink(partial, slab);
+        link(full, slab);
+        slab->listed = false;
+      }
+
+      if(++live > peak)
+        peak = live;
 
-        if(ptr) {
-          *reinterpret_cast<size_t *>(ptr) = size;
 #ifndef NDEBUG
-          fill(reinterpret_cast<size_t *>(ptr) + 1, 0xED1B13BF);
+      fill(ptr, 0xED1B13BF);
 #endif
-          return reinterpret_cast<size_t *>(ptr) + 1;
-        }
-
-        return nullptr;
-      }
+      return ptr;
     }
 
-    /// return a memory block to be cached (and eventually freed)
+    /// return a memory block to its slab, freeing the slab if it empties while another empty slab is on hand
     void give(void * const &ptr_) throw() {
+      Slab * const slab = slab_of(ptr_);
+      assert_owner(slab);
 #ifndef NDEBUG
       fill(ptr_, 0xDEADBEEF);
 #endif
-      *reinterpret_cast<void **>(ptr_) = available;
-      available = reinterpret_cast<size_t *>(ptr_) - 1;
+      *reinterpret_cast<void **>(ptr_) = slab->available;
+      slab->available = ptr_;
+      --live;
+
+      if(!slab->listed) {
+        unlink(full, slab);
+        link(partial, slab);
+        slab->listed = true;
+      }
+      if(!--slab->in_use) {
+        if(empty)
+          release(slab);
+        else
+          ++empty;
+      }
     }
 
-    /// get the size of a memory block allocated with an instance of Pool
+    /// return a memory block to the Pool that allocated it, or free it from its orphaned slab
+    static void give_to_owner(void * const &ptr_) throw() {
+      Slab * const slab = slab_of(ptr_);
+      if(slab->pool)
+        slab->pool->give(ptr_);
+      else
+        give_orphaned(slab);
+    }
+
+    /// get the Pool that allocated the memory block pointed to by ptr_, or nullptr if that Pool has been destroyed
+    static Pool * owner(const void * const &ptr_) throw() {
+      return slab_of(ptr_)->pool;
+    }
+
+    /// get the size of a memory block allocated with an instance of Pool that still exists
     static size_t size_of(const void * const &ptr_) throw() {
-      return reinterpret_cast<const size_t *>(ptr_)[-1];
+      return owner(ptr_)->size;
     }
 
     /// check if the size of the memory block provided by this Pool is greater than or equal to sz_
@@ -88,11 +137,56 @@ namespace Zeni {
       return size >= size_of(ptr_);
     }
 
+    Usage usage() const;
+
   private:
+    static Slab * slab_of(const void * const &ptr_) throw() {
+      return reinterpret_cast<Slab *>(uintptr_t(ptr_) & ~uintptr_t(slab_size - 1));
+    }
+
+    void assert_owner(const Slab * const &
+#ifndef NDEBUG
+                                           slab
+#endif
+                                               ) const throw() {
+#ifndef NDEBUG
+      if(slab->pool != this)
+        abort();
+#endif
+    }
+
+    static void link(Slab * &head, Slab * const &slab) throw() {
+      slab->prev = nullptr;
+      slab->next = head;
+      if(head)
+        head->prev = slab;
+      head = slab;
+    }
+
+    static void unlink(Slab * &head, Slab * const &slab) throw() {
+      if(slab->prev)
+        slab->prev->next = slab->next;
+      else
+        head = slab->next;
+      if(slab->next)
+        slab->next->prev = slab->prev;
+    }
+
+    /// Slabs span slab_size unless a single memory block needs more
+    size_t get_slab_bytes() const throw() {
+      return std::max(slab_size, (slab_header + size + slab_size - 1) / slab_size * slab_size);
+    }
+
+    void * get_from_new_slab() throw();
+    void release(Slab * const &slab) throw();
+    static void give_orphaned(Slab * const &slab) throw();
+
+    static const size_t slab_header; ///< Offset of the first memory block in a slab
+
 #ifndef NDEBUG
     void fill(void * const dest, const uint32_t pattern) {
       unsigned char * dd = reinterpret_cast<unsigned char *>(dest);
-      const unsigned char * const dend = dd + size_of(dest);
+      const unsigned char * const dend = dd + size;
 
       while(dend - dd > 3) {
         *reinterpret_cast<uint32_t *>(dd) = pattern;
@@ -111,26 +205,34 @@ namespace Zeni {
 #endif
 
     size_t size;
-    void * available;
+    Slab * partial = nullptr; ///< Slabs with memory blocks to spare
+    Slab * full = nullptr; ///< Slabs with none to spare, tracked so that they can be orphaned
+    size_t empty = 0; ///< Slabs with no live memory blocks
+    size_t live = 0;
+    size_t peak = 0;
+    size_t capacity = 0; ///< Memory blocks across all slabs
+    size_t slabs = 0;
+    size_t bytes = 0;
   };
 
   class UTILITY_LINKAGE Pool_Map {
     Pool_Map(const Pool_Map &rhs) = delete;
     Pool_Map & operator=(const Pool_Map &rhs) = delete;
 
-    Pool_Map() throw() {}
+    friend class Runtime_Context;
+
+    Pool_Map() throw() {
+      m_small.fill(nullptr);
+    }
     ~Pool_Map() throw() {
       for(auto &pool : m_pools)
         delete pool.second;
     }
 
   public:
-    static Pool_Map & get() {
-      static Pool_Map pool_map;
-      return pool_map;
-    };
+    static Pool_Map & get(); ///< The pools of the Runtime_Context current on this thread
 
-    /// free memory blocks from every Pool; return a count of all freed blocks
+    /// free empty slabs from every Pool; return a count of all freed slabs
     size_t clear() throw() {
       size_t count = 0;
       for(std::unordered_map<size_t, Pool *>::iterator it = m_pools.begin(), iend = m_pools.end(); it != iend; ++it)
@@ -138,22 +240,47 @@ namespace Zeni {
       return count;
     }
 
-    /// get a memory Pool that allocates memory blocks of a given size
+    static constexpr size_t small_words = 65;
+
+    /// get the size of the memory blocks that serve size_ bytes: a whole number of pointers, at least one
+    static constexpr size_t block_size(const size_t &size_) {
+      return (std::max(sizeof(void *), size_) + sizeof(void *) - 1) / sizeof(void *) * sizeof(void *);
+    }
+
+    /// check if size_ bytes are served by a Pool found without a hash lookup, as every pooled Rete and Carli type should be
+    static constexpr bool is_small(const size_t &size_) {
+      return block_size(size_) / sizeof(void *) < small_words;
+    }
+
+    /// get a memory Pool that allocates memory blocks of a given size, rounded up to a whole number of pointers
     Pool & get_Pool(const size_t &size_) {
-      Pool * &pool = m_pools[size_];
+      const size_t words = block_size(size_) / sizeof(void *);
+      if(words < small_words && m_small[words])
+        return *m_small[words];
+
+      Pool * &pool = m_pools[words * sizeof(void *)];
       if(!pool)
-        pool = new Pool(size_);
+        pool = new Pool(words * sizeof(void *));
+      if(words < small_words)
+        m_small[words] = pool;
 
       return *pool;
     }
 
-    /// get a memory Pool that allocates memory blocks the size of the block pointed to by ptr_
-    Pool & get_Pool(void * const &ptr_) {
-      return get_Pool(Pool::size_of(ptr_));
+    /// get the memory Pool that allocated the block pointed to by ptr_, or nullptr if it has been destroyed
+    Pool * get_Pool(void * const &ptr_) {
+      return Pool::owner(ptr_);
     }
 
+    /// get statistics for every Pool, ordered by block size
+    std::vector<Pool::Usage> usage() const;
+
+    /// print statistics for every Pool that has been used, ordered by block size
+    void print_usage(std::ostream &os) const;
+
   private:
     std::unordered_map<size_t, Pool *> m_pools;
+    std::array<Pool *, small_words> m_small; ///< Pools by size in pointers, sparing small allocations a hash lookup
   };
 
 #ifndef DISABLE_POOL_ALLOCATOR
@@ -182,7 +309,7 @@ namespace Zeni {
      * if it fails again, throw std::bad_alloc;
      */
     static void * operator new(size_t sz_) {
-      return allocate(sz_);
+      return allocate_bytes(sz_);
     }
 
     /// return a memory block to the appropriate memory Pool
@@ -198,26 +325,13 @@ namespace Zeni {
       return reinterpret_cast<const_pointer>(&reinterpret_cast<const char &>(x));
     }
 
-    static pointer allocate(size_type sz_, std::allocator<void>::const_pointer /*hint*/ = 0) {
-      Pool &p = pool->size_gte(sz_) ? *pool : pool_map->get_Pool(sz_);
-
-      void * ptr = p.get();
-      if(ptr)
-        return pointer(ptr);
-
-      if(pool_map->clear()) {
-        ptr = p.get();
-        if(ptr)
-          return pointer(ptr);
-      }
-
-      throw std::bad_alloc();
+    /// allocate memory for n_ instances of TYPE
+    static pointer allocate(size_type n_, std::allocator<void>::const_pointer /*hint*/ = 0) {
+      return allocate_bytes(n_ * sizeof(TYPE));
     }
 
     static void deallocate(pointer ptr_, size_type /*n*/) throw() {
-      Pool &p = pool->size_gte(ptr_) ? *pool : pool_map->get_Pool(ptr_);
-
-      p.give(ptr_);
+      Pool::give_to_owner(ptr_);
     }
 
     static size_type max_size() {
@@ -237,25 +351,35 @@ namespace Zeni {
       p->~NEWTYPE();
     }
 
+    /// Memory blocks find their way back to their own Pool, or free their orphaned slab, so any allocator can free them
     template <typename RHSTYPE>
-    bool operator==(const Pool_Allocator<RHSTYPE> &rhs) const {
-      return pool == rhs.pool;
+    bool operator==(const Pool_Allocator<RHSTYPE> &) const {
+      return true;
     }
 
     template <typename RHSTYPE>
-    bool operator!=(const Pool_Allocator<RHSTYPE> &rhs) const {
-      return pool != rhs.pool;
+    bool operator!=(const Pool_Allocator<RHSTYPE> &) const {
+      return false;
     }
 
   private:
-    static Pool_Map * pool_map;
-    static Pool * pool;
-  };
+    static pointer allocate_bytes(const size_type &sz_) {
+      Pool_Map &pool_map = Pool_Map::get();
+      Pool &p = pool_map.get_Pool(std::max(sz_, sizeof(TYPE)));
 
-  template <typename TYPE>
-  Pool_Map * Pool_Allocator<TYPE>::pool_map = &Pool_Map::get();
-  template <typename TYPE>
-  Pool * Pool_Allocator<TYPE>::pool = &Pool_Map::get().get_Pool(sizeof(TYPE));
+      void * ptr = p.get();
+      if(ptr)
+        return pointer(ptr);
+
+      if(pool_map.clear()) {
+        ptr = p.get();
+        if(ptr)
+          return pointer(ptr);
+      }
+
+      throw std::bad_alloc();
+    }
+  };
 #else
   template <typename TYPE>
   using Pool_Allocator = std::allocator<TYPE>;
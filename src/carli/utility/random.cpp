@@ -1,10 +1,32 @@
 #include "random.h"
 
+#include "runtime_context.h"
+#include "serialize.h"
+
+#include <sstream>
+
 namespace Zeni {
 
   Random & Random::get() {
-    static Random g_random(std::random_device{}());
-    return g_random;
+    return Runtime_Context::get_current().get_random();
+  }
+
+  void Random::save(std::ostream &os) const {
+    std::ostringstream engine;
+    engine << m_random;
+    serialize(os, engine.str());
+    serialize(os, m_have_next_gaussian);
+    serialize(os, m_next_gaussian);
+  }
+
+  void Random::load(std::istream &is) {
+    std::string state;
+    deserialize(is, state);
+    std::istringstream engine(state);
+    if(!(engine >> m_random))
+      throw std::runtime_error("Random engine state invalid.");
+    deserialize(is, m_have_next_gaussian);
+    deserialize(is, m_next_gaussian);
   }
 
 }
@@ -35,6 +35,7 @@
 #include <cmath>
 #include <cstdint>
 #include <cstdlib>
+#include <iosfwd>
 #include <random>
 
 #include "../linkage.h"
@@ -155,7 +156,10 @@ namespace Zeni {
       }
     }
 
-    static Random & get();
+    static Random & get(); ///< The generator of the Runtime_Context current on this thread
+
+    void save(std::ostream &os) const; ///< Engine state and any pending Gaussian, for checkpoints
+    void load(std::istream &is);
 
   private:
 #ifdef _MSC_VER
@@ -171,7 +175,7 @@ namespace Zeni {
 #endif
 
     bool m_have_next_gaussian = false;
-    double m_next_gaussian;
+    double m_next_gaussian = 0.0;
   };
 
 }
@@ -0,0 +1,31 @@
+#include "runtime_context.h"
+
+namespace Zeni {
+
+  static thread_local Runtime_Context * g_current = nullptr;
+
+  Runtime_Context::Scope::Scope(Runtime_Context &context)
+   : m_previous(g_current)
+  {
+    g_current = &context;
+  }
+
+  Runtime_Context::Scope::~Scope() {
+    g_current = m_previous;
+  }
+
+  Runtime_Context::Runtime_Context(const uint32_t &seed)
+   : m_random(seed)
+  {
+  }
+
+  Runtime_Context & Runtime_Context::get_global() {
+    static Runtime_Context g_context;
+    return g_context;
+  }
+
+  Runtime_Context & Runtime_Context::get_current() {
+    return g_current ? *g_current : get_global();
+  }
+
+}
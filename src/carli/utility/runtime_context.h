@@ -0,0 +1,69 @@
+#ifndef ZENI_RUNTIME_CONTEXT_H
+#define ZENI_RUNTIME_CONTEXT_H
+
+#include "getopt.h"
+#include "memory_pool.h"
+#include "random.h"
+
+#include <iostream>
+#include <memory>
+#include <typeindex>
+#include <unordered_map>
+
+namespace Zeni {
+
+  /// Options, random numbers, and memory pools for one agent and its environment
+  /// Options::get_global(), Random::get(), and Pool_Map::get() resolve to the context current on the calling thread
+  class UTILITY_LINKAGE Runtime_Context {
+    Runtime_Context(const Runtime_Context &) = delete;
+    Runtime_Context & operator=(const Runtime_Context &) = delete;
+
+  public:
+    /// Makes a context current on this thread until destroyed
+    class UTILITY_LINKAGE Scope {
+      Scope(const Scope &) = delete;
+      Scope & operator=(const Scope &) = delete;
+
+    public:
+      Scope(Runtime_Context &context);
+      ~Scope();
+
+    private:
+      Runtime_Context * const m_previous;
+    };
+
+    Runtime_Context(const uint32_t &seed = std::random_device{}());
+
+    static Runtime_Context & get_global(); ///< Current on any thread outside of a Scope
+    static Runtime_Context & get_current();
+
+    Options & get_options() {return m_options;}
+    Random & get_random() {return m_random;}
+    Pool_Map & get_pool_map() {return m_pool_map;}
+
+    std::ostream & get_out() {return *m_out;} ///< std::cout unless redirected
+    std::ostream & get_err() {return *m_err;} ///< std::cerr unless redirected
+    void set_out(std::ostream &os) {m_out = &os;}
+    void set_err(std::ostream &os) {m_err = &os;}
+
+    /// State another library keeps per context (e.g. symbol tables), created on first use and destroyed before the pools
+    template <typename TYPE>
+    TYPE & get_local() {
+      auto &local = m_locals[std::type_index(typeid(TYPE))];
+      if(!local)
+        local = std::make_shared<TYPE>();
+      return *static_cast<TYPE *>(local.get());
+    }
+
+  private:
+    Pool_Map m_pool_map; ///< Declared first so it outlives everything allocated from it
+    Options m_options;
+    Random m_random;
+    std::ostream * m_out = &std::cout;
+    std::ostream * m_err = &std::cerr;
+    std::unordered_map<std::type_index, std::shared_ptr<void>> m_locals;
+  };
+
+}
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef ZENI_SERIALIZE_H
+#define ZENI_SERIALIZE_H
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Zeni {
+
+  /// Raw native-endian values, for checkpoints read back by the same build on the same machine
+
+  template <typename TYPE>
+  void serialize(std::ostream &os, const TYPE &value) {
+    static_assert(std::is_trivially_copyable<TYPE>::value, "Raw serialization requires a trivially copyable type.");
+    os.write(reinterpret_cast<const char *>(&value), sizeof(TYPE));
+  }
+
+  inline void serialize(std::ostream &os, const std::string &value) {
+    serialize(os, uint64_t(value.size()));
+    os.write(value.data(), value.size());
+  }
+
+  template <typename FIRST, typename SECOND>
+  void serialize(std::ostream &os, const std::pair<FIRST, SECOND> &value) {
+    serialize(os, value.first);
+    serialize(os, value.second);
+  }
+
+  template <typename TYPE>
+  void serialize(std::ostream &os, const std::vector<TYPE> &value) {
+    serialize(os, uint64_t(value.size()));
+    for(const auto &entry : value)
+      serialize(os, entry);
+  }
+
+  template <typename TYPE>
+  void deserialize(std::istream &is, TYPE &value) {
+    static_assert(std::is_trivially_copyable<TYPE>::value, "Raw serialization requires a trivially copyable type.");
+    if(!is.read(reinterpret_cast<char *>(&value), sizeof(TYPE)))
+      throw std::runtime_error("Serialized data truncated.");
+  }
+
+  inline void deserialize(std::istream &is, std::string &value) {
+    uint64_t size;
+    deserialize(is, size);
+    value.resize(size_t(size));
+    if(size && !is.read(&value[0], std::streamsize(size)))
+      throw std::runtime_error("Serialized data truncated.");
+  }
+
+  template <typename FIRST, typename SECOND>
+  void deserialize(std::istream &is, std::pair<FIRST, SECOND> &value) {
+    deserialize(is, value.first);
+    deserialize(is, value.second);
+  }
+
+  template <typename TYPE>
+  void deserialize(std::istream &is, std::vector<TYPE> &value) {
+    uint64_t size;
+    deserialize(is, size);
+    value.clear();
+    value.reserve(size_t(size));
+    while(size--) {
+      value.emplace_back();
+      deserialize(is, value.back());
+    }
+  }
+
+}
+
+#endif
@@ -1,5 +1,7 @@
 #include "value.h"
 
+#include "utility/serialize.h"
+
 namespace Carli {
 
   bool Mean::outlier_above(const Value &value, const double &z) const {
@@ -61,4 +63,34 @@ namespace Carli {
     }
   }
 
+  void Value::save(std::ostream &os) const {
+    Zeni::serialize(os, value);
+    Zeni::serialize(os, contributor);
+    Zeni::serialize(os, value_contribution);
+    Zeni::serialize(os, value_mark2);
+  }
+
+  void Value::load(std::istream &is) {
+    Zeni::deserialize(is, value);
+    Zeni::deserialize(is, contributor);
+    Zeni::deserialize(is, value_contribution);
+    Zeni::deserialize(is, value_mark2);
+  }
+
+  void Mean::save(std::ostream &os) const {
+    Zeni::serialize(os, count);
+    Zeni::serialize(os, mean);
+    Zeni::serialize(os, mean_mark2);
+    Zeni::serialize(os, variance);
+    Zeni::serialize(os, stddev);
+  }
+
+  void Mean::load(std::istream &is) {
+    Zeni::deserialize(is, count);
+    Zeni::deserialize(is, mean);
+    Zeni::deserialize(is, mean_mark2);
+    Zeni::deserialize(is, variance);
+    Zeni::deserialize(is, stddev);
+  }
+
 }
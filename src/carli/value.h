@@ -2,6 +2,7 @@
 #define CARLI_VALUE_H
 
 #include <cmath>
+#include <iosfwd>
 
 #include "linkage.h"
 
@@ -25,6 +26,9 @@ namespace Carli {
     operator double () const {return value;}
     operator double & () {return value;}
 
+    void save(std::ostream &os) const;
+    void load(std::istream &is);
+
   private:
     double value;
 
@@ -53,6 +57,9 @@ namespace Carli {
     double get_variance() const {return variance;}
     double get_stddev() const {return stddev;}
 
+    void save(std::ostream &os) const;
+    void load(std::istream &is);
+
   private:
     unsigned long count = 0lu;
 
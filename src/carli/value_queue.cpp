@@ -1,5 +1,7 @@
 #include "value_queue.h"
 
+#include "utility/serialize.h"
+
 namespace Carli {
 
   Value_Queue::~Value_Queue() {
@@ -35,4 +37,32 @@ namespace Carli {
     }
   }
 
+  void Value_Queue::save(std::ostream &os) const {
+    Zeni::serialize(os, uint64_t(m_size));
+    for(auto entry = m_value_list; entry; entry = entry->next())
+      entry->get()->value.save(os);
+    m_mean.save(os);
+  }
+
+  void Value_Queue::load(std::istream &is) {
+    while(m_value_list)
+      pop();
+
+    uint64_t size;
+    Zeni::deserialize(is, size);
+    while(size--) {
+      Value_List::List * const entry = &(new Value_List)->list;
+
+      entry->insert_after(m_value_list_tail);
+      m_value_list_tail = entry;
+      if(!m_value_list)
+        m_value_list = entry;
+
+      entry->get()->value.load(is);
+
+      ++m_size;
+    }
+    m_mean.load(is);
+  }
+
 }
@@ -46,6 +46,9 @@ namespace Carli {
       return m_mean;
     }
 
+    void save(std::ostream &os) const;
+    void load(std::istream &is); ///< Replaces any queued values
+
   private:
     Value_List::List::list_pointer_type m_value_list;
     Value_List::List::list_pointer_type m_value_list_tail;
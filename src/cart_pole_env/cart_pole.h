@@ -28,6 +28,7 @@ namespace Cart_Pole {
 
   using std::dynamic_pointer_cast;
   using std::endl;
+  using std::istream;
   using std::make_pair;
   using std::map;
   using std::ostream;
@@ -42,8 +43,10 @@ namespace Cart_Pole {
     {
     }
 
+    static const Rete::Variable_Slot move_slot;
+
     Move(const Rete::Variable_Indices &variables, const Rete::WME_Token &token)
-     : direction(Direction(debuggable_cast<const Rete::Symbol_Constant_Int &>(*token[variables.find("move")->second]).value))
+     : direction(Direction(token.get<Rete::Symbol_Constant_Int>(variables, move_slot).value))
     {
     }
 
@@ -110,6 +113,9 @@ namespace Cart_Pole {
 
     void print_impl(ostream &os) const;
 
+    void save_impl(ostream &os) const;
+    void load_impl(istream &is);
+
     Zeni::Random m_random_init;
     Zeni::Random m_random_motion;
 
@@ -128,8 +134,8 @@ namespace Cart_Pole {
     const double TAU = 0.02;      /* seconds between state updates */
     const double FOURTHIRDS = 1.3333333333333;
 
-    const bool m_has_goal = dynamic_cast<const Option_Ranged<bool> &>(Options::get_global()["set-goal"]).get_value();
-    const bool m_ignore_x = dynamic_cast<const Option_Ranged<bool> &>(Options::get_global()["ignore-x"]).get_value();
+    const bool m_has_goal = dynamic_cast<const Option_Ranged<bool> &>(get_context().get_options()["set-goal"]).get_value();
+    const bool m_ignore_x = dynamic_cast<const Option_Ranged<bool> &>(get_context().get_options()["ignore-x"]).get_value();
 
     const double m_max_theta = m_has_goal ? 1.57079632679 : 0.2094384; ///< pi/2.0 : 12 degrees
     const double m_max_theta_dot = m_has_goal ? 2.0 : 10.0;
@@ -153,17 +159,19 @@ namespace Cart_Pole {
 
     void update();
 
-    const bool m_ignore_x = dynamic_cast<const Option_Ranged<bool> &>(Options::get_global()["ignore-x"]).get_value();
+    void load_impl(istream &is);
+
+    const bool m_ignore_x = dynamic_cast<const Option_Ranged<bool> &>(get_context().get_options()["ignore-x"]).get_value();
 
-    Rete::Symbol_Constant_Float_Ptr_C m_x_value = Rete::Symbol_Constant_Float_Ptr_C(new Rete::Symbol_Constant_Float(dynamic_pointer_cast<Environment>(get_env())->get_x()));
-    Rete::Symbol_Constant_Float_Ptr_C m_x_dot_value = Rete::Symbol_Constant_Float_Ptr_C(new Rete::Symbol_Constant_Float(dynamic_pointer_cast<Environment>(get_env())->get_x_dot()));
-    Rete::Symbol_Constant_Float_Ptr_C m_theta_value = Rete::Symbol_Constant_Float_Ptr_C(new Rete::Symbol_Constant_Float(dynamic_pointer_cast<Environment>(get_env())->get_theta()));
-    Rete::Symbol_Constant_Float_Ptr_C m_theta_dot_value = Rete::Symbol_Constant_Float_Ptr_C(new Rete::Symbol_Constant_Float(dynamic_pointer_cast<Environment>(get_env())->get_theta_dot()));
+    Rete::Symbol_Constant_Float_Ptr_C m_x_value = Rete::Symbol_Constant_Float::intern(dynamic_pointer_cast<Environment>(get_env())->get_x());
+    Rete::Symbol_Constant_Float_Ptr_C m_x_dot_value = Rete::Symbol_Constant_Float::intern(dynamic_pointer_cast<Environment>(get_env())->get_x_dot());
+    Rete::Symbol_Constant_Float_Ptr_C m_theta_value = Rete::Symbol_Constant_Float::intern(dynamic_pointer_cast<Environment>(get_env())->get_theta());
+    Rete::Symbol_Constant_Float_Ptr_C m_theta_dot_value = Rete::Symbol_Constant_Float::intern(dynamic_pointer_cast<Environment>(get_env())->get_theta_dot());
 
-    Rete::WME_Ptr m_x_wme;
-    Rete::WME_Ptr m_x_dot_wme;
-    Rete::WME_Ptr m_theta_wme;
-    Rete::WME_Ptr m_theta_dot_wme;
+    Rete::WME_Ptr_C m_x_wme;
+    Rete::WME_Ptr_C m_x_dot_wme;
+    Rete::WME_Ptr_C m_theta_wme;
+    Rete::WME_Ptr_C m_theta_dot_wme;
 
     /// http://msdn.microsoft.com/en-us/library/dn793970.aspx
     std::array<std::shared_ptr<const Carli::Action>, 2> m_action;
@@ -10,6 +10,8 @@ namespace Cart_Pole {
   using Carli::Node_Unsplit;
   using Carli::Q_Value;
 
+  const Rete::Variable_Slot Move::move_slot("move");
+
   Environment::Environment() {
     init_impl();
   }
@@ -112,6 +114,24 @@ namespace Cart_Pole {
     os << " (" << m_x << ", " << m_x_dot << ", " << m_theta << ", " << m_theta_dot << ')' << endl;
   }
 
+  void Environment::save_impl(ostream &os) const {
+    m_random_init.save(os);
+    m_random_motion.save(os);
+    Zeni::serialize(os, m_theta);
+    Zeni::serialize(os, m_theta_dot);
+    Zeni::serialize(os, m_x);
+    Zeni::serialize(os, m_x_dot);
+  }
+
+  void Environment::load_impl(istream &is) {
+    m_random_init.load(is);
+    m_random_motion.load(is);
+    Zeni::deserialize(is, m_theta);
+    Zeni::deserialize(is, m_theta_dot);
+    Zeni::deserialize(is, m_x);
+    Zeni::deserialize(is, m_x_dot);
+  }
+
   Agent::Agent(const std::shared_ptr<Carli::Environment> &env)
    : Carli::Agent(env, [this](const Rete::Variable_Indices &variables, const Rete::WME_Token &token)->Carli::Action_Ptr_C {return std::make_shared<Move>(variables, token);}),
    m_action({{std::shared_ptr<const Carli::Action>(new Move(LEFT)),
@@ -120,27 +140,27 @@ namespace Cart_Pole {
     const Rete::Symbol_Variable_Ptr_C m_first_var = Rete::Symbol_Variable_Ptr_C(new Rete::Symbol_Variable(Rete::Symbol_Variable::First));
     const Rete::Symbol_Variable_Ptr_C m_third_var = Rete::Symbol_Variable_Ptr_C(new Rete::Symbol_Variable(Rete::Symbol_Variable::Third));
 
-    const auto move_attr = std::make_shared<Rete::Symbol_Constant_String>("move");
-    const auto x_attr = std::make_shared<Rete::Symbol_Constant_String>("x");
-    const auto x_dot_attr = std::make_shared<Rete::Symbol_Constant_String>("x-dot");
-    const auto theta_attr = std::make_shared<Rete::Symbol_Constant_String>("theta");
-    const auto theta_dot_attr = std::make_shared<Rete::Symbol_Constant_String>("theta-dot");
-    const std::array<Rete::Symbol_Constant_Int_Ptr_C, 2> move_values = {{std::make_shared<Rete::Symbol_Constant_Int>(LEFT),
-                                                                         std::make_shared<Rete::Symbol_Constant_Int>(RIGHT)}};
+    const auto move_attr = Rete::Symbol_Constant_String::intern("move");
+    const auto x_attr = Rete::Symbol_Constant_String::intern("x");
+    const auto x_dot_attr = Rete::Symbol_Constant_String::intern("x-dot");
+    const auto theta_attr = Rete::Symbol_Constant_String::intern("theta");
+    const auto theta_dot_attr = Rete::Symbol_Constant_String::intern("theta-dot");
+    const std::array<Rete::Symbol_Constant_Int_Ptr_C, 2> move_values = {{Rete::Symbol_Constant_Int::intern(LEFT),
+                                                                         Rete::Symbol_Constant_Int::intern(RIGHT)}};
 
     generate_rete();
     generate_features();
 
-    m_x_wme = std::make_shared<Rete::WME>(m_s_id, x_attr, m_x_value);
-    m_x_dot_wme = std::make_shared<Rete::WME>(m_s_id, x_dot_attr, m_x_dot_value);
-    m_theta_wme = std::make_shared<Rete::WME>(m_s_id, theta_attr, m_theta_value);
-    m_theta_dot_wme = std::make_shared<Rete::WME>(m_s_id, theta_dot_attr, m_theta_dot_value);
+    m_x_wme = Rete::WME::create(m_s_id, x_attr, m_x_value);
+    m_x_dot_wme = Rete::WME::create(m_s_id, x_dot_attr, m_x_dot_value);
+    m_theta_wme = Rete::WME::create(m_s_id, theta_attr, m_theta_value);
+    m_theta_dot_wme = Rete::WME::create(m_s_id, theta_dot_attr, m_theta_dot_value);
     insert_wme(m_x_wme);
     insert_wme(m_x_dot_wme);
     insert_wme(m_theta_wme);
     insert_wme(m_theta_dot_wme);
     for(const auto &move_value : move_values)
-      insert_wme(std::make_shared<Rete::WME>(m_s_id, move_attr, move_value));
+      insert_wme(Rete::WME::create(m_s_id, move_attr, move_value));
   }
 
   Agent::~Agent() {
@@ -148,7 +168,7 @@ namespace Cart_Pole {
   }
 
   void Agent::generate_rete() {
-    std::string rules_in = dynamic_cast<const Option_String &>(Options::get_global()["rules"]).get_value();
+    std::string rules_in = dynamic_cast<const Option_String &>(get_context().get_options()["rules"]).get_value();
     if(rules_in == "default")
       rules_in = "rules/cart-pole.carli";
     if(rete_parse_file(*this, rules_in))
@@ -161,27 +181,27 @@ namespace Cart_Pole {
     Rete::Agenda::Locker locker(agenda);
     CPU_Accumulator cpu_accumulator(*this);
 
-    const bool flush_wmes = get_Option_Ranged<bool>(Options::get_global(), "rete-flush-wmes");
+    const bool flush_wmes = get_Option_Ranged<bool>(get_context().get_options(), "rete-flush-wmes");
 
     if(flush_wmes || m_x_value->value != env->get_x()) {
-      remove_wme(m_x_wme);
-      m_x_wme->symbols[2] = m_x_value = Rete::Symbol_Constant_Float_Ptr_C(new Rete::Symbol_Constant_Float(env->get_x()));
-      insert_wme(m_x_wme);
+      if(flush_wmes)
+        remove_wme(m_x_wme);
+      m_x_wme = modify_wme(m_x_wme, m_x_value = Rete::Symbol_Constant_Float::intern(env->get_x()));
     }
     if(flush_wmes || m_x_dot_value->value != env->get_x_dot()) {
-      remove_wme(m_x_dot_wme);
-      m_x_dot_wme->symbols[2] = m_x_dot_value = Rete::Symbol_Constant_Float_Ptr_C(new Rete::Symbol_Constant_Float(env->get_x_dot()));
-      insert_wme(m_x_dot_wme);
+      if(flush_wmes)
+        remove_wme(m_x_dot_wme);
+      m_x_dot_wme = modify_wme(m_x_dot_wme, m_x_dot_value = Rete::Symbol_Constant_Float::intern(env->get_x_dot()));
     }
     if(flush_wmes || m_theta_value->value != env->get_theta()) {
-      remove_wme(m_theta_wme);
-      m_theta_wme->symbols[2] = m_theta_value = Rete::Symbol_Constant_Float_Ptr_C(new Rete::Symbol_Constant_Float(env->get_theta()));
-      insert_wme(m_theta_wme);
+      if(flush_wmes)
+        remove_wme(m_theta_wme);
+      m_theta_wme = modify_wme(m_theta_wme, m_theta_value = Rete::Symbol_Constant_Float::intern(env->get_theta()));
     }
     if(flush_wmes || m_theta_dot_value->value != env->get_theta_dot()) {
-      remove_wme(m_theta_dot_wme);
-      m_theta_dot_wme->symbols[2] = m_theta_dot_value = Rete::Symbol_Constant_Float_Ptr_C(new Rete::Symbol_Constant_Float(env->get_theta_dot()));
-      insert_wme(m_theta_dot_wme);
+      if(flush_wmes)
+        remove_wme(m_theta_dot_wme);
+      m_theta_dot_wme = modify_wme(m_theta_dot_wme, m_theta_dot_value = Rete::Symbol_Constant_Float::intern(env->get_theta_dot()));
     }
   }
 
@@ -196,4 +216,28 @@ namespace Cart_Pole {
       m_metastate = Metastate::NON_TERMINAL;
   }
 
+  void Agent::load_impl(istream &) {
+    /// modify_wme must be handed the WMEs restored into working memory
+    for(const auto &wme : get_wmes()) {
+      if(wme->symbols[0] != m_s_id)
+        continue;
+      if(wme->symbols[1] == m_x_wme->symbols[1]) {
+        m_x_wme = wme;
+        m_x_value = dynamic_pointer_cast<const Rete::Symbol_Constant_Float>(wme->symbols[2]);
+      }
+      else if(wme->symbols[1] == m_x_dot_wme->symbols[1]) {
+        m_x_dot_wme = wme;
+        m_x_dot_value = dynamic_pointer_cast<const Rete::Symbol_Constant_Float>(wme->symbols[2]);
+      }
+      else if(wme->symbols[1] == m_theta_wme->symbols[1]) {
+        m_theta_wme = wme;
+        m_theta_value = dynamic_pointer_cast<const Rete::Symbol_Constant_Float>(wme->symbols[2]);
+      }
+      else if(wme->symbols[1] == m_theta_dot_wme->symbols[1]) {
+        m_theta_dot_wme = wme;
+        m_theta_dot_value = dynamic_pointer_cast<const Rete::Symbol_Constant_Float>(wme->symbols[2]);
+      }
+    }
+  }
+
 }
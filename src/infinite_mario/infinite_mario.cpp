@@ -11,6 +11,10 @@ namespace Mario {
   using Carli::Node_Unsplit;
   using Carli::Q_Value;
 
+  const Rete::Variable_Slot Button_Presses::dpad_slot("dpad");
+  const Rete::Variable_Slot Button_Presses::jump_slot("jump");
+  const Rete::Variable_Slot Button_Presses::speed_slot("speed");
+
   //void infinite_mario_ai(const std::shared_ptr<State> &prev, const std::shared_ptr<State> &current, Action &action) {
   //  action[BUTTON_LEFT] = 0;
   //  action[BUTTON_RIGHT] = 1;
@@ -216,7 +220,7 @@ namespace Mario {
       m_rho = probability_greedy(m_next, nullptr, std::numeric_limits<int64_t>::max()) / m_rho;
 
     m_current = m_next;
-    m_current_q_value = m_next_q_values[m_next];
+    m_current_q_value = m_next_q_values[*m_next];
     m_current_q_value.sort([](const tracked_ptr<Q_Value> &lhs, const tracked_ptr<Q_Value> &rhs)->bool{return lhs->depth < rhs->depth;});
 
     assert(m_current);
@@ -287,14 +291,14 @@ namespace Mario {
   //        std::cerr << "   " << *next_q.first << " is an option." << std::endl;
       std::cerr << "   " << *m_next << " is next." << std::endl;
 #endif
-      auto &value_best = m_next_q_values[m_next];
+      auto &value_best = m_next_q_values[*m_next];
       td_update(m_current_q_value, reward, value_best, m_rho, 1.0);
 
       if(!is_on_policy()) {
         Carli::Action_Ptr_C next = m_exploration_policy();
 
         if(*m_next != *next) {
-          if(sum_value(nullptr, m_current_q_value, nullptr, std::numeric_limits<int64_t>::max()) < sum_value(nullptr, m_next_q_values[next], nullptr, std::numeric_limits<int64_t>::max()))
+          if(sum_value(nullptr, m_current_q_value, nullptr, std::numeric_limits<int64_t>::max()) < sum_value(nullptr, m_next_q_values[*next], nullptr, std::numeric_limits<int64_t>::max()))
             clear_eligibility_trace();
           m_next = next;
         }
@@ -324,7 +328,7 @@ namespace Mario {
   }
 
   void Agent::generate_rete() {
-    std::string rules_in = dynamic_cast<const Option_String &>(Options::get_global()["rules"]).get_value();
+    std::string rules_in = dynamic_cast<const Option_String &>(get_context().get_options()["rules"]).get_value();
     if(rules_in == "default")
       rules_in = "../../rules/infinite-mario.carli";
     if(rete_parse_file(*this, rules_in))
@@ -332,31 +336,30 @@ namespace Mario {
   }
 
   void Agent::generate_features() {
-    std::list<Rete::WME_Ptr_C> wmes_current;
     std::ostringstream oss;
 
-    wmes_current.push_back(std::make_shared<Rete::WME>(m_s_id, m_x_attr, std::make_shared<Rete::Symbol_Constant_Float>(m_current_state->getMarioFloatPos.first)));
-    wmes_current.push_back(std::make_shared<Rete::WME>(m_s_id, m_y_attr, std::make_shared<Rete::Symbol_Constant_Float>(m_current_state->getMarioFloatPos.second)));
-    wmes_current.push_back(std::make_shared<Rete::WME>(m_s_id, m_x_dot_attr, std::make_shared<Rete::Symbol_Constant_Float>(m_current_state->getMarioFloatVel.first)));
-    wmes_current.push_back(std::make_shared<Rete::WME>(m_s_id, m_y_dot_attr, std::make_shared<Rete::Symbol_Constant_Float>(m_current_state->getMarioFloatVel.second)));
-    wmes_current.push_back(std::make_shared<Rete::WME>(m_s_id, m_mode_attr, std::make_shared<Rete::Symbol_Constant_Int>(m_current_state->getMarioMode)));
-    wmes_current.push_back(std::make_shared<Rete::WME>(m_s_id, m_on_ground_attr, m_current_state->isMarioOnGround ? m_true_value : m_false_value));
-    wmes_current.push_back(std::make_shared<Rete::WME>(m_s_id, m_may_jump_attr, m_current_state->mayMarioJump ? m_true_value : m_false_value));
-    wmes_current.push_back(std::make_shared<Rete::WME>(m_s_id, m_is_carrying_attr, m_current_state->isMarioCarrying ? m_true_value : m_false_value));
-    wmes_current.push_back(std::make_shared<Rete::WME>(m_s_id, m_is_high_jumping_attr, m_current_state->isMarioHighJumping ? m_true_value : m_false_value));
-    wmes_current.push_back(std::make_shared<Rete::WME>(m_s_id, m_is_above_pit_attr, m_current_state->getLevelSceneObservation[OBSERVATION_HEIGHT / 2][OBSERVATION_WIDTH / 2 - 1].detail.above_pit ? m_true_value : m_false_value));
-    wmes_current.push_back(std::make_shared<Rete::WME>(m_s_id, m_is_in_pit_attr, m_current_state->getLevelSceneObservation[OBSERVATION_HEIGHT / 2][OBSERVATION_WIDTH / 2 - 1].detail.pit ? m_true_value : m_false_value));
-    wmes_current.push_back(std::make_shared<Rete::WME>(m_s_id, m_pit_right_attr, m_current_state->getLevelSceneObservation[OBSERVATION_HEIGHT / 2][OBSERVATION_WIDTH / 2].detail.pit ||
+    m_wmes.push_back(Rete::WME::create(m_s_id, m_x_attr, Rete::Symbol_Constant_Float::intern(m_current_state->getMarioFloatPos.first)));
+    m_wmes.push_back(Rete::WME::create(m_s_id, m_y_attr, Rete::Symbol_Constant_Float::intern(m_current_state->getMarioFloatPos.second)));
+    m_wmes.push_back(Rete::WME::create(m_s_id, m_x_dot_attr, Rete::Symbol_Constant_Float::intern(m_current_state->getMarioFloatVel.first)));
+    m_wmes.push_back(Rete::WME::create(m_s_id, m_y_dot_attr, Rete::Symbol_Constant_Float::intern(m_current_state->getMarioFloatVel.second)));
+    m_wmes.push_back(Rete::WME::create(m_s_id, m_mode_attr, Rete::Symbol_Constant_Int::intern(m_current_state->getMarioMode)));
+    m_wmes.push_back(Rete::WME::create(m_s_id, m_on_ground_attr, m_current_state->isMarioOnGround ? m_true_value : m_false_value));
+    m_wmes.push_back(Rete::WME::create(m_s_id, m_may_jump_attr, m_current_state->mayMarioJump ? m_true_value : m_false_value));
+    m_wmes.push_back(Rete::WME::create(m_s_id, m_is_carrying_attr, m_current_state->isMarioCarrying ? m_true_value : m_false_value));
+    m_wmes.push_back(Rete::WME::create(m_s_id, m_is_high_jumping_attr, m_current_state->isMarioHighJumping ? m_true_value : m_false_value));
+    m_wmes.push_back(Rete::WME::create(m_s_id, m_is_above_pit_attr, m_current_state->getLevelSceneObservation[OBSERVATION_HEIGHT / 2][OBSERVATION_WIDTH / 2 - 1].detail.above_pit ? m_true_value : m_false_value));
+    m_wmes.push_back(Rete::WME::create(m_s_id, m_is_in_pit_attr, m_current_state->getLevelSceneObservation[OBSERVATION_HEIGHT / 2][OBSERVATION_WIDTH / 2 - 1].detail.pit ? m_true_value : m_false_value));
+    m_wmes.push_back(Rete::WME::create(m_s_id, m_pit_right_attr, m_current_state->getLevelSceneObservation[OBSERVATION_HEIGHT / 2][OBSERVATION_WIDTH / 2].detail.pit ||
                                                                                  m_current_state->getLevelSceneObservation[OBSERVATION_HEIGHT / 2][OBSERVATION_WIDTH / 2 + 1].detail.pit ? m_true_value : m_false_value));
-    wmes_current.push_back(std::make_shared<Rete::WME>(m_s_id, m_obstacle_right_attr, !tile_can_pass_through(m_current_state->getLevelSceneObservation[OBSERVATION_HEIGHT / 2][OBSERVATION_WIDTH / 2].tile) ? m_true_value : m_false_value));
+    m_wmes.push_back(Rete::WME::create(m_s_id, m_obstacle_right_attr, !tile_can_pass_through(m_current_state->getLevelSceneObservation[OBSERVATION_HEIGHT / 2][OBSERVATION_WIDTH / 2].tile) ? m_true_value : m_false_value));
 
-    wmes_current.push_back(std::make_shared<Rete::WME>(m_s_id, m_button_presses_in_attr, m_button_presses_in_id));
-    wmes_current.push_back(std::make_shared<Rete::WME>(m_button_presses_in_id, m_dpad_attr,
-      std::make_shared<Rete::Symbol_Constant_Int>(m_current_state->action[BUTTON_DOWN] ? BUTTON_DOWN :
+    m_wmes.push_back(Rete::WME::create(m_s_id, m_button_presses_in_attr, m_button_presses_in_id));
+    m_wmes.push_back(Rete::WME::create(m_button_presses_in_id, m_dpad_attr,
+      Rete::Symbol_Constant_Int::intern(m_current_state->action[BUTTON_DOWN] ? BUTTON_DOWN :
       m_current_state->action[BUTTON_LEFT] ^ m_current_state->action[BUTTON_RIGHT] ? (m_current_state->action[BUTTON_LEFT] ? BUTTON_LEFT : BUTTON_RIGHT) :
       BUTTON_NONE)));
-    wmes_current.push_back(std::make_shared<Rete::WME>(m_button_presses_in_id, m_jump_attr, m_current_state->action[BUTTON_JUMP] ? m_true_value : m_false_value));
-    wmes_current.push_back(std::make_shared<Rete::WME>(m_button_presses_in_id, m_speed_attr, m_current_state->action[BUTTON_SPEED] ? m_true_value : m_false_value));
+    m_wmes.push_back(Rete::WME::create(m_button_presses_in_id, m_jump_attr, m_current_state->action[BUTTON_JUMP] ? m_true_value : m_false_value));
+    m_wmes.push_back(Rete::WME::create(m_button_presses_in_id, m_speed_attr, m_current_state->action[BUTTON_SPEED] ? m_true_value : m_false_value));
 
     {
       int dist = 0;
@@ -377,8 +380,8 @@ namespace Mario {
         break;
       }
 
-      wmes_current.push_back(std::make_shared<Rete::WME>(m_s_id, m_right_pit_dist_attr, std::make_shared<Rete::Symbol_Constant_Float>(dist)));
-      wmes_current.push_back(std::make_shared<Rete::WME>(m_s_id, m_right_pit_width_attr, std::make_shared<Rete::Symbol_Constant_Float>(width)));
+      m_wmes.push_back(Rete::WME::create(m_s_id, m_right_pit_dist_attr, Rete::Symbol_Constant_Float::intern(dist)));
+      m_wmes.push_back(Rete::WME::create(m_s_id, m_right_pit_width_attr, Rete::Symbol_Constant_Float::intern(width)));
     }
 
     {
@@ -399,8 +402,8 @@ namespace Mario {
         break;
       }
 
-      wmes_current.push_back(std::make_shared<Rete::WME>(m_s_id, m_right_jump_dist_attr, std::make_shared<Rete::Symbol_Constant_Float>(dist)));
-      wmes_current.push_back(std::make_shared<Rete::WME>(m_s_id, m_right_jump_height_attr, std::make_shared<Rete::Symbol_Constant_Float>(OBSERVATION_HEIGHT / 2 - j)));
+      m_wmes.push_back(Rete::WME::create(m_s_id, m_right_jump_dist_attr, Rete::Symbol_Constant_Float::intern(dist)));
+      m_wmes.push_back(Rete::WME::create(m_s_id, m_right_jump_height_attr, Rete::Symbol_Constant_Float::intern(OBSERVATION_HEIGHT / 2 - j)));
     }
 
     for(int i = 0; i != 16; ++i) {
@@ -409,35 +412,35 @@ namespace Mario {
       if(!(i & 0x2) && m_current_state->isMarioHighJumping)
         continue; ///< Force high jumping
       oss << "O" << i + 1;
-      Rete::Symbol_Identifier_Ptr_C action_id = std::make_shared<Rete::Symbol_Identifier>(oss.str());
+      Rete::Symbol_Identifier_Ptr_C action_id = Rete::Symbol_Identifier::intern(oss.str());
       oss.str("");
-      wmes_current.push_back(std::make_shared<Rete::WME>(m_s_id, m_button_presses_out_attr, action_id));
-      wmes_current.push_back(std::make_shared<Rete::WME>(action_id, m_dpad_attr, std::make_shared<Rete::Symbol_Constant_Int>(
+      m_wmes.push_back(Rete::WME::create(m_s_id, m_button_presses_out_attr, action_id));
+      m_wmes.push_back(Rete::WME::create(action_id, m_dpad_attr, Rete::Symbol_Constant_Int::intern(
         (i & 0xC) == 0xC ? BUTTON_DOWN : i & 0x4 ? BUTTON_LEFT : i & 0x8 ? BUTTON_RIGHT : BUTTON_NONE)));
-      wmes_current.push_back(std::make_shared<Rete::WME>(action_id, m_jump_attr, i & 0x2 ? m_true_value : m_false_value));
-      wmes_current.push_back(std::make_shared<Rete::WME>(action_id, m_speed_attr, i & 0x1 ? m_true_value : m_false_value));
+      m_wmes.push_back(Rete::WME::create(action_id, m_jump_attr, i & 0x2 ? m_true_value : m_false_value));
+      m_wmes.push_back(Rete::WME::create(action_id, m_speed_attr, i & 0x1 ? m_true_value : m_false_value));
     }
 
     Rete::Symbol_Identifier_Ptr_C nearest_enemy_id;
     double nearest_enemy_distance = std::numeric_limits<double>::max();
     for(const auto &enemy : m_current_state->getEnemiesFloatPos) {
       oss << "E" << enemy.which;
-      const Rete::Symbol_Identifier_Ptr_C enemy_id = std::make_shared<Rete::Symbol_Identifier>(oss.str());
+      const Rete::Symbol_Identifier_Ptr_C enemy_id = Rete::Symbol_Identifier::intern(oss.str());
       oss.str("");
 
       const double x_rel = enemy.position.first - m_current_state->getMarioFloatPos.first;
       const double y_rel = enemy.position.second - m_current_state->getMarioFloatPos.second;
       const double distance = std::sqrt(x_rel*x_rel + y_rel*y_rel);
 
-      wmes_current.push_back(std::make_shared<Rete::WME>(m_s_id, m_enemy_attr, enemy_id));
-      wmes_current.push_back(std::make_shared<Rete::WME>(enemy_id, m_type_attr, std::make_shared<Rete::Symbol_Constant_Int>(object_simplified(enemy.object))));
-      wmes_current.push_back(std::make_shared<Rete::WME>(enemy_id, m_x_attr, std::make_shared<Rete::Symbol_Constant_Float>(x_rel)));
-      wmes_current.push_back(std::make_shared<Rete::WME>(enemy_id, m_y_attr, std::make_shared<Rete::Symbol_Constant_Float>(y_rel)));
-      wmes_current.push_back(std::make_shared<Rete::WME>(enemy_id, m_x_dot_attr, std::make_shared<Rete::Symbol_Constant_Float>(enemy.velocity.first)));
-      wmes_current.push_back(std::make_shared<Rete::WME>(enemy_id, m_y_dot_attr, std::make_shared<Rete::Symbol_Constant_Float>(enemy.velocity.second)));
-      wmes_current.push_back(std::make_shared<Rete::WME>(enemy_id, m_flies_attr, object_flies(enemy.object) ? m_true_value : m_false_value));
-      wmes_current.push_back(std::make_shared<Rete::WME>(enemy_id, m_fireball_kills_attr, object_killable_by_fireball(enemy.object) ? m_true_value : m_false_value));
-      wmes_current.push_back(std::make_shared<Rete::WME>(enemy_id, m_jump_kills_attr, object_killable_by_jump(enemy.object) ? m_true_value : m_false_value));
+      m_wmes.push_back(Rete::WME::create(m_s_id, m_enemy_attr, enemy_id));
+      m_wmes.push_back(Rete::WME::create(enemy_id, m_type_attr, Rete::Symbol_Constant_Int::intern(object_simplified(enemy.object))));
+      m_wmes.push_back(Rete::WME::create(enemy_id, m_x_attr, Rete::Symbol_Constant_Float::intern(x_rel)));
+      m_wmes.push_back(Rete::WME::create(enemy_id, m_y_attr, Rete::Symbol_Constant_Float::intern(y_rel)));
+      m_wmes.push_back(Rete::WME::create(enemy_id, m_x_dot_attr, Rete::Symbol_Constant_Float::intern(enemy.velocity.first)));
+      m_wmes.push_back(Rete::WME::create(enemy_id, m_y_dot_attr, Rete::Symbol_Constant_Float::intern(enemy.velocity.second)));
+      m_wmes.push_back(Rete::WME::create(enemy_id, m_flies_attr, object_flies(enemy.object) ? m_true_value : m_false_value));
+      m_wmes.push_back(Rete::WME::create(enemy_id, m_fireball_kills_attr, object_killable_by_fireball(enemy.object) ? m_true_value : m_false_value));
+      m_wmes.push_back(Rete::WME::create(enemy_id, m_jump_kills_attr, object_killable_by_jump(enemy.object) ? m_true_value : m_false_value));
 
       if(distance < nearest_enemy_distance) {
         nearest_enemy_id = enemy_id;
@@ -446,22 +449,22 @@ namespace Mario {
     }
 
     if(!nearest_enemy_id) {
-      const Rete::Symbol_Identifier_Ptr_C enemy_id = std::make_shared<Rete::Symbol_Identifier>("E0");
-
-      wmes_current.push_back(std::make_shared<Rete::WME>(m_s_id, m_enemy_attr, enemy_id));
-      wmes_current.push_back(std::make_shared<Rete::WME>(enemy_id, m_type_attr, std::make_shared<Rete::Symbol_Constant_Int>(object_simplified(OBJECT_IRRELEVANT))));
-      wmes_current.push_back(std::make_shared<Rete::WME>(enemy_id, m_x_attr, std::make_shared<Rete::Symbol_Constant_Float>(-300.0)));
-      wmes_current.push_back(std::make_shared<Rete::WME>(enemy_id, m_y_attr, m_zero));
-      wmes_current.push_back(std::make_shared<Rete::WME>(enemy_id, m_x_dot_attr, m_zero));
-      wmes_current.push_back(std::make_shared<Rete::WME>(enemy_id, m_y_dot_attr, m_zero));
-      wmes_current.push_back(std::make_shared<Rete::WME>(enemy_id, m_flies_attr, m_false_value));
-      wmes_current.push_back(std::make_shared<Rete::WME>(enemy_id, m_fireball_kills_attr, m_true_value));
-      wmes_current.push_back(std::make_shared<Rete::WME>(enemy_id, m_jump_kills_attr, m_true_value));
+      const Rete::Symbol_Identifier_Ptr_C enemy_id = Rete::Symbol_Identifier::intern("E0");
+
+      m_wmes.push_back(Rete::WME::create(m_s_id, m_enemy_attr, enemy_id));
+      m_wmes.push_back(Rete::WME::create(enemy_id, m_type_attr, Rete::Symbol_Constant_Int::intern(object_simplified(OBJECT_IRRELEVANT))));
+      m_wmes.push_back(Rete::WME::create(enemy_id, m_x_attr, Rete::Symbol_Constant_Float::intern(-300.0)));
+      m_wmes.push_back(Rete::WME::create(enemy_id, m_y_attr, m_zero));
+      m_wmes.push_back(Rete::WME::create(enemy_id, m_x_dot_attr, m_zero));
+      m_wmes.push_back(Rete::WME::create(enemy_id, m_y_dot_attr, m_zero));
+      m_wmes.push_back(Rete::WME::create(enemy_id, m_flies_attr, m_false_value));
+      m_wmes.push_back(Rete::WME::create(enemy_id, m_fireball_kills_attr, m_true_value));
+      m_wmes.push_back(Rete::WME::create(enemy_id, m_jump_kills_attr, m_true_value));
 
       nearest_enemy_id = enemy_id;
     }
 
-    wmes_current.push_back(std::make_shared<Rete::WME>(m_s_id, m_nearest_enemy_attr, nearest_enemy_id));
+    m_wmes.push_back(Rete::WME::create(m_s_id, m_nearest_enemy_attr, nearest_enemy_id));
 
     {
       int dist2 = std::numeric_limits<int>::max();
@@ -486,51 +489,27 @@ namespace Mario {
         }
       }
 
-      const Rete::Symbol_Identifier_Ptr_C powerup_id = std::make_shared<Rete::Symbol_Identifier>("POW");
+      const Rete::Symbol_Identifier_Ptr_C powerup_id = Rete::Symbol_Identifier::intern("POW");
 
-      wmes_current.push_back(std::make_shared<Rete::WME>(m_s_id, m_nearest_powerup_attr, powerup_id));
+      m_wmes.push_back(Rete::WME::create(m_s_id, m_nearest_powerup_attr, powerup_id));
 
       if(powerup != OBJECT_IRRELEVANT) {
-        wmes_current.push_back(std::make_shared<Rete::WME>(powerup_id, m_x_attr, std::make_shared<Rete::Symbol_Constant_Float>(pos_x - OBSERVATION_WIDTH / 2)));
-        wmes_current.push_back(std::make_shared<Rete::WME>(powerup_id, m_y_attr, std::make_shared<Rete::Symbol_Constant_Float>(pos_y - OBSERVATION_HEIGHT / 2)));
-        wmes_current.push_back(std::make_shared<Rete::WME>(powerup_id, m_type_attr, std::make_shared<Rete::Symbol_Constant_Int>(powerup)));
+        m_wmes.push_back(Rete::WME::create(powerup_id, m_x_attr, Rete::Symbol_Constant_Float::intern(pos_x - OBSERVATION_WIDTH / 2)));
+        m_wmes.push_back(Rete::WME::create(powerup_id, m_y_attr, Rete::Symbol_Constant_Float::intern(pos_y - OBSERVATION_HEIGHT / 2)));
+        m_wmes.push_back(Rete::WME::create(powerup_id, m_type_attr, Rete::Symbol_Constant_Int::intern(powerup)));
       }
       else {
-        wmes_current.push_back(std::make_shared<Rete::WME>(powerup_id, m_x_attr, m_zero));
-        wmes_current.push_back(std::make_shared<Rete::WME>(powerup_id, m_y_attr, m_zero));
-        wmes_current.push_back(std::make_shared<Rete::WME>(powerup_id, m_type_attr, std::make_shared<Rete::Symbol_Constant_Int>(object_simplified(OBJECT_IRRELEVANT))));
+        m_wmes.push_back(Rete::WME::create(powerup_id, m_x_attr, m_zero));
+        m_wmes.push_back(Rete::WME::create(powerup_id, m_y_attr, m_zero));
+        m_wmes.push_back(Rete::WME::create(powerup_id, m_type_attr, Rete::Symbol_Constant_Int::intern(object_simplified(OBJECT_IRRELEVANT))));
       }
     }
 
-    Rete::Agenda::Locker locker(agenda);
-    CPU_Accumulator cpu_accumulator(*this);
-
-    if(get_Option_Ranged<bool>(Options::get_global(), "rete-flush-wmes")) {
-      for(auto wt = m_wmes_prev.begin(), wend = m_wmes_prev.end(); wt != wend; ++wt)
-        remove_wme(*wt);
-      m_wmes_prev.clear();
-    }
-    else {
-      for(auto wt = m_wmes_prev.begin(), wend = m_wmes_prev.end(); wt != wend; ) {
-        const auto found = std::find_if(wmes_current.begin(), wmes_current.end(), [wt](const Rete::WME_Ptr_C &wme_)->bool{return *wme_ == **wt;});
-        if(found == wmes_current.end()) {
-          remove_wme(*wt);
-          m_wmes_prev.erase(wt++);
-        }
-        else {
-          wmes_current.erase(found);
-          ++wt;
-        }
-      }
-    }
+    if(get_Option_Ranged<bool>(get_context().get_options(), "rete-flush-wmes"))
+      clear_wmes();
 
-    for(auto &wme : wmes_current) {
-      const auto found = std::find_if(m_wmes_prev.begin(), m_wmes_prev.end(), [wme](const Rete::WME_Ptr_C &wme_)->bool{return *wme_ == *wme;});
-      if(found == m_wmes_prev.end()) {
-        m_wmes_prev.push_back(wme);
-        insert_wme(wme);
-      }
-    }
+    set_wmes(m_wmes);
+    m_wmes.clear();
   }
 
   void Agent::update() {
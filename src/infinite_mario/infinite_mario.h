@@ -43,13 +43,17 @@ namespace Mario {
     {
     }
 
+    static const Rete::Variable_Slot dpad_slot;
+    static const Rete::Variable_Slot jump_slot;
+    static const Rete::Variable_Slot speed_slot;
+
     Button_Presses(const Rete::Variable_Indices &variables, const Rete::WME_Token &token) {
       memset(&action, 0, sizeof(action));
-      const int64_t dpad = debuggable_cast<const Rete::Symbol_Constant_Int &>(*token[variables.find("dpad")->second]).value;
+      const int64_t dpad = token.get<Rete::Symbol_Constant_Int>(variables, dpad_slot).value;
       if(dpad != BUTTON_NONE)
         action.at(size_t(dpad)) = true;
-      action[BUTTON_JUMP] = debuggable_cast<const Rete::Symbol_Constant_Int &>(*token[variables.find("jump")->second]).value != 0;
-      action[BUTTON_SPEED] = debuggable_cast<const Rete::Symbol_Constant_Int &>(*token[variables.find("speed")->second]).value != 0;
+      action[BUTTON_JUMP] = token.get<Rete::Symbol_Constant_Int>(variables, jump_slot).value != 0;
+      action[BUTTON_SPEED] = token.get<Rete::Symbol_Constant_Int>(variables, speed_slot).value != 0;
     }
 
     Button_Presses * clone() const {
@@ -97,42 +101,42 @@ namespace Mario {
     const std::shared_ptr<State> &m_current_state;
     const std::shared_ptr<State> &m_prev_state;
 
-    const Rete::Symbol_Constant_String_Ptr_C m_button_presses_in_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("button-presses-in"));
-    const Rete::Symbol_Constant_String_Ptr_C m_button_presses_out_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("button-presses-out"));
-    const Rete::Symbol_Constant_String_Ptr_C m_enemy_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("enemy"));
-    const Rete::Symbol_Constant_String_Ptr_C m_x_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("x"));
-    const Rete::Symbol_Constant_String_Ptr_C m_y_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("y"));
-    const Rete::Symbol_Constant_String_Ptr_C m_x_dot_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("x-dot"));
-    const Rete::Symbol_Constant_String_Ptr_C m_y_dot_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("y-dot"));
-    const Rete::Symbol_Constant_String_Ptr_C m_mode_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("mode"));
-    const Rete::Symbol_Constant_String_Ptr_C m_on_ground_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("on-ground"));
-    const Rete::Symbol_Constant_String_Ptr_C m_may_jump_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("may-jump"));
-    const Rete::Symbol_Constant_String_Ptr_C m_is_carrying_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("is-carrying"));
-    const Rete::Symbol_Constant_String_Ptr_C m_is_high_jumping_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("is-high-jumping"));
-    const Rete::Symbol_Constant_String_Ptr_C m_is_above_pit_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("is-above-pit"));
-    const Rete::Symbol_Constant_String_Ptr_C m_is_in_pit_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("is-in-pit"));
-    const Rete::Symbol_Constant_String_Ptr_C m_pit_right_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("pit-right"));
-    const Rete::Symbol_Constant_String_Ptr_C m_obstacle_right_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("obstacle-right"));
-    const Rete::Symbol_Constant_String_Ptr_C m_right_pit_dist_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("right-pit-dist"));
-    const Rete::Symbol_Constant_String_Ptr_C m_right_pit_width_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("right-pit-width"));
-    const Rete::Symbol_Constant_String_Ptr_C m_right_jump_dist_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("right-jump-dist"));
-    const Rete::Symbol_Constant_String_Ptr_C m_right_jump_height_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("right-jump-height"));
-    const Rete::Symbol_Constant_String_Ptr_C m_dpad_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("dpad"));
-    const Rete::Symbol_Constant_String_Ptr_C m_jump_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("jump"));
-    const Rete::Symbol_Constant_String_Ptr_C m_speed_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("speed"));
-    const Rete::Symbol_Constant_String_Ptr_C m_type_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("type"));
-    const Rete::Symbol_Constant_String_Ptr_C m_flies_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("flies"));
-    const Rete::Symbol_Constant_String_Ptr_C m_nearest_enemy_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("nearest-enemy"));
-    const Rete::Symbol_Constant_String_Ptr_C m_fireball_kills_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("fireball-kills"));
-    const Rete::Symbol_Constant_String_Ptr_C m_jump_kills_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("jump-kills"));
-    const Rete::Symbol_Constant_String_Ptr_C m_nearest_powerup_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("nearest-powerup"));
-    const Rete::Symbol_Constant_Int_Ptr_C m_true_value = Rete::Symbol_Constant_Int_Ptr_C(new Rete::Symbol_Constant_Int(1));
-    const Rete::Symbol_Constant_Int_Ptr_C m_false_value = Rete::Symbol_Constant_Int_Ptr_C(new Rete::Symbol_Constant_Int(0));
-    const Rete::Symbol_Constant_Float_Ptr_C m_zero = std::make_shared<Rete::Symbol_Constant_Float>(0.0);
-
-    const Rete::Symbol_Identifier_Ptr_C m_button_presses_in_id = Rete::Symbol_Identifier_Ptr_C(new Rete::Symbol_Identifier("I1"));
-
-    std::list<Rete::WME_Ptr_C> m_wmes_prev;
+    const Rete::Symbol_Constant_String_Ptr_C m_button_presses_in_attr = Rete::Symbol_Constant_String::intern("button-presses-in");
+    const Rete::Symbol_Constant_String_Ptr_C m_button_presses_out_attr = Rete::Symbol_Constant_String::intern("button-presses-out");
+    const Rete::Symbol_Constant_String_Ptr_C m_enemy_attr = Rete::Symbol_Constant_String::intern("enemy");
+    const Rete::Symbol_Constant_String_Ptr_C m_x_attr = Rete::Symbol_Constant_String::intern("x");
+    const Rete::Symbol_Constant_String_Ptr_C m_y_attr = Rete::Symbol_Constant_String::intern("y");
+    const Rete::Symbol_Constant_String_Ptr_C m_x_dot_attr = Rete::Symbol_Constant_String::intern("x-dot");
+    const Rete::Symbol_Constant_String_Ptr_C m_y_dot_attr = Rete::Symbol_Constant_String::intern("y-dot");
+    const Rete::Symbol_Constant_String_Ptr_C m_mode_attr = Rete::Symbol_Constant_String::intern("mode");
+    const Rete::Symbol_Constant_String_Ptr_C m_on_ground_attr = Rete::Symbol_Constant_String::intern("on-ground");
+    const Rete::Symbol_Constant_String_Ptr_C m_may_jump_attr = Rete::Symbol_Constant_String::intern("may-jump");
+    const Rete::Symbol_Constant_String_Ptr_C m_is_carrying_attr = Rete::Symbol_Constant_String::intern("is-carrying");
+    const Rete::Symbol_Constant_String_Ptr_C m_is_high_jumping_attr = Rete::Symbol_Constant_String::intern("is-high-jumping");
+    const Rete::Symbol_Constant_String_Ptr_C m_is_above_pit_attr = Rete::Symbol_Constant_String::intern("is-above-pit");
+    const Rete::Symbol_Constant_String_Ptr_C m_is_in_pit_attr = Rete::Symbol_Constant_String::intern("is-in-pit");
+    const Rete::Symbol_Constant_String_Ptr_C m_pit_right_attr = Rete::Symbol_Constant_String::intern("pit-right");
+    const Rete::Symbol_Constant_String_Ptr_C m_obstacle_right_attr = Rete::Symbol_Constant_String::intern("obstacle-right");
+    const Rete::Symbol_Constant_String_Ptr_C m_right_pit_dist_attr = Rete::Symbol_Constant_String::intern("right-pit-dist");
+    const Rete::Symbol_Constant_String_Ptr_C m_right_pit_width_attr = Rete::Symbol_Constant_String::intern("right-pit-width");
+    const Rete::Symbol_Constant_String_Ptr_C m_right_jump_dist_attr = Rete::Symbol_Constant_String::intern("right-jump-dist");
+    const Rete::Symbol_Constant_String_Ptr_C m_right_jump_height_attr = Rete::Symbol_Constant_String::intern("right-jump-height");
+    const Rete::Symbol_Constant_String_Ptr_C m_dpad_attr = Rete::Symbol_Constant_String::intern("dpad");
+    const Rete::Symbol_Constant_String_Ptr_C m_jump_attr = Rete::Symbol_Constant_String::intern("jump");
+    const Rete::Symbol_Constant_String_Ptr_C m_speed_attr = Rete::Symbol_Constant_String::intern("speed");
+    const Rete::Symbol_Constant_String_Ptr_C m_type_attr = Rete::Symbol_Constant_String::intern("type");
+    const Rete::Symbol_Constant_String_Ptr_C m_flies_attr = Rete::Symbol_Constant_String::intern("flies");
+    const Rete::Symbol_Constant_String_Ptr_C m_nearest_enemy_attr = Rete::Symbol_Constant_String::intern("nearest-enemy");
+    const Rete::Symbol_Constant_String_Ptr_C m_fireball_kills_attr = Rete::Symbol_Constant_String::intern("fireball-kills");
+    const Rete::Symbol_Constant_String_Ptr_C m_jump_kills_attr = Rete::Symbol_Constant_String::intern("jump-kills");
+    const Rete::Symbol_Constant_String_Ptr_C m_nearest_powerup_attr = Rete::Symbol_Constant_String::intern("nearest-powerup");
+    const Rete::Symbol_Constant_Int_Ptr_C m_true_value = Rete::Symbol_Constant_Int::intern(1);
+    const Rete::Symbol_Constant_Int_Ptr_C m_false_value = Rete::Symbol_Constant_Int::intern(0);
+    const Rete::Symbol_Constant_Float_Ptr_C m_zero = Rete::Symbol_Constant_Float::intern(0.0);
+
+    const Rete::Symbol_Identifier_Ptr_C m_button_presses_in_id = Rete::Symbol_Identifier::intern("I1");
+
+    std::vector<Rete::WME_Ptr_C> m_wmes; ///< The next state, collected by generate_features
     double m_rho = double();
   };
 
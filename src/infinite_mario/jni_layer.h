@@ -83,6 +83,15 @@ namespace Mario {
       os << ')';
     }
 
+    /// Observations come from the Java benchmark, which the experiment's checkpoints cannot capture
+    void save_impl(std::ostream &) const {
+      abort();
+    }
+
+    void load_impl(std::istream &) {
+      abort();
+    }
+
     struct Tile_Info {
       Tile_Info() : tile(TILE_IRRELEVANT) {
         memset(&detail, 0, sizeof(detail));
@@ -28,6 +28,7 @@ namespace Mountain_Car {
 
   using std::dynamic_pointer_cast;
   using std::endl;
+  using std::istream;
   using std::make_pair;
   using std::map;
   using std::ostream;
@@ -42,8 +43,10 @@ namespace Mountain_Car {
     {
     }
 
+    static const Rete::Variable_Slot acceleration_slot;
+
     Acceleration(const Rete::Variable_Indices &variables, const Rete::WME_Token &token)
-     : direction(Direction(debuggable_cast<const Rete::Symbol_Constant_Int &>(*token[variables.find("acceleration")->second]).value))
+     : direction(Direction(token.get<Rete::Symbol_Constant_Int>(variables, acceleration_slot).value))
     {
     }
 
@@ -97,6 +100,9 @@ namespace Mountain_Car {
 
     void print_impl(ostream &os) const;
 
+    void save_impl(ostream &os) const;
+    void load_impl(istream &is);
+
     Zeni::Random m_random_init;
 
     double m_x = 0.0;
@@ -110,8 +116,8 @@ namespace Mountain_Car {
     double m_cart_force = 0.001;
     double m_grav_force = 0.0025;
 
-    const bool m_random_start = get_Option_Ranged<bool>(Options::get_global(), "random-start");
-    const bool m_reward_negative = get_Option_Ranged<bool>(Options::get_global(), "reward-negative");
+    const bool m_random_start = get_Option_Ranged<bool>(get_context().get_options(), "random-start");
+    const bool m_reward_negative = get_Option_Ranged<bool>(get_context().get_options(), "reward-negative");
   };
 
   class MOUNTAIN_CAR_LINKAGE Agent : public Carli::Agent {
@@ -128,18 +134,20 @@ namespace Mountain_Car {
 
     void update();
 
+    void load_impl(istream &is);
+
     const double m_min_x = -1.2;
     const double m_max_x = 0.6;
     const double m_min_x_dot = -0.07;
     const double m_max_x_dot = 0.07;
 
-    const Rete::Symbol_Constant_String_Ptr_C m_x_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("x"));
-    const Rete::Symbol_Constant_String_Ptr_C m_x_dot_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("x-dot"));
-    Rete::Symbol_Constant_Float_Ptr_C m_x_value = Rete::Symbol_Constant_Float_Ptr_C(new Rete::Symbol_Constant_Float(dynamic_pointer_cast<Environment>(get_env())->get_x()));
-    Rete::Symbol_Constant_Float_Ptr_C m_x_dot_value = Rete::Symbol_Constant_Float_Ptr_C(new Rete::Symbol_Constant_Float(dynamic_pointer_cast<Environment>(get_env())->get_x_dot()));
+    const Rete::Symbol_Constant_String_Ptr_C m_x_attr = Rete::Symbol_Constant_String::intern("x");
+    const Rete::Symbol_Constant_String_Ptr_C m_x_dot_attr = Rete::Symbol_Constant_String::intern("x-dot");
+    Rete::Symbol_Constant_Float_Ptr_C m_x_value = Rete::Symbol_Constant_Float::intern(dynamic_pointer_cast<Environment>(get_env())->get_x());
+    Rete::Symbol_Constant_Float_Ptr_C m_x_dot_value = Rete::Symbol_Constant_Float::intern(dynamic_pointer_cast<Environment>(get_env())->get_x_dot());
 
-    Rete::WME_Ptr m_x_wme;
-    Rete::WME_Ptr m_x_dot_wme;
+    Rete::WME_Ptr_C m_x_wme;
+    Rete::WME_Ptr_C m_x_dot_wme;
     
     /// http://msdn.microsoft.com/en-us/library/dn793970.aspx
     std::array<std::shared_ptr<const Carli::Action>, 3> m_action;
@@ -9,6 +9,8 @@ namespace Mountain_Car {
   using Carli::Node_Unsplit;
   using Carli::Q_Value;
 
+  const Rete::Variable_Slot Acceleration::acceleration_slot("acceleration");
+
   Environment::Environment() {
     Environment::init_impl();
   }
@@ -61,6 +63,22 @@ namespace Mountain_Car {
     os << " (" << m_x << ", " << m_x_dot << ')' << endl;
   }
 
+  void Environment::save_impl(ostream &os) const {
+    m_random_init.save(os);
+    Zeni::serialize(os, m_x);
+    Zeni::serialize(os, m_x_dot);
+    Zeni::serialize(os, m_cart_force);
+    Zeni::serialize(os, m_grav_force);
+  }
+
+  void Environment::load_impl(istream &is) {
+    m_random_init.load(is);
+    Zeni::deserialize(is, m_x);
+    Zeni::deserialize(is, m_x_dot);
+    Zeni::deserialize(is, m_cart_force);
+    Zeni::deserialize(is, m_grav_force);
+  }
+
   Agent::Agent(const shared_ptr<Carli::Environment> &env)
    : Carli::Agent(env, [this](const Rete::Variable_Indices &variables, const Rete::WME_Token &token)->Carli::Action_Ptr_C {return std::make_shared<Acceleration>(variables, token);}),
    m_action({{std::shared_ptr<const Carli::Action>(new Acceleration(LEFT)),
@@ -70,14 +88,14 @@ namespace Mountain_Car {
     const Rete::Symbol_Variable_Ptr_C m_first_var = Rete::Symbol_Variable_Ptr_C(new Rete::Symbol_Variable(Rete::Symbol_Variable::First));
     const Rete::Symbol_Variable_Ptr_C m_third_var = Rete::Symbol_Variable_Ptr_C(new Rete::Symbol_Variable(Rete::Symbol_Variable::Third));
 
-    auto x_attr = std::make_shared<Rete::Symbol_Constant_String>("x");
-    auto x_dot_attr = std::make_shared<Rete::Symbol_Constant_String>("x-dot");
-    auto acceleration_attr = std::make_shared<Rete::Symbol_Constant_String>("acceleration");
-    const std::array<Rete::Symbol_Constant_Int_Ptr_C, 3> acceleration_values = {{std::make_shared<Rete::Symbol_Constant_Int>(LEFT),
-                                                                                 std::make_shared<Rete::Symbol_Constant_Int>(IDLE),
-                                                                                 std::make_shared<Rete::Symbol_Constant_Int>(RIGHT)}};
+    auto x_attr = Rete::Symbol_Constant_String::intern("x");
+    auto x_dot_attr = Rete::Symbol_Constant_String::intern("x-dot");
+    auto acceleration_attr = Rete::Symbol_Constant_String::intern("acceleration");
+    const std::array<Rete::Symbol_Constant_Int_Ptr_C, 3> acceleration_values = {{Rete::Symbol_Constant_Int::intern(LEFT),
+                                                                                 Rete::Symbol_Constant_Int::intern(IDLE),
+                                                                                 Rete::Symbol_Constant_Int::intern(RIGHT)}};
 
-    if(dynamic_cast<const Option_Ranged<bool> &>(Options::get_global()["cmac"]).get_value()) {
+    if(dynamic_cast<const Option_Ranged<bool> &>(get_context().get_options()["cmac"]).get_value()) {
       Rete::WME_Bindings state_bindings;
       state_bindings.insert(Rete::WME_Binding(Rete::WME_Token_Index(0, 0, 0), Rete::WME_Token_Index(0, 0, 0)));
       auto acceleration = make_filter(Rete::WME(m_first_var, acceleration_attr, m_third_var));
@@ -91,19 +109,19 @@ namespace Mountain_Car {
       }
     }
     else {
-      std::string rules_in = dynamic_cast<const Option_String &>(Options::get_global()["rules"]).get_value();
+      std::string rules_in = dynamic_cast<const Option_String &>(get_context().get_options()["rules"]).get_value();
       if(rules_in == "default")
         rules_in = "rules/mountain-car.carli";
       if(rete_parse_file(*this, rules_in))
         abort();
     }
 
-    m_x_wme = std::make_shared<Rete::WME>(m_s_id, x_attr, m_x_value);
-    m_x_dot_wme = std::make_shared<Rete::WME>(m_s_id, x_dot_attr, m_x_dot_value);
+    m_x_wme = Rete::WME::create(m_s_id, x_attr, m_x_value);
+    m_x_dot_wme = Rete::WME::create(m_s_id, x_dot_attr, m_x_dot_value);
     insert_wme(m_x_wme);
     insert_wme(m_x_dot_wme);
     for(const auto &acceleration_value : acceleration_values)
-      insert_wme(std::make_shared<Rete::WME>(m_s_id, acceleration_attr, acceleration_value));
+      insert_wme(Rete::WME::create(m_s_id, acceleration_attr, acceleration_value));
   }
 
   Agent::~Agent() {
@@ -137,9 +155,9 @@ namespace Mountain_Car {
   }
 
   void Agent::generate_cmac(const Rete::Rete_Node_Ptr &parent) {
-    const int64_t cmac_tilings = dynamic_cast<const Option_Ranged<int64_t> &>(Options::get_global()["cmac-tilings"]).get_value();
-    const int64_t cmac_resolution = dynamic_cast<const Option_Ranged<int64_t> &>(Options::get_global()["cmac-resolution"]).get_value();
-    const int64_t cmac_offset = dynamic_cast<const Option_Ranged<int64_t> &>(Options::get_global()["cmac-offset"]).get_value();
+    const int64_t cmac_tilings = dynamic_cast<const Option_Ranged<int64_t> &>(get_context().get_options()["cmac-tilings"]).get_value();
+    const int64_t cmac_resolution = dynamic_cast<const Option_Ranged<int64_t> &>(get_context().get_options()["cmac-resolution"]).get_value();
+    const int64_t cmac_offset = dynamic_cast<const Option_Ranged<int64_t> &>(get_context().get_options()["cmac-offset"]).get_value();
 
     assert(cmac_offset < cmac_tilings);
     const double x_size = (m_max_x - m_min_x) / cmac_resolution;
@@ -157,13 +175,13 @@ namespace Mountain_Car {
       for(int64_t i = 0; i != cmac_resolution; ++i) {
         const double left = m_min_x + (i - x_offset) * x_size;
         const double right = m_min_x + (i + 1 - x_offset) * x_size;
-        auto xgte = make_predicate_vc(Rete::Rete_Predicate::GTE, Rete::WME_Token_Index(1, 1, 2), std::make_shared<Rete::Symbol_Constant_Float>(left), parent);
-        auto xlt = make_predicate_vc(Rete::Rete_Predicate::LT, Rete::WME_Token_Index(1, 1, 2), std::make_shared<Rete::Symbol_Constant_Float>(right), xgte);
+        auto xgte = make_predicate_vc(Rete::Rete_Predicate::GTE, Rete::WME_Token_Index(1, 1, 2), Rete::Symbol_Constant_Float::intern(left), parent);
+        auto xlt = make_predicate_vc(Rete::Rete_Predicate::LT, Rete::WME_Token_Index(1, 1, 2), Rete::Symbol_Constant_Float::intern(right), xgte);
         for(int64_t j = 0; j != cmac_resolution; ++j) {
           const double top = m_min_x_dot + (j - xdot_offset) * xdot_size;
           const double bottom = m_min_x_dot + (j + 1 - xdot_offset) * xdot_size;
-          auto xdotgte = make_predicate_vc(Rete::Rete_Predicate::GTE, Rete::WME_Token_Index(2, 2, 2), std::make_shared<Rete::Symbol_Constant_Float>(top), xlt);
-          auto xdotlt = make_predicate_vc(Rete::Rete_Predicate::LT, Rete::WME_Token_Index(2, 2, 2), std::make_shared<Rete::Symbol_Constant_Float>(bottom), xdotgte);
+          auto xdotgte = make_predicate_vc(Rete::Rete_Predicate::GTE, Rete::WME_Token_Index(2, 2, 2), Rete::Symbol_Constant_Float::intern(top), xlt);
+          auto xdotlt = make_predicate_vc(Rete::Rete_Predicate::LT, Rete::WME_Token_Index(2, 2, 2), Rete::Symbol_Constant_Float::intern(bottom), xdotgte);
 
           ///// This does redundant work for actions after the first.
           //for(const auto &action : m_action) {
@@ -174,7 +192,7 @@ namespace Mountain_Car {
           //}
 
           auto action = make_standard_action(xdotlt, next_rule_name("mountain-car*rl-action*cmac-"), false, variables);
-          action->data = std::make_shared<Node_Split>(*this, Rete::Rete_Action_Ptr(), action, new Q_Value(Q_Value::Token(), Q_Value::Type::SPLIT, 1, nullptr, 0), new Q_Value(Q_Value::Token(), Q_Value::Type::FRINGE, 1, nullptr, 0));
+          action->data = std::allocate_shared<Node_Split>(Zeni::Pool_Allocator<Node_Split>(), *this, Rete::Rete_Action_Ptr(), action, new Q_Value(Q_Value::Token(), Q_Value::Type::SPLIT, 1, nullptr, 0), new Q_Value(Q_Value::Token(), Q_Value::Type::FRINGE, 1, nullptr, 0));
         }
       }
     }
@@ -186,17 +204,17 @@ namespace Mountain_Car {
     Rete::Agenda::Locker locker(agenda);
     CPU_Accumulator cpu_accumulator(*this);
 
-    const bool flush_wmes = get_Option_Ranged<bool>(Options::get_global(), "rete-flush-wmes");
+    const bool flush_wmes = get_Option_Ranged<bool>(get_context().get_options(), "rete-flush-wmes");
 
     if(flush_wmes || m_x_value->value != env->get_x()) {
-      remove_wme(m_x_wme);
-      m_x_wme->symbols[2] = m_x_value = std::make_shared<Rete::Symbol_Constant_Float>(env->get_x());
-      insert_wme(m_x_wme);
+      if(flush_wmes)
+        remove_wme(m_x_wme);
+      m_x_wme = modify_wme(m_x_wme, m_x_value = Rete::Symbol_Constant_Float::intern(env->get_x()));
     }
     if(flush_wmes || m_x_dot_value->value != env->get_x_dot()) {
-      remove_wme(m_x_dot_wme);
-      m_x_dot_wme->symbols[2] = m_x_dot_value = std::make_shared<Rete::Symbol_Constant_Float>(env->get_x_dot());
-      insert_wme(m_x_dot_wme);
+      if(flush_wmes)
+        remove_wme(m_x_dot_wme);
+      m_x_dot_wme = modify_wme(m_x_dot_wme, m_x_dot_value = Rete::Symbol_Constant_Float::intern(env->get_x_dot()));
     }
   }
 
@@ -206,4 +224,20 @@ namespace Mountain_Car {
     m_metastate = env->success() ? Metastate::SUCCESS : Metastate::NON_TERMINAL;
   }
 
+  void Agent::load_impl(istream &) {
+    /// modify_wme must be handed the WMEs restored into working memory
+    for(const auto &wme : get_wmes()) {
+      if(wme->symbols[0] != m_s_id)
+        continue;
+      if(wme->symbols[1] == m_x_wme->symbols[1]) {
+        m_x_wme = wme;
+        m_x_value = dynamic_pointer_cast<const Rete::Symbol_Constant_Float>(wme->symbols[2]);
+      }
+      else if(wme->symbols[1] == m_x_dot_wme->symbols[1]) {
+        m_x_dot_wme = wme;
+        m_x_dot_value = dynamic_pointer_cast<const Rete::Symbol_Constant_Float>(wme->symbols[2]);
+      }
+    }
+  }
+
 }
@@ -29,6 +29,7 @@ namespace Puddle_World {
 
   using std::dynamic_pointer_cast;
   using std::endl;
+  using std::istream;
   using std::make_pair;
   using std::map;
   using std::ostream;
@@ -43,8 +44,10 @@ namespace Puddle_World {
     {
     }
 
+    static const Rete::Variable_Slot move_slot;
+
     Move(const Rete::Variable_Indices &variables, const Rete::WME_Token &token)
-     : direction(Direction(debuggable_cast<const Rete::Symbol_Constant_Int &>(*token[variables.find("move")->second]).value))
+     : direction(Direction(token.get<Rete::Symbol_Constant_Int>(variables, move_slot).value))
     {
     }
 
@@ -109,6 +112,9 @@ namespace Puddle_World {
 
     void print_impl(ostream &os) const;
 
+    void save_impl(ostream &os) const;
+    void load_impl(istream &is);
+
     Zeni::Random m_random_init;
     Zeni::Random m_random_motion;
 
@@ -122,7 +128,7 @@ namespace Puddle_World {
     double_pair m_goal_y;
 
     size_t m_step_count = 0lu;
-    const bool m_random_start = get_Option_Ranged<bool>(Options::get_global(), "random-start");
+    const bool m_random_start = get_Option_Ranged<bool>(get_context().get_options(), "random-start");
 
     std::vector<Puddle> m_horizontal_puddles;
     std::vector<Puddle> m_vertical_puddles;
@@ -144,11 +150,13 @@ namespace Puddle_World {
 
     void update();
 
-    Rete::Symbol_Constant_Float_Ptr_C m_x_value = Rete::Symbol_Constant_Float_Ptr_C(new Rete::Symbol_Constant_Float(dynamic_pointer_cast<Environment>(get_env())->get_position().first));
-    Rete::Symbol_Constant_Float_Ptr_C m_y_value = Rete::Symbol_Constant_Float_Ptr_C(new Rete::Symbol_Constant_Float(dynamic_pointer_cast<Environment>(get_env())->get_position().second));
+    void load_impl(istream &is);
+
+    Rete::Symbol_Constant_Float_Ptr_C m_x_value = Rete::Symbol_Constant_Float::intern(dynamic_pointer_cast<Environment>(get_env())->get_position().first);
+    Rete::Symbol_Constant_Float_Ptr_C m_y_value = Rete::Symbol_Constant_Float::intern(dynamic_pointer_cast<Environment>(get_env())->get_position().second);
 
-    Rete::WME_Ptr m_x_wme;
-    Rete::WME_Ptr m_y_wme;
+    Rete::WME_Ptr_C m_x_wme;
+    Rete::WME_Ptr_C m_y_wme;
 
     /// http://msdn.microsoft.com/en-us/library/dn793970.aspx
     std::array<std::shared_ptr<const Carli::Action>, 4> m_action;
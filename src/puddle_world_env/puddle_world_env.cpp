@@ -9,6 +9,8 @@ namespace Puddle_World {
   using Carli::Node_Unsplit;
   using Carli::Q_Value;
 
+  const Rete::Variable_Slot Move::move_slot("move");
+
   Environment::Environment()
    : m_horizontal_puddles({{{0.1, 0.45, 0.75, 0.1}}}),
    m_vertical_puddles({{{0.45, 0.4, 0.8, 0.1}}})
@@ -163,6 +165,32 @@ namespace Puddle_World {
     os << " (" << m_position.first << ", " << m_position.second << ')' << endl;
   }
 
+  void Environment::save_impl(ostream &os) const {
+    m_random_init.save(os);
+    m_random_motion.save(os);
+    Zeni::serialize(os, m_position);
+    Zeni::serialize(os, m_goal_dynamic);
+    Zeni::serialize(os, m_goal_x);
+    Zeni::serialize(os, m_goal_y);
+    Zeni::serialize(os, m_step_count);
+    Zeni::serialize(os, m_horizontal_puddles);
+    Zeni::serialize(os, m_vertical_puddles);
+    Zeni::serialize(os, m_noise);
+  }
+
+  void Environment::load_impl(istream &is) {
+    m_random_init.load(is);
+    m_random_motion.load(is);
+    Zeni::deserialize(is, m_position);
+    Zeni::deserialize(is, m_goal_dynamic);
+    Zeni::deserialize(is, m_goal_x);
+    Zeni::deserialize(is, m_goal_y);
+    Zeni::deserialize(is, m_step_count);
+    Zeni::deserialize(is, m_horizontal_puddles);
+    Zeni::deserialize(is, m_vertical_puddles);
+    Zeni::deserialize(is, m_noise);
+  }
+
   Agent::Agent(const shared_ptr<Carli::Environment> &env)
    : Carli::Agent(env, [this](const Rete::Variable_Indices &variables, const Rete::WME_Token &token)->Carli::Action_Ptr_C {return std::make_shared<Move>(variables, token);}),
    m_action({{std::shared_ptr<const Carli::Action>(new Move(NORTH)),
@@ -173,15 +201,15 @@ namespace Puddle_World {
     const Rete::Symbol_Variable_Ptr_C m_first_var = Rete::Symbol_Variable_Ptr_C(new Rete::Symbol_Variable(Rete::Symbol_Variable::First));
     const Rete::Symbol_Variable_Ptr_C m_third_var = Rete::Symbol_Variable_Ptr_C(new Rete::Symbol_Variable(Rete::Symbol_Variable::Third));
 
-    const auto move_attr = std::make_shared<Rete::Symbol_Constant_String>("move");
-    const auto x_attr = std::make_shared<Rete::Symbol_Constant_String>("x");
-    const auto y_attr = std::make_shared<Rete::Symbol_Constant_String>("y");
-    const std::array<Rete::Symbol_Constant_Int_Ptr_C, 4> move_values = {{std::make_shared<Rete::Symbol_Constant_Int>(NORTH),
-                                                                         std::make_shared<Rete::Symbol_Constant_Int>(SOUTH),
-                                                                         std::make_shared<Rete::Symbol_Constant_Int>(EAST),
-                                                                         std::make_shared<Rete::Symbol_Constant_Int>(WEST)}};
+    const auto move_attr = Rete::Symbol_Constant_String::intern("move");
+    const auto x_attr = Rete::Symbol_Constant_String::intern("x");
+    const auto y_attr = Rete::Symbol_Constant_String::intern("y");
+    const std::array<Rete::Symbol_Constant_Int_Ptr_C, 4> move_values = {{Rete::Symbol_Constant_Int::intern(NORTH),
+                                                                         Rete::Symbol_Constant_Int::intern(SOUTH),
+                                                                         Rete::Symbol_Constant_Int::intern(EAST),
+                                                                         Rete::Symbol_Constant_Int::intern(WEST)}};
 
-    if(dynamic_cast<const Option_Ranged<bool> &>(Options::get_global()["cmac"]).get_value()) {
+    if(dynamic_cast<const Option_Ranged<bool> &>(get_context().get_options()["cmac"]).get_value()) {
       Rete::WME_Bindings state_bindings;
       state_bindings.insert(Rete::WME_Binding(Rete::WME_Token_Index(0, 0, 0), Rete::WME_Token_Index(0, 0, 0)));
       const auto move = make_filter(Rete::WME(m_first_var, move_attr, m_third_var));
@@ -195,19 +223,19 @@ namespace Puddle_World {
       }
     }
     else {
-      std::string rules_in = dynamic_cast<const Option_String &>(Options::get_global()["rules"]).get_value();
+      std::string rules_in = dynamic_cast<const Option_String &>(get_context().get_options()["rules"]).get_value();
       if(rules_in == "default")
         rules_in = "rules/puddle-world.carli";
       if(rete_parse_file(*this, rules_in))
         abort();
     }
 
-    m_x_wme = std::make_shared<Rete::WME>(m_s_id, x_attr, m_x_value);
-    m_y_wme = std::make_shared<Rete::WME>(m_s_id, y_attr, m_y_value);
+    m_x_wme = Rete::WME::create(m_s_id, x_attr, m_x_value);
+    m_y_wme = Rete::WME::create(m_s_id, y_attr, m_y_value);
     insert_wme(m_x_wme);
     insert_wme(m_y_wme);
     for(const auto &move_value : move_values)
-      insert_wme(std::make_shared<Rete::WME>(m_s_id, move_attr, move_value));
+      insert_wme(Rete::WME::create(m_s_id, move_attr, move_value));
   }
 
   Agent::~Agent() {
@@ -239,9 +267,9 @@ namespace Puddle_World {
   }
 
   void Agent::generate_cmac(const Rete::Rete_Node_Ptr &parent) {
-    const int64_t cmac_tilings = dynamic_cast<const Option_Ranged<int64_t> &>(Options::get_global()["cmac-tilings"]).get_value();
-    const int64_t cmac_resolution = dynamic_cast<const Option_Ranged<int64_t> &>(Options::get_global()["cmac-resolution"]).get_value();
-    const int64_t cmac_offset = dynamic_cast<const Option_Ranged<int64_t> &>(Options::get_global()["cmac-offset"]).get_value();
+    const int64_t cmac_tilings = dynamic_cast<const Option_Ranged<int64_t> &>(get_context().get_options()["cmac-tilings"]).get_value();
+    const int64_t cmac_resolution = dynamic_cast<const Option_Ranged<int64_t> &>(get_context().get_options()["cmac-resolution"]).get_value();
+    const int64_t cmac_offset = dynamic_cast<const Option_Ranged<int64_t> &>(get_context().get_options()["cmac-offset"]).get_value();
 
     assert(cmac_offset < cmac_tilings);
     const double xy_size = 1.0 / cmac_resolution;
@@ -257,13 +285,13 @@ namespace Puddle_World {
       for(int64_t i = 0; i != cmac_resolution; ++i) {
         const double left = (i - xy_offset) * xy_size;
         const double right = (i + 1 - xy_offset) * xy_size;
-        auto xgte = make_predicate_vc(Rete::Rete_Predicate::GTE, Rete::WME_Token_Index(1, 1, 2), std::make_shared<Rete::Symbol_Constant_Float>(left), parent);
-        auto xlt = make_predicate_vc(Rete::Rete_Predicate::LT, Rete::WME_Token_Index(1, 1, 2), std::make_shared<Rete::Symbol_Constant_Float>(right), xgte);
+        auto xgte = make_predicate_vc(Rete::Rete_Predicate::GTE, Rete::WME_Token_Index(1, 1, 2), Rete::Symbol_Constant_Float::intern(left), parent);
+        auto xlt = make_predicate_vc(Rete::Rete_Predicate::LT, Rete::WME_Token_Index(1, 1, 2), Rete::Symbol_Constant_Float::intern(right), xgte);
         for(int64_t j = 0; j != cmac_resolution; ++j) {
           const double top = (j - xy_offset) * xy_size;
           const double bottom = (j + 1 - xy_offset) * xy_size;
-          auto ygte = make_predicate_vc(Rete::Rete_Predicate::GTE, Rete::WME_Token_Index(2, 2, 2), std::make_shared<Rete::Symbol_Constant_Float>(top), xlt);
-          auto ylt = make_predicate_vc(Rete::Rete_Predicate::LT, Rete::WME_Token_Index(2, 2, 2), std::make_shared<Rete::Symbol_Constant_Float>(bottom), ygte);
+          auto ygte = make_predicate_vc(Rete::Rete_Predicate::GTE, Rete::WME_Token_Index(2, 2, 2), Rete::Symbol_Constant_Float::intern(top), xlt);
+          auto ylt = make_predicate_vc(Rete::Rete_Predicate::LT, Rete::WME_Token_Index(2, 2, 2), Rete::Symbol_Constant_Float::intern(bottom), ygte);
 
           ///// This does redundant work for actions after the first.
           //for(const auto &action : m_action) {
@@ -274,7 +302,7 @@ namespace Puddle_World {
           //}
 
           auto action = make_standard_action(ylt, next_rule_name("puddle-world*rl-action*cmac-"), false, variables);
-          action->data = std::make_shared<Node_Split>(*this, Rete::Rete_Action_Ptr(), action, new Q_Value(Q_Value::Token(), Q_Value::Type::SPLIT, 1, nullptr, 0), new Q_Value(Q_Value::Token(), Q_Value::Type::FRINGE, 1, nullptr, 0));
+          action->data = std::allocate_shared<Node_Split>(Zeni::Pool_Allocator<Node_Split>(), *this, Rete::Rete_Action_Ptr(), action, new Q_Value(Q_Value::Token(), Q_Value::Type::SPLIT, 1, nullptr, 0), new Q_Value(Q_Value::Token(), Q_Value::Type::FRINGE, 1, nullptr, 0));
         }
       }
     }
@@ -287,17 +315,17 @@ namespace Puddle_World {
     Rete::Agenda::Locker locker(agenda);
     CPU_Accumulator cpu_accumulator(*this);
 
-    const bool flush_wmes = get_Option_Ranged<bool>(Options::get_global(), "rete-flush-wmes");
+    const bool flush_wmes = get_Option_Ranged<bool>(get_context().get_options(), "rete-flush-wmes");
 
     if(flush_wmes || m_x_value->value != pos.first) {
-      remove_wme(m_x_wme);
-      m_x_wme->symbols[2] = m_x_value = std::make_shared<Rete::Symbol_Constant_Float>(pos.first);
-      insert_wme(m_x_wme);
+      if(flush_wmes)
+        remove_wme(m_x_wme);
+      m_x_wme = modify_wme(m_x_wme, m_x_value = Rete::Symbol_Constant_Float::intern(pos.first));
     }
     if(flush_wmes || m_y_value->value != pos.second) {
-      remove_wme(m_y_wme);
-      m_y_wme->symbols[2] = m_y_value = std::make_shared<Rete::Symbol_Constant_Float>(pos.second);
-      insert_wme(m_y_wme);
+      if(flush_wmes)
+        remove_wme(m_y_wme);
+      m_y_wme = modify_wme(m_y_wme, m_y_value = Rete::Symbol_Constant_Float::intern(pos.second));
     }
   }
 
@@ -307,4 +335,20 @@ namespace Puddle_World {
     m_metastate = env->goal_reached() ? Metastate::SUCCESS : Metastate::NON_TERMINAL;
   }
 
+  void Agent::load_impl(istream &) {
+    /// modify_wme must be handed the WMEs restored into working memory
+    for(const auto &wme : get_wmes()) {
+      if(wme->symbols[0] != m_s_id)
+        continue;
+      if(wme->symbols[1] == m_x_wme->symbols[1]) {
+        m_x_wme = wme;
+        m_x_value = dynamic_pointer_cast<const Rete::Symbol_Constant_Float>(wme->symbols[2]);
+      }
+      else if(wme->symbols[1] == m_y_wme->symbols[1]) {
+        m_y_wme = wme;
+        m_y_value = dynamic_pointer_cast<const Rete::Symbol_Constant_Float>(wme->symbols[2]);
+      }
+    }
+  }
+
 }
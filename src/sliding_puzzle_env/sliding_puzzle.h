@@ -1,5 +1,5 @@
-#ifndef BLOCKS_WORLD_2_H
-#define BLOCKS_WORLD_2_H
+#ifndef SLIDING_PUZZLE_H
+#define SLIDING_PUZZLE_H
 
 #include "carli/agent.h"
 #include "carli/environment.h"
@@ -22,6 +22,7 @@ namespace Sliding_Puzzle {
 
   using std::dynamic_pointer_cast;
   using std::endl;
+  using std::istream;
   using std::ostream;
 
   class SLIDING_PUZZLE_LINKAGE Move : public Carli::Action {
@@ -36,8 +37,10 @@ namespace Sliding_Puzzle {
     {
     }
 
+    static const Rete::Variable_Slot tile_slot;
+
     Move(const Rete::Variable_Indices &variables, const Rete::WME_Token &token)
-     : tile(debuggable_cast<const Rete::Symbol_Constant_Int &>(*token[variables.find("tile")->second]).value)
+     : tile(token.get<Rete::Symbol_Constant_Int>(variables, tile_slot).value)
     {
     }
 
@@ -118,15 +121,19 @@ namespace Sliding_Puzzle {
 
     void print_impl(ostream &os) const;
 
+    void save_impl(ostream &os) const;
+    void load_impl(istream &is);
+
     Zeni::Random m_random;
     Grid m_grid;
-    const int64_t m_grid_w = dynamic_cast<const Option_Ranged<int64_t> &>(Options::get_global()["grid-width"]).get_value();
-    const int64_t m_grid_h = dynamic_cast<const Option_Ranged<int64_t> &>(Options::get_global()["grid-height"]).get_value();
+    const int64_t m_grid_w = dynamic_cast<const Option_Ranged<int64_t> &>(get_context().get_options()["grid-width"]).get_value();
+    const int64_t m_grid_h = dynamic_cast<const Option_Ranged<int64_t> &>(get_context().get_options()["grid-height"]).get_value();
 
-    const bool m_batch = dynamic_cast<const Option_Itemized &>(Options::get_global()["tile-movement"]).get_value() == "batch";
+    const bool m_batch = dynamic_cast<const Option_Itemized &>(get_context().get_options()["tile-movement"]).get_value() == "batch";
 
-    const bool m_evaluate_optimality = dynamic_cast<const Option_Ranged<bool> &>(Options::get_global()["evaluate-optimality"]).get_value() && supports_optimal() && dynamic_cast<const Option_Itemized &>(Options::get_global()["output"]).get_value() != "null";
+    const bool m_evaluate_optimality = dynamic_cast<const Option_Ranged<bool> &>(get_context().get_options()["evaluate-optimality"]).get_value() && supports_optimal() && dynamic_cast<const Option_Itemized &>(get_context().get_options()["output"]).get_value() != "null";
     int64_t m_num_steps_to_goal = 0;
+    bool m_skip_first_optimality = true;
   };
 
   class SLIDING_PUZZLE_LINKAGE Agent : public Carli::Agent {
@@ -144,37 +151,40 @@ namespace Sliding_Puzzle {
 
     void update();
 
+    void save_impl(ostream &os) const;
+    void load_impl(istream &is);
+
     Zeni::Random m_random;
 
-    const Rete::Symbol_Constant_String_Ptr_C m_action_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("action"));
-    //const Rete::Symbol_Constant_String_Ptr_C m_dimensionality_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("dimensionality"));
-    const Rete::Symbol_Constant_String_Ptr_C m_snake1_length_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("snake1-length"));
-    const Rete::Symbol_Constant_String_Ptr_C m_snake2_length_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("snake2-length"));
-    const Rete::Symbol_Constant_String_Ptr_C m_snake1_dist_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("snake1-dist"));
-    const Rete::Symbol_Constant_String_Ptr_C m_snake2_dist_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("snake2-dist"));
-    const Rete::Symbol_Constant_String_Ptr_C m_snake1_blank_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("snake1-blank"));
-    const Rete::Symbol_Constant_String_Ptr_C m_snake2_blank_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("snake2-blank"));
-    //const Rete::Symbol_Constant_String_Ptr_C m_top_snake_manhattan_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("top-snake-manhattan"));
-    //const Rete::Symbol_Constant_String_Ptr_C m_left_snake_manhattan_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("left-snake-manhattan"));
-    //const Rete::Symbol_Constant_String_Ptr_C m_top_snake_dist_to_blank_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("top-snake-dist-to-blank"));
-    //const Rete::Symbol_Constant_String_Ptr_C m_left_snake_dist_to_blank_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("left-snake-dist-to-blank"));
-    //const Rete::Symbol_Constant_String_Ptr_C m_top_left_ccw_dist_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("top-left-ccw-dist"));
-    //const Rete::Symbol_Constant_String_Ptr_C m_top_right_cw_dist_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("top-right-cw-dist"));
-    //const Rete::Symbol_Constant_String_Ptr_C m_left_top_cw_dist_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("left-top-cw-dist"));
-    //const Rete::Symbol_Constant_String_Ptr_C m_left_bottom_ccw_dist_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("left-bottom-ccw-dist"));
-    //const Rete::Symbol_Constant_String_Ptr_C m_moves_to_blank_tl_ccw_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("moves-to-blank-tl-ccw"));
-    const Rete::Symbol_Constant_String_Ptr_C m_tile_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("tile"));
-    const Rete::Symbol_Identifier_Ptr_C m_move_up_id = Rete::Symbol_Identifier_Ptr_C(new Rete::Symbol_Identifier("move-up"));
-    const Rete::Symbol_Identifier_Ptr_C m_move_down_id = Rete::Symbol_Identifier_Ptr_C(new Rete::Symbol_Identifier("move-down"));
-    const Rete::Symbol_Identifier_Ptr_C m_move_left_id = Rete::Symbol_Identifier_Ptr_C(new Rete::Symbol_Identifier("move-left"));
-    const Rete::Symbol_Identifier_Ptr_C m_move_right_id = Rete::Symbol_Identifier_Ptr_C(new Rete::Symbol_Identifier("move-right"));
-    const Rete::Symbol_Constant_Int_Ptr_C m_increases = Rete::Symbol_Constant_Int_Ptr_C(new Rete::Symbol_Constant_Int(1));
-    const Rete::Symbol_Constant_Int_Ptr_C m_decreases = Rete::Symbol_Constant_Int_Ptr_C(new Rete::Symbol_Constant_Int(2));
-    const Rete::Symbol_Constant_Int_Ptr_C m_unchanged = Rete::Symbol_Constant_Int_Ptr_C(new Rete::Symbol_Constant_Int(3));
-    const Rete::Symbol_Constant_Int_Ptr_C m_move_direction_up = Rete::Symbol_Constant_Int_Ptr_C(new Rete::Symbol_Constant_Int(1));
-    const Rete::Symbol_Constant_Int_Ptr_C m_move_direction_down = Rete::Symbol_Constant_Int_Ptr_C(new Rete::Symbol_Constant_Int(2));
-    const Rete::Symbol_Constant_Int_Ptr_C m_move_direction_left = Rete::Symbol_Constant_Int_Ptr_C(new Rete::Symbol_Constant_Int(3));
-    const Rete::Symbol_Constant_Int_Ptr_C m_move_direction_right = Rete::Symbol_Constant_Int_Ptr_C(new Rete::Symbol_Constant_Int(4));
+    const Rete::Symbol_Constant_String_Ptr_C m_action_attr = Rete::Symbol_Constant_String::intern("action");
+    //const Rete::Symbol_Constant_String_Ptr_C m_dimensionality_attr = Rete::Symbol_Constant_String::intern("dimensionality");
+    const Rete::Symbol_Constant_String_Ptr_C m_snake1_length_attr = Rete::Symbol_Constant_String::intern("snake1-length");
+    const Rete::Symbol_Constant_String_Ptr_C m_snake2_length_attr = Rete::Symbol_Constant_String::intern("snake2-length");
+    const Rete::Symbol_Constant_String_Ptr_C m_snake1_dist_attr = Rete::Symbol_Constant_String::intern("snake1-dist");
+    const Rete::Symbol_Constant_String_Ptr_C m_snake2_dist_attr = Rete::Symbol_Constant_String::intern("snake2-dist");
+    const Rete::Symbol_Constant_String_Ptr_C m_snake1_blank_attr = Rete::Symbol_Constant_String::intern("snake1-blank");
+    const Rete::Symbol_Constant_String_Ptr_C m_snake2_blank_attr = Rete::Symbol_Constant_String::intern("snake2-blank");
+    //const Rete::Symbol_Constant_String_Ptr_C m_top_snake_manhattan_attr = Rete::Symbol_Constant_String::intern("top-snake-manhattan");
+    //const Rete::Symbol_Constant_String_Ptr_C m_left_snake_manhattan_attr = Rete::Symbol_Constant_String::intern("left-snake-manhattan");
+    //const Rete::Symbol_Constant_String_Ptr_C m_top_snake_dist_to_blank_attr = Rete::Symbol_Constant_String::intern("top-snake-dist-to-blank");
+    //const Rete::Symbol_Constant_String_Ptr_C m_left_snake_dist_to_blank_attr = Rete::Symbol_Constant_String::intern("left-snake-dist-to-blank");
+    //const Rete::Symbol_Constant_String_Ptr_C m_top_left_ccw_dist_attr = Rete::Symbol_Constant_String::intern("top-left-ccw-dist");
+    //const Rete::Symbol_Constant_String_Ptr_C m_top_right_cw_dist_attr = Rete::Symbol_Constant_String::intern("top-right-cw-dist");
+    //const Rete::Symbol_Constant_String_Ptr_C m_left_top_cw_dist_attr = Rete::Symbol_Constant_String::intern("left-top-cw-dist");
+    //const Rete::Symbol_Constant_String_Ptr_C m_left_bottom_ccw_dist_attr = Rete::Symbol_Constant_String::intern("left-bottom-ccw-dist");
+    //const Rete::Symbol_Constant_String_Ptr_C m_moves_to_blank_tl_ccw_attr = Rete::Symbol_Constant_String::intern("moves-to-blank-tl-ccw");
+    const Rete::Symbol_Constant_String_Ptr_C m_tile_attr = Rete::Symbol_Constant_String::intern("tile");
+    const Rete::Symbol_Identifier_Ptr_C m_move_up_id = Rete::Symbol_Identifier::intern("move-up");
+    const Rete::Symbol_Identifier_Ptr_C m_move_down_id = Rete::Symbol_Identifier::intern("move-down");
+    const Rete::Symbol_Identifier_Ptr_C m_move_left_id = Rete::Symbol_Identifier::intern("move-left");
+    const Rete::Symbol_Identifier_Ptr_C m_move_right_id = Rete::Symbol_Identifier::intern("move-right");
+    const Rete::Symbol_Constant_Int_Ptr_C m_increases = Rete::Symbol_Constant_Int::intern(1);
+    const Rete::Symbol_Constant_Int_Ptr_C m_decreases = Rete::Symbol_Constant_Int::intern(2);
+    const Rete::Symbol_Constant_Int_Ptr_C m_unchanged = Rete::Symbol_Constant_Int::intern(3);
+    const Rete::Symbol_Constant_Int_Ptr_C m_move_direction_up = Rete::Symbol_Constant_Int::intern(1);
+    const Rete::Symbol_Constant_Int_Ptr_C m_move_direction_down = Rete::Symbol_Constant_Int::intern(2);
+    const Rete::Symbol_Constant_Int_Ptr_C m_move_direction_left = Rete::Symbol_Constant_Int::intern(3);
+    const Rete::Symbol_Constant_Int_Ptr_C m_move_direction_right = Rete::Symbol_Constant_Int::intern(4);
 
     std::map<int64_t, Rete::Symbol_Identifier_Ptr_C> m_move_ids;
     std::map<int64_t, Rete::Symbol_Constant_Int_Ptr_C> m_tile_names;
@@ -316,33 +326,7 @@ return manhattan;
       }
     }
 
-    std::unordered_map<Rete::WME_Ptr_C, bool, Rete::hash_deref<Rete::WME>, Rete::compare_deref_eq> m_wmes;
-
-    void clear_old_wmes() {
-      auto wt = m_wmes.begin(), wend = m_wmes.end();
-      while(wt != wend) {
-        if(wt->second)
-          wt++->second = false;
-        else {
-          {
-            CPU_Accumulator cpu_accumulator(*this);
-            remove_wme(wt->first);
-          }
-          wt = m_wmes.erase(wt);
-        }
-      }
-    }
-
-    void insert_new_wme(const Rete::WME_Ptr_C &wme) {
-      const auto found = m_wmes.find(wme);
-      if(found == m_wmes.end()) {
-        m_wmes[wme] = true;
-        CPU_Accumulator cpu_accumulator(*this);
-        insert_wme(wme);
-      }
-      else
-        found->second = true;
-    }
+    std::vector<Rete::WME_Ptr_C> m_wmes; ///< The next state, collected by generate_features
 
 //    double m_feature_generation_time = 0.0;
   };
@@ -14,6 +14,8 @@ namespace Sliding_Puzzle {
   using Carli::Node_Unsplit;
   using Carli::Q_Value;
 
+  const Rete::Variable_Slot Move::tile_slot("tile");
+
   Environment::Environment() {
     init_impl();
   }
@@ -227,13 +229,13 @@ namespace Sliding_Puzzle {
       if(approximate)
         rps_min = remaining_problem_size(m_grid);
 
-      std::cerr << "Initial " << rps_min.first << 'x' << rps_min.second << ':' << std::endl;
+      get_context().get_err() << "Initial " << rps_min.first << 'x' << rps_min.second << ':' << std::endl;
       for(int64_t j = 0; j != m_grid_h; ++j) {
-        std::cerr << ' ';
+        get_context().get_err() << ' ';
         for(int64_t i = 0; i != m_grid_w; ++i) {
-          std::cerr << ' ' << m_grid[j * m_grid_w + i];
+          get_context().get_err() << ' ' << m_grid[j * m_grid_w + i];
         }
-        std::cerr << std::endl;
+        get_context().get_err() << std::endl;
       }
     }
 
@@ -364,9 +366,8 @@ namespace Sliding_Puzzle {
     } while(!solveable(m_grid));
 
     if(m_evaluate_optimality) {
-      static bool skip_first = true;
-      if(skip_first)
-        skip_first = false;
+      if(m_skip_first_optimality)
+        m_skip_first_optimality = false;
       else
         m_num_steps_to_goal = calculate_num_steps_to_goal();
     }
@@ -399,6 +400,18 @@ namespace Sliding_Puzzle {
     }
   }
 
+  void Environment::save_impl(ostream &os) const {
+    m_random.save(os);
+    Zeni::serialize(os, m_num_steps_to_goal);
+    Zeni::serialize(os, m_skip_first_optimality);
+  }
+
+  void Environment::load_impl(istream &is) {
+    m_random.load(is);
+    Zeni::deserialize(is, m_num_steps_to_goal);
+    Zeni::deserialize(is, m_skip_first_optimality);
+  }
+
   Agent::Agent(const std::shared_ptr<Carli::Environment> &env_)
     : Carli::Agent(env_, [this](const Rete::Variable_Indices &variables, const Rete::WME_Token &token)->Carli::Action_Ptr_C {return std::make_shared<Move>(variables, token); })
   {
@@ -407,8 +420,8 @@ namespace Sliding_Puzzle {
     for(int64_t tile = 0; tile != int64_t(env->get_grid().size()); ++tile) {
       std::ostringstream oss;
       oss << "move-" << tile;
-      m_move_ids[tile] = Rete::Symbol_Identifier_Ptr_C(new Rete::Symbol_Identifier(oss.str()));
-      m_tile_names[tile] = Rete::Symbol_Constant_Int_Ptr_C(new Rete::Symbol_Constant_Int(tile));
+      m_move_ids[tile] = Rete::Symbol_Identifier::intern(oss.str());
+      m_tile_names[tile] = Rete::Symbol_Constant_Int::intern(tile);
     }
 
     generate_rete();
@@ -422,7 +435,7 @@ namespace Sliding_Puzzle {
   }
 
   void Agent::generate_rete() {
-    std::string rules_in = dynamic_cast<const Option_String &>(Options::get_global()["rules"]).get_value();
+    std::string rules_in = dynamic_cast<const Option_String &>(get_context().get_options()["rules"]).get_value();
     if(rules_in == "default")
       rules_in = "rules/sliding-puzzle.carli";
     if(rete_parse_file(*this, rules_in))
@@ -555,23 +568,19 @@ namespace Sliding_Puzzle {
       lwccw_snake2_lendistblank = snake_lendistblank(*env, grid, rps, distances_rest, rest);
     }
 
-    if(get_Option_Ranged<bool>(Options::get_global(), "rete-flush-wmes")) {
-      Rete::Agenda::Locker locker(agenda);
-      clear_old_wmes();
-    }
-
-    Rete::Agenda::Locker locker(agenda);
+    if(get_Option_Ranged<bool>(get_context().get_options(), "rete-flush-wmes"))
+      clear_wmes();
 
     const auto generate_relative_attribute =
       [this]
       (const int64_t &current, const int64_t &next, const Rete::Symbol_Identifier_Ptr_C &id, const Rete::Symbol_Constant_String_Ptr_C &attr)
     {
       if(next > current)
-        insert_new_wme(std::make_shared<Rete::WME>(id, attr, m_increases));
+        m_wmes.push_back(Rete::WME::create(id, attr, m_increases));
       else if(next < current)
-        insert_new_wme(std::make_shared<Rete::WME>(id, attr, m_decreases));
+        m_wmes.push_back(Rete::WME::create(id, attr, m_decreases));
       else
-        insert_new_wme(std::make_shared<Rete::WME>(id, attr, m_unchanged));
+        m_wmes.push_back(Rete::WME::create(id, attr, m_unchanged));
     };
 
     const auto generate_action =
@@ -590,16 +599,16 @@ namespace Sliding_Puzzle {
       Environment::Grid grid_next = env->get_grid();
       std::swap(grid_next[blank.second * grid_w + blank.first], grid_next[pos.second * grid_w + pos.first]);
 
-      insert_new_wme(std::make_shared<Rete::WME>(m_s_id, m_action_attr, move_id));
-      insert_new_wme(std::make_shared<Rete::WME>(move_id, m_tile_attr, tile_name));
+      m_wmes.push_back(Rete::WME::create(m_s_id, m_action_attr, move_id));
+      m_wmes.push_back(Rete::WME::create(move_id, m_tile_attr, tile_name));
 
       //const auto rps_next = env->remaining_problem_size(grid_next);
       //if(rps_next.first > rps.first || rps_next.second > rps.second)
-      //  insert_new_wme(std::make_shared<Rete::WME>(move_id, m_dimensionality_attr, m_increases));
+      //  m_wmes.push_back(Rete::WME::create(move_id, m_dimensionality_attr, m_increases));
       //else if(rps_next.first < rps.first || rps_next.second < rps.second)
-      //  insert_new_wme(std::make_shared<Rete::WME>(move_id, m_dimensionality_attr, m_decreases));
+      //  m_wmes.push_back(Rete::WME::create(move_id, m_dimensionality_attr, m_decreases));
       //else
-      //  insert_new_wme(std::make_shared<Rete::WME>(move_id, m_dimensionality_attr, m_unchanged));
+      //  m_wmes.push_back(Rete::WME::create(move_id, m_dimensionality_attr, m_unchanged));
 
       const std::tuple<int64_t, int64_t, int64_t> lwccw_snake1_lendistblank_next = top_left_ccw_snake_lendistblank(*env, grid_next, rps, fringe_top);
       std::tuple<int64_t, int64_t, int64_t> lwccw_snake2_lendistblank_next;
@@ -674,7 +683,8 @@ namespace Sliding_Puzzle {
       }
     }
 
-    clear_old_wmes();
+    set_wmes(m_wmes);
+    m_wmes.clear();
   }
 
   void Agent::update() {
@@ -684,4 +694,12 @@ namespace Sliding_Puzzle {
       m_metastate = Metastate::SUCCESS;
   }
 
+  void Agent::save_impl(ostream &os) const {
+    m_random.save(os);
+  }
+
+  void Agent::load_impl(istream &is) {
+    m_random.load(is);
+  }
+
 }
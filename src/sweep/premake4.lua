@@ -0,0 +1,12 @@
+project "sweep"
+  kind "ConsoleApp"
+  language "C++"
+
+  targetdir "../.."
+
+  files { "**.h", "**.cpp" }
+
+  links { "env_advent", "env_blocks_world", "env_blocks_world_2", "env_mountain_car", "env_puddle_world", "env_sliding_puzzle", "env_taxicab", "carli" }
+
+  configuration "linux"
+    linkoptions { "-pthread" }
@@ -0,0 +1,205 @@
+#include "advent_env/advent.h"
+#include "blocks_world_env/blocks_world.h"
+#include "blocks_world_2_env/blocks_world_2.h"
+#include "mountain_car_env/mountain_car.h"
+#include "puddle_world_env/puddle_world.h"
+#include "sliding_puzzle_env/sliding_puzzle.h"
+#include "taxicab_env/taxicab.h"
+
+#include "carli/experiment.h"
+#include "carli/parser/rete_parser.h"
+
+#include <atomic>
+#include <filesystem>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+namespace {
+
+  struct Environment_Factory {
+    std::function<std::shared_ptr<Carli::Environment> ()> make_env;
+    std::function<std::shared_ptr<Carli::Agent> (const std::shared_ptr<Carli::Environment> &)> make_agent;
+    std::function<void (const std::shared_ptr<Carli::Agent> &)> on_episode_termination;
+  };
+
+  template <typename ENVIRONMENT, typename AGENT>
+  Environment_Factory make_factory(const std::function<void (const std::shared_ptr<Carli::Agent> &)> &on_episode_termination = [](const std::shared_ptr<Carli::Agent> &){}) {
+    return {[](){return std::make_shared<ENVIRONMENT>();},
+            [](const std::shared_ptr<Carli::Environment> &env){return std::make_shared<AGENT>(env);},
+            on_episode_termination};
+  }
+
+  template <typename AGENT>
+  void print_policy(const std::shared_ptr<Carli::Agent> &agent) {
+    if(dynamic_cast<const Option_Itemized &>(agent->get_context().get_options()["output"]).get_value() == "experiment")
+      std::dynamic_pointer_cast<AGENT>(agent)->print_policy(agent->get_context().get_err(), 32);
+  }
+
+  const std::map<std::string, Environment_Factory> & environment_factories() {
+    static const std::map<std::string, Environment_Factory> factories = {
+      {"advent", make_factory<Advent::Environment, Advent::Agent>()},
+      {"blocks-world", make_factory<Blocks_World::Environment, Blocks_World::Agent>()},
+      {"blocks-world-2", make_factory<Blocks_World_2::Environment, Blocks_World_2::Agent>()},
+      {"mountain-car", make_factory<Mountain_Car::Environment, Mountain_Car::Agent>(print_policy<Mountain_Car::Agent>)},
+      {"puddle-world", make_factory<Puddle_World::Environment, Puddle_World::Agent>(print_policy<Puddle_World::Agent>)},
+      {"sliding-puzzle", make_factory<Sliding_Puzzle::Environment, Sliding_Puzzle::Agent>()},
+      {"taxicab", make_factory<Taxicab::Environment, Taxicab::Agent>()}
+    };
+    return factories;
+  }
+
+  /// One configuration of the grid run with one seed, as a standalone process would be run with these arguments
+  struct Job {
+    std::string label;
+    std::string seed;
+    std::vector<std::string> args;
+  };
+
+  std::vector<std::string> split_words(const std::string &words) {
+    std::vector<std::string> split;
+    std::istringstream iss(words);
+    for(std::string word; iss >> word; )
+      split.push_back(word);
+    return split;
+  }
+
+  /// Every combination of one value per grid axis, each labeled like "split-test=value,unsplit-test=none"
+  std::vector<std::pair<std::string, std::vector<std::string>>> grid_configurations(const std::vector<std::vector<std::string>> &grid) {
+    std::vector<std::pair<std::string, std::vector<std::string>>> configurations(1);
+    for(const auto &axis : grid) {
+      std::vector<std::pair<std::string, std::vector<std::string>>> expanded;
+      for(const auto &configuration : configurations) {
+        for(auto vt = axis.begin() + 1, vend = axis.end(); vt != vend; ++vt) {
+          auto next = configuration;
+          std::string value = *vt; ///< Values such as rules files must not nest directories
+          std::replace(value.begin(), value.end(), '/', '_');
+          std::replace(value.begin(), value.end(), '\\', '_');
+          next.first += (next.first.empty() ? "" : ",") + axis.front() + '=' + value;
+          next.second.push_back("--" + axis.front());
+          next.second.push_back(*vt);
+          expanded.push_back(next);
+        }
+      }
+      configurations.swap(expanded);
+    }
+    if(configurations.size() == 1 && configurations.front().first.empty())
+      configurations.front().first = "default";
+    return configurations;
+  }
+
+  void run_job(const Job &job, const Environment_Factory &factory) {
+    Zeni::Runtime_Context context;
+    Carli::Experiment experiment(context);
+
+    std::vector<const char *> argv;
+    for(const auto &arg : job.args)
+      argv.push_back(arg.c_str());
+
+    if(experiment.take_args(int(argv.size()), argv.data()) < int64_t(argv.size()))
+      throw std::runtime_error("Unknown trailing arguments in job " + job.label + " with seed " + job.seed);
+
+    experiment.standard_run(factory.make_env, factory.make_agent, factory.on_episode_termination);
+  }
+
+}
+
+int main(int argc, char **argv) {
+  try {
+    Options options("sweep");
+    std::vector<std::vector<std::string>> grid;
+    std::vector<std::string> seeds;
+
+    options.add_line("\n  Usage: sweep [options] -- <arguments shared by every job>");
+    options.add_line("\n  Sweep Options:");
+    options.add('h', std::make_shared<Option_Function>("help", 0, [&options](const Option::Arguments &){
+      options.print_help(std::cout);
+      std::cout << std::endl;
+      exit(0);
+    }), "");
+    options.add('e', std::make_shared<Option_Itemized>("environment", std::set<std::string>({"advent", "blocks-world", "blocks-world-2", "mountain-car", "puddle-world", "sliding-puzzle", "taxicab"}), "blocks-world-2"), "Which environment every job runs.");
+    options.add('g', std::make_shared<Option_Function>("grid", 1, [&grid](const Option::Arguments &args){
+      const auto axis = split_words(args.at(0));
+      if(axis.size() < 2)
+        throw std::runtime_error(std::string("Grid axis needs an option and at least one value: ") + args.at(0));
+      grid.push_back(axis);
+    }), "<\"option value...\"> Run every listed value of an experiment option; repeat to form a grid");
+    options.add('j', std::make_shared<Option_Ranged<int64_t>>("jobs", 1, true, std::numeric_limits<int64_t>::max(), true, std::max(int64_t(std::thread::hardware_concurrency()), int64_t(1))), "How many jobs to run at once, one agent per thread.");
+    options.add('o', std::make_shared<Option_String>("output-dir", "sweep"), "Where each job writes <configuration>/<environment>-<seed>.{out,err,carli}.");
+    options.add('s', std::make_shared<Option_Function>("seeds", 1, [&seeds](const Option::Arguments &args){
+      const auto more = split_words(args.at(0));
+      seeds.insert(seeds.end(), more.begin(), more.end());
+    }), "<\"seed...\"> Seeds to run for every configuration; 1 if none are given");
+
+    options.get(argc, argv);
+    if(options.optind != argc && std::string(argv[options.optind]) == "--")
+      ++options.optind;
+
+    const auto environment = dynamic_cast<const Option_Itemized &>(options["environment"]).get_value();
+    const auto num_threads = dynamic_cast<const Option_Ranged<int64_t> &>(options["jobs"]).get_value();
+    const std::filesystem::path output_dir = dynamic_cast<const Option_String &>(options["output-dir"]).get_value();
+    if(seeds.empty())
+      seeds.push_back("1");
+    const auto &factory = environment_factories().at(environment);
+
+    std::vector<Job> jobs;
+    for(const auto &configuration : grid_configurations(grid)) {
+      std::filesystem::create_directories(output_dir / configuration.first);
+      for(const auto &seed : seeds) {
+        const auto prefix = (output_dir / configuration.first / (environment + '-' + seed)).string();
+        Job job{configuration.first, seed, {argv[0]}};
+        job.args.insert(job.args.end(), argv + options.optind, argv + argc);
+        job.args.insert(job.args.end(), configuration.second.begin(), configuration.second.end());
+        job.args.insert(job.args.end(), {"--seed", seed, "--stdout", prefix + ".out", "--stderr", prefix + ".err", "--rules-out", prefix + ".carli"});
+        jobs.push_back(job);
+      }
+    }
+
+    /// Every job sources the same rules files, so parse each once and have the rest of the jobs load its compiled records
+    Rete::rete_set_templates(true);
+
+    std::atomic<size_t> next_job(0);
+    std::mutex progress_mutex;
+    size_t finished = 0;
+    size_t failed = 0;
+
+    std::vector<std::thread> threads;
+    for(int64_t i = 0; i != std::min(num_threads, int64_t(jobs.size())); ++i) {
+      threads.emplace_back([&](){
+        for(size_t j = next_job++; j < jobs.size(); j = next_job++) {
+          std::string error;
+          try {
+            run_job(jobs[j], factory);
+          }
+          catch(std::exception &ex) {
+            error = ex.what();
+          }
+          catch(...) {
+            error = "unknown exception";
+          }
+
+          std::lock_guard<std::mutex> lock(progress_mutex);
+          ++finished;
+          if(error.empty())
+            std::cout << '[' << finished << '/' << jobs.size() << "] " << jobs[j].label << " seed " << jobs[j].seed << std::endl;
+          else {
+            ++failed;
+            std::cerr << '[' << finished << '/' << jobs.size() << "] " << jobs[j].label << " seed " << jobs[j].seed << " failed: " << error << std::endl;
+          }
+        }
+      });
+    }
+    for(auto &thread : threads)
+      thread.join();
+
+    return failed ? -1 : 0;
+  }
+  catch(std::exception &ex) {
+    std::cerr << "Exiting with exception: " << ex.what() << std::endl;
+  }
+  catch(...) {
+    std::cerr << "Exiting with unknown exception." << std::endl;
+  }
+
+  return -1;
+}
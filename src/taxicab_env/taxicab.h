@@ -1,5 +1,5 @@
-#ifndef BLOCKS_WORLD_2_H
-#define BLOCKS_WORLD_2_H
+#ifndef TAXICAB_H
+#define TAXICAB_H
 
 #include "carli/agent.h"
 #include "carli/environment.h"
@@ -22,6 +22,7 @@ namespace Taxicab {
 
   using std::dynamic_pointer_cast;
   using std::endl;
+  using std::istream;
   using std::ostream;
 
   class TAXICAB_LINKAGE Action : public Carli::Action {
@@ -39,9 +40,12 @@ namespace Taxicab {
     {
     }
 
+    static const Rete::Variable_Slot type_slot;
+    static const Rete::Variable_Slot direction_slot;
+
     Action(const Rete::Variable_Indices &variables, const Rete::WME_Token &token)
-      : type(Type(debuggable_cast<const Rete::Symbol_Constant_Int &>(*token[variables.find("type")->second]).value)),
-      direction(type == MOVE ? Direction(debuggable_cast<const Rete::Symbol_Constant_Int &>(*token[variables.find("direction")->second]).value) : Direction())
+      : type(Type(token.get<Rete::Symbol_Constant_Int>(variables, type_slot).value)),
+      direction(type == MOVE ? Direction(token.get<Rete::Symbol_Constant_Int>(variables, direction_slot).value) : Direction())
     {
     }
 
@@ -54,7 +58,7 @@ namespace Taxicab {
     }
 
     int64_t compare(const Action &rhs) const {
-      return direction - rhs.direction;
+      return type != rhs.type ? type - rhs.type : direction - rhs.direction;
     }
 
     void print_impl(ostream &os) const {
@@ -158,15 +162,18 @@ namespace Taxicab {
 
     void print_impl(ostream &os) const;
 
+    void save_impl(ostream &os) const;
+    void load_impl(istream &is);
+
     bool solveable_fuel();
     void transitive_closure_distances(Grid &distances) const;
 
     Zeni::Random m_random;
 
-    int64_t m_grid_w = dynamic_cast<const Option_Ranged<int64_t> &>(Options::get_global()["grid-width"]).get_value();
-    int64_t m_grid_h = dynamic_cast<const Option_Ranged<int64_t> &>(Options::get_global()["grid-height"]).get_value();
-    int64_t m_num_filling_stations = dynamic_cast<const Option_Ranged<int64_t> &>(Options::get_global()["num-filling-stations"]).get_value();
-    int64_t m_num_destinations = dynamic_cast<const Option_Ranged<int64_t> &>(Options::get_global()["num-destinations"]).get_value();
+    int64_t m_grid_w = dynamic_cast<const Option_Ranged<int64_t> &>(get_context().get_options()["grid-width"]).get_value();
+    int64_t m_grid_h = dynamic_cast<const Option_Ranged<int64_t> &>(get_context().get_options()["grid-height"]).get_value();
+    int64_t m_num_filling_stations = dynamic_cast<const Option_Ranged<int64_t> &>(get_context().get_options()["num-filling-stations"]).get_value();
+    int64_t m_num_destinations = dynamic_cast<const Option_Ranged<int64_t> &>(get_context().get_options()["num-destinations"]).get_value();
 
     std::vector<std::pair<int64_t, int64_t>> m_filling_stations;
     std::vector<std::pair<int64_t, int64_t>> m_destinations;
@@ -179,13 +186,13 @@ namespace Taxicab {
 
     std::pair<int64_t, int64_t> m_taxi_position;
     int64_t m_fuel;
-    const int64_t m_fuel_max = dynamic_cast<const Option_Ranged<int64_t> &>(Options::get_global()["fuel-max"]).get_value();
+    const int64_t m_fuel_max = dynamic_cast<const Option_Ranged<int64_t> &>(get_context().get_options()["fuel-max"]).get_value();
 
     Passenger m_passenger;
     int64_t m_passenger_source;
     int64_t m_passenger_destination;
 
-    const bool m_evaluate_optimality = dynamic_cast<const Option_Ranged<bool> &>(Options::get_global()["evaluate-optimality"]).get_value() && supports_optimal() && dynamic_cast<const Option_Itemized &>(Options::get_global()["output"]).get_value() != "null";
+    const bool m_evaluate_optimality = dynamic_cast<const Option_Ranged<bool> &>(get_context().get_options()["evaluate-optimality"]).get_value() && supports_optimal() && dynamic_cast<const Option_Itemized &>(get_context().get_options()["output"]).get_value() != "null";
     int64_t m_num_steps_to_goal = 0;
     std::shared_ptr<const State> m_optimal_solution;
 #ifndef NDEBUG
@@ -211,61 +218,64 @@ namespace Taxicab {
 
     void update();
 
+    void save_impl(ostream &os) const;
+    void load_impl(istream &is);
+
     Zeni::Random m_random;
 
-    const Rete::Symbol_Constant_String_Ptr_C m_action_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("action"));
-    const Rete::Symbol_Constant_String_Ptr_C m_type_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("type"));
-    const Rete::Symbol_Constant_String_Ptr_C m_direction_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("direction"));
-    const Rete::Symbol_Constant_String_Ptr_C m_passenger_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("passenger"));
-    //const Rete::Symbol_Constant_String_Ptr_C m_passenger_source_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("passenger-source"));
-    //const Rete::Symbol_Constant_String_Ptr_C m_passenger_destination_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("passenger-destination"));
-    const Rete::Symbol_Constant_String_Ptr_C m_next_stop_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("next-stop"));
-    const Rete::Symbol_Constant_String_Ptr_C m_filling_station_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("filling-station"));
-    const Rete::Symbol_Constant_String_Ptr_C m_destination_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("destination"));
-    const Rete::Symbol_Constant_String_Ptr_C m_toward_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("toward"));
-    const Rete::Symbol_Constant_String_Ptr_C m_fuel_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("fuel"));
-    //const Rete::Symbol_Constant_String_Ptr_C m_toward_pickup_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("toward-pickup"));
-    //const Rete::Symbol_Constant_String_Ptr_C m_toward_dropoff_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("toward-dropoff"));
-    //const Rete::Symbol_Constant_String_Ptr_C m_refuel_required_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("refuel-required"));
-    //const Rete::Symbol_Constant_String_Ptr_C m_snake1_length_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("snake1-length"));
-    //const Rete::Symbol_Constant_String_Ptr_C m_snake2_length_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("snake2-length"));
-    //const Rete::Symbol_Constant_String_Ptr_C m_snake1_dist_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("snake1-dist"));
-    //const Rete::Symbol_Constant_String_Ptr_C m_snake2_dist_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("snake2-dist"));
-    //const Rete::Symbol_Constant_String_Ptr_C m_snake1_blank_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("snake1-blank"));
-    //const Rete::Symbol_Constant_String_Ptr_C m_snake2_blank_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("snake2-blank"));
-    //const Rete::Symbol_Constant_String_Ptr_C m_top_snake_manhattan_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("top-snake-manhattan"));
-    //const Rete::Symbol_Constant_String_Ptr_C m_left_snake_manhattan_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("left-snake-manhattan"));
-    //const Rete::Symbol_Constant_String_Ptr_C m_top_snake_dist_to_blank_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("top-snake-dist-to-blank"));
-    //const Rete::Symbol_Constant_String_Ptr_C m_left_snake_dist_to_blank_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("left-snake-dist-to-blank"));
-    //const Rete::Symbol_Constant_String_Ptr_C m_top_left_ccw_dist_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("top-left-ccw-dist"));
-    //const Rete::Symbol_Constant_String_Ptr_C m_top_right_cw_dist_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("top-right-cw-dist"));
-    //const Rete::Symbol_Constant_String_Ptr_C m_left_top_cw_dist_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("left-top-cw-dist"));
-    //const Rete::Symbol_Constant_String_Ptr_C m_left_bottom_ccw_dist_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("left-bottom-ccw-dist"));
-    //const Rete::Symbol_Constant_String_Ptr_C m_moves_to_blank_tl_ccw_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("moves-to-blank-tl-ccw"));
-    const Rete::Symbol_Identifier_Ptr_C m_move_north_id = Rete::Symbol_Identifier_Ptr_C(new Rete::Symbol_Identifier("move-north"));
-    const Rete::Symbol_Identifier_Ptr_C m_move_south_id = Rete::Symbol_Identifier_Ptr_C(new Rete::Symbol_Identifier("move-south"));
-    const Rete::Symbol_Identifier_Ptr_C m_move_east_id = Rete::Symbol_Identifier_Ptr_C(new Rete::Symbol_Identifier("move-east"));
-    const Rete::Symbol_Identifier_Ptr_C m_move_west_id = Rete::Symbol_Identifier_Ptr_C(new Rete::Symbol_Identifier("move-west"));
-    const Rete::Symbol_Identifier_Ptr_C m_refuel_id = Rete::Symbol_Identifier_Ptr_C(new Rete::Symbol_Identifier("refuel"));
-    const Rete::Symbol_Identifier_Ptr_C m_pickup_id = Rete::Symbol_Identifier_Ptr_C(new Rete::Symbol_Identifier("pickup"));
-    const Rete::Symbol_Identifier_Ptr_C m_dropoff_id = Rete::Symbol_Identifier_Ptr_C(new Rete::Symbol_Identifier("dropoff"));
-    const Rete::Symbol_Constant_Int_Ptr_C m_type_move = Rete::Symbol_Constant_Int_Ptr_C(new Rete::Symbol_Constant_Int(1));
-    const Rete::Symbol_Constant_Int_Ptr_C m_type_refuel = Rete::Symbol_Constant_Int_Ptr_C(new Rete::Symbol_Constant_Int(2));
-    const Rete::Symbol_Constant_Int_Ptr_C m_type_pickup = Rete::Symbol_Constant_Int_Ptr_C(new Rete::Symbol_Constant_Int(3));
-    const Rete::Symbol_Constant_Int_Ptr_C m_type_dropoff = Rete::Symbol_Constant_Int_Ptr_C(new Rete::Symbol_Constant_Int(4));
-    const Rete::Symbol_Constant_Int_Ptr_C m_direction_none = Rete::Symbol_Constant_Int_Ptr_C(new Rete::Symbol_Constant_Int(0));
-    const Rete::Symbol_Constant_Int_Ptr_C m_direction_north = Rete::Symbol_Constant_Int_Ptr_C(new Rete::Symbol_Constant_Int(1));
-    const Rete::Symbol_Constant_Int_Ptr_C m_direction_south = Rete::Symbol_Constant_Int_Ptr_C(new Rete::Symbol_Constant_Int(2));
-    const Rete::Symbol_Constant_Int_Ptr_C m_direction_east = Rete::Symbol_Constant_Int_Ptr_C(new Rete::Symbol_Constant_Int(3));
-    const Rete::Symbol_Constant_Int_Ptr_C m_direction_west = Rete::Symbol_Constant_Int_Ptr_C(new Rete::Symbol_Constant_Int(4));
-    const Rete::Symbol_Constant_Int_Ptr_C m_passenger_at_source = Rete::Symbol_Constant_Int_Ptr_C(new Rete::Symbol_Constant_Int(1));
-    const Rete::Symbol_Constant_Int_Ptr_C m_passenger_onboard = Rete::Symbol_Constant_Int_Ptr_C(new Rete::Symbol_Constant_Int(2));
-    const Rete::Symbol_Constant_Int_Ptr_C m_passenger_at_destination = Rete::Symbol_Constant_Int_Ptr_C(new Rete::Symbol_Constant_Int(3));
-    const Rete::Symbol_Constant_Int_Ptr_C m_fuel_insufficient = Rete::Symbol_Constant_Int_Ptr_C(new Rete::Symbol_Constant_Int(1));
-    const Rete::Symbol_Constant_Int_Ptr_C m_fuel_oneway = Rete::Symbol_Constant_Int_Ptr_C(new Rete::Symbol_Constant_Int(2));
-    const Rete::Symbol_Constant_Int_Ptr_C m_fuel_roundtrip = Rete::Symbol_Constant_Int_Ptr_C(new Rete::Symbol_Constant_Int(3));
-    const Rete::Symbol_Constant_String_Ptr_C m_true_value = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("true"));
-    const Rete::Symbol_Constant_String_Ptr_C m_false_value = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("false"));
+    const Rete::Symbol_Constant_String_Ptr_C m_action_attr = Rete::Symbol_Constant_String::intern("action");
+    const Rete::Symbol_Constant_String_Ptr_C m_type_attr = Rete::Symbol_Constant_String::intern("type");
+    const Rete::Symbol_Constant_String_Ptr_C m_direction_attr = Rete::Symbol_Constant_String::intern("direction");
+    const Rete::Symbol_Constant_String_Ptr_C m_passenger_attr = Rete::Symbol_Constant_String::intern("passenger");
+    //const Rete::Symbol_Constant_String_Ptr_C m_passenger_source_attr = Rete::Symbol_Constant_String::intern("passenger-source");
+    //const Rete::Symbol_Constant_String_Ptr_C m_passenger_destination_attr = Rete::Symbol_Constant_String::intern("passenger-destination");
+    const Rete::Symbol_Constant_String_Ptr_C m_next_stop_attr = Rete::Symbol_Constant_String::intern("next-stop");
+    const Rete::Symbol_Constant_String_Ptr_C m_filling_station_attr = Rete::Symbol_Constant_String::intern("filling-station");
+    const Rete::Symbol_Constant_String_Ptr_C m_destination_attr = Rete::Symbol_Constant_String::intern("destination");
+    const Rete::Symbol_Constant_String_Ptr_C m_toward_attr = Rete::Symbol_Constant_String::intern("toward");
+    const Rete::Symbol_Constant_String_Ptr_C m_fuel_attr = Rete::Symbol_Constant_String::intern("fuel");
+    //const Rete::Symbol_Constant_String_Ptr_C m_toward_pickup_attr = Rete::Symbol_Constant_String::intern("toward-pickup");
+    //const Rete::Symbol_Constant_String_Ptr_C m_toward_dropoff_attr = Rete::Symbol_Constant_String::intern("toward-dropoff");
+    //const Rete::Symbol_Constant_String_Ptr_C m_refuel_required_attr = Rete::Symbol_Constant_String::intern("refuel-required");
+    //const Rete::Symbol_Constant_String_Ptr_C m_snake1_length_attr = Rete::Symbol_Constant_String::intern("snake1-length");
+    //const Rete::Symbol_Constant_String_Ptr_C m_snake2_length_attr = Rete::Symbol_Constant_String::intern("snake2-length");
+    //const Rete::Symbol_Constant_String_Ptr_C m_snake1_dist_attr = Rete::Symbol_Constant_String::intern("snake1-dist");
+    //const Rete::Symbol_Constant_String_Ptr_C m_snake2_dist_attr = Rete::Symbol_Constant_String::intern("snake2-dist");
+    //const Rete::Symbol_Constant_String_Ptr_C m_snake1_blank_attr = Rete::Symbol_Constant_String::intern("snake1-blank");
+    //const Rete::Symbol_Constant_String_Ptr_C m_snake2_blank_attr = Rete::Symbol_Constant_String::intern("snake2-blank");
+    //const Rete::Symbol_Constant_String_Ptr_C m_top_snake_manhattan_attr = Rete::Symbol_Constant_String::intern("top-snake-manhattan");
+    //const Rete::Symbol_Constant_String_Ptr_C m_left_snake_manhattan_attr = Rete::Symbol_Constant_String::intern("left-snake-manhattan");
+    //const Rete::Symbol_Constant_String_Ptr_C m_top_snake_dist_to_blank_attr = Rete::Symbol_Constant_String::intern("top-snake-dist-to-blank");
+    //const Rete::Symbol_Constant_String_Ptr_C m_left_snake_dist_to_blank_attr = Rete::Symbol_Constant_String::intern("left-snake-dist-to-blank");
+    //const Rete::Symbol_Constant_String_Ptr_C m_top_left_ccw_dist_attr = Rete::Symbol_Constant_String::intern("top-left-ccw-dist");
+    //const Rete::Symbol_Constant_String_Ptr_C m_top_right_cw_dist_attr = Rete::Symbol_Constant_String::intern("top-right-cw-dist");
+    //const Rete::Symbol_Constant_String_Ptr_C m_left_top_cw_dist_attr = Rete::Symbol_Constant_String::intern("left-top-cw-dist");
+    //const Rete::Symbol_Constant_String_Ptr_C m_left_bottom_ccw_dist_attr = Rete::Symbol_Constant_String::intern("left-bottom-ccw-dist");
+    //const Rete::Symbol_Constant_String_Ptr_C m_moves_to_blank_tl_ccw_attr = Rete::Symbol_Constant_String::intern("moves-to-blank-tl-ccw");
+    const Rete::Symbol_Identifier_Ptr_C m_move_north_id = Rete::Symbol_Identifier::intern("move-north");
+    const Rete::Symbol_Identifier_Ptr_C m_move_south_id = Rete::Symbol_Identifier::intern("move-south");
+    const Rete::Symbol_Identifier_Ptr_C m_move_east_id = Rete::Symbol_Identifier::intern("move-east");
+    const Rete::Symbol_Identifier_Ptr_C m_move_west_id = Rete::Symbol_Identifier::intern("move-west");
+    const Rete::Symbol_Identifier_Ptr_C m_refuel_id = Rete::Symbol_Identifier::intern("refuel");
+    const Rete::Symbol_Identifier_Ptr_C m_pickup_id = Rete::Symbol_Identifier::intern("pickup");
+    const Rete::Symbol_Identifier_Ptr_C m_dropoff_id = Rete::Symbol_Identifier::intern("dropoff");
+    const Rete::Symbol_Constant_Int_Ptr_C m_type_move = Rete::Symbol_Constant_Int::intern(1);
+    const Rete::Symbol_Constant_Int_Ptr_C m_type_refuel = Rete::Symbol_Constant_Int::intern(2);
+    const Rete::Symbol_Constant_Int_Ptr_C m_type_pickup = Rete::Symbol_Constant_Int::intern(3);
+    const Rete::Symbol_Constant_Int_Ptr_C m_type_dropoff = Rete::Symbol_Constant_Int::intern(4);
+    const Rete::Symbol_Constant_Int_Ptr_C m_direction_none = Rete::Symbol_Constant_Int::intern(0);
+    const Rete::Symbol_Constant_Int_Ptr_C m_direction_north = Rete::Symbol_Constant_Int::intern(1);
+    const Rete::Symbol_Constant_Int_Ptr_C m_direction_south = Rete::Symbol_Constant_Int::intern(2);
+    const Rete::Symbol_Constant_Int_Ptr_C m_direction_east = Rete::Symbol_Constant_Int::intern(3);
+    const Rete::Symbol_Constant_Int_Ptr_C m_direction_west = Rete::Symbol_Constant_Int::intern(4);
+    const Rete::Symbol_Constant_Int_Ptr_C m_passenger_at_source = Rete::Symbol_Constant_Int::intern(1);
+    const Rete::Symbol_Constant_Int_Ptr_C m_passenger_onboard = Rete::Symbol_Constant_Int::intern(2);
+    const Rete::Symbol_Constant_Int_Ptr_C m_passenger_at_destination = Rete::Symbol_Constant_Int::intern(3);
+    const Rete::Symbol_Constant_Int_Ptr_C m_fuel_insufficient = Rete::Symbol_Constant_Int::intern(1);
+    const Rete::Symbol_Constant_Int_Ptr_C m_fuel_oneway = Rete::Symbol_Constant_Int::intern(2);
+    const Rete::Symbol_Constant_Int_Ptr_C m_fuel_roundtrip = Rete::Symbol_Constant_Int::intern(3);
+    const Rete::Symbol_Constant_String_Ptr_C m_true_value = Rete::Symbol_Constant_String::intern("true");
+    const Rete::Symbol_Constant_String_Ptr_C m_false_value = Rete::Symbol_Constant_String::intern("false");
 
     Rete::Symbol_Identifier_Ptr_C get_filling_station_id(const int64_t &filling_station);
     Rete::Symbol_Identifier_Ptr_C get_destination_id(const int64_t &destination);
@@ -273,33 +283,7 @@ namespace Taxicab {
     std::map<int64_t, Rete::Symbol_Identifier_Ptr_C> m_filling_station_ids;
     std::map<int64_t, Rete::Symbol_Identifier_Ptr_C> m_destination_ids;
 
-    std::unordered_map<Rete::WME_Ptr_C, bool, Rete::hash_deref<Rete::WME>, Rete::compare_deref_eq> m_wmes;
-
-    void clear_old_wmes() {
-      auto wt = m_wmes.begin(), wend = m_wmes.end();
-      while(wt != wend) {
-        if(wt->second)
-          wt++->second = false;
-        else {
-          {
-            CPU_Accumulator cpu_accumulator(*this);
-            remove_wme(wt->first);
-          }
-          wt = m_wmes.erase(wt);
-        }
-      }
-    }
-
-    void insert_new_wme(const Rete::WME_Ptr_C &wme) {
-      const auto found = m_wmes.find(wme);
-      if(found == m_wmes.end()) {
-        m_wmes[wme] = true;
-        CPU_Accumulator cpu_accumulator(*this);
-        insert_wme(wme);
-      }
-      else
-        found->second = true;
-    }
+    std::vector<Rete::WME_Ptr_C> m_wmes; ///< The next state, collected by generate_features
 
 //    double m_feature_generation_time = 0.0;
   };
@@ -14,6 +14,9 @@ namespace Taxicab {
   using Carli::Node_Unsplit;
   using Carli::Q_Value;
 
+  const Rete::Variable_Slot Action::type_slot("type");
+  const Rete::Variable_Slot Action::direction_slot("direction");
+
   Environment::Environment() {
     init_impl();
   }
@@ -28,8 +31,8 @@ namespace Taxicab {
        m_fuel == 0 && std::find(m_filling_stations.begin(), m_filling_stations.end(), m_taxi_position) == m_filling_stations.end() &&
        (m_passenger == AT_SOURCE || m_taxi_position != m_destinations[m_passenger_destination]))
     {
-      m_optimal_solution->print_solution(std::cerr);
-      m_solution->print_solution(std::cerr);
+      m_optimal_solution->print_solution(get_context().get_err());
+      m_solution->print_solution(get_context().get_err());
       assert(false);
     }
 #endif
@@ -350,6 +353,24 @@ namespace Taxicab {
     }
   }
 
+  void Environment::save_impl(ostream &os) const {
+    m_random.save(os);
+    Zeni::serialize(os, m_grid_w);
+    Zeni::serialize(os, m_grid_h);
+    Zeni::serialize(os, m_num_filling_stations);
+    Zeni::serialize(os, m_num_destinations);
+    Zeni::serialize(os, m_num_steps_to_goal);
+  }
+
+  void Environment::load_impl(istream &is) {
+    m_random.load(is);
+    Zeni::deserialize(is, m_grid_w);
+    Zeni::deserialize(is, m_grid_h);
+    Zeni::deserialize(is, m_num_filling_stations);
+    Zeni::deserialize(is, m_num_destinations);
+    Zeni::deserialize(is, m_num_steps_to_goal);
+  }
+
   bool Environment::solveable_fuel() {
     m_fuel_distances.clear();
     m_fuel_distances.resize(m_grid_w * m_grid_h, std::numeric_limits<int64_t>::max());
@@ -433,8 +454,8 @@ namespace Taxicab {
     //for(int64_t tile = 0; tile != int64_t(env->get_grid().size()); ++tile) {
     //  std::ostringstream oss;
     //  oss << "move-" << tile;
-    //  m_move_ids[tile] = Rete::Symbol_Identifier_Ptr_C(new Rete::Symbol_Identifier(oss.str()));
-    //  m_tile_names[tile] = Rete::Symbol_Constant_Int_Ptr_C(new Rete::Symbol_Constant_Int(tile));
+    //  m_move_ids[tile] = Rete::Symbol_Identifier::intern(oss.str());
+    //  m_tile_names[tile] = Rete::Symbol_Constant_Int::intern(tile);
     //}
 
     generate_rete();
@@ -448,7 +469,7 @@ namespace Taxicab {
   }
 
   void Agent::generate_rete() {
-    std::string rules_in = dynamic_cast<const Option_String &>(Options::get_global()["rules"]).get_value();
+    std::string rules_in = dynamic_cast<const Option_String &>(get_context().get_options()["rules"]).get_value();
     if(rules_in == "default")
       rules_in = "rules/taxicab.carli";
     if(rete_parse_file(*this, rules_in))
@@ -461,58 +482,54 @@ namespace Taxicab {
 
     auto env = dynamic_pointer_cast<const Environment>(get_env());
 
-    if(get_Option_Ranged<bool>(Options::get_global(), "rete-flush-wmes")) {
-      Rete::Agenda::Locker locker(agenda);
-      clear_old_wmes();
-    }
-
-    Rete::Agenda::Locker locker(agenda);
+    if(get_Option_Ranged<bool>(get_context().get_options(), "rete-flush-wmes"))
+      clear_wmes();
 
     std::map<Rete::Symbol_Identifier_Ptr_C, std::pair<int64_t, int64_t>> next_positions;
     if(env->get_fuel() && env->get_taxi_position().second) {
-      insert_new_wme(std::make_shared<Rete::WME>(m_s_id, m_action_attr, m_move_north_id));
-      insert_new_wme(std::make_shared<Rete::WME>(m_move_north_id, m_type_attr, m_type_move));
-      insert_new_wme(std::make_shared<Rete::WME>(m_move_north_id, m_direction_attr, m_direction_north));
+      m_wmes.push_back(Rete::WME::create(m_s_id, m_action_attr, m_move_north_id));
+      m_wmes.push_back(Rete::WME::create(m_move_north_id, m_type_attr, m_type_move));
+      m_wmes.push_back(Rete::WME::create(m_move_north_id, m_direction_attr, m_direction_north));
       next_positions[m_move_north_id] = std::make_pair(env->get_taxi_position().first, env->get_taxi_position().second - 1);
     }
     if(env->get_fuel() && env->get_taxi_position().second + 1 != env->get_grid_h()) {
-      insert_new_wme(std::make_shared<Rete::WME>(m_s_id, m_action_attr, m_move_south_id));
-      insert_new_wme(std::make_shared<Rete::WME>(m_move_south_id, m_type_attr, m_type_move));
-      insert_new_wme(std::make_shared<Rete::WME>(m_move_south_id, m_direction_attr, m_direction_south));
+      m_wmes.push_back(Rete::WME::create(m_s_id, m_action_attr, m_move_south_id));
+      m_wmes.push_back(Rete::WME::create(m_move_south_id, m_type_attr, m_type_move));
+      m_wmes.push_back(Rete::WME::create(m_move_south_id, m_direction_attr, m_direction_south));
       next_positions[m_move_south_id] = std::make_pair(env->get_taxi_position().first, env->get_taxi_position().second + 1);
     }
     if(env->get_fuel() && env->get_taxi_position().first + 1 != env->get_grid_w()) {
-      insert_new_wme(std::make_shared<Rete::WME>(m_s_id, m_action_attr, m_move_east_id));
-      insert_new_wme(std::make_shared<Rete::WME>(m_move_east_id, m_type_attr, m_type_move));
-      insert_new_wme(std::make_shared<Rete::WME>(m_move_east_id, m_direction_attr, m_direction_east));
+      m_wmes.push_back(Rete::WME::create(m_s_id, m_action_attr, m_move_east_id));
+      m_wmes.push_back(Rete::WME::create(m_move_east_id, m_type_attr, m_type_move));
+      m_wmes.push_back(Rete::WME::create(m_move_east_id, m_direction_attr, m_direction_east));
       next_positions[m_move_east_id] = std::make_pair(env->get_taxi_position().first + 1, env->get_taxi_position().second);
     }
     if(env->get_fuel() && env->get_taxi_position().first) {
-      insert_new_wme(std::make_shared<Rete::WME>(m_s_id, m_action_attr, m_move_west_id));
-      insert_new_wme(std::make_shared<Rete::WME>(m_move_west_id, m_type_attr, m_type_move));
-      insert_new_wme(std::make_shared<Rete::WME>(m_move_west_id, m_direction_attr, m_direction_west));
+      m_wmes.push_back(Rete::WME::create(m_s_id, m_action_attr, m_move_west_id));
+      m_wmes.push_back(Rete::WME::create(m_move_west_id, m_type_attr, m_type_move));
+      m_wmes.push_back(Rete::WME::create(m_move_west_id, m_direction_attr, m_direction_west));
       next_positions[m_move_west_id] = std::make_pair(env->get_taxi_position().first - 1, env->get_taxi_position().second);
     }
     if(env->get_fuel() != env->get_fuel_max() && std::find(env->get_filling_stations().begin(), env->get_filling_stations().end(), env->get_taxi_position()) != env->get_filling_stations().end()) {
-      insert_new_wme(std::make_shared<Rete::WME>(m_s_id, m_action_attr, m_refuel_id));
-      insert_new_wme(std::make_shared<Rete::WME>(m_refuel_id, m_type_attr, m_type_refuel));
-      insert_new_wme(std::make_shared<Rete::WME>(m_refuel_id, m_direction_attr, m_direction_none));
+      m_wmes.push_back(Rete::WME::create(m_s_id, m_action_attr, m_refuel_id));
+      m_wmes.push_back(Rete::WME::create(m_refuel_id, m_type_attr, m_type_refuel));
+      m_wmes.push_back(Rete::WME::create(m_refuel_id, m_direction_attr, m_direction_none));
     }
     if(env->get_passenger() == Environment::AT_SOURCE && env->get_taxi_position() == env->get_destinations()[env->get_passenger_source()]) {
-      insert_new_wme(std::make_shared<Rete::WME>(m_s_id, m_action_attr, m_pickup_id));
-      insert_new_wme(std::make_shared<Rete::WME>(m_pickup_id, m_type_attr, m_type_pickup));
-      insert_new_wme(std::make_shared<Rete::WME>(m_pickup_id, m_direction_attr, m_direction_none));
+      m_wmes.push_back(Rete::WME::create(m_s_id, m_action_attr, m_pickup_id));
+      m_wmes.push_back(Rete::WME::create(m_pickup_id, m_type_attr, m_type_pickup));
+      m_wmes.push_back(Rete::WME::create(m_pickup_id, m_direction_attr, m_direction_none));
     }
     if(env->get_passenger() == Environment::ONBOARD && env->get_taxi_position() == env->get_destinations()[env->get_passenger_destination()]) {
-      insert_new_wme(std::make_shared<Rete::WME>(m_s_id, m_action_attr, m_dropoff_id));
-      insert_new_wme(std::make_shared<Rete::WME>(m_dropoff_id, m_type_attr, m_type_dropoff));
-      insert_new_wme(std::make_shared<Rete::WME>(m_dropoff_id, m_direction_attr, m_direction_none));
+      m_wmes.push_back(Rete::WME::create(m_s_id, m_action_attr, m_dropoff_id));
+      m_wmes.push_back(Rete::WME::create(m_dropoff_id, m_type_attr, m_type_dropoff));
+      m_wmes.push_back(Rete::WME::create(m_dropoff_id, m_direction_attr, m_direction_none));
     }
 
     std::vector<int64_t> reachable_filling_stations;
     for(int64_t filling_station = 0; filling_station != int64_t(env->get_filling_stations().size()); ++filling_station) {
       const auto filling_station_id = get_filling_station_id(filling_station);
-      insert_new_wme(std::make_shared<Rete::WME>(m_s_id, m_filling_station_attr, filling_station_id));
+      m_wmes.push_back(Rete::WME::create(m_s_id, m_filling_station_attr, filling_station_id));
 
       int64_t dist_min = std::numeric_limits<int64_t>::max();
       for(auto next_position : next_positions) {
@@ -522,19 +539,19 @@ namespace Taxicab {
       if(dist_min != std::numeric_limits<int64_t>::max()) {
         for(auto next_position : next_positions) {
           if(env->get_distance_from_fuel(filling_station)[next_position.second.second * env->get_grid_w() + next_position.second.first] == dist_min)
-            insert_new_wme(std::make_shared<Rete::WME>(next_position.first, m_toward_attr, filling_station_id));
+            m_wmes.push_back(Rete::WME::create(next_position.first, m_toward_attr, filling_station_id));
         }
       }
 
       const int64_t dist = env->get_distance_from_fuel(filling_station)[env->get_taxi_position().second * env->get_grid_w() + env->get_taxi_position().first];
       if(dist <= env->get_fuel())
         reachable_filling_stations.push_back(filling_station);
-      //insert_new_wme(std::make_shared<Rete::WME>(filling_station_id, m_fuel_attr, dist <= env->get_fuel() ? m_fuel_roundtrip : m_fuel_insufficient));
+      //m_wmes.push_back(Rete::WME::create(filling_station_id, m_fuel_attr, dist <= env->get_fuel() ? m_fuel_roundtrip : m_fuel_insufficient));
     }
 
     for(int64_t destination = 0; destination != int64_t(env->get_destinations().size()); ++destination) {
       const auto destination_id = get_destination_id(destination);
-      insert_new_wme(std::make_shared<Rete::WME>(m_s_id, m_destination_attr, destination_id));
+      m_wmes.push_back(Rete::WME::create(m_s_id, m_destination_attr, destination_id));
 
       int64_t hops_min = std::numeric_limits<int64_t>::max();
       int64_t dist_min = std::numeric_limits<int64_t>::max();
@@ -551,7 +568,7 @@ namespace Taxicab {
           const int64_t hops = env->get_fuel2dest_hops(filling_station, destination);
           const int64_t dist = env->get_distance_from_dest(destination)[env->get_filling_stations()[filling_station].second * env->get_grid_w() + env->get_filling_stations()[filling_station].first];
           if(hops == hops_min && dist == dist_min)
-            insert_new_wme(std::make_shared<Rete::WME>(get_filling_station_id(filling_station), m_toward_attr, destination_id));
+            m_wmes.push_back(Rete::WME::create(get_filling_station_id(filling_station), m_toward_attr, destination_id));
         }
       }
 
@@ -568,12 +585,12 @@ namespace Taxicab {
         if(dist_min != std::numeric_limits<int64_t>::max()) {
           for(auto next_position : next_positions) {
             if(env->get_distance_from_dest(destination)[next_position.second.second * env->get_grid_w() + next_position.second.first] == dist_min)
-              insert_new_wme(std::make_shared<Rete::WME>(next_position.first, m_toward_attr, destination_id));
+              m_wmes.push_back(Rete::WME::create(next_position.first, m_toward_attr, destination_id));
           }
         }
       }
 
-      insert_new_wme(std::make_shared<Rete::WME>(destination_id, m_fuel_attr, fuel >= taxi_to_dest + dest_to_fuel ? m_fuel_roundtrip : fuel >= taxi_to_dest ? m_fuel_oneway : m_fuel_insufficient));
+      m_wmes.push_back(Rete::WME::create(destination_id, m_fuel_attr, fuel >= taxi_to_dest + dest_to_fuel ? m_fuel_roundtrip : fuel >= taxi_to_dest ? m_fuel_oneway : m_fuel_insufficient));
     }
 
     //bool refuel_required = false;
@@ -592,7 +609,7 @@ namespace Taxicab {
     //      refuel_required = true;
     //  }
     //}
-    //insert_new_wme(std::make_shared<Rete::WME>(m_s_id, m_refuel_required_attr, refuel_required ? m_true_value : m_false_value));
+    //m_wmes.push_back(Rete::WME::create(m_s_id, m_refuel_required_attr, refuel_required ? m_true_value : m_false_value));
 
     //std::pair<std::set<Rete::Symbol_Identifier_Ptr_C>, int64_t> min_through_source;
     //std::pair<std::set<Rete::Symbol_Identifier_Ptr_C>, int64_t> min_to_dest;
@@ -616,30 +633,31 @@ namespace Taxicab {
 
     //for(auto id : {m_move_north_id, m_move_south_id, m_move_east_id, m_move_west_id}) {
     //  const bool is_min = min_through_source.second != std::numeric_limits<int64_t>::max() && min_through_source.first.find(id) != min_through_source.first.end();
-    //  insert_new_wme(std::make_shared<Rete::WME>(id, m_toward_pickup_attr, is_min ? m_true_value : m_false_value));
+    //  m_wmes.push_back(Rete::WME::create(id, m_toward_pickup_attr, is_min ? m_true_value : m_false_value));
     //}
 
     //for(auto id : {m_move_north_id, m_move_south_id, m_move_east_id, m_move_west_id}) {
     //  const bool is_min = min_to_dest.second != std::numeric_limits<int64_t>::max() && min_to_dest.first.find(id) != min_to_dest.first.end();
-    //  insert_new_wme(std::make_shared<Rete::WME>(id, m_toward_dropoff_attr, is_min ? m_true_value : m_false_value));
+    //  m_wmes.push_back(Rete::WME::create(id, m_toward_dropoff_attr, is_min ? m_true_value : m_false_value));
     //}
 
     if(env->get_passenger() == Environment::AT_SOURCE)
-      insert_new_wme(std::make_shared<Rete::WME>(m_s_id, m_passenger_attr, m_passenger_at_source));
+      m_wmes.push_back(Rete::WME::create(m_s_id, m_passenger_attr, m_passenger_at_source));
     else if(env->get_passenger() == Environment::ONBOARD)
-      insert_new_wme(std::make_shared<Rete::WME>(m_s_id, m_passenger_attr, m_passenger_onboard));
+      m_wmes.push_back(Rete::WME::create(m_s_id, m_passenger_attr, m_passenger_onboard));
     else
-      insert_new_wme(std::make_shared<Rete::WME>(m_s_id, m_passenger_attr, m_passenger_at_destination));
+      m_wmes.push_back(Rete::WME::create(m_s_id, m_passenger_attr, m_passenger_at_destination));
 
-    //insert_new_wme(std::make_shared<Rete::WME>(m_s_id, m_passenger_source_attr, get_destination_id(env->get_passenger_source())));
-    //insert_new_wme(std::make_shared<Rete::WME>(m_s_id, m_passenger_destination_attr, get_destination_id(env->get_passenger_destination())));
+    //m_wmes.push_back(Rete::WME::create(m_s_id, m_passenger_source_attr, get_destination_id(env->get_passenger_source())));
+    //m_wmes.push_back(Rete::WME::create(m_s_id, m_passenger_destination_attr, get_destination_id(env->get_passenger_destination())));
 
     if(env->get_passenger() == Environment::AT_SOURCE)
-      insert_new_wme(std::make_shared<Rete::WME>(m_s_id, m_next_stop_attr, get_destination_id(env->get_passenger_source())));
+      m_wmes.push_back(Rete::WME::create(m_s_id, m_next_stop_attr, get_destination_id(env->get_passenger_source())));
     else
-      insert_new_wme(std::make_shared<Rete::WME>(m_s_id, m_next_stop_attr, get_destination_id(env->get_passenger_destination())));
+      m_wmes.push_back(Rete::WME::create(m_s_id, m_next_stop_attr, get_destination_id(env->get_passenger_destination())));
 
-    clear_old_wmes();
+    set_wmes(m_wmes);
+    m_wmes.clear();
   }
 
   void Agent::update() {
@@ -651,11 +669,19 @@ namespace Taxicab {
       m_metastate = Metastate::FAILURE;
   }
 
+  void Agent::save_impl(ostream &os) const {
+    m_random.save(os);
+  }
+
+  void Agent::load_impl(istream &is) {
+    m_random.load(is);
+  }
+
   Rete::Symbol_Identifier_Ptr_C Agent::get_filling_station_id(const int64_t &filling_station) {
     if(!m_filling_station_ids[filling_station]) {
       std::ostringstream oss;
       oss << "filling-station-" << filling_station;
-      m_filling_station_ids[filling_station] = Rete::Symbol_Identifier_Ptr_C(new Rete::Symbol_Identifier(oss.str()));
+      m_filling_station_ids[filling_station] = Rete::Symbol_Identifier::intern(oss.str());
     }
     return m_filling_station_ids[filling_station];
   }
@@ -664,7 +690,7 @@ namespace Taxicab {
     if(!m_destination_ids[destination]) {
       std::ostringstream oss;
       oss << "destination-" << destination;
-      m_destination_ids[destination] = Rete::Symbol_Identifier_Ptr_C(new Rete::Symbol_Identifier(oss.str()));
+      m_destination_ids[destination] = Rete::Symbol_Identifier::intern(oss.str());
     }
     return m_destination_ids[destination];
   }
@@ -53,6 +53,7 @@ namespace Tetris {
 
   using std::dynamic_pointer_cast;
   using std::endl;
+  using std::istream;
   using std::ostream;
 
   class TETRIS_LINKAGE Place : public Carli::Action {
@@ -68,10 +69,14 @@ namespace Tetris {
     {
     }
 
+    static const Rete::Variable_Slot x_slot;
+    static const Rete::Variable_Slot y_slot;
+    static const Rete::Variable_Slot type_slot;
+
     Place(const Rete::Variable_Indices &variables, const Rete::WME_Token &token)
-     : position(int16_t(debuggable_cast<const Rete::Symbol_Constant_Int &>(*token[variables.find("x")->second]).value),
-                int16_t(debuggable_cast<const Rete::Symbol_Constant_Int &>(*token[variables.find("y")->second]).value)),
-     type(Tetromino_Type(debuggable_cast<const Rete::Symbol_Constant_Int &>(*token[variables.find("type")->second]).value))
+     : position(int16_t(token.get<Rete::Symbol_Constant_Int>(variables, x_slot).value),
+                int16_t(token.get<Rete::Symbol_Constant_Int>(variables, y_slot).value)),
+     type(Tetromino_Type(token.get<Rete::Symbol_Constant_Int>(variables, type_slot).value))
     {
     }
 
@@ -161,6 +166,9 @@ namespace Tetris {
 
     void print_impl(ostream &os) const;
 
+    void save_impl(ostream &os) const;
+    void load_impl(istream &is);
+
     static Tetromino generate_Tetromino(const Tetromino_Type &type);
     uint8_t clear_lines(const std::pair<int16_t, int16_t> &position);
 
@@ -197,25 +205,25 @@ namespace Tetris {
     const Rete::Symbol_Variable_Ptr_C m_first_var = Rete::Symbol_Variable_Ptr_C(new Rete::Symbol_Variable(Rete::Symbol_Variable::First));
     const Rete::Symbol_Variable_Ptr_C m_third_var = Rete::Symbol_Variable_Ptr_C(new Rete::Symbol_Variable(Rete::Symbol_Variable::Third));
 
-    const Rete::Symbol_Constant_String_Ptr_C m_input_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("input"));
-    const Rete::Symbol_Constant_String_Ptr_C m_action_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("action"));
-    const Rete::Symbol_Constant_String_Ptr_C m_type_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("type"));
-    const Rete::Symbol_Constant_String_Ptr_C m_type_next_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("type-next"));
-    const Rete::Symbol_Constant_String_Ptr_C m_width_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("width"));
-    const Rete::Symbol_Constant_String_Ptr_C m_height_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("height"));
-    const Rete::Symbol_Constant_String_Ptr_C m_x_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("x"));
-    const Rete::Symbol_Constant_String_Ptr_C m_y_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("y"));
-    const Rete::Symbol_Constant_String_Ptr_C m_gaps_beneath_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("gaps-beneath"));
-    const Rete::Symbol_Constant_String_Ptr_C m_gaps_created_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("gaps-created"));
-    const Rete::Symbol_Constant_String_Ptr_C m_depth_to_gap_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("depth-to-gap")); ///< Depth to the highest gap
-    const Rete::Symbol_Constant_String_Ptr_C m_clears_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("clears"));
-    const Rete::Symbol_Constant_String_Ptr_C m_enables_clearing_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("enables-clearing"));
-    const Rete::Symbol_Constant_String_Ptr_C m_prohibits_clearing_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("prohibits-clearing"));
-    const Rete::Symbol_Constant_String_Ptr_C m_x_odd_attr = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("x-odd"));
-    const Rete::Symbol_Constant_String_Ptr_C m_true_value = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("true"));
-    const Rete::Symbol_Constant_String_Ptr_C m_false_value = Rete::Symbol_Constant_String_Ptr_C(new Rete::Symbol_Constant_String("false"));
-
-    std::list<Rete::WME_Ptr_C> m_wmes_prev;
+    const Rete::Symbol_Constant_String_Ptr_C m_input_attr = Rete::Symbol_Constant_String::intern("input");
+    const Rete::Symbol_Constant_String_Ptr_C m_action_attr = Rete::Symbol_Constant_String::intern("action");
+    const Rete::Symbol_Constant_String_Ptr_C m_type_attr = Rete::Symbol_Constant_String::intern("type");
+    const Rete::Symbol_Constant_String_Ptr_C m_type_next_attr = Rete::Symbol_Constant_String::intern("type-next");
+    const Rete::Symbol_Constant_String_Ptr_C m_width_attr = Rete::Symbol_Constant_String::intern("width");
+    const Rete::Symbol_Constant_String_Ptr_C m_height_attr = Rete::Symbol_Constant_String::intern("height");
+    const Rete::Symbol_Constant_String_Ptr_C m_x_attr = Rete::Symbol_Constant_String::intern("x");
+    const Rete::Symbol_Constant_String_Ptr_C m_y_attr = Rete::Symbol_Constant_String::intern("y");
+    const Rete::Symbol_Constant_String_Ptr_C m_gaps_beneath_attr = Rete::Symbol_Constant_String::intern("gaps-beneath");
+    const Rete::Symbol_Constant_String_Ptr_C m_gaps_created_attr = Rete::Symbol_Constant_String::intern("gaps-created");
+    const Rete::Symbol_Constant_String_Ptr_C m_depth_to_gap_attr = Rete::Symbol_Constant_String::intern("depth-to-gap"); ///< Depth to the highest gap
+    const Rete::Symbol_Constant_String_Ptr_C m_clears_attr = Rete::Symbol_Constant_String::intern("clears");
+    const Rete::Symbol_Constant_String_Ptr_C m_enables_clearing_attr = Rete::Symbol_Constant_String::intern("enables-clearing");
+    const Rete::Symbol_Constant_String_Ptr_C m_prohibits_clearing_attr = Rete::Symbol_Constant_String::intern("prohibits-clearing");
+    const Rete::Symbol_Constant_String_Ptr_C m_x_odd_attr = Rete::Symbol_Constant_String::intern("x-odd");
+    const Rete::Symbol_Constant_String_Ptr_C m_true_value = Rete::Symbol_Constant_String::intern("true");
+    const Rete::Symbol_Constant_String_Ptr_C m_false_value = Rete::Symbol_Constant_String::intern("false");
+
+    std::vector<Rete::WME_Ptr_C> m_wmes; ///< The next state, collected by generate_features
   };
 
 }
@@ -12,6 +12,10 @@ namespace Tetris {
   using Carli::Node_Unsplit;
   using Carli::Q_Value;
 
+  const Rete::Variable_Slot Place::x_slot("x");
+  const Rete::Variable_Slot Place::y_slot("y");
+  const Rete::Variable_Slot Place::type_slot("type");
+
   Environment::Environment()
     : score_line({{0.0, 10.0, 20.0, 30.0, 40.0}}) ///< No risk-reward tradeoff
     //: score_line({{0.0, 10.0, 20.0, 40.0, 80.0}}) ///< Risk-reward tradeoff
@@ -144,6 +148,16 @@ namespace Tetris {
     assert(index == 4);
   }
 
+  void Environment::save_impl(ostream &os) const {
+    m_random_init.save(os);
+    m_random_selection.save(os);
+  }
+
+  void Environment::load_impl(istream &is) {
+    m_random_init.load(is);
+    m_random_selection.load(is);
+  }
+
   Environment::Tetromino Environment::generate_Tetromino(const Tetromino_Type &type) {
     Environment::Tetromino tet;
     memset(&tet, 0, sizeof(tet));
@@ -514,7 +528,7 @@ namespace Tetris {
   }
 
   void Agent::generate_rete() {
-    std::string rules_in = dynamic_cast<const Option_String &>(Options::get_global()["rules"]).get_value();
+    std::string rules_in = dynamic_cast<const Option_String &>(get_context().get_options()["rules"]).get_value();
     if(rules_in == "default")
       rules_in = "rules/tetris-ycc.carli";
     if(rete_parse_file(*this, rules_in))
@@ -524,26 +538,25 @@ namespace Tetris {
   void Agent::generate_features() {
     auto env = dynamic_pointer_cast<const Environment>(get_env());
 
-    std::list<Rete::WME_Ptr_C> wmes_current;
     std::ostringstream oss;
 
-    wmes_current.push_back(std::make_shared<Rete::WME>(m_s_id, m_type_next_attr, std::make_shared<Rete::Symbol_Constant_Int>(env->get_next())));
+    m_wmes.push_back(Rete::WME::create(m_s_id, m_type_next_attr, Rete::Symbol_Constant_Int::intern(env->get_next())));
 
     size_t index = 0;
     for(const auto &placement : env->get_placements()) {
       oss << "place-" << ++index;
-      Rete::Symbol_Identifier_Ptr_C action_id = std::make_shared<Rete::Symbol_Identifier>(oss.str());
+      Rete::Symbol_Identifier_Ptr_C action_id = Rete::Symbol_Identifier::intern(oss.str());
       oss.str("");
-      wmes_current.push_back(std::make_shared<Rete::WME>(m_s_id, m_action_attr, action_id));
-      wmes_current.push_back(std::make_shared<Rete::WME>(action_id, m_type_attr, std::make_shared<Rete::Symbol_Constant_Int>(placement.type)));
-      wmes_current.push_back(std::make_shared<Rete::WME>(action_id, m_width_attr, std::make_shared<Rete::Symbol_Constant_Int>(placement.size.first)));
-      wmes_current.push_back(std::make_shared<Rete::WME>(action_id, m_height_attr, std::make_shared<Rete::Symbol_Constant_Int>(placement.size.second)));
-      wmes_current.push_back(std::make_shared<Rete::WME>(action_id, m_x_attr, std::make_shared<Rete::Symbol_Constant_Int>(placement.position.first)));
-      wmes_current.push_back(std::make_shared<Rete::WME>(action_id, m_y_attr, std::make_shared<Rete::Symbol_Constant_Int>(placement.position.second)));
-      wmes_current.push_back(std::make_shared<Rete::WME>(action_id, m_gaps_beneath_attr, std::make_shared<Rete::Symbol_Constant_Int>(placement.gaps_beneath)));
-      wmes_current.push_back(std::make_shared<Rete::WME>(action_id, m_gaps_created_attr, std::make_shared<Rete::Symbol_Constant_Int>(placement.gaps_created)));
-      wmes_current.push_back(std::make_shared<Rete::WME>(action_id, m_depth_to_gap_attr, std::make_shared<Rete::Symbol_Constant_Int>(placement.depth_to_gap)));
-      wmes_current.push_back(std::make_shared<Rete::WME>(action_id, m_x_odd_attr, (placement.position.first & 1) ? m_true_value : m_false_value));
+      m_wmes.push_back(Rete::WME::create(m_s_id, m_action_attr, action_id));
+      m_wmes.push_back(Rete::WME::create(action_id, m_type_attr, Rete::Symbol_Constant_Int::intern(placement.type)));
+      m_wmes.push_back(Rete::WME::create(action_id, m_width_attr, Rete::Symbol_Constant_Int::intern(placement.size.first)));
+      m_wmes.push_back(Rete::WME::create(action_id, m_height_attr, Rete::Symbol_Constant_Int::intern(placement.size.second)));
+      m_wmes.push_back(Rete::WME::create(action_id, m_x_attr, Rete::Symbol_Constant_Int::intern(placement.position.first)));
+      m_wmes.push_back(Rete::WME::create(action_id, m_y_attr, Rete::Symbol_Constant_Int::intern(placement.position.second)));
+      m_wmes.push_back(Rete::WME::create(action_id, m_gaps_beneath_attr, Rete::Symbol_Constant_Int::intern(placement.gaps_beneath)));
+      m_wmes.push_back(Rete::WME::create(action_id, m_gaps_created_attr, Rete::Symbol_Constant_Int::intern(placement.gaps_created)));
+      m_wmes.push_back(Rete::WME::create(action_id, m_depth_to_gap_attr, Rete::Symbol_Constant_Int::intern(placement.depth_to_gap)));
+      m_wmes.push_back(Rete::WME::create(action_id, m_x_odd_attr, (placement.position.first & 1) ? m_true_value : m_false_value));
 
       int clears = 0;
       int enables = 0;
@@ -558,40 +571,16 @@ namespace Tetris {
         if(placement.outcome[i] == Environment::Outcome::OUTCOME_PROHIBITED)
           prohibits = i;
 
-      wmes_current.push_back(std::make_shared<Rete::WME>(action_id, m_clears_attr, std::make_shared<Rete::Symbol_Constant_Int>(clears)));
-      wmes_current.push_back(std::make_shared<Rete::WME>(action_id, m_enables_clearing_attr, std::make_shared<Rete::Symbol_Constant_Int>(enables)));
-      wmes_current.push_back(std::make_shared<Rete::WME>(action_id, m_prohibits_clearing_attr, std::make_shared<Rete::Symbol_Constant_Int>(prohibits)));
+      m_wmes.push_back(Rete::WME::create(action_id, m_clears_attr, Rete::Symbol_Constant_Int::intern(clears)));
+      m_wmes.push_back(Rete::WME::create(action_id, m_enables_clearing_attr, Rete::Symbol_Constant_Int::intern(enables)));
+      m_wmes.push_back(Rete::WME::create(action_id, m_prohibits_clearing_attr, Rete::Symbol_Constant_Int::intern(prohibits)));
     }
 
-    Rete::Agenda::Locker locker(agenda);
-    CPU_Accumulator cpu_accumulator(*this);
+    if(get_Option_Ranged<bool>(get_context().get_options(), "rete-flush-wmes"))
+      clear_wmes();
 
-    if(get_Option_Ranged<bool>(Options::get_global(), "rete-flush-wmes")) {
-      for(auto wt = m_wmes_prev.begin(), wend = m_wmes_prev.end(); wt != wend; ++wt)
-        remove_wme(*wt);
-      m_wmes_prev.clear();
-    }
-    else {
-      for(auto wt = m_wmes_prev.begin(), wend = m_wmes_prev.end(); wt != wend; ) {
-        const auto found = std::find_if(wmes_current.begin(), wmes_current.end(), [wt](const Rete::WME_Ptr_C &wme_)->bool{return *wme_ == **wt;});
-        if(found == wmes_current.end()) {
-          remove_wme(*wt);
-          m_wmes_prev.erase(wt++);
-        }
-        else {
-          wmes_current.erase(found);
-          ++wt;
-        }
-      }
-    }
-
-    for(auto &wme : wmes_current) {
-      const auto found = std::find_if(m_wmes_prev.begin(), m_wmes_prev.end(), [wme](const Rete::WME_Ptr_C &wme_)->bool{return *wme_ == *wme;});
-      if(found == m_wmes_prev.end()) {
-        m_wmes_prev.push_back(wme);
-        insert_wme(wme);
-      }
-    }
+    set_wmes(m_wmes);
+    m_wmes.clear();
   }
 
   void Agent::update() {